@@ -0,0 +1,92 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+///
+/// \file CounterRandom.h
+/// \brief Counter-based random number streams for the ALICE3 fast simulation
+///
+/// The n-th number of a stream is a hash of (stream key, n), so a stream does not
+/// depend on which generator instance or thread produces it, nor on what was drawn
+/// from other streams before. Opening one stream per (collision, particle) makes the
+/// smearing of a particle reproducible independently of the processing order.
+
+#ifndef ALICE3_CORE_COUNTERRANDOM_H_
+#define ALICE3_CORE_COUNTERRANDOM_H_
+
+#include <TRandom.h>
+
+#include <cstdint>
+
+namespace o2
+{
+namespace fastsim
+{
+
+class CounterRandom : public TRandom
+{
+ public:
+  CounterRandom() = default;
+  explicit CounterRandom(uint64_t key) { setStream(key); }
+  ~CounterRandom() override = default;
+
+  // key of the stream of a particle, built from the task seed and the collision and particle indices
+  static uint64_t streamKey(uint64_t seed, uint64_t collisionIndex, uint64_t particleIndex)
+  {
+    return mix(mix(mix(seed) ^ collisionIndex) ^ particleIndex);
+  }
+
+  // restart from the first number of the stream with the given key
+  void setStream(uint64_t key)
+  {
+    mKey = key;
+    mCounter = 0;
+  }
+  uint64_t getStream() const { return mKey; }
+  uint64_t getCounter() const { return mCounter; }
+
+  // uniform in ]0, 1[ with 53 bits of precision
+  Double_t Rndm() override
+  {
+    return ((mix(mKey + kGolden * ++mCounter) >> 11) + 0.5) * 0x1.0p-53;
+  }
+  void RndmArray(Int_t n, Float_t* array) override
+  {
+    for (Int_t i = 0; i < n; i++) {
+      array[i] = static_cast<Float_t>(Rndm());
+    }
+  }
+  void RndmArray(Int_t n, Double_t* array) override
+  {
+    for (Int_t i = 0; i < n; i++) {
+      array[i] = Rndm();
+    }
+  }
+  void SetSeed(ULong_t seed = 0) override { setStream(seed); }
+  UInt_t GetSeed() const override { return static_cast<UInt_t>(mKey); }
+
+ private:
+  static constexpr uint64_t kGolden = 0x9e3779b97f4a7c15ULL;
+
+  // splitmix64 finaliser
+  static uint64_t mix(uint64_t x)
+  {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  uint64_t mKey = 0;
+  uint64_t mCounter = 0;
+};
+
+} // namespace fastsim
+} // namespace o2
+
+#endif // ALICE3_CORE_COUNTERRANDOM_H_
@@ -39,7 +39,16 @@
 #include <CommonConstants/PhysicsConstants.h>
 #include <Framework/Logger.h>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <span>
 #include <string>
 
 namespace o2
@@ -49,6 +58,50 @@ namespace delphes
 
 /*****************************************************************/
 
+LUTFile::~LUTFile()
+{
+  if (mMapped)
+    munmap(const_cast<char*>(mData), mSize);
+}
+
+std::shared_ptr<const LUTFile> LUTFile::open(const std::string& filename, bool reopen)
+{
+  // the views are shared by filename, e.g. between the species using the same LUT and between smearers of different tasks
+  static std::mutex registryMutex;
+  static std::map<std::string, std::weak_ptr<const LUTFile>> registry;
+  std::lock_guard<std::mutex> lock(registryMutex);
+  if (auto opened = registry[filename].lock(); opened && !reopen)
+    return opened;
+
+  std::shared_ptr<LUTFile> lutFile(new LUTFile);
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return nullptr;
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) != 0 || static_cast<std::size_t>(fileStat.st_size) < sizeof(lutHeader_t)) {
+    close(fd);
+    return nullptr;
+  }
+  lutFile->mSize = fileStat.st_size;
+  void* data = mmap(nullptr, lutFile->mSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data != MAP_FAILED) {
+    lutFile->mData = static_cast<const char*>(data);
+    lutFile->mMapped = true;
+  } else {
+    std::ifstream input(filename, std::ifstream::binary);
+    lutFile->mBuffer.resize(lutFile->mSize);
+    input.read(lutFile->mBuffer.data(), lutFile->mSize);
+    if (static_cast<std::size_t>(input.gcount()) != lutFile->mSize)
+      return nullptr;
+    lutFile->mData = lutFile->mBuffer.data();
+  }
+  registry[filename] = lutFile;
+  return lutFile;
+}
+
+/*****************************************************************/
+
 bool TrackSmearer::loadTable(int pdg, const char* filename, bool forceReload)
 {
   if (!filename || filename[0] == '\0') {
@@ -83,77 +136,48 @@ bool TrackSmearer::loadTable(int pdg, const char* filename, bool forceReload)
     return loadTable(pdg, filename, forceReload);
   }
 
-  mLUTHeader[ipdg] = new lutHeader_t;
-
-  std::ifstream lutFile(filename, std::ifstream::binary);
-  if (!lutFile.is_open()) {
+  auto lutFile = LUTFile::open(filename, forceReload);
+  if (!lutFile) {
     LOG(info) << " --- cannot open covariance matrix file for PDG " << pdg << ": " << filename << std::endl;
-    delete mLUTHeader[ipdg];
-    mLUTHeader[ipdg] = nullptr;
-    return false;
-  }
-  lutFile.read(reinterpret_cast<char*>(mLUTHeader[ipdg]), sizeof(lutHeader_t));
-  if (lutFile.gcount() != sizeof(lutHeader_t)) {
-    LOG(info) << " --- troubles reading covariance matrix header for PDG " << pdg << ": " << filename << std::endl;
-    delete mLUTHeader[ipdg];
-    mLUTHeader[ipdg] = nullptr;
     return false;
   }
-  if (mLUTHeader[ipdg]->version != LUTCOVM_VERSION) {
-    LOG(info) << " --- LUT header version mismatch: expected/detected = " << LUTCOVM_VERSION << "/" << mLUTHeader[ipdg]->version << std::endl;
-    delete mLUTHeader[ipdg];
-    mLUTHeader[ipdg] = nullptr;
+  const lutHeader_t& lutHeader = lutFile->header();
+  if (lutHeader.version != LUTCOVM_VERSION) {
+    LOG(info) << " --- LUT header version mismatch: expected/detected = " << LUTCOVM_VERSION << "/" << lutHeader.version << std::endl;
     return false;
   }
   bool specialPdgCase = false;
   switch (pdg) {                         // Handle special cases
     case o2::constants::physics::kAlpha: // Special case: Allow Alpha particles to use He3 LUT
-      specialPdgCase = (mLUTHeader[ipdg]->pdg == o2::constants::physics::kHelium3);
+      specialPdgCase = (lutHeader.pdg == o2::constants::physics::kHelium3);
       if (specialPdgCase)
         LOG(info)
-          << " --- Alpha particles (PDG " << pdg << ") will use He3 LUT data (PDG " << mLUTHeader[ipdg]->pdg << ")" << std::endl;
+          << " --- Alpha particles (PDG " << pdg << ") will use He3 LUT data (PDG " << lutHeader.pdg << ")" << std::endl;
       break;
     default:
       break;
   }
-  if (mLUTHeader[ipdg]->pdg != pdg && !specialPdgCase) {
-    LOG(info) << " --- LUT header PDG mismatch: expected/detected = " << pdg << "/" << mLUTHeader[ipdg]->pdg << std::endl;
-    delete mLUTHeader[ipdg];
-    mLUTHeader[ipdg] = nullptr;
+  if (lutHeader.pdg != pdg && !specialPdgCase) {
+    LOG(info) << " --- LUT header PDG mismatch: expected/detected = " << pdg << "/" << lutHeader.pdg << std::endl;
     return false;
   }
-  const int nnch = mLUTHeader[ipdg]->nchmap.nbins;
-  const int nrad = mLUTHeader[ipdg]->radmap.nbins;
-  const int neta = mLUTHeader[ipdg]->etamap.nbins;
-  const int npt = mLUTHeader[ipdg]->ptmap.nbins;
-  mLUTEntry[ipdg] = new lutEntry_t****[nnch];
-  for (int inch = 0; inch < nnch; ++inch) {
-    mLUTEntry[ipdg][inch] = new lutEntry_t***[nrad];
-    for (int irad = 0; irad < nrad; ++irad) {
-      mLUTEntry[ipdg][inch][irad] = new lutEntry_t**[neta];
-      for (int ieta = 0; ieta < neta; ++ieta) {
-        mLUTEntry[ipdg][inch][irad][ieta] = new lutEntry_t*[npt];
-        for (int ipt = 0; ipt < npt; ++ipt) {
-          mLUTEntry[ipdg][inch][irad][ieta][ipt] = new lutEntry_t;
-          lutFile.read(reinterpret_cast<char*>(mLUTEntry[ipdg][inch][irad][ieta][ipt]), sizeof(lutEntry_t));
-          if (lutFile.gcount() != sizeof(lutEntry_t)) {
-            LOG(info) << " --- troubles reading covariance matrix entry for PDG " << pdg << ": " << filename << std::endl;
-            return false;
-          }
-        }
-      }
-    }
+  const std::size_t nEntries = static_cast<std::size_t>(lutHeader.nchmap.nbins) * lutHeader.radmap.nbins * lutHeader.etamap.nbins * lutHeader.ptmap.nbins;
+  if (lutFile->nEntries() < nEntries) {
+    LOG(info) << " --- troubles reading covariance matrix entry for PDG " << pdg << ": " << filename << std::endl;
+    return false;
   }
+  delete mLUTHeader[ipdg];
+  mLUTHeader[ipdg] = new lutHeader_t(lutHeader);
+  mLUTEntry[ipdg] = lutFile->entries();
+  mLUTFile[ipdg] = lutFile;
   LOG(info) << " --- read covariance matrix table for PDG " << pdg << ": " << filename << std::endl;
   mLUTHeader[ipdg]->print();
-
-  lutFile.close();
   return true;
 }
 
 /*****************************************************************/
 
-lutEntry_t* TrackSmearer::getLUTEntry(const int pdg, const float nch, const float radius, const float eta, const float pt, float& interpolatedEff)
+const lutEntry_t* TrackSmearer::getLUTEntry(const int pdg, const float nch, const float radius, const float eta, const float pt, float& interpolatedEff)
 {
   const int ipdg = getIndexPDG(pdg);
   if (!mLUTHeader[ipdg]) {
@@ -164,6 +188,7 @@ lutEntry_t* TrackSmearer::getLUTEntry(const int pdg, const float nch, const floa
   auto irad = mLUTHeader[ipdg]->radmap.find(radius);
   auto ieta = mLUTHeader[ipdg]->etamap.find(eta);
   auto ipt = mLUTHeader[ipdg]->ptmap.find(pt);
+  const lutEntry_t* entry = getLUTCell(ipdg, inch, irad, ieta, ipt);
 
   // Interpolate if requested
   auto fraction = mLUTHeader[ipdg]->nchmap.fracPositionWithinBin(nch);
@@ -173,16 +198,16 @@ lutEntry_t* TrackSmearer::getLUTEntry(const int pdg, const float nch, const floa
       switch (mWhatEfficiency) {
         case 1:
           if (inch < mLUTHeader[ipdg]->nchmap.nbins - 1) {
-            interpolatedEff = (1.5f - fraction) * mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff + (-0.5f + fraction) * mLUTEntry[ipdg][inch + 1][irad][ieta][ipt]->eff;
+            interpolatedEff = (1.5f - fraction) * entry->eff + (-0.5f + fraction) * getLUTCell(ipdg, inch + 1, irad, ieta, ipt)->eff;
           } else {
-            interpolatedEff = mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff;
+            interpolatedEff = entry->eff;
           }
           break;
         case 2:
           if (inch < mLUTHeader[ipdg]->nchmap.nbins - 1) {
-            interpolatedEff = (1.5f - fraction) * mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff2 + (-0.5f + fraction) * mLUTEntry[ipdg][inch + 1][irad][ieta][ipt]->eff2;
+            interpolatedEff = (1.5f - fraction) * entry->eff2 + (-0.5f + fraction) * getLUTCell(ipdg, inch + 1, irad, ieta, ipt)->eff2;
           } else {
-            interpolatedEff = mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff2;
+            interpolatedEff = entry->eff2;
           }
           break;
         default:
@@ -193,16 +218,16 @@ lutEntry_t* TrackSmearer::getLUTEntry(const int pdg, const float nch, const floa
       switch (mWhatEfficiency) {
         case 1:
           if (inch > 0 && comparisonValue < mLUTHeader[ipdg]->nchmap.max) {
-            interpolatedEff = (0.5f + fraction) * mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff + (0.5f - fraction) * mLUTEntry[ipdg][inch - 1][irad][ieta][ipt]->eff;
+            interpolatedEff = (0.5f + fraction) * entry->eff + (0.5f - fraction) * getLUTCell(ipdg, inch - 1, irad, ieta, ipt)->eff;
           } else {
-            interpolatedEff = mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff;
+            interpolatedEff = entry->eff;
           }
           break;
         case 2:
           if (inch > 0 && comparisonValue < mLUTHeader[ipdg]->nchmap.max) {
-            interpolatedEff = (0.5f + fraction) * mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff2 + (0.5f - fraction) * mLUTEntry[ipdg][inch - 1][irad][ieta][ipt]->eff2;
+            interpolatedEff = (0.5f + fraction) * entry->eff2 + (0.5f - fraction) * getLUTCell(ipdg, inch - 1, irad, ieta, ipt)->eff2;
           } else {
-            interpolatedEff = mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff2;
+            interpolatedEff = entry->eff2;
           }
           break;
         default:
@@ -212,23 +237,24 @@ lutEntry_t* TrackSmearer::getLUTEntry(const int pdg, const float nch, const floa
   } else {
     switch (mWhatEfficiency) {
       case 1:
-        interpolatedEff = mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff;
+        interpolatedEff = entry->eff;
         break;
       case 2:
-        interpolatedEff = mLUTEntry[ipdg][inch][irad][ieta][ipt]->eff2;
+        interpolatedEff = entry->eff2;
         break;
       default:
         LOG(fatal) << " --- getLUTEntry: unknown efficiency type " << mWhatEfficiency;
     }
   }
-  return mLUTEntry[ipdg][inch][irad][ieta][ipt];
+  return entry;
 } //;
 
 /*****************************************************************/
 
-bool TrackSmearer::smearTrack(O2Track& o2track, lutEntry_t* lutEntry, float interpolatedEff)
+bool TrackSmearer::smearTrack(O2Track& o2track, const lutEntry_t* lutEntry, float interpolatedEff)
 {
   bool isReconstructed = true;
+  TRandom* random = mRandom ? mRandom : gRandom;
   // generate efficiency
   if (mUseEfficiency) {
     auto eff = 0.;
@@ -242,7 +268,7 @@ bool TrackSmearer::smearTrack(O2Track& o2track, lutEntry_t* lutEntry, float inte
     }
     if (mInterpolateEfficiency)
       eff = interpolatedEff;
-    if (gRandom->Uniform() > eff)
+    if (random->Uniform() > eff)
       isReconstructed = false;
   }
 
@@ -257,7 +283,7 @@ bool TrackSmearer::smearTrack(O2Track& o2track, lutEntry_t* lutEntry, float inte
     double val = 0.;
     for (int j = 0; j < kParSize; ++j)
       val += lutEntry->eigvec[j][i] * o2track.getParam(j);
-    params[i] = gRandom->Gaus(val, std::sqrt(lutEntry->eigval[i]));
+    params[i] = random->Gaus(val, std::sqrt(lutEntry->eigval[i]));
   }
   // transform back params vector
   for (int i = 0; i < kParSize; ++i) {
@@ -291,18 +317,29 @@ bool TrackSmearer::smearTrack(O2Track& o2track, int pdg, float nch)
   }
   auto eta = o2track.getEta();
   float interpolatedEff = 0.0f;
-  lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, interpolatedEff);
+  const lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, interpolatedEff);
   if (!lutEntry || !lutEntry->valid)
     return false;
   return smearTrack(o2track, lutEntry, interpolatedEff);
 }
 
+/*****************************************************************/
+
+void TrackSmearer::smearTracks(std::span<O2Track> tracks, std::span<const int> pdgs, float nch, std::span<bool> isReconstructed)
+{
+  if (pdgs.size() < tracks.size() || isReconstructed.size() < tracks.size()) {
+    LOG(fatal) << "smearTracks: " << tracks.size() << " tracks but " << pdgs.size() << " pdg codes and " << isReconstructed.size() << " reconstruction flags";
+  }
+  for (std::size_t i = 0; i < tracks.size(); ++i)
+    isReconstructed[i] = smearTrack(tracks[i], pdgs[i], nch);
+}
+
 /*****************************************************************/
 // relative uncertainty on pt
 double TrackSmearer::getPtRes(const int pdg, const float nch, const float eta, const float pt)
 {
   float dummy = 0.0f;
-  lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
+  const lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
   auto val = std::sqrt(lutEntry->covm[14]) * lutEntry->pt;
   return val;
 }
@@ -312,7 +349,7 @@ double TrackSmearer::getPtRes(const int pdg, const float nch, const float eta, c
 double TrackSmearer::getEtaRes(const int pdg, const float nch, const float eta, const float pt)
 {
   float dummy = 0.0f;
-  lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
+  const lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
   auto sigmatgl = std::sqrt(lutEntry->covm[9]);                                  // sigmatgl2
   auto etaRes = std::fabs(std::sin(2.0 * std::atan(std::exp(-eta)))) * sigmatgl; // propagate tgl to eta uncertainty
   etaRes /= lutEntry->eta;                                                       // relative uncertainty
@@ -323,7 +360,7 @@ double TrackSmearer::getEtaRes(const int pdg, const float nch, const float eta,
 double TrackSmearer::getAbsPtRes(const int pdg, const float nch, const float eta, const float pt)
 {
   float dummy = 0.0f;
-  lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
+  const lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
   auto val = std::sqrt(lutEntry->covm[14]) * lutEntry->pt * lutEntry->pt;
   return val;
 }
@@ -333,7 +370,7 @@ double TrackSmearer::getAbsPtRes(const int pdg, const float nch, const float eta
 double TrackSmearer::getAbsEtaRes(const int pdg, const float nch, const float eta, const float pt)
 {
   float dummy = 0.0f;
-  lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
+  const lutEntry_t* lutEntry = getLUTEntry(pdg, nch, 0., eta, pt, dummy);
   auto sigmatgl = std::sqrt(lutEntry->covm[9]);                                  // sigmatgl2
   auto etaRes = std::fabs(std::sin(2.0 * std::atan(std::exp(-eta)))) * sigmatgl; // propagate tgl to eta uncertainty
   return etaRes;
@@ -361,7 +398,7 @@ double TrackSmearer::getEfficiency(const int pdg, const float nch, const float e
 //   return true;
 
 // #if 0
-//   lutEntry_t* lutEntry = getLUTEntry(track.PID, 0., 0., track.Eta, track.PT);
+//   const lutEntry_t* lutEntry = getLUTEntry(track.PID, 0., 0., track.Eta, track.PT);
 //   if (!lutEntry)
 //     return;
 
@@ -29,10 +29,15 @@
 
 #include <TRandom.h>
 
+#include <cstddef>
 #include <cstdio>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
 
 ///////////////////////////////
 /// DelphesO2/src/lutCovm.hh //
@@ -171,6 +176,33 @@ namespace o2
 namespace delphes
 {
 
+/// Read-only view of a LUT file, which is the lutHeader_t followed by the lutEntry_t cells in (nch, rad, eta, pt) row-major order
+/// as written by the LUT writer. The file is memory-mapped and the cells are used in place without parsing, so the pages are
+/// shared by all smearers, species and processes using the same file. If the file cannot be mapped it is read with a single read.
+class LUTFile
+{
+ public:
+  ~LUTFile();
+  LUTFile(const LUTFile&) = delete;
+  LUTFile& operator=(const LUTFile&) = delete;
+
+  /// opens filename, or returns the view already opened in this process unless reopen is set;
+  /// nullptr if the file cannot be read or is shorter than a header
+  static std::shared_ptr<const LUTFile> open(const std::string& filename, bool reopen = false);
+
+  const lutHeader_t& header() const { return *reinterpret_cast<const lutHeader_t*>(mData); }
+  const lutEntry_t* entries() const { return reinterpret_cast<const lutEntry_t*>(mData + sizeof(lutHeader_t)); }
+  std::size_t nEntries() const { return (mSize - sizeof(lutHeader_t)) / sizeof(lutEntry_t); }
+  bool isMapped() const { return mMapped; }
+
+ private:
+  LUTFile() = default;
+  const char* mData = nullptr;
+  std::size_t mSize = 0;
+  bool mMapped = false;
+  std::vector<char> mBuffer; // file content when it could not be mapped
+};
+
 class TrackSmearer
 {
 
@@ -186,10 +218,13 @@ class TrackSmearer
   void skipUnreconstructed(bool val) { mSkipUnreconstructed = val; }           //;
   void setWhatEfficiency(int val) { mWhatEfficiency = val; }                   //;
   lutHeader_t* getLUTHeader(int pdg) { return mLUTHeader[getIndexPDG(pdg)]; }  //;
-  lutEntry_t* getLUTEntry(const int pdg, const float nch, const float radius, const float eta, const float pt, float& interpolatedEff);
+  const lutEntry_t* getLUTEntry(const int pdg, const float nch, const float radius, const float eta, const float pt, float& interpolatedEff);
 
-  bool smearTrack(O2Track& o2track, lutEntry_t* lutEntry, float interpolatedEff);
+  bool smearTrack(O2Track& o2track, const lutEntry_t* lutEntry, float interpolatedEff);
   bool smearTrack(O2Track& o2track, int pdg, float nch);
+  /// smears tracks[i] with the LUT of pdgs[i], isReconstructed[i] being the return value of smearTrack;
+  /// the tracks are processed in order, so the random sequence is the same as for a loop over smearTrack
+  void smearTracks(std::span<O2Track> tracks, std::span<const int> pdgs, float nch, std::span<bool> isReconstructed);
   // bool smearTrack(Track& track, bool atDCA = true); // Only in DelphesO2
   double getPtRes(const int pdg, const float nch, const float eta, const float pt);
   double getEtaRes(const int pdg, const float nch, const float eta, const float pt);
@@ -250,16 +285,24 @@ class TrackSmearer
   }
   void setdNdEta(float val) { mdNdEta = val; }                                 //;
   void setCcdbManager(o2::ccdb::BasicCCDBManager* mgr) { mCcdbManager = mgr; } //;
+  void setRandom(TRandom* random) { mRandom = random; }                        // gRandom if not set
 
  protected:
   static constexpr unsigned int nLUTs = 9; // Number of LUT available
   lutHeader_t* mLUTHeader[nLUTs] = {nullptr};
-  lutEntry_t***** mLUTEntry[nLUTs] = {nullptr};
+  const lutEntry_t* mLUTEntry[nLUTs] = {nullptr}; // cells of the LUT, flat in (nch, rad, eta, pt) row-major order
+  std::shared_ptr<const LUTFile> mLUTFile[nLUTs]; // keeps the cells of mLUTEntry alive
+  const lutEntry_t* getLUTCell(int ipdg, int inch, int irad, int ieta, int ipt) const
+  {
+    const lutHeader_t* header = mLUTHeader[ipdg];
+    return mLUTEntry[ipdg] + ((static_cast<std::size_t>(inch) * header->radmap.nbins + irad) * header->etamap.nbins + ieta) * header->ptmap.nbins + ipt;
+  }
   bool mUseEfficiency = true;
   bool mInterpolateEfficiency = false;
   bool mSkipUnreconstructed = true; // don't smear tracks that are not reco'ed
   int mWhatEfficiency = 1;
   float mdNdEta = 1600.;
+  TRandom* mRandom = nullptr;
 
  private:
   o2::ccdb::BasicCCDBManager* mCcdbManager = nullptr;
@@ -658,7 +658,7 @@ int FastTracker::FastTrack(o2::track::TrackParCov inputTrack, o2::track::TrackPa
     eff *= iGoodHit;
   }
   if (mApplyEffCorrection) {
-    if (gRandom->Uniform() > eff)
+    if ((mRandom ? mRandom : gRandom)->Uniform() > eff)
       return -8;
   }
 
@@ -727,7 +727,7 @@ int FastTracker::FastTrack(o2::track::TrackParCov inputTrack, o2::track::TrackPa
     for (int j = 0; j < 5; ++j)
       val += eigVec[j][ii] * outputTrack.getParam(j);
     // smear parameters according to eigenvalues
-    params_[ii] = gRandom->Gaus(val, sqrt(eigVal[ii]));
+    params_[ii] = (mRandom ? mRandom : gRandom)->Gaus(val, sqrt(eigVal[ii]));
   }
 
   // invert eigenvector matrix
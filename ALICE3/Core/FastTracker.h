@@ -22,6 +22,8 @@
 #include <string>
 #include <vector>
 
+class TRandom;
+
 namespace o2
 {
 namespace fastsim
@@ -132,6 +134,9 @@ class FastTracker
   uint64_t GetCovMatOK() const { return covMatOK; }
   uint64_t GetCovMatNotOK() const { return covMatNotOK; }
 
+  // generator used for the hit efficiency and the smearing, gRandom if not set
+  void SetRandom(TRandom* random) { mRandom = random; }
+
  private:
   // Definition of detector layers
   std::vector<DetLayer> layers;
@@ -157,6 +162,7 @@ class FastTracker
   float lhcUPCScale = 1.0f;             /// scale factor for LHC UPC events
   float upcBackgroundMultiplier = 1.0f; /// multiplier for UPC background
   float fMinRadTrack = 132.f;           /// minimum radius for track propagation in cm
+  TRandom* mRandom = nullptr;           //! random number generator, gRandom if not set
 
   /// counters for covariance matrix statuses
   uint64_t covMatOK = 0;    /// cov mat has positive eigenvals
@@ -23,6 +23,7 @@
 /// \author Roberto Preghenella preghenella@bo.infn.it
 ///
 
+#include "ALICE3/Core/CounterRandom.h"
 #include "ALICE3/Core/DelphesO2TrackSmearer.h"
 #include "ALICE3/Core/DetLayer.h"
 #include "ALICE3/Core/FastTracker.h"
@@ -55,9 +56,13 @@
 #include <TPDGCode.h>
 #include <TRandom3.h>
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -160,6 +165,12 @@ struct OnTheFlyTracker {
     Configurable<bool> applyEffCorrection{"applyEffCorrection", true, "apply efficiency correction or not"};
   } fastPrimaryTrackerSettings;
 
+  struct : ConfigurableGroup {
+    std::string prefix = "batchSettings";
+    Configurable<bool> enableBatchMode{"enableBatchMode", false, "smear the primary tracks of a collision in one batch, each from its own random stream"};
+    Configurable<int> nThreads{"nThreads", 1, "number of worker threads smearing a batch, 0: all cores (the output does not depend on it)"};
+  } batchSettings;
+
   struct : ConfigurableGroup {
     std::string prefix = "cascadeDecaySettings"; // Cascade decay settings
     Configurable<bool> decayXi{"decayXi", false, "Manually decay Xi and fill tables with daughters"};
@@ -244,6 +255,21 @@ struct OnTheFlyTracker {
   // Track smearer
   o2::delphes::DelphesO2TrackSmearer mSmearer;
 
+  // Batch mode: primary tracks waiting for smearing and per-worker smearing machinery
+  struct PrimaryTrackJob {
+    o2::track::TrackParCov trackParCov; // perfect track, smeared in place
+    int64_t mcLabel;
+    int pdgCode;
+    float mcPt;
+    float t;
+    bool isDecayDaughter;
+    bool reconstructed;
+  };
+  std::vector<PrimaryTrackJob> primaryTrackJobs;
+  std::vector<std::unique_ptr<o2::fastsim::CounterRandom>> workerRandoms;
+  std::vector<o2::delphes::DelphesO2TrackSmearer> workerSmearers;
+  std::vector<o2::fastsim::FastTracker> workerPrimaryTrackers;
+
   // For processing and vertexing
   std::vector<TrackAlice3> tracksAlice3;
   std::vector<TrackAlice3> ghostTracksAlice3;
@@ -463,6 +489,61 @@ struct OnTheFlyTracker {
       // print fastTracker settings
       fastPrimaryTracker.Print();
     }
+
+    // one copy of the smearers per worker, each drawing from its own random streams
+    if (batchSettings.enableBatchMode) {
+      int nWorkers = batchSettings.nThreads > 0 ? batchSettings.nThreads.value : static_cast<int>(std::thread::hardware_concurrency());
+      nWorkers = std::max(nWorkers, 1);
+      LOGF(info, "Smearing primary tracks in batches with %d worker(s)", nWorkers);
+      for (int iWorker = 0; iWorker < nWorkers; iWorker++) {
+        workerRandoms.push_back(std::make_unique<o2::fastsim::CounterRandom>());
+        workerSmearers.push_back(mSmearer);
+        workerSmearers.back().setRandom(workerRandoms.back().get());
+        workerPrimaryTrackers.push_back(fastPrimaryTracker);
+        workerPrimaryTrackers.back().SetRandom(workerRandoms.back().get());
+      }
+    }
+  }
+
+  /// Smears the primary tracks collected for a collision
+  /// Each track is smeared from the random stream of its (collision, particle) pair with
+  /// the smearers of whichever worker picks it up, so the result does not depend on the
+  /// number of workers or on the order in which the jobs are processed.
+  void smearPrimaryTrackJobs(int64_t mcCollisionIndex)
+  {
+    std::atomic<std::size_t> nextJob{0};
+    auto work = [&](std::size_t iWorker) {
+      auto& random = *workerRandoms[iWorker];
+      for (std::size_t iJob = nextJob++; iJob < primaryTrackJobs.size(); iJob = nextJob++) {
+        auto& job = primaryTrackJobs[iJob];
+        random.setStream(o2::fastsim::CounterRandom::streamKey(seed, mcCollisionIndex, job.mcLabel));
+        job.reconstructed = true;
+        if (enablePrimarySmearing && !fastPrimaryTrackerSettings.fastTrackPrimaries) {
+          job.reconstructed = workerSmearers[iWorker].smearTrack(job.trackParCov, job.pdgCode, dNdEta);
+        } else if (fastPrimaryTrackerSettings.fastTrackPrimaries) {
+          o2::track::TrackParCov o2Track = job.trackParCov;
+          int nHits = workerPrimaryTrackers[iWorker].FastTrack(o2Track, job.trackParCov, dNdEta);
+          if (nHits < fastPrimaryTrackerSettings.minSiliconHits) {
+            job.reconstructed = false;
+          }
+        }
+      }
+    };
+
+    const std::size_t nWorkers = std::min(workerRandoms.size(), primaryTrackJobs.size());
+    if (nWorkers <= 1) {
+      work(0);
+      return;
+    }
+    std::vector<std::thread> threads;
+    threads.reserve(nWorkers - 1);
+    for (std::size_t iWorker = 1; iWorker < nWorkers; iWorker++) {
+      threads.emplace_back(work, iWorker);
+    }
+    work(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
   }
 
   /// Function to decay the xi
@@ -528,6 +609,7 @@ struct OnTheFlyTracker {
     ghostTracksAlice3.clear();
     bcData.clear();
     cascadesAlice3.clear();
+    primaryTrackJobs.clear();
 
     o2::dataformats::DCA dcaInfo;
     o2::dataformats::VertexBase vtx;
@@ -582,6 +664,42 @@ struct OnTheFlyTracker {
     histos.fill(HIST("hLUTMultiplicity"), dNdEta);
     gRandom->SetSeed(seed);
 
+    // QA and bookkeeping of a smeared primary track
+    auto addPrimaryTrack = [&](o2::track::TrackParCov const& trackParCov, bool reconstructed, int pdgCode, float mcPt, int64_t mcLabel, float t, bool isDecayDaughter) {
+      if (!reconstructed && !processUnreconstructedTracks) {
+        return;
+      }
+      if (TMath::IsNaN(trackParCov.getZ())) {
+        // capture rare smearing mistakes / corrupted tracks
+        histos.fill(HIST("hNaNBookkeeping"), 0.0f, 0.0f);
+        return;
+      } else {
+        histos.fill(HIST("hNaNBookkeeping"), 0.0f, 1.0f); // ok!
+      }
+
+      // Base QA (note: reco pT here)
+      histos.fill(HIST("hPtReconstructed"), trackParCov.getPt());
+      if (std::abs(pdgCode) == kElectron)
+        histos.fill(HIST("hPtReconstructedEl"), mcPt);
+      if (std::abs(pdgCode) == kPiPlus)
+        histos.fill(HIST("hPtReconstructedPi"), mcPt);
+      if (std::abs(pdgCode) == kKPlus)
+        histos.fill(HIST("hPtReconstructedKa"), mcPt);
+      if (std::abs(pdgCode) == kProton)
+        histos.fill(HIST("hPtReconstructedPr"), mcPt);
+
+      if (doExtraQA) {
+        histos.fill(HIST("hRecoTrackX"), trackParCov.getX());
+      }
+
+      // populate vector with track if we reco-ed it
+      if (reconstructed) {
+        tracksAlice3.push_back(TrackAlice3{trackParCov, mcLabel, t, 100.f * 1e-3, isDecayDaughter});
+      } else {
+        ghostTracksAlice3.push_back(TrackAlice3{trackParCov, mcLabel, t, 100.f * 1e-3, isDecayDaughter});
+      }
+    };
+
     for (const auto& mcParticle : mcParticles) {
       double xiDecayRadius2D = 0;
       double laDecayRadius2D = 0;
@@ -914,6 +1032,11 @@ struct OnTheFlyTracker {
         histos.fill(HIST("hSimTrackX"), trackParCov.getX());
       }
 
+      if (batchSettings.enableBatchMode) {
+        primaryTrackJobs.push_back(PrimaryTrackJob{trackParCov, mcParticle.globalIndex(), mcParticle.pdgCode(), mcParticle.pt(), t, isDecayDaughter, true});
+        continue;
+      }
+
       bool reconstructed = true;
       if (enablePrimarySmearing && !fastPrimaryTrackerSettings.fastTrackPrimaries) {
         reconstructed = mSmearer.smearTrack(trackParCov, mcParticle.pdgCode(), dNdEta);
@@ -926,37 +1049,14 @@ struct OnTheFlyTracker {
         }
       }
 
-      if (!reconstructed && !processUnreconstructedTracks) {
-        continue;
-      }
-      if (TMath::IsNaN(trackParCov.getZ())) {
-        // capture rare smearing mistakes / corrupted tracks
-        histos.fill(HIST("hNaNBookkeeping"), 0.0f, 0.0f);
-        continue;
-      } else {
-        histos.fill(HIST("hNaNBookkeeping"), 0.0f, 1.0f); // ok!
-      }
-
-      // Base QA (note: reco pT here)
-      histos.fill(HIST("hPtReconstructed"), trackParCov.getPt());
-      if (std::abs(mcParticle.pdgCode()) == kElectron)
-        histos.fill(HIST("hPtReconstructedEl"), mcParticle.pt());
-      if (std::abs(mcParticle.pdgCode()) == kPiPlus)
-        histos.fill(HIST("hPtReconstructedPi"), mcParticle.pt());
-      if (std::abs(mcParticle.pdgCode()) == kKPlus)
-        histos.fill(HIST("hPtReconstructedKa"), mcParticle.pt());
-      if (std::abs(mcParticle.pdgCode()) == kProton)
-        histos.fill(HIST("hPtReconstructedPr"), mcParticle.pt());
-
-      if (doExtraQA) {
-        histos.fill(HIST("hRecoTrackX"), trackParCov.getX());
-      }
+      addPrimaryTrack(trackParCov, reconstructed, mcParticle.pdgCode(), mcParticle.pt(), mcParticle.globalIndex(), t, isDecayDaughter);
+    }
 
-      // populate vector with track if we reco-ed it
-      if (reconstructed) {
-        tracksAlice3.push_back(TrackAlice3{trackParCov, mcParticle.globalIndex(), t, 100.f * 1e-3, isDecayDaughter});
-      } else {
-        ghostTracksAlice3.push_back(TrackAlice3{trackParCov, mcParticle.globalIndex(), t, 100.f * 1e-3, isDecayDaughter});
+    // batch mode: smear the collected primary tracks, then add them in particle order
+    if (batchSettings.enableBatchMode && !primaryTrackJobs.empty()) {
+      smearPrimaryTrackJobs(mcCollision.globalIndex());
+      for (const auto& job : primaryTrackJobs) {
+        addPrimaryTrack(job.trackParCov, job.reconstructed, job.pdgCode, job.mcPt, job.mcLabel, job.t, job.isDecayDaughter);
       }
     }
 
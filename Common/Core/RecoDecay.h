@@ -22,15 +22,185 @@
 #include <TMCProcess.h> // for VMC Particle Production Process
 #include <TPDGCode.h>   // for PDG codes
 
-#include <algorithm>   // std::find
-#include <array>       // std::array
-#include <cmath>       // std::abs, std::sqrt
-#include <cstddef>     // std::size_t
-#include <cstdint>     // intX_t
-#include <tuple>       // std::apply
-#include <type_traits> // std::decay_t
-#include <utility>     // std::move
-#include <vector>      // std::vector
+#include <algorithm>     // std::find
+#include <array>         // std::array
+#include <cmath>         // std::abs, std::sqrt
+#include <cstddef>       // std::size_t
+#include <cstdint>       // intX_t
+#include <tuple>         // std::apply
+#include <type_traits>   // std::decay_t
+#include <unordered_map> // std::unordered_map
+#include <utility>       // std::move
+#include <vector>        // std::vector
+
+/// Index of the Monte Carlo particle tree for fast MC matching
+///
+/// Caches the PDG codes, the mother and daughter index ranges, the production processes and the generator status codes
+/// of the MC particles of a dataframe, so that the RecoDecay MC matching functions can walk the particle tree
+/// without accessing the table and without allocating for every candidate.
+/// The mother-tree levels above particles with several mothers (e.g. hadrons from string fragmentation) are built on first use
+/// and shared by all particles with the same range of mothers. The charm-hadron origins are cached per particle.
+/// The index must be filled once per dataframe and can then be passed to the RecoDecay functions instead of the table of MC particles.
+class McAncestryIndex
+{
+ public:
+  /// Fills the index with the MC particles of the current dataframe and clears the caches.
+  /// \param particlesMC  table with MC particles
+  template <typename T>
+  void fill(const T& particlesMC)
+  {
+    const std::size_t nParticles = particlesMC.size();
+    offset = particlesMC.offset();
+    pdgCodes.assign(nParticles, 0);
+    motherRanges.assign(nParticles, {0, -1});
+    daughterRanges.assign(nParticles, {0, -1});
+    processes.assign(nParticles, -1);
+    genStatusCodes.assign(nParticles, 0);
+    for (const auto& particle : particlesMC) {
+      const auto row = particle.globalIndex() - offset;
+      pdgCodes[row] = particle.pdgCode();
+      if (particle.has_mothers()) {
+        motherRanges[row] = {particle.mothersIds().front(), particle.mothersIds().back()};
+      }
+      if (particle.has_daughters()) {
+        daughterRanges[row] = {particle.daughtersIds().front(), particle.daughtersIds().back()};
+      }
+      if constexpr (requires { particle.getProcess(); }) {
+        processes[row] = particle.getProcess();
+      }
+      if constexpr (requires { particle.getGenStatusCode(); }) {
+        genStatusCodes[row] = particle.getGenStatusCode();
+      }
+    }
+    levelIds.clear();
+    levels.clear();
+    levelBlocks.clear();
+    visitStamps.assign(nParticles, 0);
+    visitStamp = 0;
+    for (auto& origins : charmHadronOrigins) {
+      origins.assign(nParticles, -1);
+    }
+  }
+
+  /// Returns the index of an MC particle given either as a table row or as an index.
+  template <typename T>
+  static int64_t indexOf(const T& particle)
+  {
+    if constexpr (std::is_integral_v<T>) {
+      return particle;
+    } else {
+      return particle.globalIndex();
+    }
+  }
+
+  int pdgCode(int64_t index) const { return pdgCodes[index - offset]; }
+  bool hasMothers(int64_t index) const { return motherRanges[index - offset][0] <= motherRanges[index - offset][1]; }
+  int64_t motherFirst(int64_t index) const { return motherRanges[index - offset][0]; }
+  int64_t motherLast(int64_t index) const { return motherRanges[index - offset][1]; }
+  bool hasDaughters(int64_t index) const { return daughterRanges[index - offset][0] <= daughterRanges[index - offset][1]; }
+  int64_t daughterFirst(int64_t index) const { return daughterRanges[index - offset][0]; }
+  int64_t daughterLast(int64_t index) const { return daughterRanges[index - offset][1]; }
+  int process(int64_t index) const { return processes[index - offset]; }
+  int genStatusCode(int64_t index) const { return genStatusCodes[index - offset]; }
+
+  /// Walks the mother tree of a particle level by level, starting with the particle itself.
+  /// Each level (mothers of the particles of the previous level, without duplicates) is passed to visitLevel
+  /// as a range of particle indices. The walk stops when visitLevel returns true or when a level is empty.
+  /// \param index  index of the MC particle
+  /// \param visitLevel  callable with signature bool(const int64_t* begin, const int64_t* end)
+  template <typename F>
+  void forEachLevel(int64_t index, F&& visitLevel) const
+  {
+    // follow the chain of particles with a single mother without building any level
+    int64_t indexSingle = index;
+    while (true) {
+      if (visitLevel(&indexSingle, &indexSingle + 1)) {
+        return;
+      }
+      if (!hasMothers(indexSingle)) {
+        return;
+      }
+      if (motherFirst(indexSingle) != motherLast(indexSingle)) {
+        break;
+      }
+      indexSingle = motherFirst(indexSingle);
+    }
+    const auto [levelFirst, levelLast] = getLevelBlock(motherFirst(indexSingle), motherLast(indexSingle));
+    for (auto iLevel = levelFirst; iLevel < levelLast; ++iLevel) {
+      if (visitLevel(levelIds.data() + levels[iLevel][0], levelIds.data() + levels[iLevel][1])) {
+        return;
+      }
+    }
+  }
+
+  /// Starts a new set of visited particles for visitOnce.
+  void clearVisited() const { ++visitStamp; }
+
+  /// Marks a particle as visited.
+  /// \return true if the particle was not visited since the last call of clearVisited, false otherwise
+  bool visitOnce(int64_t index) const
+  {
+    auto& stamp = visitStamps[index - offset];
+    if (stamp == visitStamp) {
+      return false;
+    }
+    stamp = visitStamp;
+    return true;
+  }
+
+  /// Cached charm-hadron origin of a particle; -1 if not computed yet.
+  int8_t& charmHadronOrigin(int64_t index, bool searchUpToQuark) const { return charmHadronOrigins[searchUpToQuark][index - offset]; }
+
+ private:
+  /// Returns the range of levels of the mother tree above a range of mothers, building them on first use.
+  std::array<std::size_t, 2> getLevelBlock(int64_t first, int64_t last) const
+  {
+    const uint64_t key = (static_cast<uint64_t>(first) << 32) | static_cast<uint32_t>(last);
+    auto [itBlock, isNew] = levelBlocks.try_emplace(key);
+    if (!isNew) {
+      return itBlock->second;
+    }
+    const std::size_t levelFirst = levels.size();
+    std::size_t begin = levelIds.size();
+    for (auto iMother = first; iMother <= last; ++iMother) {
+      levelIds.push_back(iMother);
+    }
+    levels.push_back({begin, levelIds.size()});
+    while (true) {
+      const auto [previousBegin, previousEnd] = levels.back();
+      begin = levelIds.size();
+      clearVisited();
+      for (auto iPart = previousBegin; iPart < previousEnd; ++iPart) {
+        const auto indexPart = levelIds[iPart];
+        for (auto iMother = motherFirst(indexPart); iMother <= motherLast(indexPart); ++iMother) {
+          if (visitOnce(iMother)) {
+            levelIds.push_back(iMother);
+          }
+        }
+      }
+      if (levelIds.size() == begin) {
+        break;
+      }
+      levels.push_back({begin, levelIds.size()});
+    }
+    itBlock->second = {levelFirst, levels.size()};
+    return itBlock->second;
+  }
+
+  int64_t offset{0};                                    // global index of the first MC particle
+  std::vector<int> pdgCodes{};                          // PDG codes
+  std::vector<std::array<int64_t, 2>> motherRanges{};   // first and last mother indices; empty if last < first
+  std::vector<std::array<int64_t, 2>> daughterRanges{}; // first and last daughter indices; empty if last < first
+  std::vector<int> processes{};                         // production processes
+  std::vector<int> genStatusCodes{};                    // generator status codes
+
+  mutable std::vector<int64_t> levelIds{};                                        // particle indices of the built mother-tree levels
+  mutable std::vector<std::array<std::size_t, 2>> levels{};                       // begin and end of each level in levelIds
+  mutable std::unordered_map<uint64_t, std::array<std::size_t, 2>> levelBlocks{}; // levels above each range of mothers
+  mutable std::vector<uint32_t> visitStamps{};                                    // last visit of each particle
+  mutable uint32_t visitStamp{0};                                                 // current visit
+  mutable std::array<std::vector<int8_t>, 2> charmHadronOrigins{};                // cached origins without and with search up to quark
+};
 
 /// Base class for calculating properties of reconstructed decays
 ///
@@ -619,6 +789,66 @@ struct RecoDecay {
     return indexMother;
   }
 
+  /// Finds the mother of an MC particle by looking for the expected PDG code in the mother chain, using the index of the MC particle tree.
+  /// Gives the same result as getMother with the table of MC particles.
+  /// \tparam acceptFlavourOscillation  switch to accept decays where the mother oscillated (e.g. B0 -> B0bar)
+  /// \param mcAncestry  index of the MC particle tree
+  /// \param particle  MC particle or its index
+  /// \param pdgMother  expected mother PDG code
+  /// \param acceptAntiParticles  switch to accept the antiparticle of the expected mother
+  /// \param sign  antiparticle indicator of the found mother w.r.t. pdgMother; 1 if particle, -1 if antiparticle, 0 if mother not found
+  /// \param depthMax  maximum decay tree level to check; Mothers up to this level will be considered. If -1, all levels are considered.
+  /// \return index of the mother particle if found, -1 otherwise
+  template <bool acceptFlavourOscillation = false, typename T>
+  static int getMother(const McAncestryIndex& mcAncestry,
+                       const T& particle,
+                       int pdgMother,
+                       bool acceptAntiParticles = false,
+                       int8_t* sign = nullptr,
+                       int8_t depthMax = -1)
+  {
+    const auto indexParticle = McAncestryIndex::indexOf(particle);
+    int8_t sgn = 0;       // 1 if the expected mother is particle, -1 if antiparticle (w.r.t. pdgMother)
+    int indexMother = -1; // index of the final matched mother, if found
+    int stage = 0;        // mother tree level
+    if (sign) {
+      *sign = sgn;
+    }
+
+    mcAncestry.forEachLevel(indexParticle, [&](const int64_t* begin, const int64_t* end) {
+      if (depthMax >= 0 && stage >= depthMax) {
+        return true;
+      }
+      // As in the table-based search, the first matching mother of the last particle with a match in this level is taken.
+      for (const auto* iPart = begin; iPart != end; ++iPart) {
+        for (auto iMother = mcAncestry.motherFirst(*iPart); iMother <= mcAncestry.motherLast(*iPart); ++iMother) {
+          auto pdgParticleIMother = mcAncestry.pdgCode(iMother);
+          if (pdgParticleIMother == pdgMother) { // exact PDG match
+            sgn = 1;
+            indexMother = iMother;
+            break;
+          } else if (acceptAntiParticles && pdgParticleIMother == -pdgMother) { // antiparticle PDG match
+            sgn = -1;
+            indexMother = iMother;
+            break;
+          }
+        }
+      }
+      stage++;
+      return indexMother > -1;
+    });
+    if (sign) {
+      if constexpr (acceptFlavourOscillation) {
+        if (std::abs(mcAncestry.genStatusCode(indexParticle)) == StatusCodeAfterFlavourOscillation) { // take possible flavour oscillation of B0(s) mother into account
+          sgn *= -1;                                                                                  // select the sign of the mother after oscillation (and not before)
+        }
+      }
+      *sign = sgn;
+    }
+
+    return indexMother;
+  }
+
   /// Gets the complete list of indices of final-state daughters of an MC particle.
   /// \tparam checkProcess  switch to accept only decay daughters by checking the production process of MC particles
   /// \param particle  MC particle
@@ -692,6 +922,69 @@ struct RecoDecay {
     }
   }
 
+  /// Gets the complete list of indices of final-state daughters of an MC particle, using the index of the MC particle tree.
+  /// Gives the same result as getDaughters with the MC particle.
+  /// \tparam checkProcess  switch to accept only decay daughters by checking the production process of MC particles
+  /// \param mcAncestry  index of the MC particle tree
+  /// \param index  index of the MC particle
+  /// \param list  vector where the indices of final-state daughters will be added
+  /// \param arrPdgFinal  array of PDG codes of particles to be considered final if found
+  /// \param depthMax  maximum decay tree level; Daughters at this level (or beyond) will be considered final. If -1, all levels are considered.
+  /// \param stage  decay tree level; If different from 0, the particle itself will be added in the list in case it has no daughters.
+  template <bool checkProcess = false, std::size_t N>
+  static void getDaughters(const McAncestryIndex& mcAncestry,
+                           int64_t index,
+                           std::vector<int>* list,
+                           const std::array<int, N>& arrPdgFinal,
+                           int8_t depthMax = -1,
+                           int8_t stage = 0)
+  {
+    if (!list) {
+      return;
+    }
+    if constexpr (checkProcess) {
+      // If the particle is neither the original particle nor coming from a decay, we do nothing and exit.
+      if (stage != 0 && mcAncestry.process(index) != TMCProcess::kPDecay && mcAncestry.process(index) != TMCProcess::kPPrimary) { // decay products of HF hadrons are labeled as kPPrimary
+        return;
+      }
+    }
+
+    bool isFinal = false;                     // Flag to indicate the end of recursion
+    if (depthMax > -1 && stage >= depthMax) { // Maximum depth has been reached (or exceeded).
+      isFinal = true;
+    }
+    // Check whether there are any daughters.
+    if (!isFinal && !mcAncestry.hasDaughters(index)) {
+      // If the original particle has no daughters, we do nothing and exit.
+      if (stage == 0) {
+        return;
+      }
+      // If this is not the original particle, we are at the end of this branch and this particle is final.
+      isFinal = true;
+    }
+    auto pdgParticle = std::abs(mcAncestry.pdgCode(index));
+    // If this is not the original particle, check its PDG code.
+    if (!isFinal && stage > 0) {
+      // If the particle has daughters but is considered to be final, we label it as final.
+      for (auto pdgI : arrPdgFinal) {        // o2-linter: disable=const-ref-in-for-loop (int elements)
+        if (pdgParticle == std::abs(pdgI)) { // Accept antiparticles.
+          isFinal = true;
+          break;
+        }
+      }
+    }
+    // If the particle is labelled as final, we add this particle in the list of final daughters and exit.
+    if (isFinal) {
+      list->push_back(index);
+      return;
+    }
+    // Call itself to get daughters of daughters recursively.
+    stage++;
+    for (auto iDau = mcAncestry.daughterFirst(index); iDau <= mcAncestry.daughterLast(index); ++iDau) {
+      getDaughters<checkProcess>(mcAncestry, iDau, list, arrPdgFinal, depthMax, stage);
+    }
+  }
+
   /// Checks whether the reconstructed decay candidate is the expected decay.
   /// \tparam acceptFlavourOscillation  switch to accept decays where the mother oscillated (e.g. B0 -> B0bar)
   /// \tparam checkProcess  switch to accept only decay daughters by checking the production process of MC particles
@@ -877,6 +1170,163 @@ struct RecoDecay {
     return indexMother;
   }
 
+  /// Checks whether the reconstructed decay candidate is the expected decay, using the index of the MC particle tree.
+  /// Gives the same result as getMatchedMCRec with the table of MC particles.
+  /// \param mcAncestry  index of the MC particle tree
+  /// \note See getMatchedMCRec with the table of MC particles for the other parameters.
+  template <bool acceptFlavourOscillation = false, bool checkProcess = false, bool acceptIncompleteReco = false, bool acceptTrackDecay = false, bool acceptTrackIntWithMaterial = false, std::size_t N, typename U>
+  static int getMatchedMCRec(const McAncestryIndex& mcAncestry,
+                             const std::array<U, N>& arrDaughters,
+                             int pdgMother,
+                             std::array<int, N> arrPdgDaughters,
+                             bool acceptAntiParticles = false,
+                             int8_t* sign = nullptr,
+                             int depthMax = 1,
+                             int8_t* nPiToMu = nullptr,
+                             int8_t* nKaToPi = nullptr,
+                             int8_t* nInteractionsWithMaterial = nullptr)
+  {
+    int8_t coefFlavourOscillation = 1;         // 1 if no B0(s) flavour oscillation occured, -1 else
+    int8_t sgn = 0;                            // 1 if the expected mother is particle, -1 if antiparticle (w.r.t. pdgMother)
+    int8_t nPiToMuLocal = 0;                   // number of pion prongs decayed to a muon
+    int8_t nKaToPiLocal = 0;                   // number of kaon prongs decayed to a pion
+    int8_t nInteractionsWithMaterialLocal = 0; // number of interactions with material
+    int indexMother = -1;                      // index of the mother particle
+    std::vector<int> arrAllDaughtersIndex;     // vector of indices of all daughters of the mother of the first provided daughter
+    std::array<int, N> arrDaughtersIndex;      // array of indices of provided daughters
+    if (sign) {
+      *sign = sgn;
+    }
+    if constexpr (acceptFlavourOscillation) {
+      // Loop over decay candidate prongs to spot possible oscillation decay product
+      for (std::size_t iProng = 0; iProng < N; ++iProng) {
+        if (!arrDaughters[iProng].has_mcParticle()) {
+          return -1;
+        }
+        if (std::abs(mcAncestry.genStatusCode(arrDaughters[iProng].mcParticleId())) == StatusCodeAfterFlavourOscillation) { // oscillation decay product spotted
+          coefFlavourOscillation = -1;                                                                                       // select the sign of the mother after oscillation (and not before)
+          break;
+        }
+      }
+    }
+    // Loop over decay candidate prongs
+    for (std::size_t iProng = 0; iProng < N; ++iProng) {
+      if (!arrDaughters[iProng].has_mcParticle()) {
+        return -1;
+      }
+      int64_t indexI = arrDaughters[iProng].mcParticleId(); // ith daughter particle
+      if constexpr (acceptTrackDecay) {
+        // Replace the MC particle associated with the prong by its mother for π → μ and K → π.
+        if (mcAncestry.hasMothers(indexI)) {
+          auto indexMotherI = mcAncestry.motherFirst(indexI);
+          auto pdgI = std::abs(mcAncestry.pdgCode(indexI));
+          auto pdgMotherI = std::abs(mcAncestry.pdgCode(indexMotherI));
+          if (pdgI == PDG_t::kMuonMinus && pdgMotherI == PDG_t::kPiPlus) {
+            // π → μ
+            nPiToMuLocal++;
+            indexI = indexMotherI;
+          } else if (pdgI == PDG_t::kPiPlus && pdgMotherI == PDG_t::kKPlus) {
+            // K → π
+            nKaToPiLocal++;
+            indexI = indexMotherI;
+          }
+        }
+      }
+      if constexpr (acceptTrackIntWithMaterial) {
+        // Replace the MC particle associated with the prong by its mother for part → part due to material interactions.
+        // It keeps looking at the mother iteratively, until it finds a particle from decay or primary
+        auto process = mcAncestry.process(indexI);
+        auto pdgI = std::abs(mcAncestry.pdgCode(indexI));
+        auto pdgMotherI = pdgI;
+        while (process != TMCProcess::kPDecay && process != TMCProcess::kPPrimary && pdgI == pdgMotherI) {
+          if (!mcAncestry.hasMothers(indexI)) {
+            break;
+          }
+          auto indexMotherI = mcAncestry.motherFirst(indexI);
+          pdgI = std::abs(mcAncestry.pdgCode(indexI));
+          pdgMotherI = std::abs(mcAncestry.pdgCode(indexMotherI));
+          if (pdgI == pdgMotherI) {
+            indexI = indexMotherI;
+            process = mcAncestry.process(indexI);
+            if (process == TMCProcess::kPDecay || process == TMCProcess::kPPrimary) { // we found the original daughter that interacted with material
+              nInteractionsWithMaterialLocal++;
+            }
+          }
+        }
+      }
+      arrDaughtersIndex[iProng] = indexI;
+      // Get the list of daughter indices from the mother of the first prong.
+      if (iProng == 0) {
+        // Get the mother index and its sign.
+        // PDG code of the first daughter's mother determines whether the expected mother is a particle or antiparticle.
+        indexMother = getMother(mcAncestry, indexI, pdgMother, acceptAntiParticles, &sgn, depthMax);
+        // Check whether mother was found.
+        if (indexMother <= -1) {
+          return -1;
+        }
+        // Check the daughter indices.
+        if (!mcAncestry.hasDaughters(indexMother)) {
+          return -1;
+        }
+        // Check that the number of direct daughters is not larger than the number of expected final daughters.
+        if constexpr (!acceptIncompleteReco && !checkProcess) {
+          if (mcAncestry.daughterLast(indexMother) - mcAncestry.daughterFirst(indexMother) + 1 > static_cast<int>(N)) {
+            return -1;
+          }
+        }
+        // Get the list of actual final daughters.
+        getDaughters<checkProcess>(mcAncestry, indexMother, &arrAllDaughtersIndex, arrPdgDaughters, depthMax);
+        // Check whether the number of actual final daughters is equal to the number of expected final daughters (i.e. the number of provided prongs).
+        if (!acceptIncompleteReco && arrAllDaughtersIndex.size() != N) {
+          return -1;
+        }
+      }
+      // Check that the daughter is in the list of final daughters.
+      // (Check that the daughter is not a stepdaughter, i.e. particle pointing to the mother while not being its daughter.)
+      bool isDaughterFound = false; // Is the index of this prong among the remaining expected indices of daughters?
+      for (std::size_t iD = 0; iD < arrAllDaughtersIndex.size(); ++iD) {
+        if (arrDaughtersIndex[iProng] == arrAllDaughtersIndex[iD]) {
+          arrAllDaughtersIndex[iD] = -1; // Remove this index from the array of expected daughters. (Rejects twin daughters, i.e. particle considered twice as a daughter.)
+          isDaughterFound = true;
+          break;
+        }
+      }
+      if (!isDaughterFound) {
+        return -1;
+      }
+      // Check daughter's PDG code.
+      auto pdgParticleI = mcAncestry.pdgCode(indexI); // PDG code of the ith daughter
+      bool isPdgFound = false;                        // Is the PDG code of this daughter among the remaining expected PDG codes?
+      for (std::size_t iProngCp = 0; iProngCp < N; ++iProngCp) {
+        if (pdgParticleI == coefFlavourOscillation * sgn * arrPdgDaughters[iProngCp]) {
+          arrPdgDaughters[iProngCp] = 0; // Remove this PDG code from the array of expected ones.
+          isPdgFound = true;
+          break;
+        }
+      }
+      if (!isPdgFound) {
+        return -1;
+      }
+    }
+    if (sign) {
+      *sign = sgn;
+    }
+    if constexpr (acceptTrackDecay) {
+      if (nPiToMu) {
+        *nPiToMu = nPiToMuLocal;
+      }
+      if (nKaToPi) {
+        *nKaToPi = nKaToPiLocal;
+      }
+    }
+    if constexpr (acceptTrackIntWithMaterial) {
+      if (nInteractionsWithMaterial) {
+        *nInteractionsWithMaterial = nInteractionsWithMaterialLocal;
+      }
+    }
+    return indexMother;
+  }
+
   /// Checks whether the MC particle is the expected one.
   /// \tparam acceptFlavourOscillation  switch to accept decays where the mother oscillated (e.g. B0 -> B0bar)
   /// \tparam checkProcess  switch to accept only decay daughters by checking the production process of MC particles
@@ -1100,6 +1550,95 @@ struct RecoDecay {
     return OriginType::None;
   }
 
+  /// Finds the origin of charm hadrons, using the index of the MC particle tree.
+  /// Gives the same result as getCharmHadronOrigin with the table of MC particles. The result is cached per particle.
+  /// \param mcAncestry  index of the MC particle tree
+  /// \param particle  MC particle or its index
+  /// \param searchUpToQuark if true tag origin based on charm/beauty quark otherwise on the presence of a b-hadron or c-hadron, with c-hadrons themselves marked as prompt
+  /// \param idxBhadMothers optional vector of b-hadron indices (might be more than one in case of searchUpToQuark in case of beauty resonances)
+  /// \return an integer corresponding to the origin (0: none, 1: prompt, 2: nonprompt) as in OriginType
+  template <typename T>
+  static int getCharmHadronOrigin(const McAncestryIndex& mcAncestry,
+                                  const T& particle,
+                                  const bool searchUpToQuark = false,
+                                  std::vector<int>* idxBhadMothers = nullptr)
+  {
+    const auto indexParticle = McAncestryIndex::indexOf(particle);
+    auto& originCached = mcAncestry.charmHadronOrigin(indexParticle, searchUpToQuark);
+    if (originCached > -1 && !idxBhadMothers) { // the b-hadron mothers are not cached
+      return originCached;
+    }
+
+    auto pdgParticle = std::abs(mcAncestry.pdgCode(indexParticle));
+    bool couldBePrompt = false;
+    if (pdgParticle / PdgDivisorMeson == PDG_t::kCharm || pdgParticle / PdgDivisorBaryon == PDG_t::kCharm) {
+      couldBePrompt = true;
+    }
+    int origin = -1;
+    mcAncestry.forEachLevel(indexParticle, [&](const int64_t* begin, const int64_t* end) {
+      mcAncestry.clearVisited();
+      for (const auto* iPart = begin; iPart != end; ++iPart) { // check all the particles that were the mothers at the previous stage
+        if (!mcAncestry.hasMothers(*iPart)) {
+          continue;
+        }
+        // we exit immediately if searchUpToQuark is false and the first mother is a quark or a boson (a hadron should never be the mother of a parton)
+        if (!searchUpToQuark) {
+          auto pdgParticleIMother = std::abs(mcAncestry.pdgCode(mcAncestry.motherFirst(*iPart))); // PDG code of the mother
+          if (pdgParticleIMother <= PdgQuarkMax || (pdgParticleIMother >= PdgBosonMin && pdgParticleIMother <= PdgBosonMax)) {
+            origin = OriginType::Prompt;
+            return true;
+          }
+        }
+        for (auto iMother = mcAncestry.motherFirst(*iPart); iMother <= mcAncestry.motherLast(*iPart); ++iMother) { // loop over the mother particles of the analysed particle
+          if (!mcAncestry.visitOnce(iMother)) {                                                                      // if a mother was already checked at this stage, do not check it again
+            continue;
+          }
+          auto pdgParticleIMother = std::abs(mcAncestry.pdgCode(iMother)); // PDG code of the mother
+          if (searchUpToQuark) {
+            if (idxBhadMothers) {
+              if (pdgParticleIMother / PdgDivisorMeson == PDG_t::kBottom || // b mesons
+                  pdgParticleIMother / PdgDivisorBaryon == PDG_t::kBottom)  // b baryons
+              {
+                idxBhadMothers->push_back(iMother);
+              }
+            }
+            if (pdgParticleIMother == PDG_t::kBottom) { // b quark
+              origin = OriginType::NonPrompt;
+              return true;
+            }
+            if (pdgParticleIMother == PDG_t::kCharm) { // c quark
+              origin = OriginType::Prompt;
+              return true;
+            }
+          } else {
+            if (
+              (pdgParticleIMother / PdgDivisorMeson == PDG_t::kBottom || // b mesons
+               pdgParticleIMother / PdgDivisorBaryon == PDG_t::kBottom)  // b baryons
+            ) {
+              if (idxBhadMothers) {
+                idxBhadMothers->push_back(iMother);
+              }
+              origin = OriginType::NonPrompt;
+              return true;
+            }
+            if (
+              (pdgParticleIMother / PdgDivisorMeson == PDG_t::kCharm || // c mesons
+               pdgParticleIMother / PdgDivisorBaryon == PDG_t::kCharm)  // c baryons
+            ) {
+              couldBePrompt = true;
+            }
+          }
+        }
+      }
+      return false;
+    });
+    if (origin < 0) {
+      origin = (!searchUpToQuark && couldBePrompt) ? OriginType::Prompt : OriginType::None;
+    }
+    originCached = origin;
+    return origin;
+  }
+
   /// based on getCharmHardronOrigin in order to extend general particle
   /// Finding the origin (from charm hadronisation or beauty-hadron decay) of paritcle (b, c and others)
   /// \param particlesMC  table with MC particles
@@ -19,6 +19,7 @@
 #include <Framework/Logger.h>
 
 #include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <set>
@@ -39,6 +40,16 @@ bool TrackSelection::FulfillsITSHitRequirements(uint8_t itsClusterMap) const
   return true;
 }
 
+std::size_t TrackSelectionSet::add(TrackSelection const& selection)
+{
+  mSelections.push_back(selection);
+  auto& itsHitsPassed = mITSHitsPassed.emplace_back();
+  for (int itsClusterMap = 0; itsClusterMap < NITSClusterMaps; itsClusterMap++) {
+    itsHitsPassed[itsClusterMap] = selection.FulfillsITSHitRequirements(static_cast<uint8_t>(itsClusterMap));
+  }
+  return mSelections.size() - 1;
+}
+
 const std::string TrackSelection::mCutNames[static_cast<int>(TrackSelection::TrackCuts::kNCuts)] = {"TrackType", "PtRange", "EtaRange", "TPCNCls", "TPCCrossedRows", "TPCCrossedRowsOverNCls", "TPCChi2NDF", "TPCRefit", "ITSNCls", "ITSChi2NDF", "ITSRefit", "ITSHits", "GoldenChi2", "DCAxy", "DCAz", "TPCFracSharedCls"};
 
 void TrackSelection::SetTrackType(o2::aod::track::TrackTypeEnum trackType)
@@ -20,11 +20,15 @@
 
 #include <Rtypes.h>
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <set>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -242,6 +246,8 @@ class TrackSelection
   void print() const;
 
  private:
+  friend class TrackSelectionSet;
+
   bool FulfillsITSHitRequirements(uint8_t itsClusterMap) const;
 
   o2::aod::track::TrackTypeEnum mTrackType{o2::aod::track::TrackTypeEnum::Track};
@@ -274,4 +280,149 @@ class TrackSelection
   ClassDefNV(TrackSelection, 1);
 };
 
+// Evaluates several track selections in one pass over the tracks.
+// The quantities used by the cuts are read once per track and shared by all selections, the ITS
+// hit requirements are tabulated for all cluster maps and the cut flags are combined without
+// branching. The masks are the same as the ones of TrackSelection::IsSelectedMask.
+class TrackSelectionSet
+{
+ public:
+  using MaskType = uint16_t;
+  static constexpr MaskType AllCutsMask = (1u << static_cast<int>(TrackSelection::TrackCuts::kNCuts)) - 1;
+
+  // add a copy of a selection, returns its position in the masks of a track
+  std::size_t add(TrackSelection const& selection);
+  std::size_t size() const { return mSelections.size(); }
+  void clear()
+  {
+    mSelections.clear();
+    mITSHitsPassed.clear();
+  }
+
+  // equivalent of TrackSelection::IsSelected for a mask
+  static bool isSelected(MaskType mask) { return mask == AllCutsMask; }
+
+  // fill masks[i] with the mask of selection i for the given track
+  template <typename T>
+  void evaluate(T const& track, MaskType* masks) const
+  {
+    const TrackValues values(track);
+    for (std::size_t i = 0; i < mSelections.size(); i++) {
+      masks[i] = evaluateSelection(i, values);
+    }
+  }
+
+  // masks of all tracks of a table, the mask of selection i of track j is masks[j * size() + i]
+  // With nThreads > 1 the table is split in contiguous chunks which are evaluated in parallel.
+  template <typename T>
+  void evaluateAll(T const& tracks, std::vector<MaskType>& masks, int nThreads = 1) const
+  {
+    const std::size_t nTracks = tracks.size();
+    const std::size_t nSelections = size();
+    masks.resize(nTracks * nSelections);
+    if (nTracks == 0 || nSelections == 0) {
+      return;
+    }
+    auto evaluateChunk = [&](std::size_t first, std::size_t last) {
+      auto track = tracks.rawIteratorAt(first);
+      for (std::size_t iTrack = first; iTrack < last; ++iTrack, ++track) {
+        evaluate(track, masks.data() + iTrack * nSelections);
+      }
+    };
+
+    const std::size_t nChunks = std::clamp<std::size_t>(nTracks / MinChunkSize, 1, std::max(nThreads, 1));
+    if (nChunks == 1) {
+      evaluateChunk(0, nTracks);
+      return;
+    }
+    const std::size_t chunkSize = (nTracks + nChunks - 1) / nChunks;
+    std::vector<std::thread> threads;
+    threads.reserve(nChunks - 1);
+    for (std::size_t first = chunkSize; first < nTracks; first += chunkSize) {
+      threads.emplace_back(evaluateChunk, first, std::min(first + chunkSize, nTracks));
+    }
+    evaluateChunk(0, chunkSize);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+ private:
+  static constexpr std::size_t MinChunkSize = 4096; // tracks per thread below which no threads are started
+  static constexpr int NITSClusterMaps = 256;
+
+  // quantities of a track used by the cuts
+  struct TrackValues {
+    template <typename T>
+    explicit TrackValues(T const& track) : trackType(track.trackType()),
+                                           isRun2(trackType == o2::aod::track::Run2Track || trackType == o2::aod::track::Run2Tracklet),
+                                           hasTPC(track.hasTPC()),
+                                           hasITS(track.hasITS()),
+                                           itsClusterMap(track.itsClusterMap()),
+                                           itsNCls(track.itsNCls()),
+                                           tpcNClsFound(track.tpcNClsFound()),
+                                           tpcNClsCrossedRows(track.tpcNClsCrossedRows()),
+                                           flags(track.flags()),
+                                           pt(track.pt()),
+                                           eta(track.eta()),
+                                           tpcCrossedRowsOverFindableCls(track.tpcCrossedRowsOverFindableCls()),
+                                           tpcChi2NCl(track.tpcChi2NCl()),
+                                           itsChi2NCl(track.itsChi2NCl()),
+                                           absDcaXY(std::fabs(track.dcaXY())),
+                                           absDcaZ(std::fabs(track.dcaZ())),
+                                           tpcFractionSharedCls(track.tpcFractionSharedCls())
+    {
+    }
+    uint8_t trackType;
+    bool isRun2;
+    bool hasTPC;
+    bool hasITS;
+    uint8_t itsClusterMap;
+    int itsNCls;
+    int tpcNClsFound;
+    int tpcNClsCrossedRows;
+    uint32_t flags;
+    float pt;
+    float eta;
+    float tpcCrossedRowsOverFindableCls;
+    float tpcChi2NCl;
+    float itsChi2NCl;
+    float absDcaXY;
+    float absDcaZ;
+    float tpcFractionSharedCls;
+  };
+
+  static MaskType flag(bool passed, TrackSelection::TrackCuts cut) { return static_cast<MaskType>(passed) << static_cast<int>(cut); }
+
+  MaskType evaluateSelection(std::size_t iSelection, TrackValues const& track) const
+  {
+    using TrackCuts = TrackSelection::TrackCuts;
+    const TrackSelection& sel = mSelections[iSelection];
+    const float maxDcaXY = sel.mMaxDcaXYPtDep ? sel.mMaxDcaXYPtDep(track.pt) : sel.mMaxDcaXY;
+    const bool tpcRefit = track.isRun2 ? (track.flags & o2::aod::track::TPCrefit) != 0 : track.hasTPC;
+    const bool itsRefit = track.isRun2 ? (track.flags & o2::aod::track::ITSrefit) != 0 : track.hasITS;
+    const bool goldenChi2 = (track.flags & o2::aod::track::GoldenChi2) != 0;
+
+    return flag(track.trackType == sel.mTrackType, TrackCuts::kTrackType) |
+           flag((track.pt >= sel.mMinPt) & (track.pt <= sel.mMaxPt), TrackCuts::kPtRange) |
+           flag((track.eta >= sel.mMinEta) & (track.eta <= sel.mMaxEta), TrackCuts::kEtaRange) |
+           flag(track.tpcNClsFound >= sel.mMinNClustersTPC, TrackCuts::kTPCNCls) |
+           flag(track.tpcNClsCrossedRows >= sel.mMinNCrossedRowsTPC, TrackCuts::kTPCCrossedRows) |
+           flag(track.tpcCrossedRowsOverFindableCls >= sel.mMinNCrossedRowsOverFindableClustersTPC, TrackCuts::kTPCCrossedRowsOverNCls) |
+           flag(track.tpcChi2NCl <= sel.mMaxChi2PerClusterTPC, TrackCuts::kTPCChi2NDF) |
+           flag(!sel.mRequireTPCRefit | tpcRefit, TrackCuts::kTPCRefit) |
+           flag(track.itsNCls >= sel.mMinNClustersITS, TrackCuts::kITSNCls) |
+           flag(track.itsChi2NCl <= sel.mMaxChi2PerClusterITS, TrackCuts::kITSChi2NDF) |
+           flag(!sel.mRequireITSRefit | itsRefit, TrackCuts::kITSRefit) |
+           flag(mITSHitsPassed[iSelection][track.itsClusterMap], TrackCuts::kITSHits) |
+           flag(!(track.isRun2 & sel.mRequireGoldenChi2) | goldenChi2, TrackCuts::kGoldenChi2) |
+           flag(track.absDcaXY <= maxDcaXY, TrackCuts::kDCAxy) |
+           flag(track.absDcaZ <= sel.mMaxDcaZ, TrackCuts::kDCAz) |
+           flag(track.tpcFractionSharedCls <= sel.mMaxTPCFractionSharedCls, TrackCuts::kTPCFracSharedCls);
+  }
+
+  std::vector<TrackSelection> mSelections;
+  std::vector<std::array<bool, NITSClusterMaps>> mITSHitsPassed; // ITS hit requirements of each selection for all cluster maps
+};
+
 #endif // COMMON_CORE_TRACKSELECTION_H_
@@ -31,7 +31,9 @@
 #include <Framework/InitContext.h>
 #include <Framework/runDataProcessing.h>
 
+#include <cstddef>
 #include <cstdint>
+#include <vector>
 
 using namespace o2;
 using namespace o2::framework;
@@ -54,6 +56,7 @@ struct TrackSelectionTask {
   Configurable<float> ptMax{"ptMax", 1e10f, "Upper cut on pt for the track selected"};
   Configurable<float> etaMin{"etaMin", -0.8, "Lower cut on eta for the track selected"};
   Configurable<float> etaMax{"etaMax", 0.8, "Upper cut on eta for the track selected"};
+  Configurable<int> nThreads{"nThreads", 1, "number of threads evaluating the selections on chunks of the track table"};
 
   Produces<aod::TrackSelection> filterTable;
   Produces<aod::TrackSelectionExtension> filterTableDetail;
@@ -65,6 +68,19 @@ struct TrackSelectionTask {
   TrackSelection filtBit4;
   TrackSelection filtBit5;
 
+  // all selections above, evaluated together in one pass over the tracks
+  enum SelectionSlot : std::size_t {
+    kGlobal = 0,
+    kFiltBit1,
+    kFiltBit2,
+    kFiltBit3,
+    kFiltBit4,
+    kFiltBit5,
+    kGlobalSDD, // Run 2 only
+  };
+  TrackSelectionSet selections;
+  std::vector<TrackSelectionSet::MaskType> masks;
+
   void init(InitContext& initContext)
   {
     // Check which tables are used
@@ -142,6 +158,17 @@ struct TrackSelectionTask {
 
     LOG(info) << "setting up filtBit5 = getJEGlobalTrackSelectionRun2();";
     filtBit5 = getJEGlobalTrackSelectionRun2(); // Jet validation requires reduced set of cuts
+
+    // the order must match SelectionSlot
+    selections.add(globalTracks);
+    selections.add(filtBit1);
+    selections.add(filtBit2);
+    selections.add(filtBit3);
+    selections.add(filtBit4);
+    selections.add(filtBit5);
+    if (!isRun3) {
+      selections.add(globalTracksSDD);
+    }
   }
 
   void process(soa::Join<aod::FullTracks, aod::TracksDCA> const& tracks)
@@ -155,60 +182,25 @@ struct TrackSelectionTask {
     if (produceTable == 0 && produceFBextendedTable == 0) {
       return;
     }
-    if (isRun3) {
-      for (const auto& track : tracks) {
-
-        if (produceTable == 1) {
-          filterTable((uint8_t)0,
-                      globalTracks.IsSelectedMask(track),
-                      filtBit1.IsSelected(track),
-                      filtBit2.IsSelected(track),
-                      filtBit3.IsSelected(track),
-                      filtBit4.IsSelected(track),
-                      filtBit5.IsSelected(track));
-        }
-        if (produceFBextendedTable == 1) {
-          o2::aod::track::TrackSelectionFlags::flagtype trackflagGlob = globalTracks.IsSelectedMask(track);
-          o2::aod::track::TrackSelectionFlags::flagtype trackflagFB1 = filtBit1.IsSelectedMask(track);
-          o2::aod::track::TrackSelectionFlags::flagtype trackflagFB2 = filtBit2.IsSelectedMask(track);
-          // o2::aod::track::TrackSelectionFlags::flagtype trackflagFB3 = filtBit3.IsSelectedMask(track); // only temporarily commented, will be used
-          // o2::aod::track::TrackSelectionFlags::flagtype trackflagFB4 = filtBit4.IsSelectedMask(track);
-          // o2::aod::track::TrackSelectionFlags::flagtype trackflagFB5 = filtBit5.IsSelectedMask(track);
-
-          filterTableDetail(o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTrackType),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kPtRange),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kEtaRange),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTPCNCls),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTPCCrossedRows),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTPCCrossedRowsOverNCls),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTPCChi2NDF),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTPCRefit),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kITSNCls),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kITSChi2NDF),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kITSRefit),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kITSHits),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kGoldenChi2),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kDCAxy),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kDCAz),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagFB1, o2::aod::track::TrackSelectionFlags::kITSHits),
-                            o2::aod::track::TrackSelectionFlags::checkFlag(trackflagFB2, o2::aod::track::TrackSelectionFlags::kITSHits));
-        }
-      }
-      return;
-    }
+    selections.evaluateAll(tracks, masks, nThreads);
+    const std::size_t nSelections = selections.size();
+    for (std::size_t iTrack = 0; iTrack < static_cast<std::size_t>(tracks.size()); iTrack++) {
+      const TrackSelectionSet::MaskType* trackMasks = masks.data() + iTrack * nSelections;
+      const o2::aod::track::TrackSelectionFlags::flagtype trackflagGlob = trackMasks[kGlobal];
 
-    for (const auto& track : tracks) {
-      o2::aod::track::TrackSelectionFlags::flagtype trackflagGlob = globalTracks.IsSelectedMask(track);
       if (produceTable == 1) {
-        filterTable((uint8_t)globalTracksSDD.IsSelected(track),
-                    globalTracks.IsSelectedMask(track),
-                    filtBit1.IsSelected(track),
-                    filtBit2.IsSelected(track),
-                    filtBit3.IsSelected(track),
-                    filtBit4.IsSelected(track),
-                    filtBit5.IsSelected(track));
+        filterTable(isRun3 ? (uint8_t)0 : (uint8_t)TrackSelectionSet::isSelected(trackMasks[kGlobalSDD]),
+                    trackflagGlob,
+                    TrackSelectionSet::isSelected(trackMasks[kFiltBit1]),
+                    TrackSelectionSet::isSelected(trackMasks[kFiltBit2]),
+                    TrackSelectionSet::isSelected(trackMasks[kFiltBit3]),
+                    TrackSelectionSet::isSelected(trackMasks[kFiltBit4]),
+                    TrackSelectionSet::isSelected(trackMasks[kFiltBit5]));
       }
       if (produceFBextendedTable == 1) {
+        // the ITS hits of the filter bits 1 and 2 are only filled for Run 3
+        const bool itsHitsFB1 = isRun3 && o2::aod::track::TrackSelectionFlags::checkFlag(trackMasks[kFiltBit1], o2::aod::track::TrackSelectionFlags::kITSHits);
+        const bool itsHitsFB2 = isRun3 && o2::aod::track::TrackSelectionFlags::checkFlag(trackMasks[kFiltBit2], o2::aod::track::TrackSelectionFlags::kITSHits);
         filterTableDetail(o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kTrackType),
                           o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kPtRange),
                           o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kEtaRange),
@@ -224,8 +216,8 @@ struct TrackSelectionTask {
                           o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kGoldenChi2),
                           o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kDCAxy),
                           o2::aod::track::TrackSelectionFlags::checkFlag(trackflagGlob, o2::aod::track::TrackSelectionFlags::kDCAz),
-                          0,
-                          0);
+                          itsHitsFB1,
+                          itsHitsFB2);
       }
     }
   }
@@ -51,6 +51,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iterator>
 #include <limits>
 #include <map>
@@ -86,6 +87,96 @@ struct bcselEntry {
   int foundZDCId = -1;
 };
 
+// sorted flat index of BCs (global BC, BC index and payload) for the lookups in the BC and collision loops
+// entries can be flagged as removed without invalidating the positions of the others
+template <typename TPayload = float>
+class BcTimeline
+{
+ public:
+  void clear()
+  {
+    globalBCs.clear();
+    indices.clear();
+    payloads.clear();
+    removed.clear();
+  }
+
+  void reserve(std::size_t n)
+  {
+    globalBCs.reserve(n);
+    indices.reserve(n);
+    payloads.reserve(n);
+  }
+
+  void add(int64_t globalBC, int32_t index, TPayload payload = TPayload{})
+  {
+    globalBCs.push_back(globalBC);
+    indices.push_back(index);
+    payloads.push_back(payload);
+  }
+
+  // to be called after the last add(): sorts the entries if needed, keeps the last entry added for duplicated BCs
+  // (as assignments to a std::map would)
+  void build()
+  {
+    if (std::adjacent_find(globalBCs.begin(), globalBCs.end(), std::greater_equal<int64_t>()) != globalBCs.end()) {
+      std::vector<std::size_t> order(globalBCs.size());
+      for (std::size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+      }
+      std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return globalBCs[a] < globalBCs[b]; });
+      std::vector<int64_t> sortedGlobalBCs;
+      std::vector<int32_t> sortedIndices;
+      std::vector<TPayload> sortedPayloads;
+      for (std::size_t i = 0; i < order.size(); i++) {
+        if (i + 1 < order.size() && globalBCs[order[i + 1]] == globalBCs[order[i]]) {
+          continue; // overridden by a later entry with the same BC
+        }
+        sortedGlobalBCs.push_back(globalBCs[order[i]]);
+        sortedIndices.push_back(indices[order[i]]);
+        sortedPayloads.push_back(payloads[order[i]]);
+      }
+      globalBCs.swap(sortedGlobalBCs);
+      indices.swap(sortedIndices);
+      payloads.swap(sortedPayloads);
+    }
+    removed.assign(globalBCs.size(), false);
+  }
+
+  std::size_t size() const { return globalBCs.size(); }
+  bool empty() const { return globalBCs.empty(); }
+  int64_t globalBC(std::size_t pos) const { return globalBCs[pos]; }
+  int32_t index(std::size_t pos) const { return indices[pos]; }
+  TPayload payload(std::size_t pos) const { return payloads[pos]; }
+  bool isRemoved(std::size_t pos) const { return removed[pos]; }
+  void remove(std::size_t pos) { removed[pos] = true; }
+
+  // position of the first entry with BC >= globalBC
+  std::size_t lowerBound(int64_t globalBC) const { return std::lower_bound(globalBCs.begin(), globalBCs.end(), globalBC) - globalBCs.begin(); }
+  // position of the first entry with BC > globalBC
+  std::size_t upperBound(int64_t globalBC) const { return std::upper_bound(globalBCs.begin(), globalBCs.end(), globalBC) - globalBCs.begin(); }
+
+  // position of the entry with the given BC, size() if not found
+  std::size_t position(int64_t globalBC) const
+  {
+    std::size_t pos = lowerBound(globalBC);
+    return (pos < globalBCs.size() && globalBCs[pos] == globalBC) ? pos : globalBCs.size();
+  }
+
+  // BC index of the entry with the given BC, -1 if not found
+  int32_t find(int64_t globalBC) const
+  {
+    std::size_t pos = position(globalBC);
+    return pos < globalBCs.size() ? indices[pos] : -1;
+  }
+
+ private:
+  std::vector<int64_t> globalBCs;
+  std::vector<int32_t> indices;
+  std::vector<TPayload> payloads;
+  std::vector<bool> removed;
+};
+
 // bc selection configurables
 struct bcselConfigurables : o2::framework::ConfigurableGroup {
   std::string prefix = "bcselOpts";
@@ -167,6 +258,7 @@ class BcSelectionModule
   bool isGoodITSLayer3 = true;                              // default value
   bool isGoodITSLayer0123 = true;                           // default value
   bool isGoodITSLayersAll = true;                           // default value
+  BcTimeline<> bcsTimeline;                                 // index from global BC to BC id, rebuilt for every DF
 
   template <typename TContext, typename TBcSelOpts, typename THistoRegistry, typename TMetadataInfo>
   void init(TContext& context, TBcSelOpts const& external_bcselopts, THistoRegistry& histos, TMetadataInfo const& metadataInfo)
@@ -296,8 +388,13 @@ class BcSelectionModule
     bcselbuffer.clear();
     for (const auto& bc : bcs) {
       uint64_t timestamp = timestamps[bc.globalIndex()];
-      par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
-      aliases = ccdb->template getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", timestamp);
+      // fetch the objects only when the cached ones are not valid anymore
+      if (!par || !ccdb->isCachedObjectValid("EventSelection/EventSelectionParams", timestamp)) {
+        par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
+      }
+      if (!aliases || !ccdb->isCachedObjectValid("EventSelection/TriggerAliases", timestamp)) {
+        aliases = ccdb->template getForTimeStamp<TriggerAliases>("EventSelection/TriggerAliases", timestamp);
+      }
       // fill fired aliases
       uint32_t alias{0};
       uint64_t triggerMask = bc.triggerMask();
@@ -436,11 +533,13 @@ class BcSelectionModule
       return; // don't do anything in case configuration reported not ok
 
     int run = bcs.iteratorAt(0).runNumber();
-    // map from GlobalBC to BcId needed to find triggerBc
-    std::map<uint64_t, int32_t> mapGlobalBCtoBcId;
+    // index from GlobalBC to BcId needed to find triggerBc
+    bcsTimeline.clear();
+    bcsTimeline.reserve(bcs.size());
     for (const auto& bc : bcs) {
-      mapGlobalBCtoBcId[bc.globalBC()] = bc.globalIndex();
+      bcsTimeline.add(bc.globalBC(), bc.globalIndex());
     }
+    bcsTimeline.build();
 
     int triggerBcShift = bcselOpts.confTriggerBcShift;
     if (bcselOpts.confTriggerBcShift == 999) {                                                                                                                               // o2-linter: disable=magic-number (special shift for early 2022 data)
@@ -465,8 +564,8 @@ class BcSelectionModule
 
       uint32_t alias{0};
       // workaround for pp2022 (trigger info is shifted by -294 bcs)
-      int32_t triggerBcId = mapGlobalBCtoBcId[bc.globalBC() + triggerBcShift];
-      if (triggerBcId && aliases) {
+      int32_t triggerBcId = bcsTimeline.find(bc.globalBC() + triggerBcShift);
+      if (triggerBcId > 0 && aliases) {
         auto triggerBc = bcs.iteratorAt(triggerBcId);
         uint64_t triggerMask = triggerBc.triggerMask();
         for (const auto& al : aliases->GetAliasToTriggerMaskMap()) {
@@ -635,19 +734,7 @@ class EventSelectionModule
   std::vector<float> diffVzParMean;  // parameterization for mean of diff vZ by FT0 vs by tracks
   std::vector<float> diffVzParSigma; // parameterization for stddev of diff vZ by FT0 vs by tracks
 
-  int32_t findClosest(const int64_t globalBC, const std::map<int64_t, int32_t>& bcs)
-  {
-    auto it = bcs.lower_bound(globalBC);
-    int64_t bc1 = it->first;
-    int32_t index1 = it->second;
-    if (it != bcs.begin())
-      --it;
-    int64_t bc2 = it->first;
-    int32_t index2 = it->second;
-    int64_t dbc1 = std::abs(bc1 - globalBC);
-    int64_t dbc2 = std::abs(bc2 - globalBC);
-    return (dbc1 <= dbc2) ? index1 : index2;
-  }
+  BcTimeline<float> bcsWithTVX; // TVX-fired bcs with FT0 vZ, rebuilt for every DF
 
   // helper function to find median time in the vector of TOF or TRD-track times
   float getMedian(std::vector<float> v)
@@ -658,7 +745,8 @@ class EventSelectionModule
   }
 
   // helper function to find closest TVX signal in time and in zVtx
-  int64_t findBestGlobalBC(int64_t meanBC, int64_t sigmaBC, int32_t nContrib, float zVtxCol, std::map<int64_t, float>& mapGlobalBcVtxZ)
+  // (bcs already matched to a collision are flagged as removed in the timeline and skipped)
+  int64_t findBestGlobalBC(int64_t meanBC, int64_t sigmaBC, int32_t nContrib, float zVtxCol, const BcTimeline<float>& bcsWithTVX)
   {
     // protection against
     if (sigmaBC < 1)
@@ -671,16 +759,19 @@ class EventSelectionModule
     float zVtxSigma = 2.7 * std::pow(nContrib, -0.466) + 0.024;
     zVtxSigma += 1.0; // additional uncertainty due to imperfectections of FT0 time calibration
 
-    auto itMin = mapGlobalBcVtxZ.lower_bound(minBC);
-    auto itMax = mapGlobalBcVtxZ.upper_bound(maxBC);
+    std::size_t posMin = bcsWithTVX.lowerBound(minBC);
+    std::size_t posMax = bcsWithTVX.upperBound(maxBC);
 
     float bestChi2 = 1e+10;
     int64_t bestGlobalBC = 0;
-    for (std::map<int64_t, float>::iterator it = itMin; it != itMax; ++it) {
-      float chi2 = std::pow((it->second - zVtxCol) / zVtxSigma, 2) + std::pow(static_cast<float>(it->first - meanBC) / sigmaBC, 2.);
+    for (std::size_t pos = posMin; pos < posMax; ++pos) {
+      if (bcsWithTVX.isRemoved(pos)) {
+        continue;
+      }
+      float chi2 = std::pow((bcsWithTVX.payload(pos) - zVtxCol) / zVtxSigma, 2) + std::pow(static_cast<float>(bcsWithTVX.globalBC(pos) - meanBC) / sigmaBC, 2.);
       if (chi2 < bestChi2) {
         bestChi2 = chi2;
-        bestGlobalBC = it->first;
+        bestGlobalBC = bcsWithTVX.globalBC(pos);
       }
     }
 
@@ -804,10 +895,14 @@ class EventSelectionModule
     if (evselOpts.amIneeded.value == 0) {
       return; // dummy process
     }
+    EventSelectionParams* par = nullptr;
     for (const auto& col : collisions) {
       auto bc = col.template bc_as<soa::Join<aod::BCs, aod::Run2BCInfos, aod::Run2MatchedToBCSparse>>();
       uint64_t timestamp = timestamps[bc.globalIndex()];
-      EventSelectionParams* par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
+      // fetch the object only when the cached one is not valid anymore
+      if (!par || !ccdb->isCachedObjectValid("EventSelection/EventSelectionParams", timestamp)) {
+        par = ccdb->template getForTimeStamp<EventSelectionParams>("EventSelection/EventSelectionParams", timestamp);
+      }
       bool* applySelection = par->getSelection(evselOpts.muonSelection);
       if (evselOpts.isMC == 1) {
         applySelection[aod::evsel::kIsBBZAC] = 0;
@@ -890,11 +985,9 @@ class EventSelectionModule
       return; // don't do anything in case configuration reported not ok
 
     int run = bcs.iteratorAt(0).runNumber();
-    // create maps from globalBC to bc index for TVX-fired bcs
+    // create index from globalBC to bc index and FT0 vZ for TVX-fired bcs
     // to be used for closest TVX searches
-    std::map<int64_t, int32_t> mapGlobalBcWithTVX;
-    std::map<int64_t, int32_t> mapGlobalBcWithOrInFT0;
-    std::map<int64_t, float> mapGlobalBcVtxZ;
+    bcsWithTVX.clear();
     for (const auto& bc : bcs) {
       int64_t globalBC = bc.globalBC();
       // skip non-colliding bcs for data and anchored runs
@@ -902,19 +995,15 @@ class EventSelectionModule
         continue;
       }
 
-      if (bc.has_ft0()) {
-        mapGlobalBcWithOrInFT0[globalBC] = bc.globalIndex();
-      }
-
       auto selection = bcselbuffer[bc.globalIndex()].selection;
       if (bitcheck64(selection, aod::evsel::kIsTriggerTVX)) {
-        mapGlobalBcWithTVX[globalBC] = bc.globalIndex();
-        mapGlobalBcVtxZ[globalBC] = bc.has_ft0() ? bc.ft0().posZ() : 0;
+        bcsWithTVX.add(globalBC, bc.globalIndex(), bc.has_ft0() ? bc.ft0().posZ() : 0);
       }
     }
+    bcsWithTVX.build();
 
     // protection against empty FT0 maps
-    if (mapGlobalBcWithTVX.size() == 0) {
+    if (bcsWithTVX.empty()) {
       LOGP(error, "FT0 table is empty or corrupted. Filling evsel table with dummy values");
       for (const auto& col : cols) {
         auto bc = col.template bc_as<soa::Join<aod::BCs, aod::Run3MatchedToBCSparse>>();
@@ -1024,19 +1113,19 @@ class EventSelectionModule
 
         // matched with TOF --> precise time, match to TVX, but keep the nominal foundGlobalBC from pattern
         if (vIsVertexTOFmatched[colIndex]) {
-          std::map<int64_t, int32_t>::iterator it = mapGlobalBcWithTVX.find(foundGlobalBC);
-          if (it != mapGlobalBcWithTVX.end()) {
-            foundBCindex = it->second;                       // TVX at foundGlobalBC is found
+          int32_t tvxBCindex = bcsWithTVX.find(foundGlobalBC);
+          if (tvxBCindex >= 0) {
+            foundBCindex = tvxBCindex;                       // TVX at foundGlobalBC is found
           } else {                                           // check if TVX is in nearby bcs
-            it = mapGlobalBcWithTVX.find(foundGlobalBC + 1); // next bc
-            if (it != mapGlobalBcWithTVX.end()) {
+            tvxBCindex = bcsWithTVX.find(foundGlobalBC + 1); // next bc
+            if (tvxBCindex >= 0) {
               // foundGlobalBC += 1;
-              foundBCindex = it->second;
+              foundBCindex = tvxBCindex;
             } else {
-              it = mapGlobalBcWithTVX.find(foundGlobalBC - 1); // previous bc
-              if (it != mapGlobalBcWithTVX.end()) {
+              tvxBCindex = bcsWithTVX.find(foundGlobalBC - 1); // previous bc
+              if (tvxBCindex >= 0) {
                 // foundGlobalBC -= 1;
-                foundBCindex = it->second;
+                foundBCindex = tvxBCindex;
               } else {
                 foundBCindex = bc.globalIndex(); // keep original BC index
               }
@@ -1045,7 +1134,7 @@ class EventSelectionModule
         } // end of if TOF-matched vertex
         else { // for non-TOF and low-mult vertices, consider nearby nominal bcs
           int64_t meanBC = globalBC + TMath::Nint(sumHighPtTime / sumHighPtW / bcNS);
-          int64_t bestGlobalBC = findBestGlobalBC(meanBC, evselOpts.confSigmaBCforHighPtTracks, vNcontributors[colIndex], col.posZ(), mapGlobalBcVtxZ);
+          int64_t bestGlobalBC = findBestGlobalBC(meanBC, evselOpts.confSigmaBCforHighPtTracks, vNcontributors[colIndex], col.posZ(), bcsWithTVX);
           if (bestGlobalBC > 0) {
             foundGlobalBC = bestGlobalBC;
             // find closest nominal bc in pattern
@@ -1057,7 +1146,7 @@ class EventSelectionModule
                 break; // the bc in pattern is found
               }
             }
-            foundBCindex = mapGlobalBcWithTVX[bestGlobalBC];
+            foundBCindex = bcsWithTVX.find(bestGlobalBC);
           } else {                           // failed to find a proper TVX with small vZ difference
             foundBCindex = bc.globalIndex(); // keep original BC index
           }
@@ -1072,28 +1161,28 @@ class EventSelectionModule
         // for collisions with TOF tracks:
         // take bc corresponding to TOF track with median time
         int64_t tofGlobalBC = globalBC + TMath::Nint(getMedian(vTrackTimesTOF) / bcNS);
-        std::map<int64_t, int32_t>::iterator it = mapGlobalBcWithTVX.find(tofGlobalBC);
-        if (it != mapGlobalBcWithTVX.end()) {
-          foundGlobalBC = it->first;
-          foundBCindex = it->second;
+        int32_t tvxBCindex = bcsWithTVX.find(tofGlobalBC);
+        if (tvxBCindex >= 0) {
+          foundGlobalBC = tofGlobalBC;
+          foundBCindex = tvxBCindex;
         }
       } else if (nPvTracksTPCnoTOFnoTRD == 0 && nPvTracksTRDnoTOF > 0) {
         // for collisions with TRD tracks but without TOF or ITSTPC-only tracks:
         // take bc corresponding to TRD track with median time
         int64_t trdGlobalBC = globalBC + TMath::Nint(getMedian(vTrackTimesTRDnoTOF) / bcNS);
-        std::map<int64_t, int32_t>::iterator it = mapGlobalBcWithTVX.find(trdGlobalBC);
-        if (it != mapGlobalBcWithTVX.end()) {
-          foundGlobalBC = it->first;
-          foundBCindex = it->second;
+        int32_t tvxBCindex = bcsWithTVX.find(trdGlobalBC);
+        if (tvxBCindex >= 0) {
+          foundGlobalBC = trdGlobalBC;
+          foundBCindex = tvxBCindex;
         }
       } else if (nPvTracksHighPtTPCnoTOFnoTRD > 0) {
         // for collisions with high-pt ITSTPC-nonTOF-nonTRD tracks
         // search in 3*confSigmaBCforHighPtTracks range (3*4 bcs by default)
         int64_t meanBC = globalBC + TMath::Nint(sumHighPtTime / sumHighPtW / bcNS);
-        int64_t bestGlobalBC = findBestGlobalBC(meanBC, evselOpts.confSigmaBCforHighPtTracks, vNcontributors[colIndex], col.posZ(), mapGlobalBcVtxZ);
+        int64_t bestGlobalBC = findBestGlobalBC(meanBC, evselOpts.confSigmaBCforHighPtTracks, vNcontributors[colIndex], col.posZ(), bcsWithTVX);
         if (bestGlobalBC > 0) {
           foundGlobalBC = bestGlobalBC;
-          foundBCindex = mapGlobalBcWithTVX[bestGlobalBC];
+          foundBCindex = bcsWithTVX.find(bestGlobalBC);
         }
       }
 
@@ -1103,8 +1192,12 @@ class EventSelectionModule
       vFoundGlobalBC[colIndex] = foundGlobalBC > 0 ? foundGlobalBC : globalBC;
 
       // erase found global BC with TVX from the pool of bcs for the next loop over low-pt TPCnoTOFnoTRD collisions
-      if (foundBCindex >= 0)
-        mapGlobalBcVtxZ.erase(foundGlobalBC);
+      if (foundBCindex >= 0) {
+        std::size_t foundPos = bcsWithTVX.position(foundGlobalBC);
+        if (foundPos < bcsWithTVX.size()) {
+          bcsWithTVX.remove(foundPos);
+        }
+      }
     }
     // alternative matching: looking for collisions with the same nominal BC
     if (runLightIons >= 0) {
@@ -1127,9 +1220,9 @@ class EventSelectionModule
           int64_t globalBC = bc.globalBC();
           int64_t meanBC = globalBC + TMath::Nint(weightedTime / bcNS);
           int64_t sigmaBC = TMath::CeilNint(weightedSigma / bcNS);
-          int64_t bestGlobalBC = findBestGlobalBC(meanBC, sigmaBC, vNcontributors[colIndex], col.posZ(), mapGlobalBcVtxZ);
+          int64_t bestGlobalBC = findBestGlobalBC(meanBC, sigmaBC, vNcontributors[colIndex], col.posZ(), bcsWithTVX);
           vFoundGlobalBC[colIndex] = bestGlobalBC > 0 ? bestGlobalBC : globalBC;
-          vFoundBCindex[colIndex] = bestGlobalBC > 0 ? mapGlobalBcWithTVX[bestGlobalBC] : bc.globalIndex();
+          vFoundBCindex[colIndex] = bestGlobalBC > 0 ? bcsWithTVX.find(bestGlobalBC) : bc.globalIndex();
         }
         // fill pileup counter
         vCollisionsPerBc[vFoundBCindex[colIndex]]++;
@@ -1368,10 +1461,9 @@ class EventSelectionModule
       if (vIsFullInfoForOccupancy[colIndex] && vCanHaveAssocCollsWithinLastDriftTime[colIndex] && colIndexFirstRejectedByTFborderCut >= 0) {
         int64_t foundGlobalBC = vFoundGlobalBC[colIndex];
         int64_t tfId = (foundGlobalBC - bcSOR) / nBCsPerTF;
-        std::map<int64_t, int32_t>::iterator it = mapGlobalBcWithTVX.find(vFoundGlobalBC[colIndexFirstRejectedByTFborderCut]);
-        while (it != mapGlobalBcWithTVX.end()) {
-          int64_t thisFoundGlobalBC = it->first;
-          int32_t thisFoundBCindex = it->second;
+        for (std::size_t pos = bcsWithTVX.position(vFoundGlobalBC[colIndexFirstRejectedByTFborderCut]); pos < bcsWithTVX.size(); pos++) {
+          int64_t thisFoundGlobalBC = bcsWithTVX.globalBC(pos);
+          int32_t thisFoundBCindex = bcsWithTVX.index(pos);
           auto bc = bcs.iteratorAt(thisFoundBCindex);
           int64_t thisTFid = (bc.globalBC() - bcSOR) / nBCsPerTF;
           if (thisTFid != tfId)
@@ -1394,7 +1486,6 @@ class EventSelectionModule
               sumAmpFT0CInFullTimeWindow += wOccup * multT0C;
             }
           }
-          it++;
         }
       }
 
@@ -235,6 +235,8 @@ struct HfFilter { // Main struct for HF triggers
 
   // helper object
   HfFilterHelper helper;
+  // tracks associated to the current collision, propagated and selected once for all candidates
+  HfTrackCache trackCache;
 
   HistogramRegistry registry{"registry"};
 
@@ -448,6 +450,7 @@ struct HfFilter { // Main struct for HF triggers
       }
 
       auto thisCollId = collision.globalIndex();
+      trackCache.reset();
 
       if (applyOptimisation) {
         optimisationTreeCollisions(thisCollId);
@@ -592,24 +595,20 @@ struct HfFilter { // Main struct for HF triggers
 
         auto trackIdsThisCollision = trackIndices.sliceBy(trackIndicesPerCollision, thisCollId);
         auto tracksWithItsPid = soa::Attach<BigTracksPID, aod::pidits::ITSNSigmaPr, aod::pidits::ITSNSigmaDe>(tracks);
-        for (const auto& trackId : trackIdsThisCollision) { // start loop over tracks
-          auto track = tracksWithItsPid.rawIteratorAt(trackId.trackId());
-
-          if (track.globalIndex() == trackPos.globalIndex() || track.globalIndex() == trackNeg.globalIndex()) {
+        trackCache.fill(collision, trackIdsThisCollision, tracks, noMatCorr);
+        for (std::size_t iTrack{0}; iTrack < trackCache.size(); ++iTrack) { // start loop over tracks
+          if (trackCache.globalIndex(iTrack) == trackPos.globalIndex() || trackCache.globalIndex(iTrack) == trackNeg.globalIndex()) {
             continue;
           }
+          auto track = tracksWithItsPid.rawIteratorAt(trackCache.globalIndex(iTrack));
 
-          auto trackParThird = getTrackParCov(track);
-          std::array<float, 2> dcaThird{track.dcaXY(), track.dcaZ()};
-          std::array<float, 3> pVecThird = track.pVector();
-          if (track.collisionId() != thisCollId) {
-            o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParThird, 2.f, noMatCorr, &dcaThird);
-            getPxPyPz(trackParThird, pVecThird);
-          }
+          const auto& trackParThird = trackCache.trackPar(iTrack);
+          const auto& dcaThird = trackCache.dca(iTrack);
+          const auto& pVecThird = trackCache.pVec(iTrack);
 
           // Beauty with D0
           if (!keepEvent[kBeauty3P] && isD0BeautyTagged) {
-            int16_t isTrackSelected = helper.isSelectedTrackForSoftPionOrBeauty<kBeauty3P>(track, trackParThird, dcaThird);
+            int16_t isTrackSelected = trackCache.getSelection<kBeauty3P>(helper, tracks, iTrack);
             if (TESTBIT(isTrackSelected, kForBeauty) && ((TESTBIT(selD0InMass, 0) && track.sign() < 0) || (TESTBIT(selD0InMass, 1) && track.sign() > 0))) { // D0 pi-/K- and D0bar pi+/K+
               auto massCandD0Pi = RecoDecay::m(std::array{pVec2Prong, pVecThird}, std::array{massD0, massPi});
               auto massCandD0K = RecoDecay::m(std::array{pVec2Prong, pVecThird}, std::array{massD0, massKa});
@@ -716,21 +715,15 @@ struct HfFilter { // Main struct for HF triggers
                 if (activateQA) {
                   hMassVsPtC[kNCharmParticles]->Fill(ptCand, massDiffDstar);
                 }
-                for (const auto& trackIdB : trackIdsThisCollision) { // start loop over tracks
-                  auto trackB = tracks.rawIteratorAt(trackIdB.trackId());
-                  if (track.globalIndex() == trackB.globalIndex()) {
+                for (const auto& iTrackB : trackCache.getSelectedIndices<kBeauty3P>(helper, tracks, kForBeauty)) { // start loop over tracks selected for beauty
+                  if (track.globalIndex() == trackCache.globalIndex(iTrackB)) {
                     continue;
                   }
-                  auto trackParFourth = getTrackParCov(trackB);
-                  std::array<float, 2> dcaFourth{trackB.dcaXY(), trackB.dcaZ()};
-                  std::array<float, 3> pVecFourth = trackB.pVector();
-                  if (trackB.collisionId() != thisCollId) {
-                    o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParFourth, 2.f, noMatCorr, &dcaFourth);
-                    getPxPyPz(trackParFourth, pVecFourth);
-                  }
+                  const auto& trackParFourth = trackCache.trackPar(iTrackB);
+                  const auto& dcaFourth = trackCache.dca(iTrackB);
+                  const auto& pVecFourth = trackCache.pVec(iTrackB);
 
-                  auto isTrackFourthSelected = helper.isSelectedTrackForSoftPionOrBeauty<kBeauty3P>(trackB, trackParFourth, dcaFourth);
-                  if (track.sign() * trackB.sign() < 0 && TESTBIT(isTrackFourthSelected, kForBeauty)) {
+                  if (track.sign() * trackCache.sign(iTrackB) < 0) {
                     auto massCandB0 = RecoDecay::m(std::array{pVecBeauty3Prong, pVecFourth}, std::array{massDStar, massPi});
                     auto pVecBeauty4Prong = RecoDecay::pVec(pVec2Prong, pVecThird, pVecFourth);
                     auto ptCandBeauty4Prong = RecoDecay::pt(pVecBeauty4Prong);
@@ -803,7 +796,7 @@ struct HfFilter { // Main struct for HF triggers
           } // end beauty selection
 
           // 2-prong femto
-          if (!keepEvent[kFemto2P] && enableFemtoChannels->get(0u, 0u) && isD0CharmTagged && track.collisionId() == thisCollId) {
+          if (!keepEvent[kFemto2P] && enableFemtoChannels->get(0u, 0u) && isD0CharmTagged && !trackCache.isAmbiguous(iTrack)) {
             bool isProton = helper.isSelectedTrack4Femto(track, trackParThird, activateQA, hPrDePID[0], hPrDePID[1], kProtonForFemto);
             if (isProton) {
               float relativeMomentum = helper.computeRelativeMomentum(pVecThird, pVec2Prong, massD0);
@@ -821,7 +814,7 @@ struct HfFilter { // Main struct for HF triggers
 
           // Beauty with JPsi
           if (preselJPsiToMuMu) {
-            if (!TESTBIT(helper.isSelectedTrackForSoftPionOrBeauty<kBtoJPsiKa>(track, trackParThird, dcaThird), kForBeauty)) { // same for all channels
+            if (!TESTBIT(trackCache.getSelection<kBtoJPsiKa>(helper, tracks, iTrack), kForBeauty)) { // same for all channels
               continue;
             }
             std::array<float, 3> pVecPosVtx{}, pVecNegVtx{}, pVecThirdVtx{}, pVecFourthVtx{};
@@ -850,24 +843,16 @@ struct HfFilter { // Main struct for HF triggers
             }
             // 4-prong vertices
             if (!keepEvent[kBtoJPsiKstar] || !keepEvent[kBtoJPsiPhi] || !keepEvent[kBtoJPsiPrKa]) {
-              for (const auto& trackIdB : trackIdsThisCollision) { // start loop over tracks
+              for (const auto& iTrackB : trackCache.getSelectedIndices<kBtoJPsiKa>(helper, tracks, kForBeauty)) { // start loop over tracks selected for beauty (same for all channels)
                 if (keepEvent[kBtoJPsiKstar] && keepEvent[kBtoJPsiPhi] && keepEvent[kBtoJPsiPrKa]) {
                   break;
                 }
-                auto trackFourth = tracksWithItsPid.rawIteratorAt(trackIdB.trackId());
-                if (trackFourth.globalIndex() == track.globalIndex() || trackFourth.globalIndex() == trackPos.globalIndex() || trackFourth.globalIndex() == trackNeg.globalIndex() || trackFourth.sign() * track.sign() > 0) {
-                  continue;
-                }
-                auto trackParFourth = getTrackParCov(trackFourth);
-                std::array<float, 2> dcaFourth{trackFourth.dcaXY(), trackFourth.dcaZ()};
-                std::array<float, 3> pVecFourth = trackFourth.pVector();
-                if (trackFourth.collisionId() != thisCollId) {
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParFourth, 2.f, noMatCorr, &dcaFourth);
-                  getPxPyPz(trackParFourth, pVecFourth);
-                }
-                if (!TESTBIT(helper.isSelectedTrackForSoftPionOrBeauty<kBtoJPsiKa>(trackFourth, trackParFourth, dcaFourth), kForBeauty)) { // same for all channels
+                auto globalIndexFourth = trackCache.globalIndex(iTrackB);
+                if (globalIndexFourth == track.globalIndex() || globalIndexFourth == trackPos.globalIndex() || globalIndexFourth == trackNeg.globalIndex() || trackCache.sign(iTrackB) * track.sign() > 0) {
                   continue;
                 }
+                auto trackFourth = tracksWithItsPid.rawIteratorAt(globalIndexFourth);
+                const auto& trackParFourth = trackCache.trackPar(iTrackB);
                 int nVtxB{0};
                 try {
                   nVtxB = df4.process(trackParPos, trackParNeg, trackParThird, trackParFourth);
@@ -962,25 +947,18 @@ struct HfFilter { // Main struct for HF triggers
             if (!keepEvent[kV0Charm2P] && TESTBIT(selV0, kK0S)) {
 
               // we first look for a D*+
-              for (const auto& trackBachelorId : trackIdsThisCollision) { // start loop over tracks
-                auto trackBachelor = tracks.rawIteratorAt(trackBachelorId.trackId());
-                if (trackBachelor.globalIndex() == trackPos.globalIndex() || trackBachelor.globalIndex() == trackNeg.globalIndex() || trackBachelor.globalIndex() == v0.posTrackId() || trackBachelor.globalIndex() == v0.negTrackId()) {
+              for (const auto& iTrackBachelor : trackCache.getSelectedIndices<kV0Charm2P>(helper, tracks, kSoftPion)) { // start loop over tracks selected as soft pions
+                auto globalIndexBachelor = trackCache.globalIndex(iTrackBachelor);
+                if (globalIndexBachelor == trackPos.globalIndex() || globalIndexBachelor == trackNeg.globalIndex() || globalIndexBachelor == v0.posTrackId() || globalIndexBachelor == v0.negTrackId()) {
                   continue;
                 }
 
-                auto trackParBachelor = getTrackPar(trackBachelor);
-                std::array<float, 2> dcaBachelor{trackBachelor.dcaXY(), trackBachelor.dcaZ()};
-                std::array<float, 3> pVecBachelor = trackBachelor.pVector();
-                if (trackBachelor.collisionId() != thisCollId) {
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParBachelor, 2.f, noMatCorr, &dcaBachelor);
-                  getPxPyPz(trackParBachelor, pVecBachelor);
-                }
-
-                auto isTrackSelected = helper.isSelectedTrackForSoftPionOrBeauty<kV0Charm2P>(trackBachelor, trackParBachelor, dcaBachelor);
-                if (TESTBIT(isTrackSelected, kSoftPion) && ((TESTBIT(selD0InMass, 0) && trackBachelor.sign() > 0) || (TESTBIT(selD0InMass, 1) && trackBachelor.sign() < 0))) {
+                const auto& pVecBachelor = trackCache.pVec(iTrackBachelor);
+                auto signBachelor = trackCache.sign(iTrackBachelor);
+                if ((TESTBIT(selD0InMass, 0) && signBachelor > 0) || (TESTBIT(selD0InMass, 1) && signBachelor < 0)) {
                   std::array<float, 2> massDausD0{massPi, massKa};
                   auto massD0dau = massD0Cand;
-                  if (trackBachelor.sign() < 0) {
+                  if (signBachelor < 0) {
                     massDausD0[0] = massKa;
                     massDausD0[1] = massPi;
                     massD0dau = massD0BarCand;
@@ -1060,44 +1038,33 @@ struct HfFilter { // Main struct for HF triggers
 
         // 2-prong (D0 or D*) with proton for Lc resonances and ThetaC (3100)
         if (!keepEvent[kPrCharm2P] && isD0SignalTagged && (TESTBIT(selD0InMass, 0) || TESTBIT(selD0InMass, 1))) {
-          for (const auto& trackProtonId : trackIdsThisCollision) { // start loop over tracks selecting only protons
-            auto trackProton = tracks.rawIteratorAt(trackProtonId.trackId());
-            auto trackParBachelorProton = getTrackPar(trackProton);
-            if (trackProton.globalIndex() == trackPos.globalIndex() || trackProton.globalIndex() == trackNeg.globalIndex()) {
+          for (std::size_t iTrackProton{0}; iTrackProton < trackCache.size(); ++iTrackProton) { // start loop over tracks selecting only protons
+            if (trackCache.globalIndex(iTrackProton) == trackPos.globalIndex() || trackCache.globalIndex(iTrackProton) == trackNeg.globalIndex()) {
               continue;
             }
-            std::array<float, 2> dcaInfoBachProton;
-            if (trackProton.collisionId() != thisCollId) {
-              o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParBachelorProton, 2.f, noMatCorr, &dcaInfoBachProton);
-            }
+            auto trackProton = tracks.rawIteratorAt(trackCache.globalIndex(iTrackProton));
             std::array<float, 3> pVecProton = trackProton.pVector();
             bool isSelPIDProton = helper.isSelectedProton4CharmOrBeautyBaryons<false>(trackProton);
             if (isSelPIDProton) {
               if (!keepEvent[kPrCharm2P]) {
                 // we first look for a D*+
-                for (const auto& trackBachelorId : trackIdsThisCollision) { // start loop over tracks to find bachelor pion
+                for (const auto& iTrackBachelor : trackCache.getSelectedIndices<kPrCharm2P>(helper, tracks, kSoftPion)) { // start loop over tracks selected as soft pions
                   if (!helper.isSelectedProtonFromLcResoOrThetaC<true>(trackProton)) {
                     continue;
                   } // stop here if proton below pT threshold for thetaC to avoid computational losses
-                  auto trackBachelor = tracks.rawIteratorAt(trackBachelorId.trackId());
-                  if (trackBachelor.globalIndex() == trackPos.globalIndex() || trackBachelor.globalIndex() == trackNeg.globalIndex() || trackBachelor.globalIndex() == trackProton.globalIndex()) {
+                  auto globalIndexBachelor = trackCache.globalIndex(iTrackBachelor);
+                  if (globalIndexBachelor == trackPos.globalIndex() || globalIndexBachelor == trackNeg.globalIndex() || globalIndexBachelor == trackProton.globalIndex()) {
                     continue;
                   }
-                  auto trackParBachelor = getTrackPar(trackBachelor);
-                  std::array<float, 2> dcaBachelor{trackBachelor.dcaXY(), trackBachelor.dcaZ()};
-                  std::array<float, 3> pVecBachelor = trackBachelor.pVector();
-                  if (trackBachelor.collisionId() != thisCollId) {
-                    o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParBachelor, 2.f, noMatCorr, &dcaBachelor);
-                    getPxPyPz(trackParBachelor, pVecBachelor);
-                  }
-                  auto isTrackSelected = helper.isSelectedTrackForSoftPionOrBeauty<kPrCharm2P>(trackBachelor, trackParBachelor, dcaBachelor);
-                  if (TESTBIT(isTrackSelected, kSoftPion) && ((TESTBIT(selD0InMass, 0) && trackBachelor.sign() > 0) || (TESTBIT(selD0InMass, 1) && trackBachelor.sign() < 0))) {
+                  const auto& pVecBachelor = trackCache.pVec(iTrackBachelor);
+                  auto signBachelor = trackCache.sign(iTrackBachelor);
+                  if ((TESTBIT(selD0InMass, 0) && signBachelor > 0) || (TESTBIT(selD0InMass, 1) && signBachelor < 0)) {
                     if (pt2Prong < cutsPtDeltaMassCharmReso->get(3u, 12u)) {
                       continue;
                     }
                     std::array<float, 2> massDausD0{massPi, massKa};
                     auto massD0dau = massD0Cand;
-                    if (trackBachelor.sign() < 0) {
+                    if (signBachelor < 0) {
                       massDausD0[0] = massKa;
                       massDausD0[1] = massPi;
                       massD0dau = massD0BarCand;
@@ -1365,25 +1332,22 @@ struct HfFilter { // Main struct for HF triggers
 
         auto trackIdsThisCollision = trackIndices.sliceBy(trackIndicesPerCollision, thisCollId);
         auto tracksWithItsPid = soa::Attach<BigTracksPID, aod::pidits::ITSNSigmaPr, aod::pidits::ITSNSigmaDe>(tracks);
+        trackCache.fill(collision, trackIdsThisCollision, tracks, noMatCorr);
 
-        for (const auto& trackId : trackIdsThisCollision) { // start loop over track indices as associated to this collision in HF code
-          auto track = tracksWithItsPid.rawIteratorAt(trackId.trackId());
-          if (track.globalIndex() == trackFirst.globalIndex() || track.globalIndex() == trackSecond.globalIndex() || track.globalIndex() == trackThird.globalIndex()) {
+        for (std::size_t iTrack{0}; iTrack < trackCache.size(); ++iTrack) { // start loop over track indices as associated to this collision in HF code
+          if (trackCache.globalIndex(iTrack) == trackFirst.globalIndex() || trackCache.globalIndex(iTrack) == trackSecond.globalIndex() || trackCache.globalIndex(iTrack) == trackThird.globalIndex()) {
             continue;
           }
+          auto track = tracksWithItsPid.rawIteratorAt(trackCache.globalIndex(iTrack));
 
-          auto trackParFourth = getTrackParCov(track);
-          std::array<float, 2> dcaFourth{track.dcaXY(), track.dcaZ()};
-          std::array<float, 3> pVecFourth = track.pVector();
-          if (track.collisionId() != thisCollId) {
-            o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParFourth, 2.f, noMatCorr, &dcaFourth);
-            getPxPyPz(trackParFourth, pVecFourth);
-          }
+          const auto& trackParFourth = trackCache.trackPar(iTrack);
+          const auto& dcaFourth = trackCache.dca(iTrack);
+          const auto& pVecFourth = trackCache.pVec(iTrack);
 
           int charmParticleID[kNBeautyParticles - 3] = {o2::constants::physics::Pdg::kDPlus, o2::constants::physics::Pdg::kDS, o2::constants::physics::Pdg::kLambdaCPlus, o2::constants::physics::Pdg::kXiCPlus};
 
           float massCharmHypos[kNBeautyParticles - 3] = {massDPlus, massDs, massLc, massXic};
-          auto isTrackSelected = helper.isSelectedTrackForSoftPionOrBeauty<kBeauty4P>(track, trackParFourth, dcaFourth);
+          auto isTrackSelected = trackCache.getSelection<kBeauty4P>(helper, tracks, iTrack);
           if (track.sign() * sign3Prong < 0 && TESTBIT(isTrackSelected, kForBeauty)) {
             for (int iHypo{0}; iHypo < kNBeautyParticles - 3 && !keepEvent[kBeauty4P]; ++iHypo) {
               if (isBeautyTagged[iHypo] && (TESTBIT(is3ProngInMass[iHypo], 0) || TESTBIT(is3ProngInMass[iHypo], 1))) {
@@ -1500,11 +1464,10 @@ struct HfFilter { // Main struct for HF triggers
             // we need a candidate Lc->pKpi and a candidate soft kaon
 
             // look for SigmaC++ candidates
-            for (const auto& trackSoftPiId : trackIdsThisCollision) { // start loop over tracks (soft pi)
+            for (const auto& iTrackSoftPi : trackCache.getSelectedIndices<kSigmaCPPK>(helper, tracks, kSoftPionForSigmaC)) { // start loop over tracks (soft pi)
 
               // soft pion candidates
-              auto trackSoftPi = tracks.rawIteratorAt(trackSoftPiId.trackId());
-              auto globalIndexSoftPi = trackSoftPi.globalIndex();
+              auto globalIndexSoftPi = trackCache.globalIndex(iTrackSoftPi);
 
               // exclude tracks already used to build the 3-prong candidate
               if (globalIndexSoftPi == trackFirst.globalIndex() || globalIndexSoftPi == trackSecond.globalIndex() || globalIndexSoftPi == trackThird.globalIndex()) {
@@ -1518,82 +1481,71 @@ struct HfFilter { // Main struct for HF triggers
               }
 
               // check the candidate SigmaC++ charge
-              std::array<int, 4> chargesSc = {trackFirst.sign(), trackSecond.sign(), trackThird.sign(), trackSoftPi.sign()};
+              std::array<int, 4> chargesSc = {trackFirst.sign(), trackSecond.sign(), trackThird.sign(), trackCache.sign(iTrackSoftPi)};
               int chargeSc = std::accumulate(chargesSc.begin(), chargesSc.end(), 0); // SIGNED electric charge of SigmaC candidate
               if (std::abs(chargeSc) != 2) {
                 continue;
               }
 
-              // select soft pion candidates
-              auto trackParSoftPi = getTrackPar(trackSoftPi);
-              std::array<float, 2> dcaSoftPi{trackSoftPi.dcaXY(), trackSoftPi.dcaZ()};
-              std::array<float, 3> pVecSoftPi = trackSoftPi.pVector();
-              if (trackSoftPi.collisionId() != thisCollId) {
-                // This is a track reassociated to this PV by the track-to-collision-associator
-                // Let's propagate this track to it, and calculate dcaXY, dcaZ
-                o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParSoftPi, 2.f, noMatCorr, &dcaSoftPi);
-                getPxPyPz(trackParSoftPi, pVecSoftPi);
-              }
-              int16_t isSoftPionSelected = helper.isSelectedTrackForSoftPionOrBeauty<kSigmaCPPK>(trackSoftPi, trackParSoftPi, dcaSoftPi);
-              if (TESTBIT(isSoftPionSelected, kSoftPionForSigmaC) /*&& (TESTBIT(is3Prong[2], 0) || TESTBIT(is3Prong[2], 1))*/) {
+              // soft pion candidates already selected, with momentum at the PV also for tracks reassociated by the track-to-collision-associator
+              const auto& pVecSoftPi = trackCache.pVec(iTrackSoftPi);
+
+              // check the mass of the SigmaC++ candidate
+              auto pVecSigmaC = RecoDecay::pVec(pVecFirst, pVecSecond, pVecThird, pVecSoftPi);
+              auto ptSigmaC = RecoDecay::pt(pVecSigmaC);
+              int8_t whichSigmaC = helper.isSelectedSigmaCInDeltaMassRange<2>(pVecFirst, pVecThird, pVecSecond, pVecSoftPi, ptSigmaC, is3Prong[2], hMassVsPtC[kNCharmParticles + 9], activateQA);
+              if (whichSigmaC > 0) {
+                /// let's build a candidate SigmaC++K- pair
+                /// and keep it only if:
+                ///   - it has the correct charge (±1)
+                ///   - it is in the correct mass range
+
+                // check the charge for SigmaC++K- candidates
+                if (std::abs(chargeSc + track.sign()) != 1) {
+                  continue;
+                }
 
-                // check the mass of the SigmaC++ candidate
-                auto pVecSigmaC = RecoDecay::pVec(pVecFirst, pVecSecond, pVecThird, pVecSoftPi);
-                auto ptSigmaC = RecoDecay::pt(pVecSigmaC);
-                int8_t whichSigmaC = helper.isSelectedSigmaCInDeltaMassRange<2>(pVecFirst, pVecThird, pVecSecond, pVecSoftPi, ptSigmaC, is3Prong[2], hMassVsPtC[kNCharmParticles + 9], activateQA);
-                if (whichSigmaC > 0) {
-                  /// let's build a candidate SigmaC++K- pair
-                  /// and keep it only if:
-                  ///   - it has the correct charge (±1)
-                  ///   - it is in the correct mass range
+                // check the invariant mass
+                float massSigmaCPKPi{-999.}, massSigmaCPiKP{-999.}, deltaMassXicResoPKPi{-999.}, deltaMassXicResoPiKP{-999.};
+                float ptSigmaCKaon = RecoDecay::pt(pVecSigmaC, pVecFourth);
 
-                  // check the charge for SigmaC++K- candidates
-                  if (std::abs(chargeSc + track.sign()) != 1) {
-                    continue;
+                if (ptSigmaCKaon > cutsPtDeltaMassCharmReso->get(2u, 10u)) {
+                  if (TESTBIT(whichSigmaC, 0)) {
+                    massSigmaCPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massProton, massKa, massPi, massPi});
+                    deltaMassXicResoPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, pVecFourth}, std::array{massProton, massKa, massPi, massPi, massKa}) - massSigmaCPKPi;
                   }
+                  if (TESTBIT(whichSigmaC, 1)) {
+                    massSigmaCPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massPi, massKa, massProton, massPi});
+                    deltaMassXicResoPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, pVecFourth}, std::array{massPi, massKa, massProton, massPi, massKa}) - massSigmaCPiKP;
+                  }
+                  bool isPKPiOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPKPi && deltaMassXicResoPKPi < cutsPtDeltaMassCharmReso->get(1u, 10u));
+                  bool isPiKPOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPiKP && deltaMassXicResoPiKP < cutsPtDeltaMassCharmReso->get(1u, 10u));
+                  if (isPKPiOk || isPiKPOk) {
+                    /// This is a good SigmaC++K- event
+                    keepEvent[kSigmaCPPK] = true;
 
-                  // check the invariant mass
-                  float massSigmaCPKPi{-999.}, massSigmaCPiKP{-999.}, deltaMassXicResoPKPi{-999.}, deltaMassXicResoPiKP{-999.};
-                  float ptSigmaCKaon = RecoDecay::pt(pVecSigmaC, pVecFourth);
-
-                  if (ptSigmaCKaon > cutsPtDeltaMassCharmReso->get(2u, 10u)) {
-                    if (TESTBIT(whichSigmaC, 0)) {
-                      massSigmaCPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massProton, massKa, massPi, massPi});
-                      deltaMassXicResoPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, pVecFourth}, std::array{massProton, massKa, massPi, massPi, massKa}) - massSigmaCPKPi;
-                    }
-                    if (TESTBIT(whichSigmaC, 1)) {
-                      massSigmaCPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massPi, massKa, massProton, massPi});
-                      deltaMassXicResoPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, pVecFourth}, std::array{massPi, massKa, massProton, massPi, massKa}) - massSigmaCPiKP;
-                    }
-                    bool isPKPiOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPKPi && deltaMassXicResoPKPi < cutsPtDeltaMassCharmReso->get(1u, 10u));
-                    bool isPiKPOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPiKP && deltaMassXicResoPiKP < cutsPtDeltaMassCharmReso->get(1u, 10u));
-                    if (isPKPiOk || isPiKPOk) {
-                      /// This is a good SigmaC++K- event
-                      keepEvent[kSigmaCPPK] = true;
-
-                      /// QA plot
-                      if (activateQA) {
-                        if (isPKPiOk) {
-                          if (TESTBIT(whichSigmaC, 2)) {
-                            hMassVsPtC[kNCharmParticles + 11]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
-                          }
-                          if (TESTBIT(whichSigmaC, 3)) {
-                            hMassVsPtC[kNCharmParticles + 12]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
-                          }
+                    /// QA plot
+                    if (activateQA) {
+                      if (isPKPiOk) {
+                        if (TESTBIT(whichSigmaC, 2)) {
+                          hMassVsPtC[kNCharmParticles + 11]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
                         }
-                        if (isPiKPOk) {
-                          if (TESTBIT(whichSigmaC, 2)) {
-                            hMassVsPtC[kNCharmParticles + 11]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
-                          }
-                          if (TESTBIT(whichSigmaC, 3)) {
-                            hMassVsPtC[kNCharmParticles + 12]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
-                          }
+                        if (TESTBIT(whichSigmaC, 3)) {
+                          hMassVsPtC[kNCharmParticles + 12]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
+                        }
+                      }
+                      if (isPiKPOk) {
+                        if (TESTBIT(whichSigmaC, 2)) {
+                          hMassVsPtC[kNCharmParticles + 11]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
+                        }
+                        if (TESTBIT(whichSigmaC, 3)) {
+                          hMassVsPtC[kNCharmParticles + 12]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
                         }
                       }
                     }
                   }
                 }
-              } // end SigmaC++ candidate
+              }
             } // end loop over tracks (soft pi)
           } // end candidate Lc->pKpi
         } // end loop over tracks
@@ -1711,11 +1663,10 @@ struct HfFilter { // Main struct for HF triggers
             // we pair SigmaC0 with V0
             if (!keepEvent[kSigmaC0K0] && (isGoodLcToPKPi || isGoodLcToPiKP) && TESTBIT(selV0, kK0S)) {
               // look for SigmaC0 candidates
-              for (const auto& trackSoftPiId : trackIdsThisCollision) { // start loop over tracks (soft pi)
+              for (const auto& iTrackSoftPi : trackCache.getSelectedIndices<kSigmaC0K0>(helper, tracks, kSoftPionForSigmaC)) { // start loop over tracks (soft pi)
 
                 // soft pion candidates
-                auto trackSoftPi = tracks.rawIteratorAt(trackSoftPiId.trackId());
-                auto globalIndexSoftPi = trackSoftPi.globalIndex();
+                auto globalIndexSoftPi = trackCache.globalIndex(iTrackSoftPi);
 
                 // exclude tracks already used to build the 3-prong candidate
                 if (globalIndexSoftPi == trackFirst.globalIndex() || globalIndexSoftPi == trackSecond.globalIndex() || globalIndexSoftPi == trackThird.globalIndex() || globalIndexSoftPi == v0.posTrackId() || globalIndexSoftPi == v0.negTrackId()) {
@@ -1724,68 +1675,57 @@ struct HfFilter { // Main struct for HF triggers
                 }
 
                 // check the candidate SigmaC0 charge
-                std::array<int, 4> chargesSc = {trackFirst.sign(), trackSecond.sign(), trackThird.sign(), trackSoftPi.sign()};
+                std::array<int, 4> chargesSc = {trackFirst.sign(), trackSecond.sign(), trackThird.sign(), trackCache.sign(iTrackSoftPi)};
                 int chargeSc = std::accumulate(chargesSc.begin(), chargesSc.end(), 0); // SIGNED electric charge of SigmaC candidate
                 if (chargeSc != 0) {
                   continue;
                 }
 
-                // select soft pion candidates
-                auto trackParSoftPi = getTrackPar(trackSoftPi);
-                std::array<float, 2> dcaSoftPi{trackSoftPi.dcaXY(), trackSoftPi.dcaZ()};
-                std::array<float, 3> pVecSoftPi = trackSoftPi.pVector();
-                if (trackSoftPi.collisionId() != thisCollId) {
-                  // This is a track reassociated to this PV by the track-to-collision-associator
-                  // Let's propagate this track to it, and calculate dcaXY, dcaZ
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParSoftPi, 2.f, noMatCorr, &dcaSoftPi);
-                  getPxPyPz(trackParSoftPi, pVecSoftPi);
-                }
-                int16_t isSoftPionSelected = helper.isSelectedTrackForSoftPionOrBeauty<kSigmaC0K0>(trackSoftPi, trackParSoftPi, dcaSoftPi);
-                if (TESTBIT(isSoftPionSelected, kSoftPionForSigmaC) /*&& (TESTBIT(is3Prong[2], 0) || TESTBIT(is3Prong[2], 1))*/) {
-
-                  // check the mass of the SigmaC0 candidate
-                  auto pVecSigmaC = RecoDecay::pVec(pVecFirst, pVecSecond, pVecThird, pVecSoftPi);
-                  auto ptSigmaC = RecoDecay::pt(pVecSigmaC);
-                  int8_t whichSigmaC = helper.isSelectedSigmaCInDeltaMassRange<0>(pVecFirst, pVecThird, pVecSecond, pVecSoftPi, ptSigmaC, is3Prong[2], hMassVsPtC[kNCharmParticles + 10], activateQA);
-                  if (whichSigmaC > 0) {
-                    /// let's build a candidate SigmaC0K0s pair
-                    /// and keep it only if it is in the correct mass range
-
-                    float massSigmaCPKPi{-999.}, massSigmaCPiKP{-999.}, deltaMassXicResoPKPi{-999.}, deltaMassXicResoPiKP{-999.};
-                    float ptSigmaCKaon = RecoDecay::pt(pVecSigmaC, v0Cand.mom);
-                    if (ptSigmaCKaon > cutsPtDeltaMassCharmReso->get(2u, 10u)) {
-                      if (TESTBIT(whichSigmaC, 0)) {
-                        massSigmaCPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massProton, massKa, massPi, massPi});
-                        deltaMassXicResoPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, v0Cand.mom}, std::array{massProton, massKa, massPi, massPi, massK0S}) - massSigmaCPKPi;
-                      }
-                      if (TESTBIT(whichSigmaC, 1)) {
-                        massSigmaCPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massPi, massKa, massProton, massPi});
-                        deltaMassXicResoPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, v0Cand.mom}, std::array{massPi, massKa, massProton, massPi, massK0S}) - massSigmaCPiKP;
-                      }
+                // soft pion candidates already selected, with momentum at the PV also for tracks reassociated by the track-to-collision-associator
+                const auto& pVecSoftPi = trackCache.pVec(iTrackSoftPi);
 
-                      bool isPKPiOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPKPi && deltaMassXicResoPKPi < cutsPtDeltaMassCharmReso->get(1u, 10u));
-                      bool isPiKPOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPiKP && deltaMassXicResoPiKP < cutsPtDeltaMassCharmReso->get(1u, 10u));
-                      if (isPKPiOk || isPiKPOk) {
-                        /// This is a good SigmaC0K0s event
-                        keepEvent[kSigmaC0K0] = true;
+                // check the mass of the SigmaC0 candidate
+                auto pVecSigmaC = RecoDecay::pVec(pVecFirst, pVecSecond, pVecThird, pVecSoftPi);
+                auto ptSigmaC = RecoDecay::pt(pVecSigmaC);
+                int8_t whichSigmaC = helper.isSelectedSigmaCInDeltaMassRange<0>(pVecFirst, pVecThird, pVecSecond, pVecSoftPi, ptSigmaC, is3Prong[2], hMassVsPtC[kNCharmParticles + 10], activateQA);
+                if (whichSigmaC > 0) {
+                  /// let's build a candidate SigmaC0K0s pair
+                  /// and keep it only if it is in the correct mass range
 
-                        /// QA plot
-                        if (activateQA) {
-                          if (isPKPiOk) {
-                            if (TESTBIT(whichSigmaC, 2)) {
-                              hMassVsPtC[kNCharmParticles + 13]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
-                            }
-                            if (TESTBIT(whichSigmaC, 3)) {
-                              hMassVsPtC[kNCharmParticles + 14]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
-                            }
+                  float massSigmaCPKPi{-999.}, massSigmaCPiKP{-999.}, deltaMassXicResoPKPi{-999.}, deltaMassXicResoPiKP{-999.};
+                  float ptSigmaCKaon = RecoDecay::pt(pVecSigmaC, v0Cand.mom);
+                  if (ptSigmaCKaon > cutsPtDeltaMassCharmReso->get(2u, 10u)) {
+                    if (TESTBIT(whichSigmaC, 0)) {
+                      massSigmaCPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massProton, massKa, massPi, massPi});
+                      deltaMassXicResoPKPi = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, v0Cand.mom}, std::array{massProton, massKa, massPi, massPi, massK0S}) - massSigmaCPKPi;
+                    }
+                    if (TESTBIT(whichSigmaC, 1)) {
+                      massSigmaCPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi}, std::array{massPi, massKa, massProton, massPi});
+                      deltaMassXicResoPiKP = RecoDecay::m(std::array{pVecFirst, pVecSecond, pVecThird, pVecSoftPi, v0Cand.mom}, std::array{massPi, massKa, massProton, massPi, massK0S}) - massSigmaCPiKP;
+                    }
+
+                    bool isPKPiOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPKPi && deltaMassXicResoPKPi < cutsPtDeltaMassCharmReso->get(1u, 10u));
+                    bool isPiKPOk = (cutsPtDeltaMassCharmReso->get(0u, 10u) < deltaMassXicResoPiKP && deltaMassXicResoPiKP < cutsPtDeltaMassCharmReso->get(1u, 10u));
+                    if (isPKPiOk || isPiKPOk) {
+                      /// This is a good SigmaC0K0s event
+                      keepEvent[kSigmaC0K0] = true;
+
+                      /// QA plot
+                      if (activateQA) {
+                        if (isPKPiOk) {
+                          if (TESTBIT(whichSigmaC, 2)) {
+                            hMassVsPtC[kNCharmParticles + 13]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
                           }
-                          if (isPiKPOk) {
-                            if (TESTBIT(whichSigmaC, 2)) {
-                              hMassVsPtC[kNCharmParticles + 13]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
-                            }
-                            if (TESTBIT(whichSigmaC, 3)) {
-                              hMassVsPtC[kNCharmParticles + 14]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
-                            }
+                          if (TESTBIT(whichSigmaC, 3)) {
+                            hMassVsPtC[kNCharmParticles + 14]->Fill(ptSigmaCKaon, deltaMassXicResoPKPi);
+                          }
+                        }
+                        if (isPiKPOk) {
+                          if (TESTBIT(whichSigmaC, 2)) {
+                            hMassVsPtC[kNCharmParticles + 13]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
+                          }
+                          if (TESTBIT(whichSigmaC, 3)) {
+                            hMassVsPtC[kNCharmParticles + 14]->Fill(ptSigmaCKaon, deltaMassXicResoPiKP);
                           }
                         }
                       }
@@ -1855,21 +1795,18 @@ struct HfFilter { // Main struct for HF triggers
           }
 
           auto trackIdsThisCollision = trackIndices.sliceBy(trackIndicesPerCollision, thisCollId);
-          for (const auto& trackId : trackIdsThisCollision) { // start loop over tracks (first bachelor)
-            auto track = tracks.rawIteratorAt(trackId.trackId());
+          trackCache.fill(collision, trackIdsThisCollision, tracks, noMatCorr);
+          for (std::size_t iTrack{0}; iTrack < trackCache.size(); ++iTrack) { // start loop over tracks (first bachelor)
+            auto globalIndexBachelor = trackCache.globalIndex(iTrack);
 
             // check if track is one of the Xi daughters
-            if (track.globalIndex() == bachelorCascId || track.globalIndex() == v0DauPosId || track.globalIndex() == v0DauNegId) {
+            if (globalIndexBachelor == bachelorCascId || globalIndexBachelor == v0DauPosId || globalIndexBachelor == v0DauNegId) {
               continue;
             }
 
-            auto trackParBachelor = getTrackParCov(track);
-            std::array<float, 2> dcaInfoBach;
-            if (track.collisionId() != thisCollId) {
-              o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParBachelor, 2.f, noMatCorr, &dcaInfoBach);
-            }
-
-            auto isSelBachelor = helper.isSelectedBachelorForCharmBaryon(track, dcaInfoBach);
+            auto track = tracks.rawIteratorAt(globalIndexBachelor);
+            const auto& trackParBachelor = trackCache.trackPar(iTrack);
+            auto isSelBachelor = trackCache.getSelectionBachelor(helper, tracks, iTrack);
             if (isSelBachelor == kRejected) {
               continue;
             }
@@ -1895,28 +1832,22 @@ struct HfFilter { // Main struct for HF triggers
             }
 
             if (!keepEvent[kCharmBarToXi2Bach]) {
-              for (const auto& trackIdSecond : trackIdsThisCollision) { // start loop over tracks (second bachelor)
-                auto trackSecond = tracks.rawIteratorAt(trackIdSecond.trackId());
+              for (std::size_t iTrackSecond{0}; iTrackSecond < trackCache.size(); ++iTrackSecond) { // start loop over tracks (second bachelor)
+                auto globalIndexSecond = trackCache.globalIndex(iTrackSecond);
 
                 // check if track is one of the Xi daughters
-                if (trackSecond.globalIndex() == track.globalIndex() || trackSecond.globalIndex() == bachelorCascId || trackSecond.globalIndex() == v0DauPosId || trackSecond.globalIndex() == v0DauNegId) {
+                if (globalIndexSecond == track.globalIndex() || globalIndexSecond == bachelorCascId || globalIndexSecond == v0DauPosId || globalIndexSecond == v0DauNegId) {
                   continue;
                 }
 
-                if (track.sign() * trackSecond.sign() < 0 || track.sign() * cascCand.sign > 0) { // we want same sign pions, opposite to the xi
+                if (track.sign() * trackCache.sign(iTrackSecond) < 0 || track.sign() * cascCand.sign > 0) { // we want same sign pions, opposite to the xi
                   continue;
                 }
 
-                auto trackParBachelorSecond = getTrackParCov(trackSecond);
-                std::array<float, 2> dcaInfoBachSecond;
-                if (trackSecond.collisionId() != thisCollId) {
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParBachelorSecond, 2.f, noMatCorr, &dcaInfoBachSecond);
-                }
-
-                auto isSelBachelorSecond = helper.isSelectedBachelorForCharmBaryon(trackSecond, dcaInfoBachSecond);
-                if (!TESTBIT(isSelBachelorSecond, kPionForCharmBaryon)) {
+                if (!TESTBIT(trackCache.getSelectionBachelor(helper, tracks, iTrackSecond), kPionForCharmBaryon)) {
                   continue;
                 }
+                const auto& trackParBachelorSecond = trackCache.trackPar(iTrackSecond);
                 if (!keepEvent[kCharmBarToXi2Bach]) { // XiPiPi
 
                   bool isSelXiBachBach{false};
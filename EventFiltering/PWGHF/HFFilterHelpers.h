@@ -810,6 +810,136 @@ class HfFilterHelper
   o2::framework::LabeledArray<double> mPreselDsToKKPi{}; // pre-selections for Ds from track-index-skim-creator
 };
 
+/// Cache of the tracks associated to a collision, filled once per collision
+/// The track parameters, DCAs and momenta are propagated to the primary vertex for reassociated tracks,
+/// while the single-track selections are evaluated at the first request and then reused for all candidates
+class HfTrackCache
+{
+ public:
+  static constexpr int16_t NotEvaluated{-1};
+  static constexpr int NSelectionBits{8};
+
+  /// Invalidates the cache, to be called for each new collision
+  void reset()
+  {
+    mIsFilled = false;
+  }
+
+  /// Fills the cache with the tracks associated to a collision, if not already done
+  /// \param collision is the collision
+  /// \param trackIdsThisCollision are the track indices associated to the collision
+  /// \param tracks is the track table
+  /// \param matCorr is the material correction type used to propagate reassociated tracks
+  template <typename C, typename I, typename T>
+  void fill(const C& collision, const I& trackIdsThisCollision, const T& tracks, o2::base::Propagator::MatCorrType matCorr)
+  {
+    if (mIsFilled) {
+      return;
+    }
+    mIsFilled = true;
+    mGlobalIndices.clear();
+    mSigns.clear();
+    mIsAmbiguous.clear();
+    mTrackPars.clear();
+    mDcas.clear();
+    mPVecs.clear();
+    auto thisCollId = collision.globalIndex();
+    for (const auto& trackId : trackIdsThisCollision) {
+      auto track = tracks.rawIteratorAt(trackId.trackId());
+      auto trackPar = getTrackParCov(track);
+      std::array<float, 2> dca{track.dcaXY(), track.dcaZ()};
+      std::array<float, 3> pVec = track.pVector();
+      bool isAmbiguous = (track.collisionId() != thisCollId);
+      if (isAmbiguous) {
+        o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackPar, 2.f, matCorr, &dca);
+        getPxPyPz(trackPar, pVec);
+      }
+      mGlobalIndices.push_back(track.globalIndex());
+      mSigns.push_back(track.sign());
+      mIsAmbiguous.push_back(isAmbiguous);
+      mTrackPars.push_back(trackPar);
+      mDcas.push_back(dca);
+      mPVecs.push_back(pVec);
+    }
+    for (auto& selections : mSelections) {
+      selections.assign(mGlobalIndices.size(), NotEvaluated);
+    }
+    mSelectionsBachelor.assign(mGlobalIndices.size(), NotEvaluated);
+    for (auto& isListFilled : mIsListFilled) {
+      isListFilled.fill(false);
+    }
+  }
+
+  std::size_t size() const { return mGlobalIndices.size(); }
+  int64_t globalIndex(std::size_t i) const { return mGlobalIndices[i]; }
+  int8_t sign(std::size_t i) const { return mSigns[i]; }
+  bool isAmbiguous(std::size_t i) const { return mIsAmbiguous[i]; }
+  const o2::track::TrackParCov& trackPar(std::size_t i) const { return mTrackPars[i]; }
+  const std::array<float, 2>& dca(std::size_t i) const { return mDcas[i]; }
+  const std::array<float, 3>& pVec(std::size_t i) const { return mPVecs[i]; }
+
+  /// Single-track selection for soft pions or beauty bachelors, evaluated once per track and trigger
+  /// \param helper is the filter helper
+  /// \param tracks is the track table
+  /// \param i is the index of the track in the cache
+  template <o2::aod::hffilters::HfTriggers whichTrigger, typename T>
+  int16_t getSelection(HfFilterHelper& helper, const T& tracks, std::size_t i)
+  {
+    auto& selection = mSelections[whichTrigger][i];
+    if (selection == NotEvaluated) {
+      selection = helper.isSelectedTrackForSoftPionOrBeauty<whichTrigger>(tracks.rawIteratorAt(mGlobalIndices[i]), mTrackPars[i], mDcas[i]);
+    }
+    return selection;
+  }
+
+  /// Indices of the tracks in the cache passing the single-track selection of a trigger with a given bit set
+  /// \param helper is the filter helper
+  /// \param tracks is the track table
+  /// \param bit is the selection bit (kSoftPion, kForBeauty, kSoftPionForBeauty, kSoftPionForSigmaC)
+  template <o2::aod::hffilters::HfTriggers whichTrigger, typename T>
+  const std::vector<std::size_t>& getSelectedIndices(HfFilterHelper& helper, const T& tracks, int bit)
+  {
+    auto& indices = mSelectedIndices[whichTrigger][bit];
+    if (!mIsListFilled[whichTrigger][bit]) {
+      mIsListFilled[whichTrigger][bit] = true;
+      indices.clear();
+      for (std::size_t i{0}; i < size(); ++i) {
+        if (TESTBIT(getSelection<whichTrigger>(helper, tracks, i), bit)) {
+          indices.push_back(i);
+        }
+      }
+    }
+    return indices;
+  }
+
+  /// Single-track selection for bachelors of charm baryons, evaluated once per track
+  /// \param helper is the filter helper
+  /// \param tracks is the track table
+  /// \param i is the index of the track in the cache
+  template <typename T>
+  int16_t getSelectionBachelor(HfFilterHelper& helper, const T& tracks, std::size_t i)
+  {
+    auto& selection = mSelectionsBachelor[i];
+    if (selection == NotEvaluated) {
+      selection = helper.isSelectedBachelorForCharmBaryon(tracks.rawIteratorAt(mGlobalIndices[i]), mDcas[i]);
+    }
+    return selection;
+  }
+
+ private:
+  bool mIsFilled{false};                                                                          // whether the cache is filled for the current collision
+  std::vector<int64_t> mGlobalIndices{};                                                          // global indices of the tracks
+  std::vector<int8_t> mSigns{};                                                                   // signs of the tracks
+  std::vector<bool> mIsAmbiguous{};                                                               // whether the track was reassociated to this collision
+  std::vector<o2::track::TrackParCov> mTrackPars{};                                               // track parameters at the primary vertex
+  std::vector<std::array<float, 2>> mDcas{};                                                      // DCAs (xy, z) to the primary vertex
+  std::vector<std::array<float, 3>> mPVecs{};                                                     // momenta at the primary vertex
+  std::array<std::vector<int16_t>, kNtriggersHF> mSelections{};                                   // soft pion / beauty bachelor selections per trigger
+  std::vector<int16_t> mSelectionsBachelor{};                                                     // charm-baryon bachelor selections
+  std::array<std::array<std::vector<std::size_t>, NSelectionBits>, kNtriggersHF> mSelectedIndices{}; // pre-filtered track indices per trigger and selection bit
+  std::array<std::array<bool, NSelectionBits>, kNtriggersHF> mIsListFilled{};                     // whether the pre-filtered indices are filled
+};
+
 /// Selection of high-pt 2-prong candidates
 /// \param pt is the pt of the 2-prong candidate
 template <typename T>
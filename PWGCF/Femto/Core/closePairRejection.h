@@ -25,12 +25,15 @@
 #include "Framework/HistogramRegistry.h"
 #include "Framework/HistogramSpec.h"
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 #include <map>
 #include <numeric>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace o2::analysis::femto
@@ -135,6 +138,59 @@ auto makeCprHistSpecMap(const T& confCpr)
     {kRadius8, {confCpr.binningDeta, confCpr.binningDphistar}}};
 };
 
+// phi* of tracks at all tpc radii, computed once per track and reused for all pairs it enters
+// phi* only depends on the magnetic field and on the charge, pt and phi of a track, so an entry is
+// indexed by the global index of the track and recomputed only if any of these changed. The cache
+// therefore stays valid across collisions, mixed events and dataframes without being reset.
+class PhiStarCache
+{
+ public:
+  struct Entry {
+    float magField = 0.f;
+    float signedPt = 0.f;
+    float phi = 0.f;
+    int chargeAbs = -1; // -1: not filled
+    std::array<float, Nradii> phistar = {0.f};
+    std::array<bool, Nradii> mask = {false};
+  };
+
+  // entries of two tracks, returned by value: both tracks can share a global index (e.g. a track which is also a V0 daughter)
+  // with a different charge, in which case the second fill overwrites the entry of the first one
+  template <typename T1, typename T2>
+  std::pair<Entry, Entry> get(float magField, T1 const& track1, int chargeAbs1, T2 const& track2, int chargeAbs2)
+  {
+    auto maxIndex = static_cast<std::size_t>(std::max<int64_t>(track1.globalIndex(), track2.globalIndex()));
+    if (maxIndex >= mEntries.size()) {
+      mEntries.resize(maxIndex + 1);
+    }
+    Entry entry1 = fill(magField, track1, chargeAbs1);
+    Entry entry2 = fill(magField, track2, chargeAbs2);
+    return {entry1, entry2};
+  }
+
+ private:
+  template <typename T>
+  Entry const& fill(float magField, T const& track, int chargeAbs)
+  {
+    auto& entry = mEntries[track.globalIndex()];
+    if (entry.chargeAbs == chargeAbs && entry.magField == magField && entry.signedPt == track.signedPt() && entry.phi == track.phi()) {
+      return entry;
+    }
+    entry.magField = magField;
+    entry.signedPt = track.signedPt();
+    entry.phi = track.phi();
+    entry.chargeAbs = chargeAbs;
+    for (size_t i = 0; i < TpcRadii.size(); i++) {
+      auto phistar = utils::dphistar(magField, TpcRadii[i], chargeAbs * entry.signedPt, entry.phi);
+      entry.phistar[i] = phistar.value_or(0.f);
+      entry.mask[i] = phistar.has_value();
+    }
+    return entry;
+  }
+
+  std::vector<Entry> mEntries;
+};
+
 template <const char* prefix>
 class CloseTrackRejection
 {
@@ -207,12 +263,11 @@ class CloseTrackRejection
 
     mDeta = track1.eta() - track2.eta();
 
+    auto [phistar1, phistar2] = mPhiStarCache.get(mMagField, track1, mChargeAbsTrack1, track2, mChargeAbsTrack2);
     for (size_t i = 0; i < TpcRadii.size(); i++) {
-      auto phistar1 = utils::dphistar(mMagField, TpcRadii[i], mChargeAbsTrack1 * track1.signedPt(), track1.phi());
-      auto phistar2 = utils::dphistar(mMagField, TpcRadii[i], mChargeAbsTrack2 * track2.signedPt(), track2.phi());
-      if (phistar1 && phistar2) {
-        mDphistar.at(i) = RecoDecay::constrainAngle(phistar1.value() - phistar2.value(), -o2::constants::math::PI); // constrain angular difference between -pi and pi
-        mDphistarMask.at(i) = true;
+      if (phistar1.mask[i] && phistar2.mask[i]) {
+        mDphistar[i] = RecoDecay::constrainAngle(phistar1.phistar[i] - phistar2.phistar[i], -o2::constants::math::PI); // constrain angular difference between -pi and pi
+        mDphistarMask[i] = true;
         count++;
       }
     }
@@ -321,6 +376,8 @@ class CloseTrackRejection
   float mDeta = 0.f;
   std::array<float, Nradii> mDphistar = {0.f};
   std::array<bool, Nradii> mDphistarMask = {false};
+
+  PhiStarCache mPhiStarCache;
 };
 
 template <const char* prefix>
@@ -20,6 +20,8 @@
 
 #include "Framework/HistogramRegistry.h"
 
+#include <array>
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <vector>
@@ -732,10 +734,23 @@ class FemtoDreamDetaDphiStar
   std::array<std::shared_ptr<THnSparse>, 3> histdetadpi_eta{};
   std::array<std::shared_ptr<THnSparse>, 3> histdetadpi_phi{};
 
+  /// phi at the radii in tmpRadiiTPC of a particle, indexed by its global index
+  /// An entry is recomputed only if the magnetic field or the phi, pT or charge of the particle
+  /// behind the index changed, so it is reused across all same- and mixed-event pairs.
+  struct PhiAtRadiiEntry {
+    float magfield = 0.f;
+    float phi = 0.f;
+    float pt = 0.f;
+    int charge = 0;
+    bool filled = false;
+    std::array<float, 9> phiAtRadii{};
+  };
+  std::vector<PhiAtRadiiEntry> phiAtRadiiCache;
+
   ///  Calculate phi at all required radii stored in tmpRadiiTPC
   /// Magnetic field to be provided in Tesla
   template <typename T>
-  int PhiAtRadiiTPC(const T& part, std::vector<float>& tmpVec)
+  int PhiAtRadiiTPC(const T& part, std::array<float, 9>& tmpVec)
   {
 
     float phi0 = part.phi();
@@ -752,21 +767,41 @@ class FemtoDreamDetaDphiStar
     }
     // End: Get the charge from cutcontainer using masks
     float pt = part.pt();
+
+    auto index = static_cast<std::size_t>(part.globalIndex());
+    if (index >= phiAtRadiiCache.size()) {
+      phiAtRadiiCache.resize(index + 1);
+    }
+    auto& entry = phiAtRadiiCache[index];
+    if (!entry.filled || entry.magfield != magfield || entry.phi != phi0 || entry.pt != pt || entry.charge != charge) {
+      fillPhiAtRadii(phi0, pt, charge, entry.phiAtRadii);
+      entry.magfield = magfield;
+      entry.phi = phi0;
+      entry.pt = pt;
+      entry.charge = charge;
+      entry.filled = true;
+    }
+    tmpVec = entry.phiAtRadii;
+    return charge;
+  }
+
+  ///  Calculate phi at all radii stored in tmpRadiiTPC for the given kinematics
+  void fillPhiAtRadii(float phi0, float pt, int charge, std::array<float, 9>& tmpVec) const
+  {
     for (size_t i = 0; i < 9; i++) {
       if (runOldVersion) {
-        tmpVec.push_back(phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
+        tmpVec[i] = phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt));
       }
       if (!runOldVersion) {
         auto arg = 0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt);
         // for very low pT particles, this value goes outside of range -1 to 1 at at large tpc radius; asin fails
         if (std::fabs(arg) < 1) {
-          tmpVec.push_back(phi0 - std::asin(0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
+          tmpVec[i] = phi0 - std::asin(0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt));
         } else {
-          tmpVec.push_back(999);
+          tmpVec[i] = 999;
         }
       }
     }
-    return charge;
   }
 
   ///  Calculate phi at specific radii
@@ -830,7 +865,7 @@ class FemtoDreamDetaDphiStar
   }
 
   template <typename T>
-  int PhiAtRadiiTPCForHF(const T& part, std::vector<float>& tmpVec, int prong)
+  int PhiAtRadiiTPCForHF(const T& part, std::array<float, 9>& tmpVec, int prong)
   {
     int charge = 0;
     float pt = -999.;
@@ -855,20 +890,7 @@ class FemtoDreamDetaDphiStar
         // Handle invalid prong value
         break;
     }
-    for (size_t i = 0; i < 9; i++) {
-      if (runOldVersion) {
-        tmpVec.push_back(phi0 - std::asin(0.3 * charge * 0.1 * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
-      }
-      if (!runOldVersion) {
-        auto arg = 0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt);
-        // for very low pT particles, this value goes outside of range -1 to 1 at at large tpc radius; asin fails
-        if (std::fabs(arg) < 1) {
-          tmpVec.push_back(phi0 - std::asin(0.3 * charge * magfield * tmpRadiiTPC[i] * 0.01 / (2. * pt)));
-        } else {
-          tmpVec.push_back(999);
-        }
-      }
-    }
+    fillPhiAtRadii(phi0, pt, charge, tmpVec);
     return charge;
   }
 
@@ -876,8 +898,8 @@ class FemtoDreamDetaDphiStar
   template <bool isHF = false, typename T1, typename T2>
   float AveragePhiStar(const T1& part1, const T2& part2, int iHist, bool* sameCharge)
   {
-    std::vector<float> tmpVec1;
-    std::vector<float> tmpVec2;
+    std::array<float, 9> tmpVec1;
+    std::array<float, 9> tmpVec2;
     auto charge1 = PhiAtRadiiTPC(part1, tmpVec1);
     if constexpr (!isHF) {
       auto charge2 = PhiAtRadiiTPC(part2, tmpVec2);
@@ -893,8 +915,8 @@ class FemtoDreamDetaDphiStar
     float dPhiAvg = 0;
     float dphi;
     for (int i = 0; i < num; i++) {
-      if (tmpVec1.at(i) != 999 && tmpVec2.at(i) != 999) {
-        dphi = tmpVec1.at(i) - tmpVec2.at(i);
+      if (tmpVec1[i] != 999 && tmpVec2[i] != 999) {
+        dphi = tmpVec1[i] - tmpVec2[i];
       } else {
         dphi = 0;
         meaningfulEntries = meaningfulEntries - 1;
@@ -11,7 +11,9 @@
 
 #include "GFW.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -79,30 +81,77 @@ int GFW::CreateRegions()
   for (auto pItr = fCumulants.begin(); pItr != fCumulants.end(); ++pItr)
     pItr->DestroyComplexVectorArray();
   fCumulants.clear();
+  fNodes.clear();
+  fNodeIndex.clear();
+  fNodeValues.clear();
+  fNodeEpochs.clear();
+  fCompiledCFGs.clear();
   InitializePowerArrays();
   if (fRegions.size() < 1) {
     printf("No regions set. Skipping...\n");
     return 0;
   }
+  fNodePtBins = 1;
+  for (const auto& lRegion : fRegions)
+    fNodePtBins = std::max(fNodePtBins, lRegion.NpT);
   int nRegions = 0;
   for (auto pItr = fRegions.begin(); pItr != fRegions.end(); pItr++) {
-    GFWCumulant* lCumulant = new GFWCumulant();
-    lCumulant->CreateComplexVectorArrayVarPower(pItr->Nhar, pItr->NparVec, pItr->NpT);
-    fCumulants.push_back(*lCumulant);
+    fCumulants.emplace_back();
+    fCumulants.back().CreateComplexVectorArrayVarPower(pItr->Nhar, pItr->NparVec, pItr->NpT);
     ++nRegions;
   }
   if (nRegions)
     fInitialized = true;
+  // Compile all the known correlators into one plan, so that common terms are evaluated only once per event
+  CompileConfigs(0);
   return nRegions;
 };
+void GFW::CompileConfigs(std::size_t first)
+{
+  fCompiledCFGs.resize(fListOfCFGs.size());
+  for (std::size_t iCfg = first; iCfg < fListOfCFGs.size(); iCfg++) {
+    const CorrConfig& lConf = fListOfCFGs[iCfg];
+    CompiledConfig& lCompiled = fCompiledCFGs[iCfg];
+    lCompiled.nodes.assign(lConf.Regs.size(), -1);
+    lCompiled.zeroHarNodes.assign(lConf.Regs.size(), -1);
+    for (int i = 0; i < static_cast<int>(lConf.Regs.size()); i++) {
+      if (lConf.Regs.at(i).size() == 0)
+        continue;
+      lCompiled.nodes[i] = CompileConfig(lConf, i, false);
+      lCompiled.zeroHarNodes[i] = CompileConfig(lConf, i, true);
+    }
+  }
+};
 void GFW::Fill(double eta, int ptin, double phi, double weight, int mask, double SecondWeight)
 {
+  ++fEpoch; // Memoised correlator terms are not valid anymore
   // if(!fInitialized) return;
   for (int i = 0; i < static_cast<int>(fRegions.size()); ++i) {
     if (fRegions.at(i).EtaMin < eta && fRegions.at(i).EtaMax > eta && (fRegions.at(i).BitMask & mask))
       fCumulants.at(i).FillArray(ptin, phi, weight, SecondWeight);
   }
 };
+void GFW::Fill(std::span<const double> etas, std::span<const int> ptins, std::span<const double> phis, std::span<const double> weights, int mask, double SecondWeight)
+{
+  const std::size_t nTracks = std::min({etas.size(), ptins.size(), phis.size(), weights.size()});
+  ++fEpoch; // Memoised correlator terms are not valid anymore
+  for (int i = 0; i < static_cast<int>(fRegions.size()); ++i) {
+    const Region& lRegion = fRegions.at(i);
+    if (!(lRegion.BitMask & mask))
+      continue;
+    fFillPhis.clear();
+    fFillWeights.clear();
+    fFillPts.clear();
+    for (std::size_t iTrack = 0; iTrack < nTracks; ++iTrack) {
+      if (lRegion.EtaMin < etas[iTrack] && lRegion.EtaMax > etas[iTrack]) {
+        fFillPhis.push_back(phis[iTrack]);
+        fFillWeights.push_back(weights[iTrack]);
+        fFillPts.push_back(ptins[iTrack]);
+      }
+    }
+    fCumulants.at(i).FillArray(fFillPhis, fFillWeights, fFillPts, SecondWeight);
+  }
+};
 complex<double> GFW::TwoRec(int n1, int n2, int p1, int p2, int ptbin, GFWCumulant* r1, GFWCumulant* r2, GFWCumulant* r3)
 {
   complex<double> part1 = r1->Vec(n1, p1, ptbin);
@@ -159,8 +208,99 @@ complex<double> GFW::RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumu
   pows.push_back(powlast);
   return formula;
 };
+int GFW::CompileNode(int poi, int ref, int ovl, vector<int>& hars, vector<int>& pows)
+{
+  // Mirrors the logic of RecursiveCorr, but creates a node for each unique term instead of evaluating it
+  if ((pows.at(0) != 1) && ovl > -1)
+    poi = ovl;
+  vector<int> key{poi, ref, ovl};
+  key.insert(key.end(), hars.begin(), hars.end());
+  key.insert(key.end(), pows.begin(), pows.end());
+  auto itr = fNodeIndex.find(key);
+  if (itr != fNodeIndex.end())
+    return itr->second;
+  CorrNode node{0, poi, ref, ovl, hars.at(0), pows.at(0), 0, 0, {}};
+  if (hars.size() == 2) {
+    node.type = 1;
+    node.har1 = hars.at(1);
+    node.pow1 = pows.at(1);
+  } else if (hars.size() > 2) {
+    node.type = 2;
+    node.har1 = hars.at(hars.size() - 1);
+    node.pow1 = pows.at(pows.size() - 1);
+    hars.erase(hars.end() - 1);
+    pows.erase(pows.end() - 1);
+    node.children.emplace_back(CompileNode(poi, ref, ovl, hars, pows), 1);
+    int lDegeneracy = 1;
+    int harSize = static_cast<int>(hars.size());
+    for (int i = harSize - 1; i >= 0; i--) {
+      if (i > 2) {
+        if (hars.at(i) == hars.at(i - 1) && pows.at(i) == pows.at(i - 1)) {
+          lDegeneracy++;
+          continue;
+        }
+      }
+      hars.at(i) += node.har1;
+      pows.at(i) += node.pow1;
+      node.children.emplace_back(CompileNode(poi, ref, ovl, hars, pows), lDegeneracy);
+      lDegeneracy = 1;
+      hars.at(i) -= node.har1;
+      pows.at(i) -= node.pow1;
+    }
+    hars.push_back(node.har1);
+    pows.push_back(node.pow1);
+  }
+  fNodes.push_back(node);
+  fNodeValues.resize(fNodes.size() * fNodePtBins);
+  fNodeEpochs.resize(fNodes.size() * fNodePtBins, 0);
+  fNodeIndex[key] = static_cast<int>(fNodes.size()) - 1;
+  return fNodeIndex[key];
+};
+int GFW::CompileConfig(const CorrConfig& corconf, int i, bool SetHarmsToZero)
+{
+  int poi = corconf.Regs.at(i).at(0);
+  int ref = (corconf.Regs.at(i).size() > 1) ? corconf.Regs.at(i).at(1) : corconf.Regs.at(i).at(0);
+  int ovl = corconf.Overlap.at(i);
+  if (ovl < 0 && ref == poi)
+    ovl = ref; // If ref and poi are the same, then the same is for overlap. Only, when OL not explicitly defined
+  vector<int> hars = corconf.Hars.at(i);
+  if (SetHarmsToZero)
+    std::fill(hars.begin(), hars.end(), 0);
+  vector<int> pows(hars.size(), 1);
+  return CompileNode(poi, ref, ovl, hars, pows);
+};
+complex<double> GFW::EvaluateNode(int inode, int ptbin)
+{
+  int slot = -1;
+  if (ptbin >= 0 && ptbin < fNodePtBins) {
+    slot = inode * fNodePtBins + ptbin;
+    if (fNodeEpochs[slot] == fEpoch)
+      return fNodeValues[slot];
+  }
+  const CorrNode& node = fNodes[inode];
+  complex<double> value;
+  if (node.type == 0) {
+    value = fCumulants[node.poi].Vec(node.har0, node.pow0, ptbin);
+  } else if (node.type == 1) {
+    value = TwoRec(node.har0, node.har1, node.pow0, node.pow1, ptbin, &fCumulants[node.poi], &fCumulants[node.ref], (node.ovl > -1) ? &fCumulants[node.ovl] : 0);
+  } else {
+    value = EvaluateNode(node.children[0].first, ptbin) * fCumulants[node.ref].Vec(node.har1, node.pow1);
+    for (std::size_t i = 1; i < node.children.size(); i++) {
+      complex<double> subtractVal = EvaluateNode(node.children[i].first, ptbin);
+      if (node.children[i].second > 1)
+        subtractVal *= node.children[i].second;
+      value -= subtractVal;
+    }
+  }
+  if (slot > -1) {
+    fNodeValues[slot] = value;
+    fNodeEpochs[slot] = fEpoch;
+  }
+  return value;
+};
 void GFW::Clear()
 {
+  ++fEpoch;
   if (!fInitialized)
     CreateRegions();
   for (auto ptr = fCumulants.begin(); ptr != fCumulants.end(); ++ptr)
@@ -246,7 +386,11 @@ GFW::CorrConfig GFW::GetCorrelatorConfig(string config, string head, bool ptdif)
   ReturnConfig.Head = head;
   ReturnConfig.pTDif = ptdif;
   // ReturnConfig.pTbin = ptbin;
+  ReturnConfig.Index = static_cast<int>(fListOfCFGs.size());
+  ReturnConfig.Owner = this;
   fListOfCFGs.push_back(ReturnConfig);
+  if (fInitialized)
+    CompileConfigs(fListOfCFGs.size() - 1); // otherwise compiled with CreateRegions
   return ReturnConfig;
 };
 
@@ -257,11 +401,15 @@ complex<double> GFW::Calculate(int poi, int ref, vector<int> hars, int ptbin)
   GFWCumulant* qovl = qpoi;
   return RecursiveCorr(qpoi, qref, qovl, ptbin, hars);
 };
-complex<double> GFW::Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZero)
+complex<double> GFW::Calculate(const CorrConfig& corconf, int ptbin, bool SetHarmsToZero)
 {
   // if(!fInitialized) return complex<double>(0,0); //First check if initialised, if not -- initialize, and if it fails, return
   if (corconf.Regs.size() == 0)
     return complex<double>(0, 0); // Check if we have any regions at all
+  // plan nodes compiled at initialisation; configs not created by this GFW are compiled on the fly
+  const std::vector<int>* lNodes = nullptr;
+  if (corconf.Owner == this && corconf.Index >= 0 && corconf.Index < static_cast<int>(fCompiledCFGs.size()))
+    lNodes = SetHarmsToZero ? &fCompiledCFGs[corconf.Index].zeroHarNodes : &fCompiledCFGs[corconf.Index].nodes;
   complex<double> retval(1, 0);
   int ptInd;
   for (int i = 0; i < static_cast<int>(corconf.Regs.size()); i++) { // looping over all regions
@@ -273,7 +421,6 @@ complex<double> GFW::Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZer
     // picking up the indecies of regions...
     int poi = corconf.Regs.at(i).at(0);
     int ref = (corconf.Regs.at(i).size() > 1) ? corconf.Regs.at(i).at(1) : corconf.Regs.at(i).at(0);
-    int ovl = corconf.Overlap.at(i);
     // and regions themselves
     GFWCumulant* qref = &fCumulants.at(ref);
     GFWCumulant* qpoi = &fCumulants.at(poi);
@@ -281,24 +428,14 @@ complex<double> GFW::Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZer
       return complex<double>(0, 0); // if REF is not filled, don't even continue. Could be redundant, but should save little CPU time
     if (!qpoi->IsPtBinFilled(ptInd))
       return complex<double>(0, 0); // if POI is not filled, don't even continue. Could be redundant, but should save little CPU time
-    GFWCumulant* qovl = 0;
     // Check if in the ref. region we have enough particles (no. of particles in the region >= no of harmonics for subevent)
     int sz1 = corconf.Hars.at(i).size();
     if (poi != ref)
       sz1--;
     if (qref->GetN() < sz1)
       return complex<double>(0, 0);
-    // Then, figure the overlap
-    if (ovl > -1) // if overlap is defined, then (unless it's explicitly disabled)
-      qovl = &fCumulants.at(ovl);
-    else if (ref == poi)
-      qovl = qref; // If ref and poi are the same, then the same is for overlap. Only, when OL not explicitly defined
-    if (SetHarmsToZero) {
-      for (int j = 0; j < static_cast<int>(corconf.Hars.at(i).size()); j++) {
-        corconf.Hars.at(i).at(j) = 0;
-      }
-    }
-    retval *= RecursiveCorr(qpoi, qref, qovl, ptInd, corconf.Hars.at(i));
+    // Overlap and harmonics are resolved when compiling; terms shared with other configs or already evaluated are reused
+    retval *= EvaluateNode(lNodes ? (*lNodes)[i] : CompileConfig(corconf, i, SetHarmsToZero), ptInd);
   }
   return retval;
 };
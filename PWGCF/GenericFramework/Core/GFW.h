@@ -21,7 +21,10 @@
 
 #include <algorithm>
 #include <complex>
+#include <cstdint>
 #include <cstdio>
+#include <map>
+#include <span>
 #include <string>
 #include <utility>
 #include <vector>
@@ -50,6 +53,8 @@ class GFW
     std::vector<int> ptInd;
     bool pTDif = false;
     std::string Head = "";
+    int Index = -1;             //! position in the list of configs of the GFW that created it
+    const GFW* Owner = nullptr; //! GFW that created it
   };
   GFW();
   ~GFW();
@@ -61,15 +66,44 @@ class GFW
   void AddRegion(std::string refName, int lNhar, int* lNparVec, double lEtaMin, double lEtaMax, int lNpT, int BitMask);  // Legacy support, array instead of a vector
   int CreateRegions();
   void Fill(double eta, int ptin, double phi, double weight, int mask, double secondWeight = -1);
+  void Fill(std::span<const double> etas, std::span<const int> ptins, std::span<const double> phis, std::span<const double> weights, int mask, double secondWeight = -1); // Batch filling of many tracks with the same mask
   void Clear();
   GFWCumulant GetCumulant(int index) { return fCumulants.at(index); }
   CorrConfig GetCorrelatorConfig(std::string config, std::string head = "", bool ptdif = false);
-  std::complex<double> Calculate(CorrConfig corconf, int ptbin, bool SetHarmsToZero);
+  std::complex<double> Calculate(const CorrConfig& corconf, int ptbin, bool SetHarmsToZero);
   void InitializePowerArrays();
 
  protected:
+  // Node of the compiled correlator plan: a unique (POI, ref., overlap, harmonics, powers) term of the recursion
+  struct CorrNode {
+    int type;                                  // 0: single Q-vector, 1: two-particle term, 2: recursion over the children
+    int poi, ref, ovl;                         // region indices (ovl = -1 if no overlap)
+    int har0, pow0, har1, pow1;                // harmonics & powers of the Q-vectors (for type 2, the last harmonic & power)
+    std::vector<std::pair<int, int>> children; // (node index, degeneracy); the first child is multiplied by the last Q-vector of ref.
+  };
   bool fInitialized;
   std::vector<CorrConfig> fListOfCFGs;
+  // Compiled correlator plan, shared by all configs. Node values are memoised per pt bin and reset with every new fill
+  std::vector<CorrNode> fNodes;                  //!
+  std::map<std::vector<int>, int> fNodeIndex;     //!
+  std::vector<std::complex<double>> fNodeValues; //!
+  std::vector<uint64_t> fNodeEpochs;             //!
+  int fNodePtBins = 1;                           //!
+  uint64_t fEpoch = 1;                           //!
+  int CompileNode(int poi, int ref, int ovl, std::vector<int>& hars, std::vector<int>& pows);
+  int CompileConfig(const CorrConfig& corconf, int i, bool SetHarmsToZero);
+  // Plan node of each subevent of a config of fListOfCFGs (-1 for empty subevents), with the configured and with zero harmonics
+  struct CompiledConfig {
+    std::vector<int> nodes;
+    std::vector<int> zeroHarNodes;
+  };
+  std::vector<CompiledConfig> fCompiledCFGs; //!
+  void CompileConfigs(std::size_t first);
+  std::complex<double> EvaluateNode(int node, int ptbin);
+  // Scratch buffers for batch filling
+  std::vector<double> fFillPhis;
+  std::vector<double> fFillWeights;
+  std::vector<int> fFillPts;
   std::complex<double> TwoRec(int n1, int n2, int p1, int p2, int ptbin, GFWCumulant*, GFWCumulant*, GFWCumulant*);
   std::complex<double> RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, std::vector<int>& hars, std::vector<int>& pows); // POI, Ref. flow, overlapping region
   std::complex<double> RecursiveCorr(GFWCumulant* qpoi, GFWCumulant* qref, GFWCumulant* qol, int ptbin, std::vector<int>& hars);                         // POI, Ref. flow, overlapping region
@@ -11,18 +11,20 @@
 
 #include "GFWCumulant.h"
 
+#include <algorithm>
+#include <span>
 #include <vector>
 
 using std::complex;
 using std::vector;
 
-GFWCumulant::GFWCumulant() : fQvector(0),
+GFWCumulant::GFWCumulant() : fPtStride(0),
+                             fMaxPow(0),
                              fUsed(kBlank),
                              fNEntries(-1),
                              fN(1),
                              fPow(1),
                              fPt(1),
-                             fFilledPts(0),
                              fInitialized(false) {}
 
 GFWCumulant::~GFWCumulant() {}
@@ -35,53 +37,127 @@ void GFWCumulant::FillArray(int ptin, double phi, double weight, double SecondWe
   else if (ptin < 0 || ptin >= fPt)
     return;
   fFilledPts[ptin] = true;
+  // Harmonics are obtained with the recurrence e^{i(n+1)phi} = e^{i n phi} * e^{i phi}, so that only one sin/cos is needed
+  const double lCos1 = cos(phi);
+  const double lSin1 = sin(phi);
+  // If second weight is specified, then keep the first weight with power no more than 1, and use the other weight otherwise
+  // this is important when POIs are a subset of REFs and have different weights than REFs
+  const double lHigherWeight = (SecondWeight > 0) ? SecondWeight : weight;
+  double lCos = 1;
+  double lSin = 0;
+  double* lQRe = fQRe.data() + ptin * fPtStride;
+  double* lQIm = fQIm.data() + ptin * fPtStride;
   for (int lN = 0; lN < fN; lN++) {
-    double lSin = sin(lN * phi); // No need to recalculate for each power
-    double lCos = cos(lN * phi); // No need to recalculate for each power
+    double lPrefactor = 1; // Powers are built incrementally, multiplication is cheaper than power
+    const int lOffset = fHarOffset[lN];
     for (int lPow = 0; lPow < PW(lN); lPow++) {
-      double lPrefactor = 0;
-      // Dont calculate it twice; multiplication is cheaper that power
-      // Also, if second weight is specified, then keep the first weight with power no more than 1, and us the other weight otherwise
-      // this is important when POIs are a subset of REFs and have different weights than REFs
-      if (SecondWeight > 0 && lPow > 1)
-        lPrefactor = pow(SecondWeight, lPow - 1) * weight;
-      else
-        lPrefactor = pow(weight, lPow);
-      double qsin = lPrefactor * lSin;
-      double qcos = lPrefactor * lCos;
-      fQvector[ptin][lN][lPow] += complex<double>(qcos, qsin);
+      lQRe[lOffset + lPow] += lPrefactor * lCos;
+      lQIm[lOffset + lPow] += lPrefactor * lSin;
+      lPrefactor *= (lPow > 0) ? lHigherWeight : weight;
     }
+    const double lCosNext = lCos * lCos1 - lSin * lSin1;
+    lSin = lSin * lCos1 + lCos * lSin1;
+    lCos = lCosNext;
   }
   Inc();
 };
-void GFWCumulant::ResetQs()
+void GFWCumulant::FillArray(std::span<const double> phis, std::span<const double> weights, std::span<const int> ptins, double SecondWeight)
 {
-  if (!fNEntries)
-    return; // If 0 entries, then no need to reset. Otherwise, if -1, then just initialized and need to set to 0.
-  for (int i = 0; i < fPt; i++) {
-    fFilledPts[i] = false;
-    for (int lN = 0; lN < fN; lN++) {
-      for (int lPow = 0; lPow < PW(lN); lPow++) {
-        fQvector[i][lN][lPow] = fNullQ;
+  if (!fInitialized)
+    CreateComplexVectorArray(1, 1, 1);
+  const int nIn = static_cast<int>(std::min({phis.size(), weights.size(), ptins.size()}));
+  if (nIn == 0)
+    return;
+  // Scratch columns: pt bin, cos(n phi), sin(n phi), cos(phi), sin(phi), then one column per power of the weight
+  const int nCols = 5 + std::max(fMaxPow, 1);
+  if (static_cast<int>(fBatch.size()) < nIn * nCols)
+    fBatch.resize(nIn * nCols);
+  double* lPt = fBatch.data();
+  double* lCos = lPt + nIn;
+  double* lSin = lCos + nIn;
+  double* lCos1 = lSin + nIn;
+  double* lSin1 = lCos1 + nIn;
+  double* lPows = lSin1 + nIn;
+  // First select the tracks in the pt range, as in the single track filling
+  int nTr = 0;
+  for (int i = 0; i < nIn; i++) {
+    int ptin = ptins[i];
+    if (fPt == 1)
+      ptin = 0;
+    else if (ptin < 0 || ptin >= fPt)
+      continue;
+    fFilledPts[ptin] = true;
+    lPt[nTr] = ptin;
+    lCos1[nTr] = cos(phis[i]);
+    lSin1[nTr] = sin(phis[i]);
+    lCos[nTr] = 1;
+    lSin[nTr] = 0;
+    lPows[nTr] = weights[i]; // first column temporarily keeps the weight
+    ++nTr;
+  }
+  if (!nTr)
+    return;
+  // Powers of weights: column p holds w^p (or w*sw^(p-1) if the second weight is set)
+  for (int t = 0; t < nTr; t++) {
+    const double w = lPows[t];
+    const double hw = (SecondWeight > 0) ? SecondWeight : w;
+    double lPrefactor = 1;
+    for (int lPow = 0; lPow < fMaxPow; lPow++) {
+      lPows[lPow * nIn + t] = lPrefactor;
+      lPrefactor *= (lPow > 0) ? hw : w;
+    }
+  }
+  for (int lN = 0; lN < fN; lN++) {
+    const int lOffset = fHarOffset[lN];
+    for (int lPow = 0; lPow < PW(lN); lPow++) {
+      const double* lPw = lPows + lPow * nIn;
+      if (fPt == 1) {
+        // single pt bin: plain reductions over tracks, which the compiler can vectorise
+        double lSumRe = 0;
+        double lSumIm = 0;
+        for (int t = 0; t < nTr; t++) {
+          lSumRe += lPw[t] * lCos[t];
+          lSumIm += lPw[t] * lSin[t];
+        }
+        fQRe[lOffset + lPow] += lSumRe;
+        fQIm[lOffset + lPow] += lSumIm;
+      } else {
+        for (int t = 0; t < nTr; t++) {
+          const int lInd = static_cast<int>(lPt[t]) * fPtStride + lOffset + lPow;
+          fQRe[lInd] += lPw[t] * lCos[t];
+          fQIm[lInd] += lPw[t] * lSin[t];
+        }
       }
     }
+    // Move all tracks to the next harmonic
+    for (int t = 0; t < nTr; t++) {
+      const double lCosNext = lCos[t] * lCos1[t] - lSin[t] * lSin1[t];
+      lSin[t] = lSin[t] * lCos1[t] + lCos[t] * lSin1[t];
+      lCos[t] = lCosNext;
+    }
   }
+  fNEntries += nTr;
+};
+void GFWCumulant::ResetQs()
+{
+  if (!fNEntries)
+    return; // If 0 entries, then no need to reset. Otherwise, if -1, then just initialized and need to set to 0.
+  std::fill(fFilledPts.begin(), fFilledPts.end(), false);
+  std::fill(fQRe.begin(), fQRe.end(), 0.);
+  std::fill(fQIm.begin(), fQIm.end(), 0.);
   fNEntries = 0;
 };
 void GFWCumulant::DestroyComplexVectorArray()
 {
   if (!fInitialized)
     return;
-  for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      delete[] fQvector[i][l_n];
-    }
-  }
-  for (int i = 0; i < fPt; i++) {
-    delete[] fQvector[i];
-  }
-  delete[] fQvector;
-  delete[] fFilledPts;
+  fQRe.clear();
+  fQIm.clear();
+  fHarOffset.clear();
+  fFilledPts.clear();
+  fBatch.clear();
+  fPtStride = 0;
+  fMaxPow = 0;
   fInitialized = false;
   fNEntries = -1;
 };
@@ -100,18 +176,19 @@ void GFWCumulant::CreateComplexVectorArrayVarPower(int N, vector<int> PowVec, in
   fN = N;
   fPow = 0;
   fPt = Pt;
-  fFilledPts = new bool[Pt];
   fPowVec = PowVec;
-  fQvector = new complex<double>**[fPt];
-  for (int i = 0; i < fPt; i++) {
-    fQvector[i] = new complex<double>*[fN];
-  }
+  fHarOffset.resize(fN);
+  fPtStride = 0;
+  fMaxPow = 0;
   for (int l_n = 0; l_n < fN; l_n++) {
-    for (int i = 0; i < fPt; i++) {
-      fQvector[i][l_n] = new complex<double>[PW(l_n)];
-    }
+    fHarOffset[l_n] = fPtStride;
+    fPtStride += PW(l_n);
+    fMaxPow = std::max(fMaxPow, PW(l_n));
   }
-  ResetQs();
+  fFilledPts.assign(fPt, false);
+  fQRe.assign(fPt * fPtStride, 0.);
+  fQIm.assign(fPt * fPtStride, 0.);
+  fNEntries = 0;
   fInitialized = true;
 };
 complex<double> GFWCumulant::Vec(int n, int p, int ptbin)
@@ -121,12 +198,12 @@ complex<double> GFWCumulant::Vec(int n, int p, int ptbin)
   if (ptbin >= fPt || ptbin < 0)
     ptbin = 0;
   if (n >= 0)
-    return fQvector[ptbin][n][p];
-  return conj(fQvector[ptbin][-n][p]);
+    return complex<double>(fQRe[Index(ptbin, n, p)], fQIm[Index(ptbin, n, p)]);
+  return complex<double>(fQRe[Index(ptbin, -n, p)], -fQIm[Index(ptbin, -n, p)]);
 };
 bool GFWCumulant::IsPtBinFilled(int ptb)
 {
-  if (!fFilledPts)
+  if (fFilledPts.empty())
     return false;
   if (ptb > 0) {
     if (fPt == 1)
@@ -18,6 +18,7 @@
 
 #include <cmath>
 #include <complex>
+#include <span>
 #include <vector>
 
 class GFWCumulant
@@ -27,6 +28,7 @@ class GFWCumulant
   ~GFWCumulant();
   void ResetQs();
   void FillArray(int ptin, double phi, double weight = 1, double SecondWeight = -1);
+  void FillArray(std::span<const double> phis, std::span<const double> weights, std::span<const int> ptins, double SecondWeight = -1); // Batch filling of many tracks
   enum UsedFlags_t { kBlank = 0,
                      kFull = 1,
                      kPt = 2 };
@@ -44,7 +46,14 @@ class GFWCumulant
   void DestroyComplexVectorArray();
   std::complex<double> Vec(int, int, int ptbin = 0); // envelope class to summarize pt-dif. Q-vec getter
  protected:
-  std::complex<double>*** fQvector;
+  int Index(int ptbin, int n, int p) const { return ptbin * fPtStride + fHarOffset[n] + p; }
+  // Q-vectors are stored contiguously as structure of arrays, index = ptbin * fPtStride + fHarOffset[harmonic] + power
+  std::vector<double> fQRe;     //! Real parts
+  std::vector<double> fQIm;     //! Imaginary parts
+  std::vector<int> fHarOffset;  //! Offset of each harmonic within one pt bin
+  int fPtStride;                //! Number of (harmonic, power) pairs in one pt bin
+  int fMaxPow;                  //! Highest power over all harmonics
+  std::vector<double> fBatch;   //! Scratch for batch filling, one column of accepted tracks per quantity
   uint fUsed;
   int fNEntries;
   // Q-vectors. Could be done recursively, but maybe defining each one of them explicitly is easier to read
@@ -52,7 +61,7 @@ class GFWCumulant
   int fPow;                 //! Power
   std::vector<int> fPowVec; //! Powers array
   int fPt;                  //! fPt bins
-  bool* fFilledPts;
+  std::vector<char> fFilledPts;
   bool fInitialized; // Arrays are initialized
   std::complex<double> fNullQ = 0;
 };
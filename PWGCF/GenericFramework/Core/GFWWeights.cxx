@@ -11,6 +11,7 @@
 
 #include "GFWWeights.h"
 #include "TMath.h"
+#include <algorithm>
 #include <cstdio>
 
 GFWWeights::GFWWeights() : TNamed("", ""),
@@ -116,6 +117,10 @@ void GFWWeights::fill(double phi, double eta, double vz, double pt, double /*cen
 };
 double GFWWeights::getWeight(double phi, double eta, double vz, double pt, double /*cent*/, int htype)
 {
+  if (htype == 0 && !fFrozenData.empty())
+    return fFrozenData.getInvWeight(phi, eta, vz);
+  if (htype == 1 && !fFrozenRec.empty())
+    return fFrozenRec.getInvWeight(pt, eta, vz);
   TObjArray* tar = 0;
   const char* pf = "";
   if (htype == 0) {
@@ -145,6 +150,8 @@ double GFWWeights::getWeight(double phi, double eta, double vz, double pt, doubl
 };
 double GFWWeights::getNUA(double phi, double eta, double vz)
 {
+  if (!fFrozenNUA.empty())
+    return fFrozenNUA.getInvWeight(phi, eta, vz);
   if (!fAccInt)
     createNUA();
   int xind = fAccInt->GetXaxis()->FindBin(phi);
@@ -157,6 +164,8 @@ double GFWWeights::getNUA(double phi, double eta, double vz)
 }
 double GFWWeights::getNUE(double pt, double eta, double vz)
 {
+  if (!fFrozenNUE.empty())
+    return fFrozenNUE.getInvWeight(pt, eta, vz);
   if (!fEffInt)
     createNUE();
   int xind = fEffInt->GetXaxis()->FindBin(pt);
@@ -167,6 +176,66 @@ double GFWWeights::getNUE(double pt, double eta, double vz)
     return 1. / weight;
   return 1;
 }
+void GFWWeights::FrozenMap::fill(const TH3D* h)
+{
+  const TAxis* hAxes[3] = {h->GetXaxis(), h->GetYaxis(), h->GetZaxis()};
+  for (int i = 0; i < 3; i++) {
+    axes[i].nBins = hAxes[i]->GetNbins();
+    axes[i].min = hAxes[i]->GetXmin();
+    axes[i].max = hAxes[i]->GetXmax();
+    axes[i].edges.clear();
+    const TArrayD* edges = hAxes[i]->GetXbins();
+    if (edges->GetSize() > 0)
+      axes[i].edges.assign(edges->GetArray(), edges->GetArray() + edges->GetSize());
+  }
+  invWeights.resize(static_cast<size_t>(axes[0].nBins + 2) * (axes[1].nBins + 2) * (axes[2].nBins + 2));
+  for (size_t bin = 0; bin < invWeights.size(); bin++) {
+    double weight = h->GetBinContent(bin);
+    invWeights[bin] = (weight != 0) ? 1. / weight : 1.;
+  }
+}
+void GFWWeights::freeze()
+{
+  // Frozen lookups are meant for weights that do not change anymore, e.g. once they are fetched from the CCDB.
+  // NUE is only frozen if it has already been created, since createNUE rebins the MC maps.
+  unfreeze();
+  if (fW_data) {
+    if (!fAccInt)
+      createNUA();
+    if (fAccInt)
+      fFrozenNUA.fill(fAccInt);
+    TH3D* th3 = reinterpret_cast<TH3D*>(fW_data->FindObject(getBinName(0, 0, "data")));
+    if (th3)
+      fFrozenData.fill(th3);
+  }
+  if (fW_mcrec) {
+    TH3D* th3 = reinterpret_cast<TH3D*>(fW_mcrec->FindObject(getBinName(0, 0, "mcrec")));
+    if (th3)
+      fFrozenRec.fill(th3);
+  }
+  if (fEffInt)
+    fFrozenNUE.fill(fEffInt);
+  fFrozen = true;
+}
+void GFWWeights::unfreeze()
+{
+  fFrozen = false;
+  fFrozenNUA = FrozenMap();
+  fFrozenNUE = FrozenMap();
+  fFrozenData = FrozenMap();
+  fFrozenRec = FrozenMap();
+}
+void GFWWeights::getWeights(std::span<const float> phi, std::span<const float> eta, std::span<const float> vz, std::span<float> out)
+{
+  if (!fFrozen)
+    freeze();
+  if (fFrozenNUA.empty()) {
+    std::fill(out.begin(), out.end(), 1.f);
+    return;
+  }
+  for (size_t i = 0; i < out.size(); i++)
+    out[i] = static_cast<float>(fFrozenNUA.getInvWeight(phi[i], eta[i], vz[i]));
+}
 double GFWWeights::findMax(TH3D* inh, int& ix, int& iy, int& iz)
 {
   double maxv = inh->GetBinContent(1, 1, 1);
@@ -183,6 +252,7 @@ double GFWWeights::findMax(TH3D* inh, int& ix, int& iy, int& iz)
 };
 void GFWWeights::mcToEfficiency()
 {
+  unfreeze();
   if (fW_mcgen->GetEntries() < 1) {
     LOGF(info, "MC gen. array empty. This is probably because effs. have been calculated and the generated particle histograms have been cleared out!\n");
     return;
@@ -198,6 +268,7 @@ void GFWWeights::mcToEfficiency()
 };
 void GFWWeights::rebinNUA(int nX, int nY, int nZ)
 {
+  unfreeze();
   if (fW_data->GetEntries() < 1)
     return;
   for (int i = 0; i < fW_data->GetEntries(); i++) {
@@ -208,6 +279,7 @@ void GFWWeights::rebinNUA(int nX, int nY, int nZ)
 };
 void GFWWeights::createNUA(bool IntegrateOverCentAndPt)
 {
+  unfreeze();
   if (!IntegrateOverCentAndPt) {
     LOGF(info, "Method is outdated! NUA is integrated over centrality and pT. Quit now, or the behaviour will be bad\n");
     return;
@@ -261,6 +333,7 @@ TH1D* GFWWeights::getdNdPhi()
 }
 void GFWWeights::createNUE(bool IntegrateOverCentrality)
 {
+  unfreeze();
   if (!IntegrateOverCentrality) {
     LOGF(info, "Method is outdated! NUE is integrated over centrality. Quit now, or the behaviour will be bad\n");
     return;
@@ -357,6 +430,7 @@ void GFWWeights::addArray(TObjArray* targ, TObjArray* sour)
 };
 void GFWWeights::overwriteNUA()
 {
+  unfreeze();
   if (!fAccInt)
     createNUA();
   TString ts(fW_data->At(0)->GetName());
@@ -484,6 +558,7 @@ void GFWWeights::mergeWeights(GFWWeights* other)
 }
 void GFWWeights::setTH3D(TH3D* th3d)
 {
+  unfreeze();
   if (!fW_data) {
     fW_data = new TObjArray();
     fW_data->SetName("GFWWeights_Data");
@@ -27,6 +27,10 @@
 #include "TCollection.h"
 #include "TString.h"
 
+#include <algorithm>
+#include <span>
+#include <vector>
+
 class GFWWeights : public TNamed
 {
  public:
@@ -38,6 +42,9 @@ class GFWWeights : public TNamed
   double getWeight(double phi, double eta, double vz, double pt, double cent, int htype);             // htype: 0 for data, 1 for mc rec, 2 for mc gen
   double getNUA(double phi, double eta, double vz);                                                   // This just fetches correction from integrated NUA, should speed up
   double getNUE(double pt, double eta, double vz);                                                    // fetches weight from fEffInt
+  void freeze();                                                                                      // copies the inverse weights into flat lookup tables, see FrozenMap
+  bool isFrozen() const { return fFrozen; }
+  void getWeights(std::span<const float> phi, std::span<const float> eta, std::span<const float> vz, std::span<float> out); // getNUA for a batch of tracks
   bool isDataFilled() { return fDataFilled; }
   bool isMCFilled() { return fMCFilled; }
   double findMax(TH3D* inh, int& ix, int& iy, int& iz);
@@ -74,6 +81,42 @@ class GFWWeights : public TNamed
   int fNbinsPt;    //! do not store
   double* fbinsPt; //! do not store
   void addArray(TObjArray* targ, TObjArray* sour);
+  void unfreeze();
+
+  // Inverse weights of a TH3D in a contiguous array with the TH3 global-bin layout (under- and overflow included),
+  // so that a lookup is three bin computations and one load instead of a FindObject, three TAxis::FindBin and a division
+  struct FrozenMap {
+    struct Axis {
+      int nBins = 0;
+      double min = 0.;
+      double max = 0.;
+      std::vector<double> edges; // only filled for variable binning
+      int findBin(double x) const // same result as TAxis::FindBin for a non-extendable axis
+      {
+        if (x < min)
+          return 0;
+        if (!(x < max))
+          return nBins + 1;
+        if (edges.empty())
+          return 1 + static_cast<int>(nBins * (x - min) / (max - min));
+        return static_cast<int>(std::upper_bound(edges.begin(), edges.end(), x) - edges.begin());
+      }
+    };
+    Axis axes[3];
+    std::vector<double> invWeights; // double, so that the frozen lookups return exactly 1. / weight as the unfrozen ones
+    void fill(const TH3D* h);
+    bool empty() const { return invWeights.empty(); }
+    double getInvWeight(double x, double y, double z) const
+    {
+      int bin = axes[0].findBin(x) + (axes[0].nBins + 2) * (axes[1].findBin(y) + (axes[1].nBins + 2) * axes[2].findBin(z));
+      return invWeights[bin];
+    }
+  };
+  bool fFrozen = false;  //!
+  FrozenMap fFrozenNUA;  //! from fAccInt
+  FrozenMap fFrozenNUE;  //! from fEffInt
+  FrozenMap fFrozenData; //! data map used by getWeight
+  FrozenMap fFrozenRec;  //! mc rec map used by getWeight
   const char* getBinName(double /*ptv*/, double /*v0mv*/, const char* pf = "")
   {
     int ptind = 0;  // GetPtBin(ptv);
@@ -467,6 +467,10 @@ struct FlowGenericFramework {
       } else {
         cfg.mAcceptance.push_back(ccdb->getForTimeStamp<GFWWeights>(cfgAcceptance.value + runstr, timestamp));
       }
+      for (auto& acceptance : cfg.mAcceptance) {
+        if (acceptance && !acceptance->isFrozen())
+          acceptance->freeze(); // flat NUA lookup tables for the per-track getNUA calls
+      }
     }
     if (!cfgEfficiency.value.empty()) {
       cfg.mEfficiency = ccdb->getForTimeStamp<TH1D>(cfgEfficiency, timestamp);
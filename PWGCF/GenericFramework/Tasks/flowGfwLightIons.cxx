@@ -618,6 +618,8 @@ struct FlowGfwLightIons {
     if (!cfgAcceptance.value.empty()) {
       std::string runstr = (cfgRunByRun) ? "RunByRun/" : "";
       cfg.mAcceptance = ccdb->getForTimeStamp<GFWWeights>(cfgAcceptance.value + runstr, timestamp);
+      if (cfg.mAcceptance && !cfg.mAcceptance->isFrozen())
+        cfg.mAcceptance->freeze(); // flat NUA lookup tables for the per-track getNUA calls
     }
     if (!cfgEfficiency.value.empty()) {
       cfg.mEfficiency = ccdb->getForTimeStamp<TH1D>(cfgEfficiency, timestamp);
@@ -266,6 +266,8 @@ struct Qvector {
                                                                                                    // Does NOT apply to Qa, Qb, etc., vectors, needed for eta separ.
   TComplex fQ[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}};       //! generic Q-vector
   TComplex fQvector[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{TComplex(0., 0.)}}; //! "integrated" Q-vector
+  std::complex<double> fQc[gMaxHarmonic * gMaxCorrelator + 1][gMaxCorrelator + 1] = {{0.}};      //! contiguous C++ copy of generic Q-vector fQ, used in Recursion(). Synchronized in CacheQ()
+  std::unordered_map<std::string, std::complex<double>> fRecursionCache;                          //! memoised terms of Recursion() for current generic Q-vector, key = (harmonics, power, skip)
 
   bool fCalculateqvectorsKineAny = false;                              // by default, it's off. It's set to true automatically if any of kine correlators is requested,
                                                                        // either for Correlations, Test0, EtaSeparations, etc.
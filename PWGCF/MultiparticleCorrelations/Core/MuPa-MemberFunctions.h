@@ -9575,6 +9575,7 @@ void FillEventHistograms(T1 const& collision, T2 const& tracks, eBeforeAfter ba)
           qv.fQ[h][wp] = qv.fQvector[h][wp];
         }
       }
+      CacheQ();
 
       for (int h = 1; h <= gMaxHarmonic; h++) {
         TComplex two = Two(h, -h);
@@ -9740,6 +9741,7 @@ void FillEventHistograms(T1 const& collision, T2 const& tracks, eBeforeAfter ba)
           qv.fQ[h][wp] = qv.fQvector[h][wp];
         }
       }
+      CacheQ();
 
       for (int h = 1; h <= gMaxHarmonic; h++) {
         TComplex two = Two(h, -h);
@@ -11423,6 +11425,7 @@ void CalculateCorrelations()
       qv.fQ[h][wp] = qv.fQvector[h][wp];
     }
   }
+  CacheQ();
 
   // b) Calculate correlations:
   for (int h = 1; h <= gMaxHarmonic; h++) // harmonic
@@ -11792,6 +11795,7 @@ void CalculateTest0()
       qv.fQ[h][wp] = qv.fQvector[h][wp];
     }
   }
+  CacheQ();
 
   // b) Calculate correlations:
   double correlation = 0.; // still has to be divided with 'weight' later, to get average correlation
@@ -12367,6 +12371,7 @@ void CalculateKineTest0Ndim(eqvectorKine kineVarChoice, int Ndim)
         qv.fQ[h][wp] = TComplex(qv.fqvector[kineVarChoice][b][h][wp].real(), qv.fqvector[kineVarChoice][b][h][wp].imag()); // TBI 20250601 check if there is a simpler way to initialize ROOT TComplex with C++ type 'complex'
       }
     }
+    CacheQ();
 
     if (tc.fVerbose) { // TBI 20250701 temporary check, remove eventually
       Trace(__FUNCTION__, __LINE__);
@@ -13634,18 +13639,37 @@ TComplex Twelve(int n1, int n2, int n3, int n4, int n5, int n6, int n7, int n8,
 
 //============================================================
 
-TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
+std::complex<double> RecursionStd(int n, int* harmonic, int mult = 1, int skip = 0)
 {
   // Calculate multi-particle correlators by using recursion (an improved faster version) originally developed by
   // Kristjan Gulbrandsen (gulbrand@nbi.dk).
+  // Each term is memoised in qv.fRecursionCache, keyed on (harmonics, power, skip), so that it is calculated only once for the
+  // current generic Q-vector. Without memoisation, the number of calls grows combinatorially with the order of correlator
+  // (e.g. ~8M calls vs. ~5k unique terms for 12-p correlator). The cache is flushed in CacheQ(), whenever generic Q-vector changes.
+
+  std::string key(n + 2, 0);
+  for (int i = 0; i < n; i++) {
+    key[i] = static_cast<char>(harmonic[i]); // |harmonic| <= gMaxHarmonic * gMaxCorrelator fits in char
+  }
+  key[n] = static_cast<char>(mult);
+  key[n + 1] = static_cast<char>(skip);
+  auto cached = qv.fRecursionCache.find(key);
+  if (cached != qv.fRecursionCache.end()) {
+    return cached->second;
+  }
 
   int nm1 = n - 1;
-  TComplex c(Q(harmonic[nm1], mult));
-  if (nm1 == 0)
+  int hnm1 = harmonic[nm1];
+  std::complex<double> c = hnm1 >= 0 ? qv.fQc[hnm1][mult] : std::conj(qv.fQc[-hnm1][mult]);
+  if (nm1 == 0) {
+    qv.fRecursionCache.emplace(std::move(key), c);
     return c;
-  c *= Recursion(nm1, harmonic);
-  if (nm1 == skip)
+  }
+  c *= RecursionStd(nm1, harmonic);
+  if (nm1 == skip) {
+    qv.fRecursionCache.emplace(std::move(key), c);
     return c;
+  }
 
   int multp1 = mult + 1;
   int nm2 = n - 2;
@@ -13653,7 +13677,7 @@ TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
   int hhold = harmonic[counter1];
   harmonic[counter1] = harmonic[nm2];
   harmonic[nm2] = hhold + harmonic[nm1];
-  TComplex c2(Recursion(nm1, harmonic, multp1, nm2));
+  std::complex<double> c2(RecursionStd(nm1, harmonic, multp1, nm2));
   int counter2 = n - 3;
   while (counter2 >= skip) {
     harmonic[nm2] = harmonic[counter1];
@@ -13662,20 +13686,48 @@ TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
     hhold = harmonic[counter1];
     harmonic[counter1] = harmonic[nm2];
     harmonic[nm2] = hhold + harmonic[nm1];
-    c2 += Recursion(nm1, harmonic, multp1, counter2);
+    c2 += RecursionStd(nm1, harmonic, multp1, counter2);
     --counter2;
   }
   harmonic[nm2] = harmonic[counter1];
   harmonic[counter1] = hhold;
 
-  if (mult == 1)
-    return c - c2;
-  return c - static_cast<double>(mult) * c2;
+  std::complex<double> result = (mult == 1) ? c - c2 : c - static_cast<double>(mult) * c2;
+  qv.fRecursionCache.emplace(std::move(key), result);
+  return result;
+
+} // std::complex<double> RecursionStd(int n, int* harmonic, int mult = 1, int skip = 0)
+
+//============================================================
+
+TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
+{
+  // Wrapper for RecursionStd(), which does all the work with C++ complex numbers and memoisation.
+
+  std::complex<double> c = RecursionStd(n, harmonic, mult, skip);
+  return TComplex(c.real(), c.imag());
 
 } // TComplex Recursion(int n, int* harmonic, int mult = 1, int skip = 0)
 
 //============================================================
 
+void CacheQ()
+{
+  // Synchronize the contiguous C++ copy of generic Q-vector with fQ, and flush all memoised terms of Recursion().
+  // Call it whenever the generic Q-vector fQ changes.
+
+  for (int h = 0; h < gMaxHarmonic * gMaxCorrelator + 1; h++) {
+    for (int wp = 0; wp < gMaxCorrelator + 1; wp++) // weight power
+    {
+      qv.fQc[h][wp] = std::complex<double>(qv.fQ[h][wp].Re(), qv.fQ[h][wp].Im());
+    }
+  }
+  qv.fRecursionCache.clear();
+
+} // void CacheQ()
+
+//============================================================
+
 void ResetQ()
 {
   // Reset the components of generic Q-vectors. Use it whenever you call the
@@ -13691,6 +13743,7 @@ void ResetQ()
       qv.fQ[h][wp] = TComplex(0., 0.);
     }
   }
+  CacheQ();
 
   if (tc.fVerbose) {
     ExitFunction(__FUNCTION__);
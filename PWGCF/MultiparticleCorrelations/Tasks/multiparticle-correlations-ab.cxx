@@ -96,6 +96,8 @@ using TracksRec_QA = TracksRec;    // if I would need additional tables for QA,
 #include <Riostream.h>
 
 #include <complex>
+#include <string>
+#include <unordered_map>
 using namespace std;
 
 // *) Enums:
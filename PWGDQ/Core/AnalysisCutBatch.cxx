@@ -0,0 +1,308 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+#include "PWGDQ/Core/AnalysisCutBatch.h"
+
+#include "PWGDQ/Core/VarManager.h"
+
+#include "Framework/Logger.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+//____________________________________________________________________________
+AnalysisCutBatch::AnalysisCutBatch(int nLutPoints) : fNLutPoints(nLutPoints),
+                                                     fVarToColumn(VarManager::kNVars, -1),
+                                                     fColumnVars(),
+                                                     fRangeCuts(),
+                                                     fNodes(),
+                                                     fChildren(),
+                                                     fRootNodes(),
+                                                     fLuts(),
+                                                     fNCandidates(0),
+                                                     fCapacity(0),
+                                                     fColumns(),
+                                                     fResults(),
+                                                     fLimitLow(),
+                                                     fLimitHigh(),
+                                                     fMasks()
+{
+  //
+  // constructor
+  //
+  if (fNLutPoints == 1) {
+    fNLutPoints = 2;
+  }
+}
+
+//____________________________________________________________________________
+int AnalysisCutBatch::AddCut(AnalysisCut* cut)
+{
+  //
+  // compile the cut tree into the node list and return the bit assigned to this cut
+  //
+  if (fRootNodes.size() >= 64) {
+    LOG(fatal) << "AnalysisCutBatch: at most 64 cuts can be evaluated in one batch";
+  }
+  if (fNCandidates > 0) {
+    LOG(fatal) << "AnalysisCutBatch: cuts must be added before the candidates";
+  }
+  int node = (cut->IsA() == AnalysisCompositeCut::Class() ? CompileCompositeCut(*static_cast<AnalysisCompositeCut*>(cut)) : CompileCut(*cut));
+  fRootNodes.push_back(node);
+  return fRootNodes.size() - 1;
+}
+
+//____________________________________________________________________________
+int AnalysisCutBatch::CompileCut(const AnalysisCut& cut)
+{
+  //
+  // add a leaf node with all the range cuts of an AnalysisCut
+  //
+  Node node;
+  node.type = kLeaf;
+  node.first = fRangeCuts.size();
+  for (const auto& c : cut.GetCuts()) {
+    RangeCut rc;
+    rc.col = GetColumn(c.fVar);
+    rc.low = c.fLow;
+    rc.high = c.fHigh;
+    rc.exclude = c.fExclude;
+    rc.depCol = (c.fDepVar != -1 ? GetColumn(c.fDepVar) : -1);
+    rc.depLow = c.fDepLow;
+    rc.depHigh = c.fDepHigh;
+    rc.depExclude = c.fDepExclude;
+    rc.dep2Col = (c.fDepVar2 != -1 ? GetColumn(c.fDepVar2) : -1);
+    rc.dep2Low = c.fDep2Low;
+    rc.dep2High = c.fDep2High;
+    rc.dep2Exclude = c.fDep2Exclude;
+    rc.funcLow = c.fFuncLow;
+    rc.funcHigh = c.fFuncHigh;
+    if ((rc.funcLow || rc.funcHigh) && rc.depCol == -1) {
+      LOG(fatal) << "AnalysisCutBatch: cut " << cut.GetName() << " uses a function limit without a dependent variable";
+    }
+    rc.lutLow = MakeLut(rc.funcLow);
+    rc.lutHigh = MakeLut(rc.funcHigh);
+    fRangeCuts.push_back(rc);
+  }
+  node.last = fRangeCuts.size();
+  fNodes.push_back(node);
+  return fNodes.size() - 1;
+}
+
+//____________________________________________________________________________
+int AnalysisCutBatch::CompileCompositeCut(const AnalysisCompositeCut& cut)
+{
+  //
+  // compile the children first, then add the composite node
+  //   the children are ordered as in AnalysisCompositeCut::IsSelected(): simple cuts first, then composite cuts
+  //
+  std::vector<int> children;
+  for (const auto& c : cut.GetCutList()) {
+    children.push_back(CompileCut(c));
+  }
+  for (const auto& c : cut.GetCompositeCutList()) {
+    children.push_back(CompileCompositeCut(c));
+  }
+  Node node;
+  node.type = (cut.GetUseAND() ? kAND : kOR);
+  node.first = fChildren.size();
+  fChildren.insert(fChildren.end(), children.begin(), children.end());
+  node.last = fChildren.size();
+  fNodes.push_back(node);
+  return fNodes.size() - 1;
+}
+
+//____________________________________________________________________________
+int AnalysisCutBatch::GetColumn(int var)
+{
+  //
+  // return the column holding a variable, adding a new one if needed
+  //
+  if (fVarToColumn[var] == -1) {
+    fVarToColumn[var] = fColumnVars.size();
+    fColumnVars.push_back(var);
+  }
+  return fVarToColumn[var];
+}
+
+//____________________________________________________________________________
+int AnalysisCutBatch::MakeLut(TF1* func)
+{
+  //
+  // tabulate a limit function over its range, if lookup tables are enabled
+  //
+  if (!func || fNLutPoints <= 0) {
+    return -1;
+  }
+  Lut lut;
+  lut.xmin = func->GetXmin();
+  lut.xmax = func->GetXmax();
+  if (!(lut.xmax > lut.xmin)) {
+    return -1;
+  }
+  double step = (lut.xmax - lut.xmin) / (fNLutPoints - 1);
+  lut.invStep = 1.0 / step;
+  lut.values.resize(fNLutPoints);
+  for (int i = 0; i < fNLutPoints; ++i) {
+    lut.values[i] = func->Eval(lut.xmin + i * step);
+  }
+  fLuts.push_back(std::move(lut));
+  return fLuts.size() - 1;
+}
+
+//____________________________________________________________________________
+void AnalysisCutBatch::ResizeColumns(int capacity)
+{
+  //
+  // grow the column storage, keeping the candidates already added
+  //
+  int nCols = fColumnVars.size();
+  std::vector<float> columns(static_cast<size_t>(nCols) * capacity);
+  for (int col = 0; col < nCols; ++col) {
+    std::copy_n(fColumns.begin() + static_cast<size_t>(col) * fCapacity, fNCandidates, columns.begin() + static_cast<size_t>(col) * capacity);
+  }
+  fColumns.swap(columns);
+  fCapacity = capacity;
+}
+
+//____________________________________________________________________________
+void AnalysisCutBatch::Reserve(int nCandidates)
+{
+  if (nCandidates > fCapacity) {
+    ResizeColumns(nCandidates);
+  }
+}
+
+//____________________________________________________________________________
+void AnalysisCutBatch::AddCandidate(const float* values)
+{
+  //
+  // copy the used variables of one candidate (as filled by the VarManager) into the columns
+  //
+  if (fNCandidates == fCapacity) {
+    ResizeColumns(std::max(2 * fCapacity, 64));
+  }
+  float* column = fColumns.data() + fNCandidates;
+  for (const auto& var : fColumnVars) {
+    *column = values[var];
+    column += fCapacity;
+  }
+  fNCandidates++;
+}
+
+//____________________________________________________________________________
+void AnalysisCutBatch::EvaluateLimits(TF1* func, int lut, const float* x, float* limits, int n)
+{
+  //
+  // evaluate a limit function for all candidates, using the lookup table where available
+  //
+  if (lut < 0) {
+    for (int i = 0; i < n; ++i) {
+      limits[i] = func->Eval(x[i]);
+    }
+    return;
+  }
+  const Lut& table = fLuts[lut];
+  const int nPoints = table.values.size();
+  for (int i = 0; i < n; ++i) {
+    if (x[i] < table.xmin || x[i] > table.xmax) {
+      limits[i] = func->Eval(x[i]);
+      continue;
+    }
+    double t = (x[i] - table.xmin) * table.invStep;
+    int bin = std::min(static_cast<int>(t), nPoints - 2);
+    float frac = t - bin;
+    limits[i] = table.values[bin] + frac * (table.values[bin + 1] - table.values[bin]);
+  }
+}
+
+//____________________________________________________________________________
+const std::vector<uint64_t>& AnalysisCutBatch::Evaluate()
+{
+  //
+  // evaluate all the nodes over the current batch of candidates
+  //   the nodes are ordered such that the children are always evaluated before their parent
+  //
+  const int n = fNCandidates;
+  fMasks.assign(n, 0);
+  if (n == 0) {
+    return fMasks;
+  }
+  fResults.resize(fNodes.size() * static_cast<size_t>(n));
+  fLimitLow.resize(n);
+  fLimitHigh.resize(n);
+
+  for (size_t inode = 0; inode < fNodes.size(); ++inode) {
+    const Node& node = fNodes[inode];
+    uint8_t* result = fResults.data() + inode * n;
+
+    if (node.type == kLeaf) {
+      std::fill_n(result, n, 1);
+      for (int icut = node.first; icut < node.last; ++icut) {
+        const RangeCut& rc = fRangeCuts[icut];
+        const float* v = fColumns.data() + static_cast<size_t>(rc.col) * fCapacity;
+        const float* dep = (rc.depCol != -1 ? fColumns.data() + static_cast<size_t>(rc.depCol) * fCapacity : nullptr);
+        const float* dep2 = (rc.dep2Col != -1 ? fColumns.data() + static_cast<size_t>(rc.dep2Col) * fCapacity : nullptr);
+        // constant limits are broadcast, function limits are evaluated for all candidates at once
+        const float* low = nullptr;
+        const float* high = nullptr;
+        if (rc.funcLow) {
+          EvaluateLimits(rc.funcLow, rc.lutLow, dep, fLimitLow.data(), n);
+          low = fLimitLow.data();
+        }
+        if (rc.funcHigh) {
+          EvaluateLimits(rc.funcHigh, rc.lutHigh, dep, fLimitHigh.data(), n);
+          high = fLimitHigh.data();
+        }
+        for (int i = 0; i < n; ++i) {
+          // the cut applies only if the dependent variables are in (or out of, if exclusion is used) their range
+          bool applies = true;
+          if (dep) {
+            applies &= ((dep[i] > rc.depLow && dep[i] <= rc.depHigh) != rc.depExclude);
+          }
+          if (dep2) {
+            applies &= ((dep2[i] > rc.dep2Low && dep2[i] <= rc.dep2High) != rc.dep2Exclude);
+          }
+          float cutLow = (low ? low[i] : rc.low);
+          float cutHigh = (high ? high[i] : rc.high);
+          bool pass = ((v[i] >= cutLow && v[i] <= cutHigh) != rc.exclude);
+          result[i] &= static_cast<uint8_t>(!applies || pass);
+        }
+      }
+      continue;
+    }
+
+    // composite node: empty AND selects everything, empty OR selects nothing
+    const bool useAND = (node.type == kAND);
+    std::fill_n(result, n, static_cast<uint8_t>(useAND));
+    for (int ichild = node.first; ichild < node.last; ++ichild) {
+      const uint8_t* child = fResults.data() + static_cast<size_t>(fChildren[ichild]) * n;
+      if (useAND) {
+        for (int i = 0; i < n; ++i) {
+          result[i] &= child[i];
+        }
+      } else {
+        for (int i = 0; i < n; ++i) {
+          result[i] |= child[i];
+        }
+      }
+    }
+  }
+
+  for (size_t icut = 0; icut < fRootNodes.size(); ++icut) {
+    const uint8_t* result = fResults.data() + static_cast<size_t>(fRootNodes[icut]) * n;
+    for (int i = 0; i < n; ++i) {
+      fMasks[i] |= (static_cast<uint64_t>(result[i]) << icut);
+    }
+  }
+  return fMasks;
+}
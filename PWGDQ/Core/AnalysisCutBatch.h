@@ -0,0 +1,114 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+//
+// Contact: iarsene@cern.ch, i.c.arsene@fys.uio.no
+//
+// Class to evaluate a set of analysis cuts on batches of candidates
+//   The cut trees (AnalysisCut and AnalysisCompositeCut) are compiled into a flat list of nodes which is evaluated
+//   over columns (one per used variable) of N candidates at once. The result is a selection bit mask for each candidate,
+//   with one bit per cut, in the order in which the cuts were added.
+//   Optionally, the TF1 cut limits are precomputed into lookup tables with linear interpolation (nLutPoints > 0),
+//   otherwise they are evaluated exactly, as in AnalysisCut::IsSelected()
+//
+
+#ifndef PWGDQ_CORE_ANALYSISCUTBATCH_H_
+#define PWGDQ_CORE_ANALYSISCUTBATCH_H_
+
+#include "PWGDQ/Core/AnalysisCompositeCut.h"
+#include "PWGDQ/Core/AnalysisCut.h"
+
+#include <TF1.h>
+
+#include <cstdint>
+#include <vector>
+
+class AnalysisCutBatch
+{
+ public:
+  explicit AnalysisCutBatch(int nLutPoints = 0);
+  ~AnalysisCutBatch() = default;
+
+  // compile a cut and add it to the batch; returns the bit of this cut in the selection masks
+  int AddCut(AnalysisCut* cut);
+  int GetNCuts() const { return fRootNodes.size(); }
+
+  // candidates are added one by one, only the variables used by the cuts are copied into the columns
+  void Reserve(int nCandidates);
+  void AddCandidate(const float* values);
+  void ClearCandidates() { fNCandidates = 0; }
+  int GetNCandidates() const { return fNCandidates; }
+
+  // evaluate all the cuts on all the candidates added since the last ClearCandidates()
+  // returns one selection mask per candidate; bit i is set if the candidate passes the i-th cut
+  const std::vector<uint64_t>& Evaluate();
+
+ private:
+  enum NodeType {
+    kLeaf = 0, // AND of the range cuts of one AnalysisCut
+    kAND,      // AND of the children nodes
+    kOR        // OR of the children nodes
+  };
+  struct Node {
+    int type;  // one of NodeType
+    int first; // first range cut (kLeaf) or first child index in fChildren (kAND, kOR)
+    int last;  // end of the range
+  };
+  struct RangeCut {
+    int col;         // column of the variable to cut upon
+    float low;       // lower limit
+    float high;      // upper limit
+    bool exclude;    // use the range for exclusion
+    int depCol;      // column of the first dependent variable (-1 if not used)
+    float depLow;    // lower limit for the first dependent variable
+    float depHigh;   // upper limit for the first dependent variable
+    bool depExclude; // use the dependent variable range for exclusion
+    int dep2Col;     // column of the second dependent variable (-1 if not used)
+    float dep2Low;   // lower limit for the second dependent variable
+    float dep2High;  // upper limit for the second dependent variable
+    bool dep2Exclude;
+    TF1* funcLow;  // function of the first dependent variable for the lower limit
+    TF1* funcHigh; // function of the first dependent variable for the upper limit
+    int lutLow;    // index of the lookup table of funcLow in fLuts (-1 if not used)
+    int lutHigh;   // index of the lookup table of funcHigh in fLuts (-1 if not used)
+  };
+  struct Lut {
+    double xmin;
+    double xmax;
+    double invStep;
+    std::vector<float> values;
+  };
+
+  int CompileCut(const AnalysisCut& cut);
+  int CompileCompositeCut(const AnalysisCompositeCut& cut);
+  int GetColumn(int var);
+  int MakeLut(TF1* func);
+  void EvaluateLimits(TF1* func, int lut, const float* x, float* limits, int n);
+  void ResizeColumns(int capacity);
+
+  int fNLutPoints;                  // number of points in the lookup tables of the TF1 limits (0: exact evaluation)
+  std::vector<int> fVarToColumn;    // column of each variable (-1 if not used)
+  std::vector<int> fColumnVars;     // variable of each column
+  std::vector<RangeCut> fRangeCuts; // all range cuts of all the leaves
+  std::vector<Node> fNodes;         // nodes, ordered such that children come before their parent
+  std::vector<int> fChildren;       // children indices of the composite nodes
+  std::vector<int> fRootNodes;      // node of each added cut
+  std::vector<Lut> fLuts;           // lookup tables for the TF1 limits
+
+  int fNCandidates;            // number of candidates in the current batch
+  int fCapacity;               // allocated number of candidates per column
+  std::vector<float> fColumns; // SoA storage of the used variables, column-major
+  std::vector<uint8_t> fResults; // per node decision for each candidate
+  std::vector<float> fLimitLow;  // scratch for function limits
+  std::vector<float> fLimitHigh; // scratch for function limits
+  std::vector<uint64_t> fMasks;  // selection masks
+};
+
+#endif // PWGDQ_CORE_ANALYSISCUTBATCH_H_
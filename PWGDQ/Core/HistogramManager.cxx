@@ -45,7 +45,8 @@ HistogramManager::HistogramManager() : TNamed("", ""),
                                        fUseDefaultVariableNames(false),
                                        fBinsAllocated(0),
                                        fVariableNames(nullptr),
-                                       fVariableUnits(nullptr)
+                                       fVariableUnits(nullptr),
+                                       fPlanDirty(true)
 {
   //
   // Constructor
@@ -61,7 +62,8 @@ HistogramManager::HistogramManager(const char* name, const char* title, const in
                                                                                               fUseDefaultVariableNames(kFALSE),
                                                                                               fBinsAllocated(0),
                                                                                               fVariableNames(),
-                                                                                              fVariableUnits()
+                                                                                              fVariableUnits(),
+                                                                                              fPlanDirty(true)
 {
   //
   // Constructor
@@ -116,6 +118,8 @@ void HistogramManager::AddHistClass(const char* histClass)
   fMainList->Add(hList);
   std::list<std::vector<int>> varList;
   fVariablesMap[histClass] = varList;
+  fPlanHandles.erase(histClass); // in case it was looked up before being created
+  fPlanDirty = true;
 }
 
 //_________________________________________________________________
@@ -187,6 +191,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fPlanDirty = true;
 
   // create and configure histograms according to required options
   TH1* h = nullptr;
@@ -397,6 +402,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fPlanDirty = true;
 
   TH1* h = nullptr;
   switch (dimension) {
@@ -582,6 +588,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fPlanDirty = true;
 
   uint32_t nbins = 1;
   THnBase* h = nullptr;
@@ -675,6 +682,7 @@ void HistogramManager::AddHistogram(const char* histClass, const char* hname, co
   std::list varList = fVariablesMap[histClass];
   varList.push_back(varVector);
   fVariablesMap[histClass] = varList;
+  fPlanDirty = true;
 
   // get the min and max for each axis
   auto* xmin = new double[nDimensions];
@@ -746,150 +754,183 @@ void HistogramManager::FillHistClass(const char* className, Float_t* values)
   //
   //  fill a class of histograms
   //
-
-  // get the needed histogram list
-  auto* hList = reinterpret_cast<TList*>(fMainList->FindObject(className));
-  if (!hList) {
+  int handle = GetHistClassHandle(className);
+  if (handle < 0) {
     // TODO: add some meaningfull error message
     /*LOG(warn) << "HistogramManager::FillHistClass(): Histogram list " << className << " not found!";
     LOG(warn) << "         Histogram list not filled" << endl; */
     return;
   }
+  FillHistClass(handle, values);
+}
 
-  // get the corresponding std::list containng identifiers to the needed variables to be filled
-  auto const& varList = fVariablesMap[className];
+//____________________________________________________________________________________
+int HistogramManager::GetHistClassHandle(const char* className)
+{
+  //
+  // get the handle of a histogram class, create it if needed
+  //
+  auto handleIt = fPlanHandles.find(className);
+  if (handleIt != fPlanHandles.end()) {
+    return handleIt->second;
+  }
+  int handle = -1;
+  if (fMainList->FindObject(className)) {
+    handle = fPlanClassNames.size();
+    fPlanClassNames.emplace_back(className);
+    fPlanDirty = true;
+  }
+  fPlanHandles[className] = handle;
+  return handle;
+}
 
-  TIter next(hList);
+//____________________________________________________________________________________
+void HistogramManager::CompileFillPlans()
+{
+  //
+  // translate the histogram lists and variable maps into flat fill plans, one for each handle
+  //
+  fPlanEntries.clear();
+  fPlanVars.clear();
+  fPlanRanges.clear();
+  for (const auto& className : fPlanClassNames) {
+    int first = fPlanEntries.size();
+    auto* hList = reinterpret_cast<TList*>(fMainList->FindObject(className.c_str()));
+    if (hList) {
+      auto const& varList = fVariablesMap[className];
+      TIter next(hList);
+      // NOTE: the histogram list and the std::list should contain the same number of elements and be synchronized
+      for (auto varIter = varList.begin(); varIter != varList.end(); varIter++) {
+        TObject* h = next();
+        FillPlanEntry entry{h, kFillTH1, -1, -1, -1, -1, (*varIter)[2], false, 0, 0};
+        bool isProfile = ((*varIter)[0] == 1 ? true : false);
+        if ((*varIter)[1] > 0) {
+          entry.kind = kFillTHn;
+          entry.nDim = (*varIter)[1];
+          entry.varOffset = fPlanVars.size();
+          for (int i = 0; i < entry.nDim; i++) {
+            fPlanVars.push_back((*varIter)[3 + i]);
+          }
+        } else {
+          int dimension = (reinterpret_cast<TH1*>(h))->GetDimension();
+          entry.kind = (isProfile ? kFillProfile : kFillTH1) + (dimension - 1);
+          entry.varX = (*varIter)[3];
+          entry.varY = (*varIter)[4];
+          entry.varZ = (*varIter)[5];
+          entry.varT = (*varIter)[6];
+          entry.isFillLabelx = ((*varIter)[7] == 1 ? true : false);
+        }
+        fPlanEntries.push_back(entry);
+      }
+    }
+    fPlanRanges.emplace_back(first, static_cast<int>(fPlanEntries.size()));
+  }
+  fPlanDirty = false;
+}
+
+//____________________________________________________________________________________
+void HistogramManager::FillHistClass(int handle, Float_t* values)
+{
+  //
+  //  fill a class of histograms, using its compiled fill plan
+  //
+  if (handle < 0) {
+    return;
+  }
+  if (fPlanDirty) {
+    CompileFillPlans();
+  }
 
-  TObject* h = nullptr;
-  bool isProfile;
-  bool isTHn;
-  int dimension = 0;
-  bool isSparse = kFALSE;
-  bool isFillLabelx = kFALSE;
   // TODO: At the moment, maximum 20 dimensions are foreseen for the THn histograms. We should make this more dynamic
   //       But maybe its better to have it like to avoid dynamically allocating this array in the histogram loop
   double fillValues[20] = {0.0};
-  int varX = -1, varY = -1, varZ = -1, varT = -1, varW = -1;
-
-  // loop over the histogram and std::list
-  // NOTE: these two should contain the same number of elements and be synchronized, otherwise its a mess
-  for (auto varIter = varList.begin(); varIter != varList.end(); varIter++) {
-    h = next(); // get the histogram
-    // decode information from the vector of indices
-    isProfile = ((*varIter)[0] == 1 ? true : false);
-    isTHn = ((*varIter)[1] > 0 ? true : false);
-    if (isTHn) {
-      dimension = (*varIter)[1];
-    } else {
-      dimension = (reinterpret_cast<TH1*>(h))->GetDimension();
-    }
 
-    // get the various variable indices
-    varW = (*varIter)[2];
-    if (isTHn) {
-      for (int i = 0; i < dimension; i++) {
-        fillValues[i] = values[(*varIter)[3 + i]];
-      }
-    } else {
-      varX = (*varIter)[3];
-      varY = (*varIter)[4];
-      varZ = (*varIter)[5];
-      varT = (*varIter)[6];
-      isFillLabelx = ((*varIter)[7] == 1 ? true : false);
-    }
-
-    if (!isTHn) {
-      switch (dimension) {
-        case 1:
-          if (isProfile) {
-            if (varW > kNothing) {
-              if (isFillLabelx) {
-                (reinterpret_cast<TProfile*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], values[varW]);
-              } else {
-                (reinterpret_cast<TProfile*>(h))->Fill(values[varX], values[varY], values[varW]);
-              }
-            } else {
-              if (isFillLabelx) {
-                (reinterpret_cast<TProfile*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY]);
-              } else {
-                (reinterpret_cast<TProfile*>(h))->Fill(values[varX], values[varY]);
-              }
-            }
+  const auto& range = fPlanRanges[handle];
+  for (int iEntry = range.first; iEntry < range.second; iEntry++) {
+    const FillPlanEntry& entry = fPlanEntries[iEntry];
+    TObject* h = entry.hist;
+    const int varX = entry.varX, varY = entry.varY, varZ = entry.varZ, varT = entry.varT, varW = entry.varW;
+    switch (entry.kind) {
+      case kFillProfile:
+        if (varW > kNothing) {
+          if (entry.isFillLabelx) {
+            (reinterpret_cast<TProfile*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], values[varW]);
           } else {
-            if (varW > kNothing) {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH1*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varW]);
-              } else {
-                (reinterpret_cast<TH1*>(h))->Fill(values[varX], values[varW]);
-              }
-            } else {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH1*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), 1.);
-              } else {
-                (reinterpret_cast<TH1*>(h))->Fill(values[varX]);
-              }
-            }
+            (reinterpret_cast<TProfile*>(h))->Fill(values[varX], values[varY], values[varW]);
           }
-          break;
-        case 2:
-          if (isProfile) {
-            if (varW > kNothing) {
-              (reinterpret_cast<TProfile2D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              (reinterpret_cast<TProfile2D*>(h))->Fill(values[varX], values[varY], values[varZ]);
-            }
+        } else {
+          if (entry.isFillLabelx) {
+            (reinterpret_cast<TProfile*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY]);
           } else {
-            if (varW > kNothing) {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH2*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], values[varW]);
-              } else {
-                (reinterpret_cast<TH2*>(h))->Fill(values[varX], values[varY], values[varW]);
-              }
-            } else {
-              if (isFillLabelx) {
-                (reinterpret_cast<TH2*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], 1.);
-              } else {
-                (reinterpret_cast<TH2*>(h))->Fill(values[varX], values[varY]);
-              }
-            }
+            (reinterpret_cast<TProfile*>(h))->Fill(values[varX], values[varY]);
           }
-          break;
-        case 3:
-          if (isProfile) {
-            if (varW > kNothing) {
-              (reinterpret_cast<TProfile3D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varT], values[varW]);
-            } else {
-              (reinterpret_cast<TProfile3D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varT]);
-            }
+        }
+        break;
+      case kFillTH1:
+        if (varW > kNothing) {
+          if (entry.isFillLabelx) {
+            (reinterpret_cast<TH1*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varW]);
           } else {
-            if (varW > kNothing) {
-              (reinterpret_cast<TH3*>(h))->Fill(values[varX], values[varY], values[varZ], values[varW]);
-            } else {
-              (reinterpret_cast<TH3*>(h))->Fill(values[varX], values[varY], values[varZ]);
-            }
+            (reinterpret_cast<TH1*>(h))->Fill(values[varX], values[varW]);
           }
-          break;
-
-        default:
-          break;
-      } // end switch
-      // end if(!isTHn)
-    } else {
-      if (varW > kNothing) {
-        if (isSparse) {
-          (reinterpret_cast<THnSparse*>(h))->Fill(fillValues, values[varW]);
         } else {
-          (reinterpret_cast<THn*>(h))->Fill(fillValues, values[varW]);
+          if (entry.isFillLabelx) {
+            (reinterpret_cast<TH1*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), 1.);
+          } else {
+            (reinterpret_cast<TH1*>(h))->Fill(values[varX]);
+          }
         }
-      } else {
-        if (isSparse) {
-          (reinterpret_cast<THnSparse*>(h))->Fill(fillValues);
+        break;
+      case kFillProfile2D:
+        if (varW > kNothing) {
+          (reinterpret_cast<TProfile2D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varW]);
         } else {
-          (reinterpret_cast<THn*>(h))->Fill(fillValues);
+          (reinterpret_cast<TProfile2D*>(h))->Fill(values[varX], values[varY], values[varZ]);
         }
-      }
-    } // end else
+        break;
+      case kFillTH2:
+        if (varW > kNothing) {
+          if (entry.isFillLabelx) {
+            (reinterpret_cast<TH2*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], values[varW]);
+          } else {
+            (reinterpret_cast<TH2*>(h))->Fill(values[varX], values[varY], values[varW]);
+          }
+        } else {
+          if (entry.isFillLabelx) {
+            (reinterpret_cast<TH2*>(h))->Fill(Form("%d", static_cast<int>(values[varX])), values[varY], 1.);
+          } else {
+            (reinterpret_cast<TH2*>(h))->Fill(values[varX], values[varY]);
+          }
+        }
+        break;
+      case kFillProfile3D:
+        if (varW > kNothing) {
+          (reinterpret_cast<TProfile3D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varT], values[varW]);
+        } else {
+          (reinterpret_cast<TProfile3D*>(h))->Fill(values[varX], values[varY], values[varZ], values[varT]);
+        }
+        break;
+      case kFillTH3:
+        if (varW > kNothing) {
+          (reinterpret_cast<TH3*>(h))->Fill(values[varX], values[varY], values[varZ], values[varW]);
+        } else {
+          (reinterpret_cast<TH3*>(h))->Fill(values[varX], values[varY], values[varZ]);
+        }
+        break;
+      case kFillTHn:
+        for (int i = 0; i < entry.nDim; i++) {
+          fillValues[i] = values[fPlanVars[entry.varOffset + i]];
+        }
+        // THn and THnSparse share the filling interface of THnBase
+        if (varW > kNothing) {
+          (reinterpret_cast<THnBase*>(h))->Fill(fillValues, values[varW]);
+        } else {
+          (reinterpret_cast<THnBase*>(h))->Fill(fillValues);
+        }
+        break;
+      default:
+        break;
+    } // end switch
   } // end loop over histograms
 }
 
@@ -26,6 +26,7 @@
 
 #include <string>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <list>
 
@@ -47,6 +48,9 @@ class HistogramManager : public TNamed
       delete fMainList;
     }
     fMainList = list;
+    // fill plans are recompiled from the new list, classes not found so far are searched again
+    fPlanDirty = true;
+    std::erase_if(fPlanHandles, [](const auto& handle) { return handle.second < 0; });
   }
 
   // Create a new histogram class
@@ -85,6 +89,10 @@ class HistogramManager : public TNamed
                     TString* axLabels = nullptr, int varW = -1, bool useSparse = kFALSE, bool isdouble = false);
 
   void FillHistClass(const char* className, float* values);
+  // Get an integer handle for a histogram class, to be used with FillHistClass(int, float*) in order to avoid any string lookup
+  // Returns -1 if the class does not exist. Handles stay valid also if histograms are added later
+  int GetHistClassHandle(const char* className);
+  void FillHistClass(int handle, float* values);
 
   void SetUseDefaultVariableNames(bool flag) { fUseDefaultVariableNames = flag; }
   void SetDefaultVarNames(TString* vars, TString* units);
@@ -108,6 +116,32 @@ class HistogramManager : public TNamed
   TString* fVariableNames;          //! variable names
   TString* fVariableUnits;          //! variable units
 
+  // compiled fill plans: for each histogram class, a flat list of the histograms to be filled and their variables
+  enum FillKind {
+    kFillTH1 = 0,
+    kFillTH2,
+    kFillTH3,
+    kFillProfile,
+    kFillProfile2D,
+    kFillProfile3D,
+    kFillTHn
+  };
+  struct FillPlanEntry {
+    TObject* hist;     // histogram to be filled
+    int kind;          // one of FillKind
+    int varX, varY, varZ, varT, varW;
+    bool isFillLabelx; // fill using the x-axis labels
+    int nDim;          // number of dimensions for THn
+    int varOffset;     // offset of the THn axes variables in fPlanVars
+  };
+  std::unordered_map<std::string, int> fPlanHandles;  //! handles of histogram classes (-1 for classes not found)
+  std::vector<std::string> fPlanClassNames;           //! histogram class name for each handle
+  std::vector<std::pair<int, int>> fPlanRanges;       //! [first, last) range in fPlanEntries for each handle
+  std::vector<FillPlanEntry> fPlanEntries;            //! histograms to be filled, contiguous for each class
+  std::vector<int> fPlanVars;                         //! THn axes variables
+  bool fPlanDirty;                                    //! histograms were added since the plans were compiled
+
+  void CompileFillPlans();
   void MakeAxisLabels(TAxis* ax, const char* labels);
 
   HistogramManager& operator=(const HistogramManager& c);
@@ -14,6 +14,7 @@
 
 #include "PWGDQ/Core/AnalysisCompositeCut.h"
 #include "PWGDQ/Core/AnalysisCut.h"
+#include "PWGDQ/Core/AnalysisCutBatch.h"
 #include "PWGDQ/Core/CutsLibrary.h"
 #include "PWGDQ/Core/DQMlResponse.h"
 #include "PWGDQ/Core/HistogramManager.h"
@@ -580,12 +581,18 @@ struct AnalysisTrackSelection {
   Configurable<std::string> grpmagPath{"grpmagPath", "GLO/Config/GRPMagField", "CCDB path of the GRPMagField object"};
   // Track related options
   Configurable<bool> fPropTrack{"cfgPropTrack", true, "Propgate tracks to associated collision to recalculate DCA and momentum vector"};
+  Configurable<bool> fConfigBatchCuts{"cfgBatchCuts", false, "If true, evaluate the track cuts on all the associations of the dataframe at once (not used if cfgQA is true)"};
+  Configurable<int> fConfigBatchLutPoints{"cfgBatchLutPoints", 0, "Number of points of the lookup tables for the TF1 cut limits in the batched evaluation (0: exact evaluation)"};
+  Configurable<bool> fConfigBatchCheck{"cfgBatchCheck", false, "If true, cross-check the batched decisions against AnalysisCompositeCut::IsSelected and report the mismatches"};
 
   Service<o2::ccdb::BasicCCDBManager> fCCDB;
   o2::ccdb::CcdbApi fCCDBApi;
 
   HistogramManager* fHistMan;
   std::vector<AnalysisCompositeCut*> fTrackCuts;
+  AnalysisCutBatch* fTrackCutBatch = nullptr; // batched evaluation of fTrackCuts, if enabled
+  std::vector<int> fBatchCandidates;          // candidate index of each association in the batch, -1 if the event is not selected
+  std::vector<uint32_t> fReferenceFilterMaps; // decisions of AnalysisCompositeCut::IsSelected, for the cross-check of the batch
 
   int fCurrentRun; // current run kept to detect run changes and trigger loading params from CCDB
 
@@ -618,6 +625,18 @@ struct AnalysisTrackSelection {
 
     VarManager::SetUseVars(AnalysisCut::fgUsedVars); // provide the list of required variables so that VarManager knows what to fill
 
+    // the per cut QA histograms need the values of each track, so the batched evaluation is used only without QA
+    if (fConfigBatchCuts) {
+      if (fConfigQA) {
+        LOG(warning) << "cfgBatchCuts is ignored since cfgQA is enabled";
+      } else {
+        fTrackCutBatch = new AnalysisCutBatch(fConfigBatchLutPoints);
+        for (auto& cut : fTrackCuts) {
+          fTrackCutBatch->AddCut(cut);
+        }
+      }
+    }
+
     if (fConfigQA) {
       fHistMan = new HistogramManager("analysisHistos", "aa", VarManager::kNVars);
       fHistMan->SetUseDefaultVariableNames(kTRUE);
@@ -645,6 +664,79 @@ struct AnalysisTrackSelection {
     fCCDBApi.init(fConfigCcdbUrl.value);
   }
 
+  // for this track, count the number of associated collisions with in-bunch pileup and out of bunch associations
+  void countAssociation(int64_t trackIdx, int64_t eventIdx, bool inBunch)
+  {
+    auto& assocMap = (inBunch ? fNAssocsInBunch : fNAssocsOutOfBunch);
+    assocMap[trackIdx].push_back(eventIdx);
+  }
+
+  // evaluate the track cuts on all the associations at once
+  //   first pass: fill the variables of each association with a selected event into the batch
+  //   second pass: publish the decisions in the order of the associations
+  template <uint32_t TEventFillMap, uint32_t TTrackFillMap, typename TEvents, typename TTracks>
+  void runBatchedTrackSelection(ReducedTracksAssoc const& assocs)
+  {
+    fTrackCutBatch->ClearCandidates();
+    fTrackCutBatch->Reserve(assocs.size());
+    fBatchCandidates.assign(assocs.size(), -1);
+    fReferenceFilterMaps.clear();
+
+    int iAssoc = 0;
+    for (auto& assoc : assocs) {
+      auto event = assoc.template reducedevent_as<TEvents>();
+      if (!event.isEventSelected_bit(0)) {
+        iAssoc++;
+        continue;
+      }
+      VarManager::ResetValues(0, VarManager::kNBarrelTrackVariables);
+      VarManager::FillEvent<TEventFillMap>(event);
+      auto track = assoc.template reducedtrack_as<TTracks>();
+      VarManager::FillTrack<TTrackFillMap>(track);
+      if (fPropTrack) {
+        VarManager::FillTrackCollision<TTrackFillMap>(track, event);
+      }
+      fBatchCandidates[iAssoc++] = fTrackCutBatch->GetNCandidates();
+      fTrackCutBatch->AddCandidate(VarManager::fgValues);
+
+      if (fConfigBatchCheck) {
+        uint32_t filterMap = static_cast<uint32_t>(0);
+        int iCut = 0;
+        for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); cut++, iCut++) {
+          if ((*cut)->IsSelected(VarManager::fgValues)) {
+            filterMap |= (static_cast<uint32_t>(1) << iCut);
+          }
+        }
+        fReferenceFilterMaps.push_back(filterMap);
+      }
+    }
+
+    const auto& masks = fTrackCutBatch->Evaluate();
+    int nMismatches = 0;
+    iAssoc = 0;
+    for (auto& assoc : assocs) {
+      int candidate = fBatchCandidates[iAssoc++];
+      if (candidate < 0) {
+        trackSel(0);
+        continue;
+      }
+      uint32_t filterMap = static_cast<uint32_t>(masks[candidate]);
+      if (fConfigBatchCheck && filterMap != fReferenceFilterMaps[candidate]) {
+        nMismatches++;
+      }
+      trackSel(filterMap);
+
+      if (fConfigPublishAmbiguity && filterMap > 0) {
+        auto event = assoc.template reducedevent_as<TEvents>();
+        countAssociation(assoc.reducedtrackId(), event.globalIndex(), event.isEventSelected_bit(1));
+      }
+    }
+    if (nMismatches > 0) {
+      LOG(warning) << "Batched track cuts differ from AnalysisCompositeCut::IsSelected for " << nMismatches << " out of " << fTrackCutBatch->GetNCandidates()
+                   << " associations" << (fConfigBatchLutPoints > 0 ? " (expected close to the TF1 limits with cfgBatchLutPoints > 0)" : "");
+    }
+  }
+
   template <uint32_t TEventFillMap, uint32_t TTrackFillMap, typename TEvents, typename TTracks>
   void runTrackSelection(ReducedTracksAssoc const& assocs, TEvents const& events, TTracks const& tracks)
   {
@@ -689,63 +781,50 @@ struct AnalysisTrackSelection {
     uint32_t filterMap = static_cast<uint32_t>(0);
     int iCut = 0;
 
-    for (auto& assoc : assocs) {
-
-      // if the event from this association is not selected, reject also the association
-      auto event = assoc.template reducedevent_as<TEvents>();
-      if (!event.isEventSelected_bit(0)) {
-        trackSel(0);
-        continue;
-      }
-      VarManager::ResetValues(0, VarManager::kNBarrelTrackVariables);
-      // fill event information which might be needed in histograms/cuts that combine track and event properties
-      VarManager::FillEvent<TEventFillMap>(event);
+    if (fTrackCutBatch) {
+      runBatchedTrackSelection<TEventFillMap, TTrackFillMap, TEvents, TTracks>(assocs);
+    } else {
+      for (auto& assoc : assocs) {
 
-      auto track = assoc.template reducedtrack_as<TTracks>();
-      filterMap = static_cast<uint32_t>(0);
-      VarManager::FillTrack<TTrackFillMap>(track);
-      // compute quantities which depend on the associated collision, such as DCA
-      if (fPropTrack) {
-        VarManager::FillTrackCollision<TTrackFillMap>(track, event);
-      }
-      if (fConfigQA) {
-        fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
-      }
-      iCut = 0;
-      for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); cut++, iCut++) {
-        if ((*cut)->IsSelected(VarManager::fgValues)) {
-          filterMap |= (static_cast<uint32_t>(1) << iCut);
-          if (fConfigQA) {
-            fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut)->GetName()), VarManager::fgValues);
-          }
+        // if the event from this association is not selected, reject also the association
+        auto event = assoc.template reducedevent_as<TEvents>();
+        if (!event.isEventSelected_bit(0)) {
+          trackSel(0);
+          continue;
         }
-      } // end loop over cuts
+        VarManager::ResetValues(0, VarManager::kNBarrelTrackVariables);
+        // fill event information which might be needed in histograms/cuts that combine track and event properties
+        VarManager::FillEvent<TEventFillMap>(event);
+
+        auto track = assoc.template reducedtrack_as<TTracks>();
+        filterMap = static_cast<uint32_t>(0);
+        VarManager::FillTrack<TTrackFillMap>(track);
+        // compute quantities which depend on the associated collision, such as DCA
+        if (fPropTrack) {
+          VarManager::FillTrackCollision<TTrackFillMap>(track, event);
+        }
+        if (fConfigQA) {
+          fHistMan->FillHistClass("TrackBarrel_BeforeCuts", VarManager::fgValues);
+        }
+        iCut = 0;
+        for (auto cut = fTrackCuts.begin(); cut != fTrackCuts.end(); cut++, iCut++) {
+          if ((*cut)->IsSelected(VarManager::fgValues)) {
+            filterMap |= (static_cast<uint32_t>(1) << iCut);
+            if (fConfigQA) {
+              fHistMan->FillHistClass(Form("TrackBarrel_%s", (*cut)->GetName()), VarManager::fgValues);
+            }
+          }
+        } // end loop over cuts
 
-      // publish the decisions
-      trackSel(filterMap);
+        // publish the decisions
+        trackSel(filterMap);
 
-      // count the number of associations per track
-      if (fConfigPublishAmbiguity && filterMap > 0) {
-        // for this track, count the number of associated collisions with in-bunch pileup and out of bunch associations
-        if (event.isEventSelected_bit(1)) {
-          if (fNAssocsInBunch.find(track.globalIndex()) == fNAssocsInBunch.end()) {
-            std::vector<int64_t> evVector = {event.globalIndex()};
-            fNAssocsInBunch[track.globalIndex()] = evVector;
-          } else {
-            auto& evVector = fNAssocsInBunch[track.globalIndex()];
-            evVector.push_back(event.globalIndex());
-          }
-        } else {
-          if (fNAssocsOutOfBunch.find(track.globalIndex()) == fNAssocsOutOfBunch.end()) {
-            std::vector<int64_t> evVector = {event.globalIndex()};
-            fNAssocsOutOfBunch[track.globalIndex()] = evVector;
-          } else {
-            auto& evVector = fNAssocsOutOfBunch[track.globalIndex()];
-            evVector.push_back(event.globalIndex());
-          }
+        // count the number of associations per track
+        if (fConfigPublishAmbiguity && filterMap > 0) {
+          countAssociation(track.globalIndex(), event.globalIndex(), event.isEventSelected_bit(1));
         }
-      }
-    } // end loop over associations
+      } // end loop over associations
+    }
 
     if (fConfigPublishAmbiguity) {
       // QA the collision-track associations
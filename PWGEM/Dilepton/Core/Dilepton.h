@@ -25,7 +25,7 @@
 #include "PWGEM/Dilepton/Utils/EMTrack.h"
 #include "PWGEM/Dilepton/Utils/EMTrackUtilities.h"
 #include "PWGEM/Dilepton/Utils/EventHistograms.h"
-#include "PWGEM/Dilepton/Utils/EventMixingHandler.h"
+#include "PWGEM/Dilepton/Utils/EventMixingPool.h"
 #include "PWGEM/Dilepton/Utils/MlResponseDielectronSingleTrack.h"
 #include "PWGEM/Dilepton/Utils/PairUtilities.h"
 
@@ -85,8 +85,8 @@ using MyMuon = MyMuons::iterator;
 using FilteredMyMuons = soa::Filtered<MyMuons>;
 using FilteredMyMuon = FilteredMyMuons::iterator;
 
-using MyEMH_electron = o2::aod::pwgem::dilepton::utils::EventMixingHandler<std::tuple<int, int, int, int>, std::pair<int, int>, EMTrack>;
-using MyEMH_muon = o2::aod::pwgem::dilepton::utils::EventMixingHandler<std::tuple<int, int, int, int>, std::pair<int, int>, EMFwdTrack>;
+using MyEMH_electron = o2::aod::pwgem::dilepton::utils::EventMixingPool<std::tuple<int, int, int, int>, std::pair<int, int>, EMTrack>;
+using MyEMH_muon = o2::aod::pwgem::dilepton::utils::EventMixingPool<std::tuple<int, int, int, int>, std::pair<int, int>, EMFwdTrack>;
 
 template <o2::aod::pwgem::dilepton::utils::pairutil::DileptonPairType pairtype, typename TEMH, typename... Types>
 struct Dilepton {
@@ -505,6 +505,11 @@ struct Dilepton {
 
   ~Dilepton()
   {
+    if (emh_pos && emh_neg) {
+      auto statsPos = emh_pos->GetMemoryStats();
+      auto statsNeg = emh_neg->GetMemoryStats();
+      LOGF(info, "event mixing pool: %zu bins, %zu + %zu collisions, %zu + %zu tracks, %zu + %zu bytes", statsPos.nBins, statsPos.nCollisionsInPool, statsNeg.nCollisionsInPool, statsPos.nTracks, statsNeg.nTracks, statsPos.totalBytes(), statsNeg.totalBytes());
+    }
     delete emh_pos;
     emh_pos = 0x0;
     delete emh_neg;
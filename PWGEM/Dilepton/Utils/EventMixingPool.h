@@ -0,0 +1,399 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+
+/// \event mixing pool with bounded memory
+/// \author daiki.sekihata@cern.ch
+///
+/// Drop-in replacement for EventMixingHandler with the same interface.
+/// - each mixing bin is a ring buffer of fixed depth, stored mirrored so that the collisions of a bin are always contiguous
+/// - mixing bins and collisions are found through open-addressing hash tables instead of std::map
+/// - tracks of all collisions are stored in one contiguous arena, which is compacted when half of it is dead
+/// - accessors return spans into the pool instead of copies
+/// Spans returned by the getters are valid until the next call to AddTrackToEventPool() or AddCollisionIdAtLast().
+
+#ifndef PWGEM_DILEPTON_UTILS_EVENTMIXINGPOOL_H_
+#define PWGEM_DILEPTON_UTILS_EVENTMIXINGPOOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace o2::aod::pwgem::dilepton::utils
+{
+namespace mixingpool
+{
+// hash for the keys used in the mixing: integral types, std::pair and std::tuple of them
+struct KeyHash {
+  static constexpr size_t combine(size_t seed, size_t value)
+  {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+  }
+
+  template <typename K>
+  size_t operator()(const K& key) const
+  {
+    if constexpr (std::is_arithmetic_v<K> || std::is_enum_v<K>) {
+      return std::hash<K>{}(key);
+    } else {
+      size_t seed = 0;
+      std::apply([&seed, this](const auto&... elements) { ((seed = combine(seed, (*this)(elements))), ...); }, key);
+      return seed;
+    }
+  }
+};
+
+// open-addressing hash table with linear probing, mapping a key to a non-negative index
+template <typename K>
+class FlatIndex
+{
+ public:
+  FlatIndex() { rehash(16); }
+
+  int find(const K& key) const
+  {
+    for (size_t i = KeyHash{}(key)&fMask;; i = (i + 1) & fMask) {
+      if (fValues[i] < 0) {
+        return -1;
+      }
+      if (fKeys[i] == key) {
+        return fValues[i];
+      }
+    }
+  }
+
+  void insert(const K& key, int value)
+  {
+    if (2 * (fSize + 1) > fValues.size()) {
+      rehash(2 * fValues.size());
+    }
+    size_t i = KeyHash{}(key)&fMask;
+    while (fValues[i] >= 0 && !(fKeys[i] == key)) {
+      i = (i + 1) & fMask;
+    }
+    if (fValues[i] < 0) {
+      fSize++;
+    }
+    fKeys[i] = key;
+    fValues[i] = value;
+  }
+
+  void erase(const K& key)
+  {
+    size_t i = KeyHash{}(key)&fMask;
+    while (fValues[i] >= 0 && !(fKeys[i] == key)) {
+      i = (i + 1) & fMask;
+    }
+    if (fValues[i] < 0) {
+      return;
+    }
+    // backward-shift deletion: move following entries of the same probe chain into the hole
+    for (size_t j = (i + 1) & fMask; fValues[j] >= 0; j = (j + 1) & fMask) {
+      size_t home = KeyHash{}(fKeys[j]) & fMask;
+      if (((j - home) & fMask) >= ((j - i) & fMask)) {
+        fKeys[i] = fKeys[j];
+        fValues[i] = fValues[j];
+        i = j;
+      }
+    }
+    fValues[i] = -1;
+    fSize--;
+  }
+
+  void clear()
+  {
+    std::fill(fValues.begin(), fValues.end(), -1);
+    fSize = 0;
+  }
+
+  size_t size() const { return fSize; }
+  size_t bytes() const { return fKeys.capacity() * sizeof(K) + fValues.capacity() * sizeof(int); }
+
+ private:
+  void rehash(size_t nslots)
+  {
+    std::vector<K> keys(nslots);
+    std::vector<int> values(nslots, -1);
+    keys.swap(fKeys);
+    values.swap(fValues);
+    fMask = nslots - 1;
+    fSize = 0;
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (values[i] >= 0) {
+        insert(keys[i], values[i]);
+      }
+    }
+  }
+
+  std::vector<K> fKeys;
+  std::vector<int> fValues; // -1 for empty slots
+  size_t fMask = 0;
+  size_t fSize = 0;
+};
+} // namespace mixingpool
+
+template <typename T, typename U, typename V>
+class EventMixingPool
+{
+ public:
+  struct MemoryStats {
+    size_t nBins = 0;             // number of mixing bins
+    size_t nCollisionsInPool = 0; // number of collisions stored in the mixing bins
+    size_t nCollisionsStaged = 0; // number of collisions with tracks but not yet added to a mixing bin
+    size_t nTracks = 0;           // number of live tracks
+    size_t nDeadTracks = 0;       // number of tracks of released collisions, not yet compacted
+    size_t arenaBytes = 0;        // allocated size of the track arena
+    size_t indexBytes = 0;        // allocated size of the ring buffers, collision records and hash tables
+    size_t totalBytes() const { return arenaBytes + indexBytes; }
+  };
+
+  EventMixingPool() = default;
+  explicit EventMixingPool(int ndepth) : fNdepth(ndepth) {}
+  ~EventMixingPool() = default;
+
+  // changing the depth clears the pool
+  void SetNdepth(int ndepth)
+  {
+    fNdepth = ndepth;
+    Clear();
+  }
+
+  void ReserveNTracksPerCollision(U /*key_df_collision*/, int ntrack)
+  {
+    fArena.reserve(fArena.size() + ntrack);
+  }
+
+  void AddTrackToEventPool(U key_df_collision, V obj)
+  {
+    int irec = GetOrCreateRecord(key_df_collision);
+    if (fNDeadTracks > kMinDeadTracks && 2 * fNDeadTracks > fArena.size()) {
+      Compact(irec);
+    }
+    Record& rec = fRecords[irec];
+    if (rec.size == 0) {
+      rec.offset = fArena.size();
+    } else if (rec.offset + rec.size != fArena.size()) {
+      // tracks of another collision were added in between: move this one to the end of the arena
+      uint32_t offset = fArena.size();
+      fArena.reserve(offset + rec.size + 1);
+      for (uint32_t i = 0; i < rec.size; i++) {
+        fArena.push_back(fArena[rec.offset + i]);
+      }
+      fNDeadTracks += rec.size;
+      rec.offset = offset;
+    }
+    fArena.emplace_back(std::move(obj));
+    rec.size++;
+  }
+
+  std::span<const U> GetCollisionIdsFromEventPool(T key_bin) const
+  {
+    int ibin = fBinIndex.find(key_bin);
+    if (ibin < 0) {
+      return {};
+    }
+    const Bin& bin = fBins[ibin];
+    return std::span<const U>(fBinKeys.data() + Slot(ibin, bin.head), bin.count);
+  }
+
+  std::span<const V> GetTracksPerCollision(T key_bin, int index) const
+  {
+    return GetTracksPerCollision(GetCollisionIdsFromEventPool(key_bin)[index]);
+  }
+
+  std::span<const V> GetTracksPerCollision(U key_df_collision) const
+  {
+    int irec = fCollisionIndex.find(key_df_collision);
+    if (irec < 0) {
+      return {};
+    }
+    const Record& rec = fRecords[irec];
+    return std::span<const V>(fArena.data() + rec.offset, rec.size);
+  }
+
+  // call this function at the end of collision loop
+  void AddCollisionIdAtLast(T key_bin, U key_df_collision)
+  {
+    if (fNdepth <= 0) {
+      return;
+    }
+    int ibin = fBinIndex.find(key_bin);
+    if (ibin < 0) {
+      ibin = fBins.size();
+      fBins.emplace_back();
+      fBinKeys.resize(fBins.size() * 2 * fNdepth);
+      fBinRecords.resize(fBins.size() * 2 * fNdepth, -1);
+      fBinIndex.insert(key_bin, ibin);
+    }
+    Bin& bin = fBins[ibin];
+    int pos;
+    if (bin.count == fNdepth) { // the oldest collision is overwritten
+      pos = bin.head;
+      Release(fBinRecords[Slot(ibin, pos)]);
+      bin.head = (bin.head + 1) % fNdepth;
+    } else {
+      pos = (bin.head + bin.count) % fNdepth;
+      bin.count++;
+    }
+    int irec = GetOrCreateRecord(key_df_collision);
+    fRecords[irec].nRefs++;
+    // each slot is written twice so that [head, head + count) is always contiguous
+    fBinKeys[Slot(ibin, pos)] = key_df_collision;
+    fBinKeys[Slot(ibin, pos + fNdepth)] = key_df_collision;
+    fBinRecords[Slot(ibin, pos)] = irec;
+    fBinRecords[Slot(ibin, pos + fNdepth)] = irec;
+  }
+
+  // drop the tracks of collisions which were filled but never added to a mixing bin
+  void ClearStagedCollisions()
+  {
+    for (size_t irec = 0; irec < fRecords.size(); irec++) {
+      if (fRecords[irec].inUse && fRecords[irec].nRefs == 0) {
+        FreeRecord(irec);
+      }
+    }
+  }
+
+  void Clear()
+  {
+    fBins.clear();
+    fBinKeys.clear();
+    fBinRecords.clear();
+    fBinIndex.clear();
+    fRecords.clear();
+    fFreeRecords.clear();
+    fCollisionIndex.clear();
+    fArena.clear();
+    fNDeadTracks = 0;
+  }
+
+  MemoryStats GetMemoryStats() const
+  {
+    MemoryStats stats;
+    stats.nBins = fBins.size();
+    for (const auto& rec : fRecords) {
+      if (!rec.inUse) {
+        continue;
+      }
+      if (rec.nRefs > 0) {
+        stats.nCollisionsInPool++;
+      } else {
+        stats.nCollisionsStaged++;
+      }
+      stats.nTracks += rec.size;
+    }
+    stats.nDeadTracks = fNDeadTracks;
+    stats.arenaBytes = fArena.capacity() * sizeof(V);
+    stats.indexBytes = fBins.capacity() * sizeof(Bin) + fBinKeys.capacity() * sizeof(U) + fBinRecords.capacity() * sizeof(int) + fRecords.capacity() * sizeof(Record) + fFreeRecords.capacity() * sizeof(int) + fBinIndex.bytes() + fCollisionIndex.bytes();
+    return stats;
+  }
+
+ private:
+  static constexpr size_t kMinDeadTracks = 1024; // do not compact small arenas
+
+  struct Bin {
+    int head = 0;  // position of the oldest collision in the ring
+    int count = 0; // number of collisions in the ring
+  };
+  struct Record {
+    U key{};
+    uint32_t offset = 0; // first track in the arena
+    uint32_t size = 0;   // number of tracks
+    int nRefs = 0;       // number of ring slots pointing to this collision
+    bool inUse = false;
+  };
+
+  size_t Slot(int ibin, int pos) const { return static_cast<size_t>(ibin) * 2 * fNdepth + pos; }
+
+  int GetOrCreateRecord(const U& key)
+  {
+    int irec = fCollisionIndex.find(key);
+    if (irec >= 0) {
+      return irec;
+    }
+    if (!fFreeRecords.empty()) {
+      irec = fFreeRecords.back();
+      fFreeRecords.pop_back();
+    } else {
+      irec = fRecords.size();
+      fRecords.emplace_back();
+    }
+    fRecords[irec] = Record{};
+    fRecords[irec].key = key;
+    fRecords[irec].inUse = true;
+    fCollisionIndex.insert(key, irec);
+    return irec;
+  }
+
+  void Release(int irec)
+  {
+    if (irec < 0 || --fRecords[irec].nRefs > 0) {
+      return;
+    }
+    FreeRecord(irec);
+  }
+
+  void FreeRecord(int irec)
+  {
+    Record& rec = fRecords[irec];
+    fNDeadTracks += rec.size;
+    fCollisionIndex.erase(rec.key);
+    rec = Record{};
+    fFreeRecords.push_back(irec);
+  }
+
+  // squeeze out the tracks of released collisions; the collision being filled is moved to the end
+  void Compact(int irecLast)
+  {
+    fOrder.clear();
+    for (size_t irec = 0; irec < fRecords.size(); irec++) {
+      if (fRecords[irec].inUse && static_cast<int>(irec) != irecLast && fRecords[irec].size > 0) {
+        fOrder.push_back(irec);
+      }
+    }
+    std::sort(fOrder.begin(), fOrder.end(), [this](int a, int b) { return fRecords[a].offset < fRecords[b].offset; });
+    Record& last = fRecords[irecLast];
+    // move the collision being filled out of the way first, so that the others can be shifted down
+    fScratch.assign(fArena.begin() + last.offset, fArena.begin() + last.offset + last.size);
+    uint32_t write = 0;
+    for (const auto& irec : fOrder) {
+      Record& rec = fRecords[irec];
+      std::move(fArena.begin() + rec.offset, fArena.begin() + rec.offset + rec.size, fArena.begin() + write);
+      rec.offset = write;
+      write += rec.size;
+    }
+    std::move(fScratch.begin(), fScratch.end(), fArena.begin() + write);
+    last.offset = write;
+    write += last.size;
+    fArena.erase(fArena.begin() + write, fArena.end());
+    fNDeadTracks = 0;
+  }
+
+  int fNdepth = 0;                              // depth of event mixing
+  std::vector<Bin> fBins;                       // ring buffer state of each mixing bin
+  std::vector<U> fBinKeys;                      // collision keys of the ring buffers, 2 * fNdepth per bin (mirrored)
+  std::vector<int> fBinRecords;                 // collision records of the ring buffers, 2 * fNdepth per bin (mirrored)
+  mixingpool::FlatIndex<T> fBinIndex;           // e.g. <zbin, centbin, epbin> -> mixing bin index
+  std::vector<Record> fRecords;                 // collisions with their track range in the arena
+  std::vector<int> fFreeRecords;                // released records to be reused
+  mixingpool::FlatIndex<U> fCollisionIndex;     // e.g. pair<df index, global collision index> -> record index
+  std::vector<V> fArena;                        // tracks of all the collisions
+  std::vector<V> fScratch;                      // temporary storage used during compaction
+  std::vector<int> fOrder;                      // temporary storage used during compaction
+  size_t fNDeadTracks = 0;                      // arena entries not owned by any live collision
+};
+} // namespace o2::aod::pwgem::dilepton::utils
+#endif // PWGEM_DILEPTON_UTILS_EVENTMIXINGPOOL_H_
@@ -74,12 +74,17 @@
 
 #include <algorithm> // std::find
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
+#include <functional>
 #include <iterator> // std::distance
+#include <limits>
 #include <numeric>
-#include <string>  // std::string
+#include <string> // std::string
+#include <thread>
+#include <tuple>
 #include <utility> // std::forward
 #include <vector>  // std::vector
 
@@ -123,6 +128,108 @@ enum ChannelsProtonPid {
 constexpr int ChannelKaonPid = ChannelsProtonPid::NChannelsProtonPid;
 constexpr int ChannelsDeuteronPid = ChannelsProtonPid::NChannelsProtonPid + 1;
 
+/// Per-collision store of tracks propagated to the primary vertex
+/// Each track is propagated at most once per collision and then shared by all the candidate builders
+class HfPropagatedTrackStore
+{
+ public:
+  struct PropagatedTrack {
+    o2::track::TrackParCov trackParCov{}; // track parameters at the DCA to the primary vertex
+    std::array<float, 3> pVec{};          // momentum at the DCA to the primary vertex
+    std::array<float, 2> dcaInfo{};       // DCA xy and z to the primary vertex
+  };
+
+  /// Prepares the store for a new collision
+  /// \param nTracks is the number of rows of the track table
+  /// \param nTracksMax is the maximum number of tracks that will be requested for this collision
+  void reset(std::size_t nTracks, std::size_t nTracksMax)
+  {
+    for (const auto& globalIndex : storedGlobalIndices) {
+      slotOfTrack[globalIndex] = -1;
+    }
+    storedGlobalIndices.clear();
+    propagatedTracks.clear();
+    if (slotOfTrack.size() < nTracks) {
+      slotOfTrack.resize(nTracks, -1);
+    }
+    // the storage must not be reallocated while filling, since the candidate builders keep references to the stored tracks
+    propagatedTracks.reserve(nTracksMax);
+    storedGlobalIndices.reserve(nTracksMax);
+  }
+
+  /// Propagates a track to the primary vertex of the collision, if the track is not associated to it by default
+  /// \param collision is the collision
+  /// \param track is the track
+  /// \param matCorr is the material correction used for the propagation
+  /// \return the propagated track parameters, momentum and DCA
+  template <typename TCollision, typename TTrack>
+  static PropagatedTrack propagate(TCollision const& collision, TTrack const& track, o2::base::Propagator::MatCorrType matCorr)
+  {
+    PropagatedTrack propagatedTrack{getTrackParCov(track), track.pVector(), {track.dcaXY(), track.dcaZ()}};
+    if (collision.globalIndex() != track.collisionId()) { // this is not the "default" collision for this track, we have to re-propagate it
+      o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, propagatedTrack.trackParCov, 2.f, matCorr, &propagatedTrack.dcaInfo);
+      getPxPyPz(propagatedTrack.trackParCov, propagatedTrack.pVec);
+    }
+    return propagatedTrack;
+  }
+
+  /// Adds a track already propagated to the primary vertex of the current collision
+  /// \param globalIndex is the global index of the track
+  /// \param propagatedTrack is the propagated track
+  /// \return the stored track
+  PropagatedTrack const& add(int64_t globalIndex, PropagatedTrack const& propagatedTrack)
+  {
+    if (propagatedTracks.size() == propagatedTracks.capacity()) {
+      LOGP(fatal, "HfPropagatedTrackStore: more than the {} reserved tracks requested", propagatedTracks.capacity());
+    }
+    slotOfTrack[globalIndex] = propagatedTracks.size();
+    storedGlobalIndices.push_back(globalIndex);
+    return propagatedTracks.emplace_back(propagatedTrack);
+  }
+
+  /// Returns the track propagated to the primary vertex of the collision, propagating it only at the first request
+  /// \param collision is the collision being processed
+  /// \param track is the track
+  /// \param matCorr is the material correction used for the propagation
+  /// \return the propagated track parameters, momentum and DCA
+  template <typename TCollision, typename TTrack>
+  PropagatedTrack const& get(TCollision const& collision, TTrack const& track, o2::base::Propagator::MatCorrType matCorr)
+  {
+    const auto globalIndex = track.globalIndex();
+    if (slotOfTrack[globalIndex] >= 0) {
+      return propagatedTracks[slotOfTrack[globalIndex]];
+    }
+    return add(globalIndex, propagate(collision, track, matCorr));
+  }
+
+ private:
+  std::vector<PropagatedTrack> propagatedTracks{}; // tracks propagated for the current collision
+  std::vector<int> slotOfTrack{};                  // position in propagatedTracks for each track global index, -1 if not stored
+  std::vector<int64_t> storedGlobalIndices{};      // global indices of the stored tracks, to reset only the used slots
+};
+
+/// Vertexing state owned by a single thread: fitters and propagated tracks
+struct HfVertexingWorker {
+  o2::vertexing::DCAFitterN<2> df2;  // 2-prong vertex fitter
+  o2::vertexing::DCAFitterN<3> df3;  // 3-prong vertex fitter
+  HfPropagatedTrackStore trackStore; // tracks propagated to the primary vertex of the current collision
+
+  void setBz(float bz)
+  {
+    df2.setBz(bz);
+    df3.setBz(bz);
+  }
+};
+
+/// Buffer of table rows with the same call interface as the table cursors, filled by the vertexing threads
+template <typename... Ts>
+struct HfRowBuffer {
+  std::vector<std::tuple<Ts...>> rows{};
+
+  void operator()(Ts... values) { rows.emplace_back(values...); }
+  int64_t lastIndex() const { return static_cast<int64_t>(rows.size()) - 1; }
+};
+
 /// Event selection
 struct HfTrackIndexSkimCreatorTagSelCollisions {
   Produces<aod::HfSelCollision> rowSelectedCollision;
@@ -1217,6 +1324,9 @@ struct HfTrackIndexSkimCreator {
     Configurable<double> maxDZIni{"maxDZIni", 4., "reject (if>0) PCA candidate if tracks DZ exceeds threshold"};
     Configurable<double> minParamChange{"minParamChange", 1.e-3, "stop iterations if largest change of any X is smaller than this"};
     Configurable<double> minRelChi2Change{"minRelChi2Change", 0.9, "stop iterations if chi2/chi2old > this"};
+    // parallel vertexing
+    Configurable<int> nThreadsVertexing{"nThreadsVertexing", 1, "Number of threads for the 2-prong and 3-prong vertexing (1: serial, > 1 not supported with PV refit, debug, histograms and ML for HF filters)"};
+    Configurable<int> nCollisionsPerThreadVertexing{"nCollisionsPerThreadVertexing", 8, "Number of collisions per thread buffered before filling the tables in parallel vertexing"};
     // CCDB
     Configurable<std::string> ccdbUrl{"ccdbUrl", "http://alice-ccdb.cern.ch", "url of the ccdb repository"};
     Configurable<std::string> ccdbPathLut{"ccdbPathLut", "GLO/Param/MatLUT", "Path for LUT parametrization"};
@@ -1273,8 +1383,7 @@ struct HfTrackIndexSkimCreator {
   } config;
 
   SliceCache cache;
-  o2::vertexing::DCAFitterN<2> df2; // 2-prong vertex fitter
-  o2::vertexing::DCAFitterN<3> df3; // 3-prong vertex fitter
+  std::vector<HfVertexingWorker> workers{}; // vertex fitters and propagated tracks, one per vertexing thread
   // Needed for PV refitting
   Service<o2::ccdb::BasicCCDBManager> ccdb;
   o2::base::MatLayerCylSet* lut{};
@@ -1295,6 +1404,16 @@ struct HfTrackIndexSkimCreator {
   std::array<std::vector<double>, kN2ProngDecays> binsPt2Prong{};
   std::array<LabeledArray<double>, kN3ProngDecays> cut3Prong{};
   std::array<std::vector<double>, kN3ProngDecays> binsPt3Prong{};
+  // kinematic limits used to skip track pairs that cannot form any 3-prong candidate in the mass windows
+  std::array<double, 3> massMinProng3Prong{}; // lightest mass hypothesis for each 3-prong daughter
+  double massMax3Prong{0.};                   // widest upper edge of the 3-prong mass windows
+
+  // rows of one collision produced by a vertexing thread, written to the tables in collision order
+  struct CollisionRows {
+    HfRowBuffer<int64_t, int64_t, int64_t, uint8_t> rowTrackIndexProng2;
+    HfRowBuffer<int64_t, int64_t, int64_t, int64_t, uint8_t> rowTrackIndexProng3;
+    HfRowBuffer<int64_t, int64_t, int64_t> rowTrackIndexDstar; // the D0 index refers to rowTrackIndexProng2
+  };
 
   // ML response
   o2::analysis::MlResponse<float> hfMlResponse2Prongs;                               // only D0
@@ -1365,21 +1484,50 @@ struct HfTrackIndexSkimCreator {
     cut3Prong = {config.cutsDplusToPiKPi, config.cutsLcToPKPi, config.cutsDsToKKPi, config.cutsXicToPKPi, config.cutsCdToDeKPi};
     binsPt3Prong = {config.binsPtDplusToPiKPi, config.binsPtLcToPKPi, config.binsPtDsToKKPi, config.binsPtXicToPKPi, config.binsPtCdToDeKPi};
 
-    df2.setPropagateToPCA(config.propagateToPCA);
-    df2.setMaxR(config.maxR);
-    df2.setMaxDZIni(config.maxDZIni);
-    df2.setMinParamChange(config.minParamChange);
-    df2.setMinRelChi2Change(config.minRelChi2Change);
-    df2.setUseAbsDCA(config.useAbsDCA);
-    df2.setWeightedFinalPCA(config.useWeightedFinalPCA);
+    // a 3-prong candidate cannot be lighter than the pair of the first two daughters plus the third daughter, each one with its lightest mass hypothesis
+    massMinProng3Prong.fill(std::numeric_limits<double>::max());
+    massMax3Prong = 0.;
+    for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+      for (const auto& arrMassHypo : arrMass3Prong[iDecay3P]) {
+        for (std::size_t iProng = 0; iProng < massMinProng3Prong.size(); iProng++) {
+          massMinProng3Prong[iProng] = std::min(massMinProng3Prong[iProng], arrMassHypo[iProng]);
+        }
+      }
+      for (std::size_t iBin = 0; iBin + 1 < binsPt3Prong[iDecay3P].size(); iBin++) {
+        const double minMass = cut3Prong[iDecay3P].get(iBin, 0u);
+        const double maxMass = cut3Prong[iDecay3P].get(iBin, 1u);
+        massMax3Prong = (minMass >= 0. && maxMass > 0.) ? std::max(massMax3Prong, maxMass) : std::numeric_limits<double>::max(); // no mass window in this bin
+      }
+    }
+
+    if (config.nThreadsVertexing > 1) {
+      // the histograms, the ML models, the PV refit and the debug tables are not safe to fill from several threads
+      if (doprocess2And3ProngsWithPvRefit || doprocess2And3ProngsWithPvRefitWithPidForHfFiltersBdt || config.debug || config.fillHistograms || config.applyMlForHfFilters) {
+        LOGP(fatal, "Parallel vertexing (nThreadsVertexing = {}) is not supported with PV refit, debug mode, histograms or ML for HF filters", config.nThreadsVertexing.value);
+      }
+      if (config.nCollisionsPerThreadVertexing < 1) {
+        LOGP(fatal, "nCollisionsPerThreadVertexing must be at least 1");
+      }
+    }
 
-    df3.setPropagateToPCA(config.propagateToPCA);
-    df3.setMaxR(config.maxR);
-    df3.setMaxDZIni(config.maxDZIni);
-    df3.setMinParamChange(config.minParamChange);
-    df3.setMinRelChi2Change(config.minRelChi2Change);
-    df3.setUseAbsDCA(config.useAbsDCA);
-    df3.setWeightedFinalPCA(config.useWeightedFinalPCA);
+    workers.resize(std::max(1, config.nThreadsVertexing.value));
+    for (auto& worker : workers) {
+      worker.df2.setPropagateToPCA(config.propagateToPCA);
+      worker.df2.setMaxR(config.maxR);
+      worker.df2.setMaxDZIni(config.maxDZIni);
+      worker.df2.setMinParamChange(config.minParamChange);
+      worker.df2.setMinRelChi2Change(config.minRelChi2Change);
+      worker.df2.setUseAbsDCA(config.useAbsDCA);
+      worker.df2.setWeightedFinalPCA(config.useWeightedFinalPCA);
+
+      worker.df3.setPropagateToPCA(config.propagateToPCA);
+      worker.df3.setMaxR(config.maxR);
+      worker.df3.setMaxDZIni(config.maxDZIni);
+      worker.df3.setMinParamChange(config.minParamChange);
+      worker.df3.setMinRelChi2Change(config.minRelChi2Change);
+      worker.df3.setUseAbsDCA(config.useAbsDCA);
+      worker.df3.setWeightedFinalPCA(config.useWeightedFinalPCA);
+    }
 
     ccdb->setURL(config.ccdbUrl);
     ccdb->setCaching(true);
@@ -2066,405 +2214,187 @@ struct HfTrackIndexSkimCreator {
 
   } /// end of performPvRefitCandProngs function
 
-  template <bool DoPvRefit, bool UsePidForHfFiltersBdt, typename TTracks>
-  void run2And3Prongs(SelectedCollisions const& collisions,
-                      aod::BCsWithTimestamps const& bcWithTimeStamps,
-                      FilteredTrackAssocSel const&,
-                      TTracks const& tracks)
+  /// 2-prong, 3-prong and D* skimming of a single collision
+  /// \param collision is the collision
+  /// \param bcWithTimeStamps is the BC table, needed for the PV refit
+  /// \param tracks is the track table
+  /// \param groupedTrackIndicesPos1 are the positive tracks of the collision selected for 2-prongs and 3-prongs
+  /// \param groupedTrackIndicesNeg1 are the negative tracks of the collision selected for 2-prongs and 3-prongs
+  /// \param groupedTrackIndicesSoftPionsPos are the positive soft-pion candidates of the collision
+  /// \param groupedTrackIndicesSoftPionsNeg are the negative soft-pion candidates of the collision
+  /// \param worker holds the vertex fitters, with the magnetic field already set, and the tracks propagated to the primary vertex of the collision
+  /// \param output provides the cursors of the 2-prong, 3-prong and D* tables: the task itself or the row buffers of a vertexing thread
+  template <bool DoPvRefit, bool UsePidForHfFiltersBdt, typename TCollision, typename TTracks, typename TTrackIndices, typename TOutput>
+  void run2And3ProngsCollision(TCollision const& collision,
+                               aod::BCsWithTimestamps const& bcWithTimeStamps,
+                               TTracks const& tracks,
+                               TTrackIndices const& groupedTrackIndicesPos1,
+                               TTrackIndices const& groupedTrackIndicesNeg1,
+                               TTrackIndices const& groupedTrackIndicesSoftPionsPos,
+                               TTrackIndices const& groupedTrackIndicesSoftPionsNeg,
+                               HfVertexingWorker& worker,
+                               TOutput& output)
   {
-
-    // can be added to run over limited collisions per file - for tesing purposes
-    /*
-    if (nCollsMax > -1){
-      if (nColls == nCollMax){
-        return;
-        //can be added to run over limited collisions per file - for tesing purposes
-      }
-      nColls++;
-    }
-    */
-
-    for (const auto& collision : collisions) {
-
-      /// retrieve PV contributors for the current collision
-      std::vector<int64_t> vecPvContributorGlobId{};
-      std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov{};
-      std::vector<bool> vecPvRefitContributorUsed{};
-      if constexpr (DoPvRefit) {
-        auto groupedTracksUnfiltered = tracks.sliceBy(tracksPerCollision, collision.globalIndex());
-        const int nTrk = groupedTracksUnfiltered.size();
-        int nContrib = 0;
-        int nNonContrib = 0;
-        for (const auto& trackUnfiltered : groupedTracksUnfiltered) {
-          if (!trackUnfiltered.isPVContributor()) {
-            /// the track did not contribute to fit the primary vertex
-            nNonContrib++;
-            continue;
-          }
-          vecPvContributorGlobId.push_back(trackUnfiltered.globalIndex());
-          vecPvContributorTrackParCov.push_back(getTrackParCov(trackUnfiltered));
-          nContrib++;
-          if (config.debugPvRefit) {
-            LOG(info) << "---> a contributor! stuff saved";
-            LOG(info) << "vec_contrib size: " << vecPvContributorTrackParCov.size() << ", nContrib: " << nContrib;
-          }
+    auto& df2 = worker.df2;
+    auto& df3 = worker.df3;
+    auto& trackStore = worker.trackStore;
+
+    /// retrieve PV contributors for the current collision
+    std::vector<int64_t> vecPvContributorGlobId{};
+    std::vector<o2::track::TrackParCov> vecPvContributorTrackParCov{};
+    std::vector<bool> vecPvRefitContributorUsed{};
+    if constexpr (DoPvRefit) {
+      auto groupedTracksUnfiltered = tracks.sliceBy(tracksPerCollision, collision.globalIndex());
+      const int nTrk = groupedTracksUnfiltered.size();
+      int nContrib = 0;
+      int nNonContrib = 0;
+      for (const auto& trackUnfiltered : groupedTracksUnfiltered) {
+        if (!trackUnfiltered.isPVContributor()) {
+          /// the track did not contribute to fit the primary vertex
+          nNonContrib++;
+          continue;
         }
+        vecPvContributorGlobId.push_back(trackUnfiltered.globalIndex());
+        vecPvContributorTrackParCov.push_back(getTrackParCov(trackUnfiltered));
+        nContrib++;
         if (config.debugPvRefit) {
-          LOG(info) << "===> nTrk: " << nTrk << ",   nContrib: " << nContrib << ",   nNonContrib: " << nNonContrib;
-          if (static_cast<uint16_t>(vecPvContributorTrackParCov.size()) != collision.numContrib() || static_cast<uint16_t>(nContrib != collision.numContrib())) {
-            LOG(info) << "!!! Some problem here !!! vecPvContributorTrackParCov.size()= " << vecPvContributorTrackParCov.size() << ", nContrib=" << nContrib << ", collision.numContrib()" << collision.numContrib();
-          }
+          LOG(info) << "---> a contributor! stuff saved";
+          LOG(info) << "vec_contrib size: " << vecPvContributorTrackParCov.size() << ", nContrib: " << nContrib;
         }
-        vecPvRefitContributorUsed = std::vector<bool>(vecPvContributorGlobId.size(), true);
       }
-
-      // auto centrality = collision.centV0M(); //FIXME add centrality when option for variations to the process function appears
-
-      const auto n2ProngBit = BIT(kN2ProngDecays) - 1; // bit value for 2-prong candidates where each candidate is one bit and they are all set to 1
-      const auto n3ProngBit = BIT(kN3ProngDecays) - 1; // bit value for 3-prong candidates where each candidate is one bit and they are all set to 1
-
-      std::array<std::vector<bool>, kN2ProngDecays> cutStatus2Prong{};
-      std::array<std::vector<bool>, kN3ProngDecays> cutStatus3Prong{};
-      uint8_t nCutStatus2ProngBit[kN2ProngDecays]; // bit value for selection status for each 2-prong candidate where each selection is one bit and they are all set to 1
-      uint8_t nCutStatus3ProngBit[kN3ProngDecays]; // bit value for selection status for each 3-prong candidate where each selection is one bit and they are all set to 1
-
-      for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
-        nCutStatus2ProngBit[iDecay2P] = BIT(kNCuts2Prong[iDecay2P]) - 1;
-        cutStatus2Prong[iDecay2P] = std::vector<bool>(kNCuts2Prong[iDecay2P], true);
-      }
-      for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-        nCutStatus3ProngBit[iDecay3P] = BIT(kNCuts3Prong[iDecay3P]) - 1;
-        cutStatus3Prong[iDecay3P] = std::vector<bool>(kNCuts3Prong[iDecay3P], true);
+      if (config.debugPvRefit) {
+        LOG(info) << "===> nTrk: " << nTrk << ",   nContrib: " << nContrib << ",   nNonContrib: " << nNonContrib;
+        if (static_cast<uint16_t>(vecPvContributorTrackParCov.size()) != collision.numContrib() || static_cast<uint16_t>(nContrib != collision.numContrib())) {
+          LOG(info) << "!!! Some problem here !!! vecPvContributorTrackParCov.size()= " << vecPvContributorTrackParCov.size() << ", nContrib=" << nContrib << ", collision.numContrib()" << collision.numContrib();
+        }
       }
+      vecPvRefitContributorUsed = std::vector<bool>(vecPvContributorGlobId.size(), true);
+    }
 
-      int whichHypo2Prong[kN2ProngDecays + 1]; // we also put D0 for D* in the last slot
-      int whichHypo3Prong[kN3ProngDecays];
-
-      // set the magnetic field from CCDB
-      const auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
-      initCCDB(bc, runNumber, ccdb, config.isRun2 ? config.ccdbPathGrp : config.ccdbPathGrpMag, lut, config.isRun2);
-      df2.setBz(o2::base::Propagator::Instance()->getNominalBz());
-      df3.setBz(o2::base::Propagator::Instance()->getNominalBz());
-
-      // used to calculate number of candidiates per event
-      auto nCand2 = rowTrackIndexProng2.lastIndex();
-      auto nCand3 = rowTrackIndexProng3.lastIndex();
-
-      // if there isn't at least a positive and a negative track, continue immediately
-      // if (tracksPos.size() < 1 || tracksNeg.size() < 1) {
-      //  return;
-      //}
-
-      const auto thisCollId = collision.globalIndex();
+    // auto centrality = collision.centV0M(); //FIXME add centrality when option for variations to the process function appears
 
-      // first loop over positive tracks
-      const auto groupedTrackIndicesPos1 = positiveFor2And3Prongs->sliceByCached(aod::track::collisionId, collision.globalIndex(), cache);
-      int lastFilledD0 = -1; // index to be filled in table for D* mesons
-      for (auto trackIndexPos1 = groupedTrackIndicesPos1.begin(); trackIndexPos1 != groupedTrackIndicesPos1.end(); ++trackIndexPos1) {
-        const auto trackPos1 = trackIndexPos1.template track_as<TTracks>();
+    const auto n2ProngBit = BIT(kN2ProngDecays) - 1; // bit value for 2-prong candidates where each candidate is one bit and they are all set to 1
+    const auto n3ProngBit = BIT(kN3ProngDecays) - 1; // bit value for 3-prong candidates where each candidate is one bit and they are all set to 1
 
-        // retrieve the selection flag that corresponds to this collision
-        const auto isSelProngPos1 = trackIndexPos1.isSelProng();
-        const bool sel2ProngStatusPos = TESTBIT(isSelProngPos1, CandidateType::Cand2Prong);
-        const bool sel3ProngStatusPos1 = TESTBIT(isSelProngPos1, CandidateType::Cand3Prong);
-
-        auto trackParVarPos1 = getTrackParCov(trackPos1);
-        std::array pVecTrackPos1{trackPos1.pVector()};
-        std::array dcaInfoPos1{trackPos1.dcaXY(), trackPos1.dcaZ()};
-        if (thisCollId != trackPos1.collisionId()) { // this is not the "default" collision for this track, we have to re-propagate it
-          o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParVarPos1, 2.f, noMatCorr, &dcaInfoPos1);
-          getPxPyPz(trackParVarPos1, pVecTrackPos1);
-        }
-
-        // first loop over negative tracks
-        const auto groupedTrackIndicesNeg1 = negativeFor2And3Prongs->sliceByCached(aod::track::collisionId, collision.globalIndex(), cache);
-        for (auto trackIndexNeg1 = groupedTrackIndicesNeg1.begin(); trackIndexNeg1 != groupedTrackIndicesNeg1.end(); ++trackIndexNeg1) {
-          const auto trackNeg1 = trackIndexNeg1.template track_as<TTracks>();
-
-          // retrieve the selection flag that corresponds to this collision
-          const auto isSelProngNeg1 = trackIndexNeg1.isSelProng();
-          const bool sel2ProngStatusNeg = TESTBIT(isSelProngNeg1, CandidateType::Cand2Prong);
-          const bool sel3ProngStatusNeg1 = TESTBIT(isSelProngNeg1, CandidateType::Cand3Prong);
-
-          auto trackParVarNeg1 = getTrackParCov(trackNeg1);
-          std::array pVecTrackNeg1{trackNeg1.pVector()};
-          std::array dcaInfoNeg1{trackNeg1.dcaXY(), trackNeg1.dcaZ()};
-          if (thisCollId != trackNeg1.collisionId()) { // this is not the "default" collision for this track, we have to re-propagate it
-            o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParVarNeg1, 2.f, noMatCorr, &dcaInfoNeg1);
-            getPxPyPz(trackParVarNeg1, pVecTrackNeg1);
-          }
+    std::array<std::vector<bool>, kN2ProngDecays> cutStatus2Prong{};
+    std::array<std::vector<bool>, kN3ProngDecays> cutStatus3Prong{};
+    uint8_t nCutStatus2ProngBit[kN2ProngDecays]; // bit value for selection status for each 2-prong candidate where each selection is one bit and they are all set to 1
+    uint8_t nCutStatus3ProngBit[kN3ProngDecays]; // bit value for selection status for each 3-prong candidate where each selection is one bit and they are all set to 1
 
-          uint isSelected2ProngCand = n2ProngBit; // bitmap for checking status of two-prong candidates (1 is true, 0 is rejected)
-
-          if (config.debug) {
-            for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
-              for (int iCut = 0; iCut < kNCuts2Prong[iDecay2P]; iCut++) {
-                cutStatus2Prong[iDecay2P][iCut] = true;
-              }
-            }
-          }
+    for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
+      nCutStatus2ProngBit[iDecay2P] = BIT(kNCuts2Prong[iDecay2P]) - 1;
+      cutStatus2Prong[iDecay2P] = std::vector<bool>(kNCuts2Prong[iDecay2P], true);
+    }
+    for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+      nCutStatus3ProngBit[iDecay3P] = BIT(kNCuts3Prong[iDecay3P]) - 1;
+      cutStatus3Prong[iDecay3P] = std::vector<bool>(kNCuts3Prong[iDecay3P], true);
+    }
 
-          // initialise PV refit coordinates and cov matrix for 2-prongs already here for D*
-          std::array pvRefitCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
-          std::array pvRefitCovMatrix2Prong = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
+    int whichHypo2Prong[kN2ProngDecays + 1]; // we also put D0 for D* in the last slot
+    int whichHypo3Prong[kN3ProngDecays];
 
-          // 2-prong vertex reconstruction
-          float pt2Prong{-1.};
-          bool is2ProngCandidateGoodFor3Prong{sel3ProngStatusPos1 && sel3ProngStatusNeg1};
-          int nVtxFrom2ProngFitter = 0;
-          if (sel2ProngStatusPos && sel2ProngStatusNeg) {
+    // used to calculate number of candidiates per event
+    auto nCand2 = output.rowTrackIndexProng2.lastIndex();
+    auto nCand3 = output.rowTrackIndexProng3.lastIndex();
 
-            // 2-prong preselections
-            // TODO: in case of PV refit, the single-track DCA is calculated wrt two different PV vertices (only 1 track excluded)
-            applyPreselection2Prong(pVecTrackPos1, pVecTrackNeg1, dcaInfoPos1[0], dcaInfoNeg1[0], cutStatus2Prong, whichHypo2Prong, isSelected2ProngCand, pt2Prong);
+    // if there isn't at least a positive and a negative track, continue immediately
+    // if (tracksPos.size() < 1 || tracksNeg.size() < 1) {
+    //  return;
+    //}
 
-            if (isSelected2ProngCand > 0) {
-              // secondary vertex reconstruction and further 2-prong selections
-              try {
-                nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
-              } catch (...) {
-              }
+    const auto thisCollId = collision.globalIndex();
 
-              if (nVtxFrom2ProngFitter > 0) { // should it be this or > 0 or are they equivalent
-                // get secondary vertex
-                const auto& secondaryVertex2 = df2.getPCACandidate();
-                // get track momenta
-                std::array<float, 3> pvec0{};
-                std::array<float, 3> pvec1{};
-                df2.getTrack(0).getPxPyPzGlo(pvec0);
-                df2.getTrack(1).getPxPyPzGlo(pvec1);
+    // first loop over positive tracks
+    int lastFilledD0 = -1; // index to be filled in table for D* mesons
+    for (auto trackIndexPos1 = groupedTrackIndicesPos1.begin(); trackIndexPos1 != groupedTrackIndicesPos1.end(); ++trackIndexPos1) {
+      const auto trackPos1 = trackIndexPos1.template track_as<TTracks>();
 
-                /// PV refit excluding the candidate daughters, if contributors
-                if constexpr (DoPvRefit) {
-                  if (config.fillHistograms) {
-                    registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
-                  }
-                  int nCandContr = 2;
-                  auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-                  auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-                  bool isTrackFirstContr = true;
-                  bool isTrackSecondContr = true;
-                  if (trackFirstIt == vecPvContributorGlobId.end()) {
-                    /// This track did not contribute to the original PV refit
-                    if (config.debugPvRefit) {
-                      LOG(info) << "--- [2 Prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
-                    }
-                    nCandContr--;
-                    isTrackFirstContr = false;
-                  }
-                  if (trackSecondIt == vecPvContributorGlobId.end()) {
-                    /// This track did not contribute to the original PV refit
-                    if (config.debugPvRefit) {
-                      LOG(info) << "--- [2 Prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
-                    }
-                    nCandContr--;
-                    isTrackSecondContr = false;
-                  }
-                  if (nCandContr == 2) { // o2-linter: disable="magic-number" (see comment below)
-                    /// Both the daughter tracks were used for the original PV refit, let's refit it after excluding them
-                    if (config.debugPvRefit) {
-                      LOG(info) << "### [2 Prong] Calling performPvRefitCandProngs for HF 2 prong candidate";
-                    }
-                    performPvRefitCandProngs(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, {trackPos1.globalIndex(), trackNeg1.globalIndex()}, pvRefitCoord2Prong, pvRefitCovMatrix2Prong);
-                  } else if (nCandContr == 1) {
-                    /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
-                    if (config.debugPvRefit) {
-                      LOG(info) << "####### [2 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
-                    }
-                    if (config.fillHistograms) {
-                      registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
-                    }
-                    if (isTrackFirstContr && !isTrackSecondContr) {
-                      /// the first daughter is contributor, the second is not
-                      pvRefitCoord2Prong = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
-                      pvRefitCovMatrix2Prong = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
-                    } else if (!isTrackFirstContr && isTrackSecondContr) {
-                      ///  the second daughter is contributor, the first is not
-                      pvRefitCoord2Prong = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
-                      pvRefitCovMatrix2Prong = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
-                    }
-                  } else {
-                    /// 0 contributors among the HF candidate daughters
-                    if (config.fillHistograms) {
-                      registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
-                    }
-                    if (config.debugPvRefit) {
-                      LOG(info) << "####### [2 Prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
-                    }
-                  }
-                }
+      // retrieve the selection flag that corresponds to this collision
+      const auto isSelProngPos1 = trackIndexPos1.isSelProng();
+      const bool sel2ProngStatusPos = TESTBIT(isSelProngPos1, CandidateType::Cand2Prong);
+      const bool sel3ProngStatusPos1 = TESTBIT(isSelProngPos1, CandidateType::Cand3Prong);
 
-                const auto pVecCandProng2 = RecoDecay::pVec(pvec0, pvec1);
-                // 2-prong selections after secondary vertex
-                std::array pvCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()};
-                if constexpr (DoPvRefit) {
-                  pvCoord2Prong[0] = pvRefitCoord2Prong[0];
-                  pvCoord2Prong[1] = pvRefitCoord2Prong[1];
-                  pvCoord2Prong[2] = pvRefitCoord2Prong[2];
-                }
-                applySelection2Prong(pVecCandProng2, secondaryVertex2, pvCoord2Prong, cutStatus2Prong, isSelected2ProngCand);
-                if (is2ProngCandidateGoodFor3Prong && config.do3Prong) {
-                  is2ProngCandidateGoodFor3Prong = isTwoTrackVertexSelectedFor3Prongs(secondaryVertex2, pvCoord2Prong, df2);
-                }
+      const auto& propagatedTrackPos1 = trackStore.get(collision, trackPos1, noMatCorr);
+      const auto& trackParVarPos1 = propagatedTrackPos1.trackParCov;
+      const auto& pVecTrackPos1 = propagatedTrackPos1.pVec;
+      const auto& dcaInfoPos1 = propagatedTrackPos1.dcaInfo;
 
-                std::vector<float> mlScoresD0{};
-                if (config.applyMlForHfFilters) {
-                  const auto trackParVarPcaPos1 = df2.getTrack(0);
-                  const auto trackParVarPcaNeg1 = df2.getTrack(1);
-                  const std::vector<float> inputFeatures{trackParVarPcaPos1.getPt(), dcaInfoPos1[0], dcaInfoPos1[1], trackParVarPcaNeg1.getPt(), dcaInfoNeg1[0], dcaInfoNeg1[1]};
-                  applyMlSelectionForHfFilters2Prong(inputFeatures, mlScoresD0, isSelected2ProngCand);
-                }
+      // first loop over negative tracks
+      for (auto trackIndexNeg1 = groupedTrackIndicesNeg1.begin(); trackIndexNeg1 != groupedTrackIndicesNeg1.end(); ++trackIndexNeg1) {
+        const auto trackNeg1 = trackIndexNeg1.template track_as<TTracks>();
 
-                if (isSelected2ProngCand > 0) {
-                  // fill table row
-                  rowTrackIndexProng2(thisCollId, trackPos1.globalIndex(), trackNeg1.globalIndex(), isSelected2ProngCand);
-                  if (config.applyMlForHfFilters) {
-                    rowTrackIndexMlScoreProng2(mlScoresD0);
-                  }
-                  if (TESTBIT(isSelected2ProngCand, hf_cand_2prong::DecayType::D0ToPiK)) {
-                    lastFilledD0 = rowTrackIndexProng2.lastIndex();
-                  }
+        // retrieve the selection flag that corresponds to this collision
+        const auto isSelProngNeg1 = trackIndexNeg1.isSelProng();
+        const bool sel2ProngStatusNeg = TESTBIT(isSelProngNeg1, CandidateType::Cand2Prong);
+        const bool sel3ProngStatusNeg1 = TESTBIT(isSelProngNeg1, CandidateType::Cand3Prong);
 
-                  if constexpr (DoPvRefit) {
-                    // fill table row with coordinates of PV refit
-                    rowProng2PVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
-                                     pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
-                  }
+        const auto& propagatedTrackNeg1 = trackStore.get(collision, trackNeg1, noMatCorr);
+        const auto& trackParVarNeg1 = propagatedTrackNeg1.trackParCov;
+        const auto& pVecTrackNeg1 = propagatedTrackNeg1.pVec;
+        const auto& dcaInfoNeg1 = propagatedTrackNeg1.dcaInfo;
 
-                  if (config.debug) {
-                    uint8_t prong2CutStatus[kN2ProngDecays];
-                    for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
-                      prong2CutStatus[iDecay2P] = nCutStatus2ProngBit[iDecay2P];
-                      for (int iCut = 0; iCut < kNCuts2Prong[iDecay2P]; iCut++) {
-                        if (!cutStatus2Prong[iDecay2P][iCut]) {
-                          CLRBIT(prong2CutStatus[iDecay2P], iCut);
-                        }
-                      }
-                    }
-                    rowProng2CutStatus(prong2CutStatus[0], prong2CutStatus[1], prong2CutStatus[2]); // FIXME when we can do this by looping over kN2ProngDecays
-                  }
+        uint isSelected2ProngCand = n2ProngBit; // bitmap for checking status of two-prong candidates (1 is true, 0 is rejected)
 
-                  // fill histograms
-                  if (config.fillHistograms) {
-                    registry.fill(HIST("hVtx2ProngX"), secondaryVertex2[0]);
-                    registry.fill(HIST("hVtx2ProngY"), secondaryVertex2[1]);
-                    registry.fill(HIST("hVtx2ProngZ"), secondaryVertex2[2]);
-                    const std::array arrMom{pvec0, pvec1};
-                    for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
-                      if (TESTBIT(isSelected2ProngCand, iDecay2P)) {
-                        if (TESTBIT(whichHypo2Prong[iDecay2P], 0)) {
-                          const auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][0]);
-                          switch (iDecay2P) {
-                            case hf_cand_2prong::DecayType::D0ToPiK:
-                              registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
-                              break;
-                            case hf_cand_2prong::DecayType::JpsiToEE:
-                              registry.fill(HIST("hMassJpsiToEE"), mass2Prong);
-                              break;
-                            case hf_cand_2prong::DecayType::JpsiToMuMu:
-                              registry.fill(HIST("hMassJpsiToMuMu"), mass2Prong);
-                              break;
-                          }
-                        }
-                        if (TESTBIT(whichHypo2Prong[iDecay2P], 1)) {
-                          const auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][1]);
-                          if (iDecay2P == hf_cand_2prong::DecayType::D0ToPiK) {
-                            registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
-                          }
-                        }
-                      }
-                    }
-                  }
-                }
-              } else {
-                isSelected2ProngCand = 0; // reset to 0 not to use the D0 to build a D* meson
-              }
-            } else {
-              isSelected2ProngCand = 0; // reset to 0 not to use the D0 to build a D* meson
+        if (config.debug) {
+          for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
+            for (int iCut = 0; iCut < kNCuts2Prong[iDecay2P]; iCut++) {
+              cutStatus2Prong[iDecay2P][iCut] = true;
             }
           }
+        }
+
+        // initialise PV refit coordinates and cov matrix for 2-prongs already here for D*
+        std::array pvRefitCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
+        std::array pvRefitCovMatrix2Prong = getPrimaryVertex(collision).getCov();               /// initialize to the original PV
+
+        // 2-prong vertex reconstruction
+        float pt2Prong{-1.};
+        bool is2ProngCandidateGoodFor3Prong{sel3ProngStatusPos1 && sel3ProngStatusNeg1};
+        if (config.do3Prong && is2ProngCandidateGoodFor3Prong && !config.debug) {
+          // skip the pair if even the lightest 3-prong candidate built with it is above all the mass windows
+          // the pair gives the first two daughters in either order (pos-neg-pos or neg-pos-neg), so both orders are considered
+          const auto massMin3Prong = std::min(RecoDecay::m(std::array{pVecTrackPos1, pVecTrackNeg1}, std::array{massMinProng3Prong[0], massMinProng3Prong[1]}),
+                                              RecoDecay::m(std::array{pVecTrackNeg1, pVecTrackPos1}, std::array{massMinProng3Prong[0], massMinProng3Prong[1]})) +
+                                     massMinProng3Prong[2];
+          is2ProngCandidateGoodFor3Prong = massMin3Prong < massMax3Prong;
+        }
+        int nVtxFrom2ProngFitter = 0;
+        if (sel2ProngStatusPos && sel2ProngStatusNeg) {
 
-          // if the cut on the decay length of 3-prongs computed with the first two tracks is enabled and the vertex was not computed for the D0, we compute it now
-          if (config.do3Prong && is2ProngCandidateGoodFor3Prong && (config.minTwoTrackDecayLengthFor3Prongs > 0.f || config.maxTwoTrackChi2PcaFor3Prongs < 1.e9f) && nVtxFrom2ProngFitter == 0) { // o2-linter: disable="magic-number" (default maxTwoTrackChi2PcaFor3Prongs is 1.e10)
+          // 2-prong preselections
+          // TODO: in case of PV refit, the single-track DCA is calculated wrt two different PV vertices (only 1 track excluded)
+          applyPreselection2Prong(pVecTrackPos1, pVecTrackNeg1, dcaInfoPos1[0], dcaInfoNeg1[0], cutStatus2Prong, whichHypo2Prong, isSelected2ProngCand, pt2Prong);
+
+          if (isSelected2ProngCand > 0) {
+            // secondary vertex reconstruction and further 2-prong selections
             try {
               nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
             } catch (...) {
             }
-            if (nVtxFrom2ProngFitter > 0) {
-              const auto& secondaryVertex2 = df2.getPCACandidate();
-              const std::array pvCoord2Prong{collision.posX(), collision.posY(), collision.posZ()};
-              is2ProngCandidateGoodFor3Prong = isTwoTrackVertexSelectedFor3Prongs(secondaryVertex2, pvCoord2Prong, df2);
-            } else {
-              is2ProngCandidateGoodFor3Prong = false;
-            }
-          }
-
-          if (config.do3Prong && is2ProngCandidateGoodFor3Prong) { // if 3 prongs are enabled and the first 2 tracks are selected for the 3-prong channels
-            // second loop over positive tracks
-            for (auto trackIndexPos2 = trackIndexPos1 + 1; trackIndexPos2 != groupedTrackIndicesPos1.end(); ++trackIndexPos2) {
 
-              uint isSelected3ProngCand = n3ProngBit;
-              if (!TESTBIT(trackIndexPos2.isSelProng(), CandidateType::Cand3Prong)) { // continue immediately
-                if (!config.debug) {
-                  continue;
-                }
-                isSelected3ProngCand = 0;
-              }
-
-              if (config.applyKaonPidIn3Prongs && !TESTBIT(trackIndexNeg1.isIdentifiedPid(), ChannelKaonPid)) { // continue immediately if kaon PID enabled and opposite-sign track not a kaon
-                if (!config.debug) {
-                  continue;
-                }
-                isSelected3ProngCand = 0;
-              }
-
-              const auto trackPos2 = trackIndexPos2.template track_as<TTracks>();
-              auto trackParVarPos2 = getTrackParCov(trackPos2);
-              std::array dcaInfoPos2{trackPos2.dcaXY(), trackPos2.dcaZ()};
-
-              // preselection of 3-prong candidates
-              if (isSelected3ProngCand) {
-                std::array pVecTrackPos2{trackPos2.pVector()};
-                if (thisCollId != trackPos2.collisionId()) { // this is not the "default" collision for this track and we still did not re-propagate it, we have to re-propagate it
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParVarPos2, 2.f, noMatCorr, &dcaInfoPos2);
-                  getPxPyPz(trackParVarPos2, pVecTrackPos2);
-                }
-
-                if (config.debug) {
-                  for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-                    for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
-                      cutStatus3Prong[iDecay3P][iCut] = true;
-                    }
-                  }
-                }
-
-                // 3-prong preselections
-                const auto isIdentifiedPidTrackPos1 = trackIndexPos1.isIdentifiedPid();
-                const auto isIdentifiedPidTrackPos2 = trackIndexPos2.isIdentifiedPid();
-                applyPreselection3Prong(pVecTrackPos1, pVecTrackNeg1, pVecTrackPos2, isIdentifiedPidTrackPos1, isIdentifiedPidTrackPos2, cutStatus3Prong, whichHypo3Prong, isSelected3ProngCand);
-                if (!config.debug && isSelected3ProngCand == 0) {
-                  continue;
-                }
-              }
+            if (nVtxFrom2ProngFitter > 0) { // should it be this or > 0 or are they equivalent
+              // get secondary vertex
+              const auto& secondaryVertex2 = df2.getPCACandidate();
+              // get track momenta
+              std::array<float, 3> pvec0{};
+              std::array<float, 3> pvec1{};
+              df2.getTrack(0).getPxPyPzGlo(pvec0);
+              df2.getTrack(1).getPxPyPzGlo(pvec1);
 
               /// PV refit excluding the candidate daughters, if contributors
-              std::array pvRefitCoord3Prong2Pos1Neg{collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
-              std::array pvRefitCovMatrix3Prong2Pos1Neg{getPrimaryVertex(collision).getCov()};             /// initialize to the original PV
               if constexpr (DoPvRefit) {
                 if (config.fillHistograms) {
                   registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
                 }
-                int nCandContr = 3;
+                int nCandContr = 2;
                 auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
                 auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-                auto trackThirdIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos2.globalIndex());
                 bool isTrackFirstContr = true;
                 bool isTrackSecondContr = true;
-                bool isTrackThirdContr = true;
                 if (trackFirstIt == vecPvContributorGlobId.end()) {
                   /// This track did not contribute to the original PV refit
                   if (config.debugPvRefit) {
-                    LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
+                    LOG(info) << "--- [2 Prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
                   }
                   nCandContr--;
                   isTrackFirstContr = false;
@@ -2472,58 +2402,33 @@ struct HfTrackIndexSkimCreator {
                 if (trackSecondIt == vecPvContributorGlobId.end()) {
                   /// This track did not contribute to the original PV refit
                   if (config.debugPvRefit) {
-                    LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
+                    LOG(info) << "--- [2 Prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
                   }
                   nCandContr--;
                   isTrackSecondContr = false;
                 }
-                if (trackThirdIt == vecPvContributorGlobId.end()) {
-                  /// This track did not contribute to the original PV refit
+                if (nCandContr == 2) { // o2-linter: disable="magic-number" (see comment below)
+                  /// Both the daughter tracks were used for the original PV refit, let's refit it after excluding them
                   if (config.debugPvRefit) {
-                    LOG(info) << "--- [3 prong] trackPos2 with globalIndex " << trackPos2.globalIndex() << " was not a PV contributor";
+                    LOG(info) << "### [2 Prong] Calling performPvRefitCandProngs for HF 2 prong candidate";
                   }
-                  nCandContr--;
-                  isTrackThirdContr = false;
-                }
-
-                // Fill a vector with global ID of candidate daughters that are contributors
-                std::vector<int64_t> vecCandPvContributorGlobId = {};
-                if (isTrackFirstContr) {
-                  vecCandPvContributorGlobId.push_back(trackPos1.globalIndex());
-                }
-                if (isTrackSecondContr) {
-                  vecCandPvContributorGlobId.push_back(trackNeg1.globalIndex());
-                }
-                if (isTrackThirdContr) {
-                  vecCandPvContributorGlobId.push_back(trackPos2.globalIndex());
-                }
-
-                if (nCandContr == 3 || nCandContr == 2) { // o2-linter: disable="magic-number" (see comment below)
-                  /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
-                  if (config.debugPvRefit) {
-                    LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
-                  }
-                  performPvRefitCandProngs(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong2Pos1Neg, pvRefitCovMatrix3Prong2Pos1Neg);
+                  performPvRefitCandProngs(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, {trackPos1.globalIndex(), trackNeg1.globalIndex()}, pvRefitCoord2Prong, pvRefitCovMatrix2Prong);
                 } else if (nCandContr == 1) {
                   /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
                   if (config.debugPvRefit) {
-                    LOG(info) << "####### [3 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
+                    LOG(info) << "####### [2 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
                   }
                   if (config.fillHistograms) {
                     registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
                   }
-                  if (isTrackFirstContr && !isTrackSecondContr && !isTrackThirdContr) {
-                    /// the first daughter is contributor, the second and the third are not
-                    pvRefitCoord3Prong2Pos1Neg = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
-                    pvRefitCovMatrix3Prong2Pos1Neg = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
-                  } else if (!isTrackFirstContr && isTrackSecondContr && !isTrackThirdContr) {
-                    /// the second daughter is contributor, the first and the third are not
-                    pvRefitCoord3Prong2Pos1Neg = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
-                    pvRefitCovMatrix3Prong2Pos1Neg = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
-                  } else if (!isTrackFirstContr && !isTrackSecondContr && isTrackThirdContr) {
-                    /// the third daughter is contributor, the first and the second are not
-                    pvRefitCoord3Prong2Pos1Neg = {trackPos2.pvRefitX(), trackPos2.pvRefitY(), trackPos2.pvRefitZ()};
-                    pvRefitCovMatrix3Prong2Pos1Neg = {trackPos2.pvRefitSigmaX2(), trackPos2.pvRefitSigmaXY(), trackPos2.pvRefitSigmaY2(), trackPos2.pvRefitSigmaXZ(), trackPos2.pvRefitSigmaYZ(), trackPos2.pvRefitSigmaZ2()};
+                  if (isTrackFirstContr && !isTrackSecondContr) {
+                    /// the first daughter is contributor, the second is not
+                    pvRefitCoord2Prong = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
+                    pvRefitCovMatrix2Prong = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
+                  } else if (!isTrackFirstContr && isTrackSecondContr) {
+                    ///  the second daughter is contributor, the first is not
+                    pvRefitCoord2Prong = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
+                    pvRefitCovMatrix2Prong = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
                   }
                 } else {
                   /// 0 contributors among the HF candidate daughters
@@ -2531,483 +2436,853 @@ struct HfTrackIndexSkimCreator {
                     registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
                   }
                   if (config.debugPvRefit) {
-                    LOG(info) << "####### [3 prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
+                    LOG(info) << "####### [2 Prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
                   }
                 }
               }
 
-              // reconstruct the 3-prong secondary vertex
-              int nVtxFrom3ProngFitter = 0;
-              try {
-                nVtxFrom3ProngFitter = df3.process(trackParVarPos1, trackParVarNeg1, trackParVarPos2);
-              } catch (...) {
-                continue;
+              const auto pVecCandProng2 = RecoDecay::pVec(pvec0, pvec1);
+              // 2-prong selections after secondary vertex
+              std::array pvCoord2Prong = {collision.posX(), collision.posY(), collision.posZ()};
+              if constexpr (DoPvRefit) {
+                pvCoord2Prong[0] = pvRefitCoord2Prong[0];
+                pvCoord2Prong[1] = pvRefitCoord2Prong[1];
+                pvCoord2Prong[2] = pvRefitCoord2Prong[2];
               }
-
-              if (nVtxFrom3ProngFitter == 0) {
-                continue;
+              applySelection2Prong(pVecCandProng2, secondaryVertex2, pvCoord2Prong, cutStatus2Prong, isSelected2ProngCand);
+              if (is2ProngCandidateGoodFor3Prong && config.do3Prong) {
+                is2ProngCandidateGoodFor3Prong = isTwoTrackVertexSelectedFor3Prongs(secondaryVertex2, pvCoord2Prong, df2);
               }
-              // get secondary vertex
-              const auto& secondaryVertex3 = df3.getPCACandidate();
-              // get track momenta
-              std::array<float, 3> pvec0{};
-              std::array<float, 3> pvec1{};
-              std::array<float, 3> pvec2{};
-              const auto trackParVarPcaPos1 = df3.getTrack(0);
-              const auto trackParVarPcaNeg1 = df3.getTrack(1);
-              const auto trackParVarPcaPos2 = df3.getTrack(2);
-              trackParVarPcaPos1.getPxPyPzGlo(pvec0);
-              trackParVarPcaNeg1.getPxPyPzGlo(pvec1);
-              trackParVarPcaPos2.getPxPyPzGlo(pvec2);
-              const auto pVecCandProng3Pos = RecoDecay::pVec(pvec0, pvec1, pvec2);
-
-              // 3-prong selections after secondary vertex
-              applySelection3Prong(pVecCandProng3Pos, secondaryVertex3, pvRefitCoord3Prong2Pos1Neg, cutStatus3Prong, isSelected3ProngCand);
-
-              std::array<std::vector<float>, kN3ProngDecays - 1> mlScores3Prongs;
+
+              std::vector<float> mlScoresD0{};
               if (config.applyMlForHfFilters) {
-                const std::vector<float> inputFeatures{trackParVarPcaPos1.getPt(), dcaInfoPos1[0], dcaInfoPos1[1], trackParVarPcaNeg1.getPt(), dcaInfoNeg1[0], dcaInfoNeg1[1], trackParVarPcaPos2.getPt(), dcaInfoPos2[0], dcaInfoPos2[1]};
-                std::vector<float> inputFeaturesLcPid{};
-                if constexpr (UsePidForHfFiltersBdt) {
-                  inputFeaturesLcPid.push_back(trackPos1.tpcNSigmaPr());
-                  inputFeaturesLcPid.push_back(trackPos2.tpcNSigmaPr());
-                  inputFeaturesLcPid.push_back(trackPos1.tpcNSigmaPi());
-                  inputFeaturesLcPid.push_back(trackPos2.tpcNSigmaPi());
-                  inputFeaturesLcPid.push_back(trackNeg1.tpcNSigmaKa());
-                }
-                applyMlSelectionForHfFilters3Prong<UsePidForHfFiltersBdt>(inputFeatures, inputFeaturesLcPid, mlScores3Prongs, isSelected3ProngCand);
+                const auto trackParVarPcaPos1 = df2.getTrack(0);
+                const auto trackParVarPcaNeg1 = df2.getTrack(1);
+                const std::vector<float> inputFeatures{trackParVarPcaPos1.getPt(), dcaInfoPos1[0], dcaInfoPos1[1], trackParVarPcaNeg1.getPt(), dcaInfoNeg1[0], dcaInfoNeg1[1]};
+                applyMlSelectionForHfFilters2Prong(inputFeatures, mlScoresD0, isSelected2ProngCand);
               }
 
-              if (!config.debug && isSelected3ProngCand == 0) {
-                continue;
-              }
+              if (isSelected2ProngCand > 0) {
+                // fill table row
+                output.rowTrackIndexProng2(thisCollId, trackPos1.globalIndex(), trackNeg1.globalIndex(), isSelected2ProngCand);
+                if (config.applyMlForHfFilters) {
+                  rowTrackIndexMlScoreProng2(mlScoresD0);
+                }
+                if (TESTBIT(isSelected2ProngCand, hf_cand_2prong::DecayType::D0ToPiK)) {
+                  lastFilledD0 = output.rowTrackIndexProng2.lastIndex();
+                }
 
-              // fill table row
-              rowTrackIndexProng3(thisCollId, trackPos1.globalIndex(), trackNeg1.globalIndex(), trackPos2.globalIndex(), isSelected3ProngCand);
-              if (config.applyMlForHfFilters) {
-                rowTrackIndexMlScoreProng3(mlScores3Prongs[0], mlScores3Prongs[1], mlScores3Prongs[2], mlScores3Prongs[3]);
-              }
-              if constexpr (DoPvRefit) {
-                // fill table row of coordinates of PV refit
-                rowProng3PVrefit(pvRefitCoord3Prong2Pos1Neg[0], pvRefitCoord3Prong2Pos1Neg[1], pvRefitCoord3Prong2Pos1Neg[2],
-                                 pvRefitCovMatrix3Prong2Pos1Neg[0], pvRefitCovMatrix3Prong2Pos1Neg[1], pvRefitCovMatrix3Prong2Pos1Neg[2], pvRefitCovMatrix3Prong2Pos1Neg[3], pvRefitCovMatrix3Prong2Pos1Neg[4], pvRefitCovMatrix3Prong2Pos1Neg[5]);
-              }
+                if constexpr (DoPvRefit) {
+                  // fill table row with coordinates of PV refit
+                  rowProng2PVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
+                                   pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
+                }
 
-              if (config.debug) {
-                uint8_t prong3CutStatus[kN3ProngDecays];
-                for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-                  prong3CutStatus[iDecay3P] = nCutStatus3ProngBit[iDecay3P];
-                  for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
-                    if (!cutStatus3Prong[iDecay3P][iCut]) {
-                      CLRBIT(prong3CutStatus[iDecay3P], iCut);
+                if (config.debug) {
+                  uint8_t prong2CutStatus[kN2ProngDecays];
+                  for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
+                    prong2CutStatus[iDecay2P] = nCutStatus2ProngBit[iDecay2P];
+                    for (int iCut = 0; iCut < kNCuts2Prong[iDecay2P]; iCut++) {
+                      if (!cutStatus2Prong[iDecay2P][iCut]) {
+                        CLRBIT(prong2CutStatus[iDecay2P], iCut);
+                      }
                     }
                   }
+                  rowProng2CutStatus(prong2CutStatus[0], prong2CutStatus[1], prong2CutStatus[2]); // FIXME when we can do this by looping over kN2ProngDecays
                 }
-                rowProng3CutStatus(prong3CutStatus[0], prong3CutStatus[1], prong3CutStatus[2], prong3CutStatus[3]); // FIXME when we can do this by looping over kN3ProngDecays
-              }
 
-              // fill histograms
-              if (config.fillHistograms) {
-                registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
-                registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
-                registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
-                const std::array arr3Mom{pvec0, pvec1, pvec2};
-                for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-                  if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
-                    if (TESTBIT(whichHypo3Prong[iDecay3P], 0)) {
-                      const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
-                      switch (iDecay3P) {
-                        case hf_cand_3prong::DecayType::DplusToPiKPi:
-                          registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::DsToKKPi:
-                          registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::LcToPKPi:
-                          registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::XicToPKPi:
-                          registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::CdToDeKPi:
-                          registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
-                          break;
+                // fill histograms
+                if (config.fillHistograms) {
+                  registry.fill(HIST("hVtx2ProngX"), secondaryVertex2[0]);
+                  registry.fill(HIST("hVtx2ProngY"), secondaryVertex2[1]);
+                  registry.fill(HIST("hVtx2ProngZ"), secondaryVertex2[2]);
+                  const std::array arrMom{pvec0, pvec1};
+                  for (int iDecay2P = 0; iDecay2P < kN2ProngDecays; iDecay2P++) {
+                    if (TESTBIT(isSelected2ProngCand, iDecay2P)) {
+                      if (TESTBIT(whichHypo2Prong[iDecay2P], 0)) {
+                        const auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][0]);
+                        switch (iDecay2P) {
+                          case hf_cand_2prong::DecayType::D0ToPiK:
+                            registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
+                            break;
+                          case hf_cand_2prong::DecayType::JpsiToEE:
+                            registry.fill(HIST("hMassJpsiToEE"), mass2Prong);
+                            break;
+                          case hf_cand_2prong::DecayType::JpsiToMuMu:
+                            registry.fill(HIST("hMassJpsiToMuMu"), mass2Prong);
+                            break;
+                        }
                       }
-                    }
-                    if (TESTBIT(whichHypo3Prong[iDecay3P], 1)) {
-                      const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
-                      switch (iDecay3P) {
-                        case hf_cand_3prong::DecayType::DsToKKPi:
-                          registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::LcToPKPi:
-                          registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::XicToPKPi:
-                          registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::CdToDeKPi:
-                          registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
-                          break;
+                      if (TESTBIT(whichHypo2Prong[iDecay2P], 1)) {
+                        const auto mass2Prong = RecoDecay::m(arrMom, arrMass2Prong[iDecay2P][1]);
+                        if (iDecay2P == hf_cand_2prong::DecayType::D0ToPiK) {
+                          registry.fill(HIST("hMassD0ToPiK"), mass2Prong);
+                        }
                       }
                     }
                   }
                 }
               }
+            } else {
+              isSelected2ProngCand = 0; // reset to 0 not to use the D0 to build a D* meson
             }
+          } else {
+            isSelected2ProngCand = 0; // reset to 0 not to use the D0 to build a D* meson
+          }
+        }
 
-            // second loop over negative tracks
-            for (auto trackIndexNeg2 = trackIndexNeg1 + 1; trackIndexNeg2 != groupedTrackIndicesNeg1.end(); ++trackIndexNeg2) {
+        // if the cut on the decay length of 3-prongs computed with the first two tracks is enabled and the vertex was not computed for the D0, we compute it now
+        if (config.do3Prong && is2ProngCandidateGoodFor3Prong && (config.minTwoTrackDecayLengthFor3Prongs > 0.f || config.maxTwoTrackChi2PcaFor3Prongs < 1.e9f) && nVtxFrom2ProngFitter == 0) { // o2-linter: disable="magic-number" (default maxTwoTrackChi2PcaFor3Prongs is 1.e10)
+          try {
+            nVtxFrom2ProngFitter = df2.process(trackParVarPos1, trackParVarNeg1);
+          } catch (...) {
+          }
+          if (nVtxFrom2ProngFitter > 0) {
+            const auto& secondaryVertex2 = df2.getPCACandidate();
+            const std::array pvCoord2Prong{collision.posX(), collision.posY(), collision.posZ()};
+            is2ProngCandidateGoodFor3Prong = isTwoTrackVertexSelectedFor3Prongs(secondaryVertex2, pvCoord2Prong, df2);
+          } else {
+            is2ProngCandidateGoodFor3Prong = false;
+          }
+        }
 
-              int isSelected3ProngCand = n3ProngBit;
-              if (!TESTBIT(trackIndexNeg2.isSelProng(), CandidateType::Cand3Prong)) { // continue immediately
-                if (!config.debug) {
-                  continue;
-                }
-                isSelected3ProngCand = 0;
+        if (config.do3Prong && is2ProngCandidateGoodFor3Prong) { // if 3 prongs are enabled and the first 2 tracks are selected for the 3-prong channels
+          // second loop over positive tracks
+          for (auto trackIndexPos2 = trackIndexPos1 + 1; trackIndexPos2 != groupedTrackIndicesPos1.end(); ++trackIndexPos2) {
+
+            uint isSelected3ProngCand = n3ProngBit;
+            if (!TESTBIT(trackIndexPos2.isSelProng(), CandidateType::Cand3Prong)) { // continue immediately
+              if (!config.debug) {
+                continue;
               }
+              isSelected3ProngCand = 0;
+            }
 
-              if (config.applyKaonPidIn3Prongs && !TESTBIT(trackIndexPos1.isIdentifiedPid(), ChannelKaonPid)) { // continue immediately if kaon PID enabled and opposite-sign track not a kaon
-                if (!config.debug) {
-                  continue;
-                }
-                isSelected3ProngCand = 0;
+            if (config.applyKaonPidIn3Prongs && !TESTBIT(trackIndexNeg1.isIdentifiedPid(), ChannelKaonPid)) { // continue immediately if kaon PID enabled and opposite-sign track not a kaon
+              if (!config.debug) {
+                continue;
               }
+              isSelected3ProngCand = 0;
+            }
 
-              auto trackNeg2 = trackIndexNeg2.template track_as<TTracks>();
-              auto trackParVarNeg2 = getTrackParCov(trackNeg2);
-              std::array dcaInfoNeg2{trackNeg2.dcaXY(), trackNeg2.dcaZ()};
-
-              // preselection of 3-prong candidates
-              if (isSelected3ProngCand) {
-                std::array pVecTrackNeg2{trackNeg2.pVector()};
-                if (thisCollId != trackNeg2.collisionId()) { // this is not the "default" collision for this track and we still did not re-propagate it, we have to re-propagate it
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParVarNeg2, 2.f, noMatCorr, &dcaInfoNeg2);
-                  getPxPyPz(trackParVarNeg2, pVecTrackNeg2);
-                }
+            const auto trackPos2 = trackIndexPos2.template track_as<TTracks>();
+            const auto& propagatedTrackPos2 = trackStore.get(collision, trackPos2, noMatCorr);
+            const auto& trackParVarPos2 = propagatedTrackPos2.trackParCov;
+            const auto& dcaInfoPos2 = propagatedTrackPos2.dcaInfo;
 
-                if (config.debug) {
-                  for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-                    for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
-                      cutStatus3Prong[iDecay3P][iCut] = true;
-                    }
+            // preselection of 3-prong candidates
+            if (isSelected3ProngCand) {
+              const auto& pVecTrackPos2 = propagatedTrackPos2.pVec;
+
+              if (config.debug) {
+                for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+                  for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
+                    cutStatus3Prong[iDecay3P][iCut] = true;
                   }
                 }
+              }
 
-                // 3-prong preselections
-                int8_t const isIdentifiedPidTrackNeg1 = trackIndexNeg1.isIdentifiedPid();
-                int8_t const isIdentifiedPidTrackNeg2 = trackIndexNeg2.isIdentifiedPid();
-                applyPreselection3Prong(pVecTrackNeg1, pVecTrackPos1, pVecTrackNeg2, isIdentifiedPidTrackNeg1, isIdentifiedPidTrackNeg2, cutStatus3Prong, whichHypo3Prong, isSelected3ProngCand);
-                if (!config.debug && isSelected3ProngCand == 0) {
-                  continue;
-                }
+              // 3-prong preselections
+              const auto isIdentifiedPidTrackPos1 = trackIndexPos1.isIdentifiedPid();
+              const auto isIdentifiedPidTrackPos2 = trackIndexPos2.isIdentifiedPid();
+              applyPreselection3Prong(pVecTrackPos1, pVecTrackNeg1, pVecTrackPos2, isIdentifiedPidTrackPos1, isIdentifiedPidTrackPos2, cutStatus3Prong, whichHypo3Prong, isSelected3ProngCand);
+              if (!config.debug && isSelected3ProngCand == 0) {
+                continue;
               }
+            }
 
-              /// PV refit excluding the candidate daughters, if contributors
-              std::array pvRefitCoord3Prong1Pos2Neg{collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
-              std::array pvRefitCovMatrix3Prong1Pos2Neg{getPrimaryVertex(collision).getCov()};             /// initialize to the original PV
-              if constexpr (DoPvRefit) {
-                if (config.fillHistograms) {
-                  registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
-                }
-                int nCandContr = 3;
-                auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
-                auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
-                auto trackThirdIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg2.globalIndex());
-                bool isTrackFirstContr = true;
-                bool isTrackSecondContr = true;
-                bool isTrackThirdContr = true;
-                if (trackFirstIt == vecPvContributorGlobId.end()) {
-                  /// This track did not contribute to the original PV refit
-                  if (config.debugPvRefit) {
-                    LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
-                  }
-                  nCandContr--;
-                  isTrackFirstContr = false;
+            /// PV refit excluding the candidate daughters, if contributors
+            std::array pvRefitCoord3Prong2Pos1Neg{collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
+            std::array pvRefitCovMatrix3Prong2Pos1Neg{getPrimaryVertex(collision).getCov()};             /// initialize to the original PV
+            if constexpr (DoPvRefit) {
+              if (config.fillHistograms) {
+                registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
+              }
+              int nCandContr = 3;
+              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
+              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
+              auto trackThirdIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos2.globalIndex());
+              bool isTrackFirstContr = true;
+              bool isTrackSecondContr = true;
+              bool isTrackThirdContr = true;
+              if (trackFirstIt == vecPvContributorGlobId.end()) {
+                /// This track did not contribute to the original PV refit
+                if (config.debugPvRefit) {
+                  LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
                 }
-                if (trackSecondIt == vecPvContributorGlobId.end()) {
-                  /// This track did not contribute to the original PV refit
-                  if (config.debugPvRefit) {
-                    LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
-                  }
-                  nCandContr--;
-                  isTrackSecondContr = false;
+                nCandContr--;
+                isTrackFirstContr = false;
+              }
+              if (trackSecondIt == vecPvContributorGlobId.end()) {
+                /// This track did not contribute to the original PV refit
+                if (config.debugPvRefit) {
+                  LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
                 }
-                if (trackThirdIt == vecPvContributorGlobId.end()) {
-                  /// This track did not contribute to the original PV refit
-                  if (config.debugPvRefit) {
-                    LOG(info) << "--- [3 prong] trackNeg2 with globalIndex " << trackNeg2.globalIndex() << " was not a PV contributor";
-                  }
-                  nCandContr--;
-                  isTrackThirdContr = false;
+                nCandContr--;
+                isTrackSecondContr = false;
+              }
+              if (trackThirdIt == vecPvContributorGlobId.end()) {
+                /// This track did not contribute to the original PV refit
+                if (config.debugPvRefit) {
+                  LOG(info) << "--- [3 prong] trackPos2 with globalIndex " << trackPos2.globalIndex() << " was not a PV contributor";
                 }
+                nCandContr--;
+                isTrackThirdContr = false;
+              }
+
+              // Fill a vector with global ID of candidate daughters that are contributors
+              std::vector<int64_t> vecCandPvContributorGlobId = {};
+              if (isTrackFirstContr) {
+                vecCandPvContributorGlobId.push_back(trackPos1.globalIndex());
+              }
+              if (isTrackSecondContr) {
+                vecCandPvContributorGlobId.push_back(trackNeg1.globalIndex());
+              }
+              if (isTrackThirdContr) {
+                vecCandPvContributorGlobId.push_back(trackPos2.globalIndex());
+              }
 
-                // Fill a vector with global ID of candidate daughters that are contributors
-                std::vector<int64_t> vecCandPvContributorGlobId = {};
-                if (isTrackFirstContr) {
-                  vecCandPvContributorGlobId.push_back(trackPos1.globalIndex());
+              if (nCandContr == 3 || nCandContr == 2) { // o2-linter: disable="magic-number" (see comment below)
+                /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
+                if (config.debugPvRefit) {
+                  LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
+                }
+                performPvRefitCandProngs(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong2Pos1Neg, pvRefitCovMatrix3Prong2Pos1Neg);
+              } else if (nCandContr == 1) {
+                /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
+                if (config.debugPvRefit) {
+                  LOG(info) << "####### [3 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
                 }
-                if (isTrackSecondContr) {
-                  vecCandPvContributorGlobId.push_back(trackNeg1.globalIndex());
+                if (config.fillHistograms) {
+                  registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
+                }
+                if (isTrackFirstContr && !isTrackSecondContr && !isTrackThirdContr) {
+                  /// the first daughter is contributor, the second and the third are not
+                  pvRefitCoord3Prong2Pos1Neg = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
+                  pvRefitCovMatrix3Prong2Pos1Neg = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
+                } else if (!isTrackFirstContr && isTrackSecondContr && !isTrackThirdContr) {
+                  /// the second daughter is contributor, the first and the third are not
+                  pvRefitCoord3Prong2Pos1Neg = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
+                  pvRefitCovMatrix3Prong2Pos1Neg = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
+                } else if (!isTrackFirstContr && !isTrackSecondContr && isTrackThirdContr) {
+                  /// the third daughter is contributor, the first and the second are not
+                  pvRefitCoord3Prong2Pos1Neg = {trackPos2.pvRefitX(), trackPos2.pvRefitY(), trackPos2.pvRefitZ()};
+                  pvRefitCovMatrix3Prong2Pos1Neg = {trackPos2.pvRefitSigmaX2(), trackPos2.pvRefitSigmaXY(), trackPos2.pvRefitSigmaY2(), trackPos2.pvRefitSigmaXZ(), trackPos2.pvRefitSigmaYZ(), trackPos2.pvRefitSigmaZ2()};
+                }
+              } else {
+                /// 0 contributors among the HF candidate daughters
+                if (config.fillHistograms) {
+                  registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
                 }
-                if (isTrackThirdContr) {
-                  vecCandPvContributorGlobId.push_back(trackNeg2.globalIndex());
+                if (config.debugPvRefit) {
+                  LOG(info) << "####### [3 prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
                 }
+              }
+            }
 
-                if (nCandContr == 3 || nCandContr == 2) { // o2-linter: disable="magic-number" (see comment below)
-                  /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
-                  if (config.debugPvRefit) {
-                    LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
-                  }
-                  performPvRefitCandProngs(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong1Pos2Neg, pvRefitCovMatrix3Prong1Pos2Neg);
-                } else if (nCandContr == 1) {
-                  /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
-                  if (config.debugPvRefit) {
-                    LOG(info) << "####### [3 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
-                  }
-                  if (config.fillHistograms) {
-                    registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
-                  }
-                  if (isTrackFirstContr && !isTrackSecondContr && !isTrackThirdContr) {
-                    /// the first daughter is contributor, the second and the third are not
-                    pvRefitCoord3Prong1Pos2Neg = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
-                    pvRefitCovMatrix3Prong1Pos2Neg = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
-                  } else if (!isTrackFirstContr && isTrackSecondContr && !isTrackThirdContr) {
-                    /// the second daughter is contributor, the first and the third are not
-                    pvRefitCoord3Prong1Pos2Neg = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
-                    pvRefitCovMatrix3Prong1Pos2Neg = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
-                  } else if (!isTrackFirstContr && !isTrackSecondContr && isTrackThirdContr) {
-                    /// the third daughter is contributor, the first and the second are not
-                    pvRefitCoord3Prong1Pos2Neg = {trackNeg2.pvRefitX(), trackNeg2.pvRefitY(), trackNeg2.pvRefitZ()};
-                    pvRefitCovMatrix3Prong1Pos2Neg = {trackNeg2.pvRefitSigmaX2(), trackNeg2.pvRefitSigmaXY(), trackNeg2.pvRefitSigmaY2(), trackNeg2.pvRefitSigmaXZ(), trackNeg2.pvRefitSigmaYZ(), trackNeg2.pvRefitSigmaZ2()};
+            // reconstruct the 3-prong secondary vertex
+            int nVtxFrom3ProngFitter = 0;
+            try {
+              nVtxFrom3ProngFitter = df3.process(trackParVarPos1, trackParVarNeg1, trackParVarPos2);
+            } catch (...) {
+              continue;
+            }
+
+            if (nVtxFrom3ProngFitter == 0) {
+              continue;
+            }
+            // get secondary vertex
+            const auto& secondaryVertex3 = df3.getPCACandidate();
+            // get track momenta
+            std::array<float, 3> pvec0{};
+            std::array<float, 3> pvec1{};
+            std::array<float, 3> pvec2{};
+            const auto trackParVarPcaPos1 = df3.getTrack(0);
+            const auto trackParVarPcaNeg1 = df3.getTrack(1);
+            const auto trackParVarPcaPos2 = df3.getTrack(2);
+            trackParVarPcaPos1.getPxPyPzGlo(pvec0);
+            trackParVarPcaNeg1.getPxPyPzGlo(pvec1);
+            trackParVarPcaPos2.getPxPyPzGlo(pvec2);
+            const auto pVecCandProng3Pos = RecoDecay::pVec(pvec0, pvec1, pvec2);
+
+            // 3-prong selections after secondary vertex
+            applySelection3Prong(pVecCandProng3Pos, secondaryVertex3, pvRefitCoord3Prong2Pos1Neg, cutStatus3Prong, isSelected3ProngCand);
+
+            std::array<std::vector<float>, kN3ProngDecays - 1> mlScores3Prongs;
+            if (config.applyMlForHfFilters) {
+              const std::vector<float> inputFeatures{trackParVarPcaPos1.getPt(), dcaInfoPos1[0], dcaInfoPos1[1], trackParVarPcaNeg1.getPt(), dcaInfoNeg1[0], dcaInfoNeg1[1], trackParVarPcaPos2.getPt(), dcaInfoPos2[0], dcaInfoPos2[1]};
+              std::vector<float> inputFeaturesLcPid{};
+              if constexpr (UsePidForHfFiltersBdt) {
+                inputFeaturesLcPid.push_back(trackPos1.tpcNSigmaPr());
+                inputFeaturesLcPid.push_back(trackPos2.tpcNSigmaPr());
+                inputFeaturesLcPid.push_back(trackPos1.tpcNSigmaPi());
+                inputFeaturesLcPid.push_back(trackPos2.tpcNSigmaPi());
+                inputFeaturesLcPid.push_back(trackNeg1.tpcNSigmaKa());
+              }
+              applyMlSelectionForHfFilters3Prong<UsePidForHfFiltersBdt>(inputFeatures, inputFeaturesLcPid, mlScores3Prongs, isSelected3ProngCand);
+            }
+
+            if (!config.debug && isSelected3ProngCand == 0) {
+              continue;
+            }
+
+            // fill table row
+            output.rowTrackIndexProng3(thisCollId, trackPos1.globalIndex(), trackNeg1.globalIndex(), trackPos2.globalIndex(), isSelected3ProngCand);
+            if (config.applyMlForHfFilters) {
+              rowTrackIndexMlScoreProng3(mlScores3Prongs[0], mlScores3Prongs[1], mlScores3Prongs[2], mlScores3Prongs[3]);
+            }
+            if constexpr (DoPvRefit) {
+              // fill table row of coordinates of PV refit
+              rowProng3PVrefit(pvRefitCoord3Prong2Pos1Neg[0], pvRefitCoord3Prong2Pos1Neg[1], pvRefitCoord3Prong2Pos1Neg[2],
+                               pvRefitCovMatrix3Prong2Pos1Neg[0], pvRefitCovMatrix3Prong2Pos1Neg[1], pvRefitCovMatrix3Prong2Pos1Neg[2], pvRefitCovMatrix3Prong2Pos1Neg[3], pvRefitCovMatrix3Prong2Pos1Neg[4], pvRefitCovMatrix3Prong2Pos1Neg[5]);
+            }
+
+            if (config.debug) {
+              uint8_t prong3CutStatus[kN3ProngDecays];
+              for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+                prong3CutStatus[iDecay3P] = nCutStatus3ProngBit[iDecay3P];
+                for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
+                  if (!cutStatus3Prong[iDecay3P][iCut]) {
+                    CLRBIT(prong3CutStatus[iDecay3P], iCut);
                   }
-                } else {
-                  /// 0 contributors among the HF candidate daughters
-                  if (config.fillHistograms) {
-                    registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
+                }
+              }
+              rowProng3CutStatus(prong3CutStatus[0], prong3CutStatus[1], prong3CutStatus[2], prong3CutStatus[3]); // FIXME when we can do this by looping over kN3ProngDecays
+            }
+
+            // fill histograms
+            if (config.fillHistograms) {
+              registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
+              registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
+              registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
+              const std::array arr3Mom{pvec0, pvec1, pvec2};
+              for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+                if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
+                  if (TESTBIT(whichHypo3Prong[iDecay3P], 0)) {
+                    const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
+                    switch (iDecay3P) {
+                      case hf_cand_3prong::DecayType::DplusToPiKPi:
+                        registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::DsToKKPi:
+                        registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::LcToPKPi:
+                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::XicToPKPi:
+                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::CdToDeKPi:
+                        registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
+                        break;
+                    }
                   }
-                  if (config.debugPvRefit) {
-                    LOG(info) << "####### [3 prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
+                  if (TESTBIT(whichHypo3Prong[iDecay3P], 1)) {
+                    const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
+                    switch (iDecay3P) {
+                      case hf_cand_3prong::DecayType::DsToKKPi:
+                        registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::LcToPKPi:
+                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::XicToPKPi:
+                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::CdToDeKPi:
+                        registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
+                        break;
+                    }
                   }
                 }
               }
+            }
+          }
 
-              // reconstruct the 3-prong secondary vertex
-              int nVtxFrom3ProngFitterSecondLoop = 0;
-              try {
-                nVtxFrom3ProngFitterSecondLoop = df3.process(trackParVarNeg1, trackParVarPos1, trackParVarNeg2);
-              } catch (...) {
+          // second loop over negative tracks
+          for (auto trackIndexNeg2 = trackIndexNeg1 + 1; trackIndexNeg2 != groupedTrackIndicesNeg1.end(); ++trackIndexNeg2) {
+
+            int isSelected3ProngCand = n3ProngBit;
+            if (!TESTBIT(trackIndexNeg2.isSelProng(), CandidateType::Cand3Prong)) { // continue immediately
+              if (!config.debug) {
                 continue;
               }
+              isSelected3ProngCand = 0;
+            }
 
-              if (nVtxFrom3ProngFitterSecondLoop == 0) {
+            if (config.applyKaonPidIn3Prongs && !TESTBIT(trackIndexPos1.isIdentifiedPid(), ChannelKaonPid)) { // continue immediately if kaon PID enabled and opposite-sign track not a kaon
+              if (!config.debug) {
                 continue;
               }
-              // get secondary vertex
-              const auto& secondaryVertex3 = df3.getPCACandidate();
-              // get track momenta
-              std::array<float, 3> pvec0{};
-              std::array<float, 3> pvec1{};
-              std::array<float, 3> pvec2{};
-              const auto trackParVarPcaNeg1 = df3.getTrack(0);
-              const auto trackParVarPcaPos1 = df3.getTrack(1);
-              const auto trackParVarPcaNeg2 = df3.getTrack(2);
-              trackParVarPcaNeg1.getPxPyPzGlo(pvec0);
-              trackParVarPcaPos1.getPxPyPzGlo(pvec1);
-              trackParVarPcaNeg2.getPxPyPzGlo(pvec2);
+              isSelected3ProngCand = 0;
+            }
 
-              const auto pVecCandProng3Neg = RecoDecay::pVec(pvec0, pvec1, pvec2);
+            auto trackNeg2 = trackIndexNeg2.template track_as<TTracks>();
+            const auto& propagatedTrackNeg2 = trackStore.get(collision, trackNeg2, noMatCorr);
+            const auto& trackParVarNeg2 = propagatedTrackNeg2.trackParCov;
+            const auto& dcaInfoNeg2 = propagatedTrackNeg2.dcaInfo;
 
-              // 3-prong selections after secondary vertex
-              applySelection3Prong(pVecCandProng3Neg, secondaryVertex3, pvRefitCoord3Prong1Pos2Neg, cutStatus3Prong, isSelected3ProngCand);
+            // preselection of 3-prong candidates
+            if (isSelected3ProngCand) {
+              const auto& pVecTrackNeg2 = propagatedTrackNeg2.pVec;
 
-              std::array<std::vector<float>, kN3ProngDecays - 1> mlScores3Prongs{};
-              if (config.applyMlForHfFilters) {
-                const std::vector<float> inputFeatures{trackParVarPcaNeg1.getPt(), dcaInfoNeg1[0], dcaInfoNeg1[1], trackParVarPcaPos1.getPt(), dcaInfoPos1[0], dcaInfoPos1[1], trackParVarPcaNeg2.getPt(), dcaInfoNeg2[0], dcaInfoNeg2[1]};
-                std::vector<float> inputFeaturesLcPid{};
-                if constexpr (UsePidForHfFiltersBdt) {
-                  inputFeaturesLcPid.push_back(trackNeg1.tpcNSigmaPr());
-                  inputFeaturesLcPid.push_back(trackNeg2.tpcNSigmaPr());
-                  inputFeaturesLcPid.push_back(trackNeg1.tpcNSigmaPi());
-                  inputFeaturesLcPid.push_back(trackNeg2.tpcNSigmaPi());
-                  inputFeaturesLcPid.push_back(trackPos1.tpcNSigmaKa());
+              if (config.debug) {
+                for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+                  for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
+                    cutStatus3Prong[iDecay3P][iCut] = true;
+                  }
                 }
-                applyMlSelectionForHfFilters3Prong<UsePidForHfFiltersBdt>(inputFeatures, inputFeaturesLcPid, mlScores3Prongs, isSelected3ProngCand);
               }
 
+              // 3-prong preselections
+              int8_t const isIdentifiedPidTrackNeg1 = trackIndexNeg1.isIdentifiedPid();
+              int8_t const isIdentifiedPidTrackNeg2 = trackIndexNeg2.isIdentifiedPid();
+              applyPreselection3Prong(pVecTrackNeg1, pVecTrackPos1, pVecTrackNeg2, isIdentifiedPidTrackNeg1, isIdentifiedPidTrackNeg2, cutStatus3Prong, whichHypo3Prong, isSelected3ProngCand);
               if (!config.debug && isSelected3ProngCand == 0) {
                 continue;
               }
+            }
 
-              // fill table row
-              rowTrackIndexProng3(thisCollId, trackNeg1.globalIndex(), trackPos1.globalIndex(), trackNeg2.globalIndex(), isSelected3ProngCand);
-              if (config.applyMlForHfFilters) {
-                rowTrackIndexMlScoreProng3(mlScores3Prongs[0], mlScores3Prongs[1], mlScores3Prongs[2], mlScores3Prongs[3]);
+            /// PV refit excluding the candidate daughters, if contributors
+            std::array pvRefitCoord3Prong1Pos2Neg{collision.posX(), collision.posY(), collision.posZ()}; /// initialize to the original PV
+            std::array pvRefitCovMatrix3Prong1Pos2Neg{getPrimaryVertex(collision).getCov()};             /// initialize to the original PV
+            if constexpr (DoPvRefit) {
+              if (config.fillHistograms) {
+                registry.fill(HIST("PvRefit/verticesPerCandidate"), 1);
               }
-              if constexpr (DoPvRefit) {
-                // fill table row of coordinates of PV refit
-                rowProng3PVrefit(pvRefitCoord3Prong1Pos2Neg[0], pvRefitCoord3Prong1Pos2Neg[1], pvRefitCoord3Prong1Pos2Neg[2],
-                                 pvRefitCovMatrix3Prong1Pos2Neg[0], pvRefitCovMatrix3Prong1Pos2Neg[1], pvRefitCovMatrix3Prong1Pos2Neg[2], pvRefitCovMatrix3Prong1Pos2Neg[3], pvRefitCovMatrix3Prong1Pos2Neg[4], pvRefitCovMatrix3Prong1Pos2Neg[5]);
+              int nCandContr = 3;
+              auto trackFirstIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackPos1.globalIndex());
+              auto trackSecondIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg1.globalIndex());
+              auto trackThirdIt = std::find(vecPvContributorGlobId.begin(), vecPvContributorGlobId.end(), trackNeg2.globalIndex());
+              bool isTrackFirstContr = true;
+              bool isTrackSecondContr = true;
+              bool isTrackThirdContr = true;
+              if (trackFirstIt == vecPvContributorGlobId.end()) {
+                /// This track did not contribute to the original PV refit
+                if (config.debugPvRefit) {
+                  LOG(info) << "--- [3 prong] trackPos1 with globalIndex " << trackPos1.globalIndex() << " was not a PV contributor";
+                }
+                nCandContr--;
+                isTrackFirstContr = false;
               }
-
-              if (config.debug) {
-                int prong3CutStatus[kN3ProngDecays];
-                for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-                  prong3CutStatus[iDecay3P] = nCutStatus3ProngBit[iDecay3P];
-                  for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
-                    if (!cutStatus3Prong[iDecay3P][iCut]) {
-                      CLRBIT(prong3CutStatus[iDecay3P], iCut);
-                    }
-                  }
+              if (trackSecondIt == vecPvContributorGlobId.end()) {
+                /// This track did not contribute to the original PV refit
+                if (config.debugPvRefit) {
+                  LOG(info) << "--- [3 prong] trackNeg1 with globalIndex " << trackNeg1.globalIndex() << " was not a PV contributor";
+                }
+                nCandContr--;
+                isTrackSecondContr = false;
+              }
+              if (trackThirdIt == vecPvContributorGlobId.end()) {
+                /// This track did not contribute to the original PV refit
+                if (config.debugPvRefit) {
+                  LOG(info) << "--- [3 prong] trackNeg2 with globalIndex " << trackNeg2.globalIndex() << " was not a PV contributor";
                 }
-                rowProng3CutStatus(prong3CutStatus[0], prong3CutStatus[1], prong3CutStatus[2], prong3CutStatus[3]); // FIXME when we can do this by looping over kN3ProngDecays
+                nCandContr--;
+                isTrackThirdContr = false;
               }
 
-              // fill histograms
-              if (config.fillHistograms) {
-                registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
-                registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
-                registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
-                const std::array arr3Mom{pvec0, pvec1, pvec2};
-                for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
-                  if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
-                    if (TESTBIT(whichHypo3Prong[iDecay3P], 0)) {
-                      const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
-                      switch (iDecay3P) {
-                        case hf_cand_3prong::DecayType::DplusToPiKPi:
-                          registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::DsToKKPi:
-                          registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::LcToPKPi:
-                          registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::XicToPKPi:
-                          registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::CdToDeKPi:
-                          registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
-                          break;
-                      }
-                    }
-                    if (TESTBIT(whichHypo3Prong[iDecay3P], 1)) {
-                      const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
-                      switch (iDecay3P) {
-                        case hf_cand_3prong::DecayType::DsToKKPi:
-                          registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::LcToPKPi:
-                          registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::XicToPKPi:
-                          registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
-                          break;
-                        case hf_cand_3prong::DecayType::CdToDeKPi:
-                          registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
-                          break;
-                      }
-                    }
-                  }
+              // Fill a vector with global ID of candidate daughters that are contributors
+              std::vector<int64_t> vecCandPvContributorGlobId = {};
+              if (isTrackFirstContr) {
+                vecCandPvContributorGlobId.push_back(trackPos1.globalIndex());
+              }
+              if (isTrackSecondContr) {
+                vecCandPvContributorGlobId.push_back(trackNeg1.globalIndex());
+              }
+              if (isTrackThirdContr) {
+                vecCandPvContributorGlobId.push_back(trackNeg2.globalIndex());
+              }
+
+              if (nCandContr == 3 || nCandContr == 2) { // o2-linter: disable="magic-number" (see comment below)
+                /// At least two of the daughter tracks were used for the original PV refit, let's refit it after excluding them
+                if (config.debugPvRefit) {
+                  LOG(info) << "### [3 prong] Calling performPvRefitCandProngs for HF 3 prong candidate, removing " << nCandContr << " daughters";
+                }
+                performPvRefitCandProngs(collision, bcWithTimeStamps, vecPvContributorGlobId, vecPvContributorTrackParCov, vecCandPvContributorGlobId, pvRefitCoord3Prong1Pos2Neg, pvRefitCovMatrix3Prong1Pos2Neg);
+              } else if (nCandContr == 1) {
+                /// Only one daughter was a contributor, let's use then the PV recalculated by excluding only it
+                if (config.debugPvRefit) {
+                  LOG(info) << "####### [3 Prong] nCandContr==" << nCandContr << " ---> just 1 contributor!";
+                }
+                if (config.fillHistograms) {
+                  registry.fill(HIST("PvRefit/verticesPerCandidate"), 5);
+                }
+                if (isTrackFirstContr && !isTrackSecondContr && !isTrackThirdContr) {
+                  /// the first daughter is contributor, the second and the third are not
+                  pvRefitCoord3Prong1Pos2Neg = {trackPos1.pvRefitX(), trackPos1.pvRefitY(), trackPos1.pvRefitZ()};
+                  pvRefitCovMatrix3Prong1Pos2Neg = {trackPos1.pvRefitSigmaX2(), trackPos1.pvRefitSigmaXY(), trackPos1.pvRefitSigmaY2(), trackPos1.pvRefitSigmaXZ(), trackPos1.pvRefitSigmaYZ(), trackPos1.pvRefitSigmaZ2()};
+                } else if (!isTrackFirstContr && isTrackSecondContr && !isTrackThirdContr) {
+                  /// the second daughter is contributor, the first and the third are not
+                  pvRefitCoord3Prong1Pos2Neg = {trackNeg1.pvRefitX(), trackNeg1.pvRefitY(), trackNeg1.pvRefitZ()};
+                  pvRefitCovMatrix3Prong1Pos2Neg = {trackNeg1.pvRefitSigmaX2(), trackNeg1.pvRefitSigmaXY(), trackNeg1.pvRefitSigmaY2(), trackNeg1.pvRefitSigmaXZ(), trackNeg1.pvRefitSigmaYZ(), trackNeg1.pvRefitSigmaZ2()};
+                } else if (!isTrackFirstContr && !isTrackSecondContr && isTrackThirdContr) {
+                  /// the third daughter is contributor, the first and the second are not
+                  pvRefitCoord3Prong1Pos2Neg = {trackNeg2.pvRefitX(), trackNeg2.pvRefitY(), trackNeg2.pvRefitZ()};
+                  pvRefitCovMatrix3Prong1Pos2Neg = {trackNeg2.pvRefitSigmaX2(), trackNeg2.pvRefitSigmaXY(), trackNeg2.pvRefitSigmaY2(), trackNeg2.pvRefitSigmaXZ(), trackNeg2.pvRefitSigmaYZ(), trackNeg2.pvRefitSigmaZ2()};
+                }
+              } else {
+                /// 0 contributors among the HF candidate daughters
+                if (config.fillHistograms) {
+                  registry.fill(HIST("PvRefit/verticesPerCandidate"), 6);
+                }
+                if (config.debugPvRefit) {
+                  LOG(info) << "####### [3 prong] nCandContr==" << nCandContr << " ---> some of the candidate daughters did not contribute to the original PV fit, PV refit not redone";
                 }
               }
             }
-          }
 
-          if (config.doDstar && TESTBIT(isSelected2ProngCand, hf_cand_2prong::DecayType::D0ToPiK) && (pt2Prong + config.ptTolerance) * 1.2 > config.binsPtDstarToD0Pi->at(0) && whichHypo2Prong[kN2ProngDecays] != 0) { // o2-linter: disable="magic-number" (see comment below)
-                                                                                                                                                                                                                        // if D* enabled and pt of the D0 is larger than the minimum of the D* one within 20% (D* and D0 momenta are very similar, always within 20% according to PYTHIA8)
-            // second loop over positive tracks
-            if (TESTBIT(whichHypo2Prong[kN2ProngDecays], 0) && (!config.applyKaonPidIn3Prongs || TESTBIT(trackIndexNeg1.isIdentifiedPid(), ChannelKaonPid))) { // only for D0 candidates; moreover if kaon PID enabled, apply to the negative track
-              auto groupedTrackIndicesSoftPionsPos = positiveSoftPions->sliceByCached(aod::track::collisionId, collision.globalIndex(), cache);
-              for (auto trackIndexPos2 = groupedTrackIndicesSoftPionsPos.begin(); trackIndexPos2 != groupedTrackIndicesSoftPionsPos.end(); ++trackIndexPos2) {
-                if (trackIndexPos2 == trackIndexPos1) {
-                  continue;
-                }
-                auto trackPos2 = trackIndexPos2.template track_as<TTracks>();
-                std::array pVecTrackPos2{trackPos2.pVector()};
-                if (thisCollId != trackPos2.collisionId()) { // this is not the "default" collision for this track, we have to re-propagate it
-                  auto trackParVarPos2 = getTrackParCov(trackPos2);
-                  std::array dcaInfoPos2{trackPos2.dcaXY(), trackPos2.dcaZ()};
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParVarPos2, 2.f, noMatCorr, &dcaInfoPos2);
-                  getPxPyPz(trackParVarPos2, pVecTrackPos2);
+            // reconstruct the 3-prong secondary vertex
+            int nVtxFrom3ProngFitterSecondLoop = 0;
+            try {
+              nVtxFrom3ProngFitterSecondLoop = df3.process(trackParVarNeg1, trackParVarPos1, trackParVarNeg2);
+            } catch (...) {
+              continue;
+            }
+
+            if (nVtxFrom3ProngFitterSecondLoop == 0) {
+              continue;
+            }
+            // get secondary vertex
+            const auto& secondaryVertex3 = df3.getPCACandidate();
+            // get track momenta
+            std::array<float, 3> pvec0{};
+            std::array<float, 3> pvec1{};
+            std::array<float, 3> pvec2{};
+            const auto trackParVarPcaNeg1 = df3.getTrack(0);
+            const auto trackParVarPcaPos1 = df3.getTrack(1);
+            const auto trackParVarPcaNeg2 = df3.getTrack(2);
+            trackParVarPcaNeg1.getPxPyPzGlo(pvec0);
+            trackParVarPcaPos1.getPxPyPzGlo(pvec1);
+            trackParVarPcaNeg2.getPxPyPzGlo(pvec2);
+
+            const auto pVecCandProng3Neg = RecoDecay::pVec(pvec0, pvec1, pvec2);
+
+            // 3-prong selections after secondary vertex
+            applySelection3Prong(pVecCandProng3Neg, secondaryVertex3, pvRefitCoord3Prong1Pos2Neg, cutStatus3Prong, isSelected3ProngCand);
+
+            std::array<std::vector<float>, kN3ProngDecays - 1> mlScores3Prongs{};
+            if (config.applyMlForHfFilters) {
+              const std::vector<float> inputFeatures{trackParVarPcaNeg1.getPt(), dcaInfoNeg1[0], dcaInfoNeg1[1], trackParVarPcaPos1.getPt(), dcaInfoPos1[0], dcaInfoPos1[1], trackParVarPcaNeg2.getPt(), dcaInfoNeg2[0], dcaInfoNeg2[1]};
+              std::vector<float> inputFeaturesLcPid{};
+              if constexpr (UsePidForHfFiltersBdt) {
+                inputFeaturesLcPid.push_back(trackNeg1.tpcNSigmaPr());
+                inputFeaturesLcPid.push_back(trackNeg2.tpcNSigmaPr());
+                inputFeaturesLcPid.push_back(trackNeg1.tpcNSigmaPi());
+                inputFeaturesLcPid.push_back(trackNeg2.tpcNSigmaPi());
+                inputFeaturesLcPid.push_back(trackPos1.tpcNSigmaKa());
+              }
+              applyMlSelectionForHfFilters3Prong<UsePidForHfFiltersBdt>(inputFeatures, inputFeaturesLcPid, mlScores3Prongs, isSelected3ProngCand);
+            }
+
+            if (!config.debug && isSelected3ProngCand == 0) {
+              continue;
+            }
+
+            // fill table row
+            output.rowTrackIndexProng3(thisCollId, trackNeg1.globalIndex(), trackPos1.globalIndex(), trackNeg2.globalIndex(), isSelected3ProngCand);
+            if (config.applyMlForHfFilters) {
+              rowTrackIndexMlScoreProng3(mlScores3Prongs[0], mlScores3Prongs[1], mlScores3Prongs[2], mlScores3Prongs[3]);
+            }
+            if constexpr (DoPvRefit) {
+              // fill table row of coordinates of PV refit
+              rowProng3PVrefit(pvRefitCoord3Prong1Pos2Neg[0], pvRefitCoord3Prong1Pos2Neg[1], pvRefitCoord3Prong1Pos2Neg[2],
+                               pvRefitCovMatrix3Prong1Pos2Neg[0], pvRefitCovMatrix3Prong1Pos2Neg[1], pvRefitCovMatrix3Prong1Pos2Neg[2], pvRefitCovMatrix3Prong1Pos2Neg[3], pvRefitCovMatrix3Prong1Pos2Neg[4], pvRefitCovMatrix3Prong1Pos2Neg[5]);
+            }
+
+            if (config.debug) {
+              int prong3CutStatus[kN3ProngDecays];
+              for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+                prong3CutStatus[iDecay3P] = nCutStatus3ProngBit[iDecay3P];
+                for (int iCut = 0; iCut < kNCuts3Prong[iDecay3P]; iCut++) {
+                  if (!cutStatus3Prong[iDecay3P][iCut]) {
+                    CLRBIT(prong3CutStatus[iDecay3P], iCut);
+                  }
                 }
+              }
+              rowProng3CutStatus(prong3CutStatus[0], prong3CutStatus[1], prong3CutStatus[2], prong3CutStatus[3]); // FIXME when we can do this by looping over kN3ProngDecays
+            }
 
-                uint8_t isSelectedDstar{0};
-                uint8_t cutStatus{BIT(kNCutsDstar) - 1};
-                float deltaMass{-1.};
-                isSelectedDstar = applySelectionDstar(pVecTrackPos1, pVecTrackNeg1, pVecTrackPos2, cutStatus, deltaMass); // we do not compute the D* decay vertex at this stage because we are not interested in applying topological selections
-                if (isSelectedDstar) {
-                  rowTrackIndexDstar(thisCollId, trackPos2.globalIndex(), lastFilledD0);
-                  if (config.fillHistograms) {
-                    registry.fill(HIST("hMassDstarToD0Pi"), deltaMass);
+            // fill histograms
+            if (config.fillHistograms) {
+              registry.fill(HIST("hVtx3ProngX"), secondaryVertex3[0]);
+              registry.fill(HIST("hVtx3ProngY"), secondaryVertex3[1]);
+              registry.fill(HIST("hVtx3ProngZ"), secondaryVertex3[2]);
+              const std::array arr3Mom{pvec0, pvec1, pvec2};
+              for (int iDecay3P = 0; iDecay3P < kN3ProngDecays; iDecay3P++) {
+                if (TESTBIT(isSelected3ProngCand, iDecay3P)) {
+                  if (TESTBIT(whichHypo3Prong[iDecay3P], 0)) {
+                    const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][0]);
+                    switch (iDecay3P) {
+                      case hf_cand_3prong::DecayType::DplusToPiKPi:
+                        registry.fill(HIST("hMassDPlusToPiKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::DsToKKPi:
+                        registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::LcToPKPi:
+                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::XicToPKPi:
+                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::CdToDeKPi:
+                        registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
+                        break;
+                    }
                   }
-                  if constexpr (DoPvRefit) {
-                    // fill table row with coordinates of PV refit (same as 2-prong because we do not remove the soft pion)
-                    rowDstarPVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
-                                    pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
+                  if (TESTBIT(whichHypo3Prong[iDecay3P], 1)) {
+                    const auto mass3Prong = RecoDecay::m(arr3Mom, arrMass3Prong[iDecay3P][1]);
+                    switch (iDecay3P) {
+                      case hf_cand_3prong::DecayType::DsToKKPi:
+                        registry.fill(HIST("hMassDsToKKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::LcToPKPi:
+                        registry.fill(HIST("hMassLcToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::XicToPKPi:
+                        registry.fill(HIST("hMassXicToPKPi"), mass3Prong);
+                        break;
+                      case hf_cand_3prong::DecayType::CdToDeKPi:
+                        registry.fill(HIST("hMassCdToDeKPi"), mass3Prong);
+                        break;
+                    }
                   }
                 }
-                if (config.debug) {
-                  rowDstarCutStatus(cutStatus);
-                }
               }
             }
+          }
+        }
 
-            // second loop over negative tracks
-            if (TESTBIT(whichHypo2Prong[kN2ProngDecays], 1) && (!config.applyKaonPidIn3Prongs || TESTBIT(trackIndexPos1.isIdentifiedPid(), ChannelKaonPid))) { // only for D0bar candidates; moreover if kaon PID enabled, apply to the positive track
-              auto groupedTrackIndicesSoftPionsNeg = negativeSoftPions->sliceByCached(aod::track::collisionId, collision.globalIndex(), cache);
-              for (auto trackIndexNeg2 = groupedTrackIndicesSoftPionsNeg.begin(); trackIndexNeg2 != groupedTrackIndicesSoftPionsNeg.end(); ++trackIndexNeg2) {
-                if (trackIndexNeg1 == trackIndexNeg2) {
-                  continue;
+        if (config.doDstar && TESTBIT(isSelected2ProngCand, hf_cand_2prong::DecayType::D0ToPiK) && (pt2Prong + config.ptTolerance) * 1.2 > config.binsPtDstarToD0Pi->at(0) && whichHypo2Prong[kN2ProngDecays] != 0) { // o2-linter: disable="magic-number" (see comment below)
+                                                                                                                                                                                                                      // if D* enabled and pt of the D0 is larger than the minimum of the D* one within 20% (D* and D0 momenta are very similar, always within 20% according to PYTHIA8)
+          // second loop over positive tracks
+          if (TESTBIT(whichHypo2Prong[kN2ProngDecays], 0) && (!config.applyKaonPidIn3Prongs || TESTBIT(trackIndexNeg1.isIdentifiedPid(), ChannelKaonPid))) { // only for D0 candidates; moreover if kaon PID enabled, apply to the negative track
+            for (auto trackIndexPos2 = groupedTrackIndicesSoftPionsPos.begin(); trackIndexPos2 != groupedTrackIndicesSoftPionsPos.end(); ++trackIndexPos2) {
+              if (trackIndexPos2 == trackIndexPos1) {
+                continue;
+              }
+              auto trackPos2 = trackIndexPos2.template track_as<TTracks>();
+              const auto& pVecTrackPos2 = trackStore.get(collision, trackPos2, noMatCorr).pVec;
+
+              uint8_t isSelectedDstar{0};
+              uint8_t cutStatus{BIT(kNCutsDstar) - 1};
+              float deltaMass{-1.};
+              isSelectedDstar = applySelectionDstar(pVecTrackPos1, pVecTrackNeg1, pVecTrackPos2, cutStatus, deltaMass); // we do not compute the D* decay vertex at this stage because we are not interested in applying topological selections
+              if (isSelectedDstar) {
+                output.rowTrackIndexDstar(thisCollId, trackPos2.globalIndex(), lastFilledD0);
+                if (config.fillHistograms) {
+                  registry.fill(HIST("hMassDstarToD0Pi"), deltaMass);
                 }
-                auto trackNeg2 = trackIndexNeg2.template track_as<TTracks>();
-                std::array pVecTrackNeg2{trackNeg2.pVector()};
-                if (thisCollId != trackNeg2.collisionId()) { // this is not the "default" collision for this track, we have to re-propagate it
-                  auto trackParVarNeg2 = getTrackParCov(trackNeg2);
-                  std::array dcaInfoNeg2{trackNeg2.dcaXY(), trackNeg2.dcaZ()};
-                  o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackParVarNeg2, 2.f, noMatCorr, &dcaInfoNeg2);
-                  getPxPyPz(trackParVarNeg2, pVecTrackNeg2);
+                if constexpr (DoPvRefit) {
+                  // fill table row with coordinates of PV refit (same as 2-prong because we do not remove the soft pion)
+                  rowDstarPVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
+                                  pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
                 }
+              }
+              if (config.debug) {
+                rowDstarCutStatus(cutStatus);
+              }
+            }
+          }
 
-                uint8_t isSelectedDstar{0};
-                uint8_t cutStatus{BIT(kNCutsDstar) - 1};
-                float deltaMass{-1.};
-                isSelectedDstar = applySelectionDstar(pVecTrackNeg1, pVecTrackPos1, pVecTrackNeg2, cutStatus, deltaMass); // we do not compute the D* decay vertex at this stage because we are not interested in applying topological selections
-                if (isSelectedDstar) {
-                  rowTrackIndexDstar(thisCollId, trackNeg2.globalIndex(), lastFilledD0);
-                  if (config.fillHistograms) {
-                    registry.fill(HIST("hMassDstarToD0Pi"), deltaMass);
-                  }
-                  if constexpr (DoPvRefit) {
-                    // fill table row with coordinates of PV refit (same as 2-prong because we do not remove the soft pion)
-                    rowDstarPVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
-                                    pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
-                  }
+          // second loop over negative tracks
+          if (TESTBIT(whichHypo2Prong[kN2ProngDecays], 1) && (!config.applyKaonPidIn3Prongs || TESTBIT(trackIndexPos1.isIdentifiedPid(), ChannelKaonPid))) { // only for D0bar candidates; moreover if kaon PID enabled, apply to the positive track
+            for (auto trackIndexNeg2 = groupedTrackIndicesSoftPionsNeg.begin(); trackIndexNeg2 != groupedTrackIndicesSoftPionsNeg.end(); ++trackIndexNeg2) {
+              if (trackIndexNeg1 == trackIndexNeg2) {
+                continue;
+              }
+              auto trackNeg2 = trackIndexNeg2.template track_as<TTracks>();
+              const auto& pVecTrackNeg2 = trackStore.get(collision, trackNeg2, noMatCorr).pVec;
+
+              uint8_t isSelectedDstar{0};
+              uint8_t cutStatus{BIT(kNCutsDstar) - 1};
+              float deltaMass{-1.};
+              isSelectedDstar = applySelectionDstar(pVecTrackNeg1, pVecTrackPos1, pVecTrackNeg2, cutStatus, deltaMass); // we do not compute the D* decay vertex at this stage because we are not interested in applying topological selections
+              if (isSelectedDstar) {
+                output.rowTrackIndexDstar(thisCollId, trackNeg2.globalIndex(), lastFilledD0);
+                if (config.fillHistograms) {
+                  registry.fill(HIST("hMassDstarToD0Pi"), deltaMass);
                 }
-                if (config.debug) {
-                  rowDstarCutStatus(cutStatus);
+                if constexpr (DoPvRefit) {
+                  // fill table row with coordinates of PV refit (same as 2-prong because we do not remove the soft pion)
+                  rowDstarPVrefit(pvRefitCoord2Prong[0], pvRefitCoord2Prong[1], pvRefitCoord2Prong[2],
+                                  pvRefitCovMatrix2Prong[0], pvRefitCovMatrix2Prong[1], pvRefitCovMatrix2Prong[2], pvRefitCovMatrix2Prong[3], pvRefitCovMatrix2Prong[4], pvRefitCovMatrix2Prong[5]);
                 }
               }
+              if (config.debug) {
+                rowDstarCutStatus(cutStatus);
+              }
             }
-          } // end of D*
-        }
+          }
+        } // end of D*
       }
+    }
 
-      const int nTracks = 0;
-      // auto nTracks = trackIndicesPerCollision.lastIndex() - trackIndicesPerCollision.firstIndex(); // number of tracks passing 2 and 3 prong selection in this collision
-      nCand2 = rowTrackIndexProng2.lastIndex() - nCand2; // number of 2-prong candidates in this collision
-      nCand3 = rowTrackIndexProng3.lastIndex() - nCand3; // number of 3-prong candidates in this collision
+    const int nTracks = 0;
+    // auto nTracks = trackIndicesPerCollision.lastIndex() - trackIndicesPerCollision.firstIndex(); // number of tracks passing 2 and 3 prong selection in this collision
+    nCand2 = output.rowTrackIndexProng2.lastIndex() - nCand2; // number of 2-prong candidates in this collision
+    nCand3 = output.rowTrackIndexProng3.lastIndex() - nCand3; // number of 3-prong candidates in this collision
 
-      if (config.fillHistograms) {
-        registry.fill(HIST("hNTracks"), nTracks);
-        registry.fill(HIST("hNCand2Prong"), nCand2);
-        registry.fill(HIST("hNCand3Prong"), nCand3);
-        registry.fill(HIST("hNCand2ProngVsNTracks"), nTracks, nCand2);
-        registry.fill(HIST("hNCand3ProngVsNTracks"), nTracks, nCand3);
+    if (config.fillHistograms) {
+      registry.fill(HIST("hNTracks"), nTracks);
+      registry.fill(HIST("hNCand2Prong"), nCand2);
+      registry.fill(HIST("hNCand3Prong"), nCand3);
+      registry.fill(HIST("hNCand2ProngVsNTracks"), nTracks, nCand2);
+      registry.fill(HIST("hNCand3ProngVsNTracks"), nTracks, nCand3);
+    }
+  } /// end of run2And3ProngsCollision function
+
+  template <bool DoPvRefit, bool UsePidForHfFiltersBdt, typename TTracks>
+  void run2And3Prongs(SelectedCollisions const& collisions,
+                      aod::BCsWithTimestamps const& bcWithTimeStamps,
+                      FilteredTrackAssocSel const& trackIndices,
+                      TTracks const& tracks)
+  {
+
+    // can be added to run over limited collisions per file - for tesing purposes
+    /*
+    if (nCollsMax > -1){
+      if (nColls == nCollMax){
+        return;
+        //can be added to run over limited collisions per file - for tesing purposes
       }
+      nColls++;
+    }
+    */
+
+    if constexpr (!DoPvRefit) {
+      if (workers.size() > 1) {
+        run2And3ProngsParallel<UsePidForHfFiltersBdt>(collisions, bcWithTimeStamps, trackIndices, tracks);
+        return;
+      }
+    }
+
+    auto& worker = workers[0];
+    for (const auto& collision : collisions) {
+
+      // set the magnetic field from CCDB
+      const auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
+      initCCDB(bc, runNumber, ccdb, config.isRun2 ? config.ccdbPathGrp : config.ccdbPathGrpMag, lut, config.isRun2);
+      worker.setBz(o2::base::Propagator::Instance()->getNominalBz());
+
+      const auto thisCollId = collision.globalIndex();
+
+      // all the tracks used for the candidates of this collision are propagated at most once and then shared
+      worker.trackStore.reset(tracks.size(), trackIndices.sliceBy(trackIndicesPerCollision, thisCollId).size());
+
+      const auto groupedTrackIndicesPos1 = positiveFor2And3Prongs->sliceByCached(aod::track::collisionId, thisCollId, cache);
+      const auto groupedTrackIndicesNeg1 = negativeFor2And3Prongs->sliceByCached(aod::track::collisionId, thisCollId, cache);
+      const auto groupedTrackIndicesSoftPionsPos = positiveSoftPions->sliceByCached(aod::track::collisionId, thisCollId, cache);
+      const auto groupedTrackIndicesSoftPionsNeg = negativeSoftPions->sliceByCached(aod::track::collisionId, thisCollId, cache);
+
+      run2And3ProngsCollision<DoPvRefit, UsePidForHfFiltersBdt>(collision, bcWithTimeStamps, tracks, groupedTrackIndicesPos1, groupedTrackIndicesNeg1, groupedTrackIndicesSoftPionsPos, groupedTrackIndicesSoftPionsNeg, worker, *this);
     }
   } /// end of run2And3Prongs function
 
+  /// Parallel version of run2And3Prongs, without PV refit
+  /// The collisions are processed in blocks: the magnetic field and the propagation of the tracks to their non-default collisions are handled serially,
+  /// the combinatorics and the vertex fits run in parallel with one worker per thread, and the rows are written to the tables in collision order
+  template <bool UsePidForHfFiltersBdt, typename TTracks>
+  void run2And3ProngsParallel(SelectedCollisions const& collisions,
+                              aod::BCsWithTimestamps const& bcWithTimeStamps,
+                              FilteredTrackAssocSel const& trackIndices,
+                              TTracks const& tracks)
+  {
+    using TTrackIndices = decltype(positiveFor2And3Prongs->sliceByCached(aod::track::collisionId, 0, cache));
+    struct CollisionJob {
+      SelectedCollisions::iterator collision;
+      TTrackIndices groupedTrackIndicesPos1;
+      TTrackIndices groupedTrackIndicesNeg1;
+      TTrackIndices groupedTrackIndicesSoftPionsPos;
+      TTrackIndices groupedTrackIndicesSoftPionsNeg;
+      float bz;
+      std::size_t nTracksMax;                                                                    // number of track associations of the collision
+      std::vector<std::pair<int64_t, HfPropagatedTrackStore::PropagatedTrack>> propagatedTracks; // tracks not associated by default to the collision
+      CollisionRows rows;
+    };
+
+    const std::size_t nThreads = workers.size();
+    const std::size_t nCollisionsPerBlock = nThreads * config.nCollisionsPerThreadVertexing;
+    std::vector<CollisionJob> jobs;
+    jobs.reserve(nCollisionsPerBlock);
+
+    auto processJobs = [&]() {
+      if (jobs.empty()) {
+        return;
+      }
+      // each thread takes the next collision not yet processed
+      std::atomic<std::size_t> nextJob{0};
+      auto runWorker = [&](HfVertexingWorker& worker) {
+        for (auto iJob = nextJob++; iJob < jobs.size(); iJob = nextJob++) {
+          auto& job = jobs[iJob];
+          worker.setBz(job.bz);
+          worker.trackStore.reset(tracks.size(), job.nTracksMax);
+          for (const auto& [globalIndex, propagatedTrack] : job.propagatedTracks) {
+            worker.trackStore.add(globalIndex, propagatedTrack);
+          }
+          run2And3ProngsCollision<false, UsePidForHfFiltersBdt>(job.collision, bcWithTimeStamps, tracks, job.groupedTrackIndicesPos1, job.groupedTrackIndicesNeg1, job.groupedTrackIndicesSoftPionsPos, job.groupedTrackIndicesSoftPionsNeg, worker, job.rows);
+        }
+      };
+      std::vector<std::thread> threads;
+      for (std::size_t iThread = 1; iThread < nThreads; iThread++) {
+        threads.emplace_back(runWorker, std::ref(workers[iThread]));
+      }
+      runWorker(workers[0]);
+      for (auto& thread : threads) {
+        thread.join();
+      }
+
+      // fill the tables in collision order, so that the output does not depend on the number of threads
+      for (const auto& job : jobs) {
+        const auto firstIndexProng2 = rowTrackIndexProng2.lastIndex() + 1;
+        for (const auto& row : job.rows.rowTrackIndexProng2.rows) {
+          std::apply([&](auto... values) { rowTrackIndexProng2(values...); }, row);
+        }
+        for (const auto& row : job.rows.rowTrackIndexProng3.rows) {
+          std::apply([&](auto... values) { rowTrackIndexProng3(values...); }, row);
+        }
+        for (const auto& [collisionId, softPionId, indexD0] : job.rows.rowTrackIndexDstar.rows) {
+          rowTrackIndexDstar(collisionId, softPionId, firstIndexProng2 + indexD0);
+        }
+      }
+      jobs.clear();
+    };
+
+    for (const auto& collision : collisions) {
+
+      // set the magnetic field from CCDB
+      const auto bc = collision.bc_as<o2::aod::BCsWithTimestamps>();
+      initCCDB(bc, runNumber, ccdb, config.isRun2 ? config.ccdbPathGrp : config.ccdbPathGrpMag, lut, config.isRun2);
+
+      const auto thisCollId = collision.globalIndex();
+      const auto groupedTrackIndices = trackIndices.sliceBy(trackIndicesPerCollision, thisCollId);
+      auto& job = jobs.emplace_back(CollisionJob{collision,
+                                                 positiveFor2And3Prongs->sliceByCached(aod::track::collisionId, thisCollId, cache),
+                                                 negativeFor2And3Prongs->sliceByCached(aod::track::collisionId, thisCollId, cache),
+                                                 positiveSoftPions->sliceByCached(aod::track::collisionId, thisCollId, cache),
+                                                 negativeSoftPions->sliceByCached(aod::track::collisionId, thisCollId, cache),
+                                                 o2::base::Propagator::Instance()->getNominalBz(),
+                                                 static_cast<std::size_t>(groupedTrackIndices.size()),
+                                                 {},
+                                                 {}});
+
+      // the propagator is shared, hence the tracks to be re-propagated to this collision are propagated here and not by the vertexing threads
+      for (const auto& trackIndex : groupedTrackIndices) {
+        const auto track = trackIndex.template track_as<TTracks>();
+        if (track.collisionId() != thisCollId) {
+          job.propagatedTracks.emplace_back(track.globalIndex(), HfPropagatedTrackStore::propagate(collision, track, noMatCorr));
+        }
+      }
+
+      if (jobs.size() == nCollisionsPerBlock) {
+        processJobs();
+      }
+    }
+    processJobs();
+  } /// end of run2And3ProngsParallel function
+
   void processNo2And3Prongs(SelectedCollisions const&)
   {
     // dummy
@@ -3108,6 +3383,7 @@ struct HfTrackIndexSkimCreatorCascades {
   o2::base::Propagator::MatCorrType noMatCorr = o2::base::Propagator::MatCorrType::USEMatCorrNONE;
   o2::base::Propagator::MatCorrType matCorr = o2::base::Propagator::MatCorrType::USEMatCorrLUT;
   int runNumber{0};
+  HfPropagatedTrackStore trackStore; // bachelor tracks propagated to the primary vertex of the current collision
 
   using SelectedCollisions = soa::Filtered<soa::Join<aod::Collisions, aod::HfSelCollision>>;
   using FilteredTrackAssocSel = soa::Filtered<soa::Join<aod::TrackAssoc, aod::HfSelTrack>>;
@@ -3163,7 +3439,7 @@ struct HfTrackIndexSkimCreatorCascades {
   void processCascades(SelectedCollisions const& collisions,
                        soa::Join<aod::V0Datas, aod::V0Covs> const& v0s,
                        FilteredTrackAssocSel const& trackIndices,
-                       aod::TracksWCovDcaExtra const&,
+                       aod::TracksWCovDcaExtra const& tracks,
                        aod::BCsWithTimestamps const&)
   {
     // set the magnetic field from CCDB
@@ -3178,18 +3454,14 @@ struct HfTrackIndexSkimCreatorCascades {
       const auto thisCollId = collision.globalIndex();
       const auto groupedBachTrackIndices = trackIndices.sliceBy(trackIndicesPerCollision, thisCollId);
       const auto groupedV0s = v0s.sliceBy(v0sPerCollision, thisCollId);
+      trackStore.reset(tracks.size(), groupedBachTrackIndices.size());
 
       // fist we loop over the bachelor candidate
       for (const auto& bachIdx : groupedBachTrackIndices) {
 
         const auto bach = bachIdx.track_as<aod::TracksWCovDcaExtra>();
-        std::array pVecBach{bach.pVector()};
-        auto trackBach = getTrackParCov(bach);
-        if (thisCollId != bach.collisionId()) { // this is not the "default" collision for this track, we have to re-propagate it
-          std::array dcaInfoBach{bach.dcaXY(), bach.dcaZ()};
-          o2::base::Propagator::Instance()->propagateToDCABxByBz({collision.posX(), collision.posY(), collision.posZ()}, trackBach, 2.f, noMatCorr, &dcaInfoBach);
-          getPxPyPz(trackBach, pVecBach);
-        }
+        const auto& propagatedBach = trackStore.get(collision, bach, noMatCorr);
+        const auto& trackBach = propagatedBach.trackParCov;
 
         // now we loop over the V0s
         for (const auto& v0 : groupedV0s) {
@@ -3230,6 +3502,7 @@ struct HfTrackIndexSkimCreatorCascades {
           }
 
           std::array pVecV0{v0.px(), v0.py(), v0.pz()};
+          std::array pVecBach{propagatedBach.pVec}; // updated at the cascade vertex below, hence copied for each V0
 
           // invariant-mass cut: we do it here, before updating the momenta of bach and V0 during the fitting to save CPU
           // TODO: but one should better check that the value here and after the fitter do not change significantly!!!
@@ -20,15 +20,24 @@
 #include <TMath.h>
 
 #include <fastjet/AreaDefinition.hh>
+#include <fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh>
 #include <fastjet/ClusterSequenceArea.hh>
+#include <fastjet/ClusterSequenceAreaBase.hh>
 #include <fastjet/GhostedAreaSpec.hh>
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/PseudoJet.hh>
 #include <fastjet/Selector.hh>
 #include <fastjet/contrib/ConstituentSubtractor.hh>
+#include <fastjet/RectangularGrid.hh>
+#include <fastjet/tools/GridMedianBackgroundEstimator.hh>
 #include <fastjet/tools/Subtractor.hh>
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <math.h>
@@ -90,8 +99,8 @@ std::tuple<double, double> JetBkgSubUtils::estimateRhoAreaMedian(const std::vect
   double rho = 0.0;
   double rhoM = 0.0;
   if (rhovector.size() != 0) {
-    rho = TMath::Median<double>(rhovector.size(), rhovector.data());
-    rhoM = TMath::Median<double>(rhoMdvector.size(), rhoMdvector.data());
+    rho = JetBkgRhoEstimator::median(rhovector);
+    rhoM = JetBkgRhoEstimator::median(rhoMdvector);
   }
 
   if (doSparseSub) {
@@ -225,3 +234,208 @@ double JetBkgSubUtils::getMd(fastjet::PseudoJet jet) const
 
   return sum;
 }
+
+void JetBkgRhoEstimator::initialise(JetBkgSubUtils& bkgSub, Mode mode_out, bool fixedGhosts_out, double gridSize_out)
+{
+  bkgSub.initialise();
+  mode = mode_out;
+  fixedGhosts = fixedGhosts_out;
+  gridSize = gridSize_out;
+  bkgEtaMin = bkgSub.getEtaMin();
+  bkgEtaMax = bkgSub.getEtaMax();
+  jetDefBkg = bkgSub.getJetDefinition();
+  areaDefBkg = bkgSub.getAreaDefinition();
+  selRho = bkgSub.getRhoSelector();
+
+  ghosts.clear();
+  ghostArea = 0.;
+  if (fixedGhosts) {
+    fastjet::GhostedAreaSpec ghostAreaSpec = bkgSub.getGhostAreaSpec();
+    ghostAreaSpec.add_ghosts(ghosts);
+    ghostArea = ghostAreaSpec.actual_ghost_area();
+  }
+
+  gridEstimator.reset();
+  if (mode == Mode::gridMedian) {
+    gridEstimator = std::make_unique<fastjet::GridMedianBackgroundEstimator>(fastjet::RectangularGrid(bkgEtaMin, bkgEtaMax, gridSize, gridSize));
+    gridEstimator->set_compute_rho_m(true);
+  }
+}
+
+double JetBkgRhoEstimator::median(std::vector<double>& values)
+{
+  if (values.empty()) {
+    return 0.0;
+  }
+  std::size_t half = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + half, values.end());
+  double upper = values[half];
+  if (values.size() % 2 == 1) {
+    return upper;
+  }
+  double lower = *std::max_element(values.begin(), values.begin() + half);
+  return 0.5 * (lower + upper);
+}
+
+void JetBkgRhoEstimator::clusterJets(const std::vector<fastjet::PseudoJet>& inputParticles)
+{
+  // the first inputParticles.size() entries of the clustering history are the input particles, the explicit ghosts follow
+  std::unique_ptr<fastjet::ClusterSequenceAreaBase> clusterSeq;
+  if (fixedGhosts) {
+    clusterSeq = std::make_unique<fastjet::ClusterSequenceActiveAreaExplicitGhosts>(inputParticles, jetDefBkg, ghosts, ghostArea);
+  } else {
+    clusterSeq = std::make_unique<fastjet::ClusterSequenceArea>(inputParticles, jetDefBkg, areaDefBkg);
+  }
+
+  jets = selRho(clusterSeq->inclusive_jets());
+  jetArea.resize(jets.size());
+  jetIsPhysical.assign(jets.size(), 0);
+  jetNConstituents.assign(jets.size(), 0);
+  jetMd.assign(jets.size(), 0.);
+  constituentJet.clear();
+  int nInput = static_cast<int>(inputParticles.size());
+  for (std::size_t iJet = 0; iJet < jets.size(); iJet++) {
+    jetArea[iJet] = jets[iJet].area();
+    jetIsPhysical[iJet] = !clusterSeq->is_pure_ghost(jets[iJet]);
+    double md = 0.;
+    for (const auto& constituent : jets[iJet].constituents()) {
+      md += std::sqrt(constituent.m() * constituent.m() + constituent.pt() * constituent.pt()) - constituent.pt();
+      if (constituent.cluster_hist_index() < nInput) {
+        constituentJet.emplace_back(constituent.cluster_hist_index(), static_cast<int>(iJet));
+        jetNConstituents[iJet]++;
+      }
+    }
+    jetMd[iJet] = md;
+  }
+  std::sort(constituentJet.begin(), constituentJet.end());
+  // the jets refer to the cluster sequence, which is released here; keep their plain four-momenta
+  for (auto& jet : jets) {
+    jet = fastjet::PseudoJet(jet.px(), jet.py(), jet.pz(), jet.E());
+  }
+}
+
+std::tuple<double, double> JetBkgRhoEstimator::rhoFromJets(bool doSparseSub)
+{
+  double totaljetAreaPhys(0), totalAreaCovered(0);
+  rhoValues.clear();
+  rhoMValues.clear();
+  for (std::size_t iJet = 0; iJet < jets.size(); iJet++) {
+    if (jetIsPhysical[iJet]) {
+      rhoValues.push_back(jets[iJet].perp() / jetArea[iJet]);
+      rhoMValues.push_back(jetMd[iJet] / jetArea[iJet]);
+      totaljetAreaPhys += jetArea[iJet];
+    }
+    totalAreaCovered += jetArea[iJet];
+  }
+  double rho = median(rhoValues);
+  double rhoM = median(rhoMValues);
+  if (doSparseSub) {
+    double occupancyFactor = totalAreaCovered > 0 ? totaljetAreaPhys / totalAreaCovered : 1.;
+    rho *= occupancyFactor;
+    rhoM *= occupancyFactor;
+  }
+  return std::make_tuple(rho, rhoM);
+}
+
+std::tuple<double, double> JetBkgRhoEstimator::rhoFromGrid(const std::vector<fastjet::PseudoJet>& particles)
+{
+  gridEstimator->set_particles(particles);
+  return std::make_tuple(gridEstimator->rho(), gridEstimator->rho_m());
+}
+
+std::tuple<double, double> JetBkgRhoEstimator::estimateRho(const std::vector<fastjet::PseudoJet>& inputParticles, bool doSparseSub)
+{
+  if (inputParticles.size() == 0) {
+    return std::make_tuple(0.0, 0.0);
+  }
+  if (mode == Mode::gridMedian) {
+    return rhoFromGrid(inputParticles);
+  }
+  clusterJets(inputParticles);
+  return rhoFromJets(doSparseSub);
+}
+
+void JetBkgRhoEstimator::estimateRhoVariants(const std::vector<fastjet::PseudoJet>& inputParticles, const std::vector<std::vector<std::size_t>>& removedParticles, bool doSparseSub, std::vector<std::tuple<double, double>>& rhos)
+{
+  rhos.clear();
+  if (mode == Mode::gridMedian) {
+    removedFlags.assign(inputParticles.size(), 0);
+    for (const auto& removed : removedParticles) {
+      variantParticles.clear();
+      for (auto iParticle : removed) {
+        removedFlags[iParticle] = 1;
+      }
+      for (std::size_t iParticle = 0; iParticle < inputParticles.size(); iParticle++) {
+        if (!removedFlags[iParticle]) {
+          variantParticles.push_back(inputParticles[iParticle]);
+        }
+      }
+      for (auto iParticle : removed) {
+        removedFlags[iParticle] = 0;
+      }
+      rhos.push_back(variantParticles.size() == 0 ? std::make_tuple(0.0, 0.0) : rhoFromGrid(variantParticles));
+    }
+    return;
+  }
+
+  if (inputParticles.size() == 0) {
+    rhos.assign(removedParticles.size(), std::make_tuple(0.0, 0.0));
+    return;
+  }
+  clusterJets(inputParticles);
+
+  for (const auto& removed : removedParticles) {
+    // subtract the removed particles from the jets that contain them
+    touchedJets.clear();
+    touchedP4.clear();
+    touchedMd.clear();
+    touchedNConstituents.clear();
+    for (auto iParticle : removed) {
+      auto entry = std::lower_bound(constituentJet.begin(), constituentJet.end(), std::make_pair(static_cast<int>(iParticle), -1));
+      if (entry == constituentJet.end() || entry->first != static_cast<int>(iParticle)) {
+        continue; // not in a selected jet
+      }
+      int iJet = entry->second;
+      auto iTouched = std::find(touchedJets.begin(), touchedJets.end(), iJet) - touchedJets.begin();
+      if (iTouched == static_cast<std::ptrdiff_t>(touchedJets.size())) {
+        touchedJets.push_back(iJet);
+        touchedP4.push_back(jets[iJet]);
+        touchedMd.push_back(jetMd[iJet]);
+        touchedNConstituents.push_back(jetNConstituents[iJet]);
+      }
+      const auto& particle = inputParticles[iParticle];
+      touchedP4[iTouched] -= particle;
+      touchedMd[iTouched] -= std::sqrt(particle.m() * particle.m() + particle.pt() * particle.pt()) - particle.pt();
+      touchedNConstituents[iTouched]--;
+    }
+
+    double totaljetAreaPhys(0), totalAreaCovered(0);
+    rhoValues.clear();
+    rhoMValues.clear();
+    for (std::size_t iJet = 0; iJet < jets.size(); iJet++) {
+      totalAreaCovered += jetArea[iJet];
+      if (!jetIsPhysical[iJet]) {
+        continue;
+      }
+      auto iTouched = std::find(touchedJets.begin(), touchedJets.end(), static_cast<int>(iJet)) - touchedJets.begin();
+      if (iTouched == static_cast<std::ptrdiff_t>(touchedJets.size())) {
+        rhoValues.push_back(jets[iJet].perp() / jetArea[iJet]);
+        rhoMValues.push_back(jetMd[iJet] / jetArea[iJet]);
+      } else if (touchedNConstituents[iTouched] > 0) {
+        rhoValues.push_back(touchedP4[iTouched].perp() / jetArea[iJet]);
+        rhoMValues.push_back(touchedMd[iTouched] / jetArea[iJet]);
+      } else {
+        continue; // only ghosts left
+      }
+      totaljetAreaPhys += jetArea[iJet];
+    }
+    double rho = median(rhoValues);
+    double rhoM = median(rhoMValues);
+    if (doSparseSub) {
+      double occupancyFactor = totalAreaCovered > 0 ? totaljetAreaPhys / totalAreaCovered : 1.;
+      rho *= occupancyFactor;
+      rhoM *= occupancyFactor;
+    }
+    rhos.push_back(std::make_tuple(rho, rhoM));
+  }
+}
@@ -22,8 +22,12 @@
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/PseudoJet.hh>
 #include <fastjet/Selector.hh>
+#include <fastjet/tools/GridMedianBackgroundEstimator.hh>
 
+#include <cstddef>
+#include <memory>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <math.h>
@@ -158,4 +162,89 @@ class JetBkgSubUtils
 
 }; // class JetBkgSubUtils
 
+/// @brief Reusable median background estimator
+///
+/// Keeps the jet definition, the acceptance selector and, optionally, a fixed ghost grid between events,
+/// together with the scratch buffers of the median, so that repeated rho estimates in a task do not rebuild them.
+/// Besides the area-median method of JetBkgSubUtils it offers a grid-median mode (fastjet::GridMedianBackgroundEstimator)
+/// and the estimate of rho for several particle-removal variants of one event from a single clustering.
+class JetBkgRhoEstimator
+{
+ public:
+  enum class Mode { areaMedian = 0,
+                    gridMedian = 1
+  };
+
+  JetBkgRhoEstimator() = default;
+  ~JetBkgRhoEstimator() = default;
+
+  /// @brief Takes the jet definition, acceptance and ghost settings of bkgSub, which is initialised here
+  /// @param bkgSub background subtraction settings
+  /// @param mode area-median (default, same result as JetBkgSubUtils::estimateRhoAreaMedian) or grid-median
+  /// @param fixedGhosts generate the ghosts once and reuse them for every event (area-median mode only)
+  /// @param gridSize requested cell size in rapidity and azimuth for the grid-median mode
+  void initialise(JetBkgSubUtils& bkgSub, Mode mode = Mode::areaMedian, bool fixedGhosts = false, double gridSize = 0.55);
+
+  /// @brief Median rho and rhoM of the event
+  /// @param inputParticles (all particles in the event)
+  /// @param doSparseSub weather to do rho sparse subtraction (area-median mode only, empty grid cells already enter the grid median)
+  /// @return Rho, RhoM the underlying event density
+  std::tuple<double, double> estimateRho(const std::vector<fastjet::PseudoJet>& inputParticles, bool doSparseSub);
+
+  /// @brief Median rho and rhoM of several variants of the event from a single clustering of all the input particles
+  ///
+  /// Variant i is the event without the particles at the positions removedParticles[i] of inputParticles.
+  /// The kT jets of the full event are reused: the removed particles are subtracted from the jets that contain them
+  /// (exact for the E-scheme), jets left with only ghosts are counted as empty and the hard jets rejected from the median are
+  /// those of the full event. The result approximates a reclustering of each variant, which is what the per-variant
+  /// call of estimateRho does; in grid-median mode the removed particles are simply left out of their cells.
+  /// @param inputParticles (all particles in the event)
+  /// @param removedParticles positions in inputParticles of the particles removed in each variant
+  /// @param doSparseSub weather to do rho sparse subtraction
+  /// @param rhos Rho, RhoM of each variant (to be filled)
+  void estimateRhoVariants(const std::vector<fastjet::PseudoJet>& inputParticles, const std::vector<std::vector<std::size_t>>& removedParticles, bool doSparseSub, std::vector<std::tuple<double, double>>& rhos);
+
+  Mode getMode() const { return mode; }
+  bool getFixedGhosts() const { return fixedGhosts; }
+  double getGridSize() const { return gridSize; }
+
+  /// @brief Median with the convention of TMath::Median (mean of the two central values for an even number of entries), reorders values
+  static double median(std::vector<double>& values);
+
+ private:
+  std::tuple<double, double> rhoFromJets(bool doSparseSub);
+  std::tuple<double, double> rhoFromGrid(const std::vector<fastjet::PseudoJet>& particles);
+  void clusterJets(const std::vector<fastjet::PseudoJet>& inputParticles);
+
+  Mode mode = Mode::areaMedian;
+  bool fixedGhosts = false;
+  double gridSize = 0.55;
+  float bkgEtaMin = -0.9;
+  float bkgEtaMax = 0.9;
+
+  fastjet::JetDefinition jetDefBkg;
+  fastjet::AreaDefinition areaDefBkg;
+  fastjet::Selector selRho;
+  std::vector<fastjet::PseudoJet> ghosts;
+  double ghostArea = 0.;
+  std::unique_ptr<fastjet::GridMedianBackgroundEstimator> gridEstimator;
+
+  // per-event state of the area-median method, kept to avoid reallocations
+  std::vector<fastjet::PseudoJet> jets;            // selected kT jets
+  std::vector<double> jetArea;                     // area of the jet
+  std::vector<char> jetIsPhysical;                 // jet has at least one real constituent
+  std::vector<int> jetNConstituents;               // number of real constituents of the jet
+  std::vector<double> jetMd;                       // jet Md used for rhoM
+  std::vector<std::pair<int, int>> constituentJet; // (position in the input, selected jet) of all real constituents, sorted
+  std::vector<double> rhoValues;
+  std::vector<double> rhoMValues;
+  std::vector<fastjet::PseudoJet> variantParticles;
+  std::vector<char> removedFlags;
+  std::vector<int> touchedJets;
+  std::vector<fastjet::PseudoJet> touchedP4;
+  std::vector<double> touchedMd;
+  std::vector<int> touchedNConstituents;
+
+}; // class JetBkgRhoEstimator
+
 #endif // PWGJE_CORE_JETBKGSUBUTILS_H_
@@ -16,11 +16,13 @@
 
 #include "PWGJE/Core/JetFinder.h"
 
+#include <fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh>
 #include <fastjet/ClusterSequenceArea.hh>
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/PseudoJet.hh>
 #include <fastjet/Selector.hh>
 
+#include <memory>
 #include <vector>
 
 /// Sets the jet finding parameters
@@ -70,3 +72,44 @@ fastjet::ClusterSequenceArea JetFinder::findJets(std::vector<fastjet::PseudoJet>
   }
   return clusterSeq;
 }
+
+/// Returns true if the ghosts of the area definition can be generated once and shared between radii
+bool JetFinder::canShareGhosts() const
+{
+  return (areaType == fastjet::active_area || areaType == fastjet::active_area_explicit_ghosts) && ghostRepeatN == 1;
+}
+
+/// Generates one set of ghosts of the area definition
+/// \param ghosts vector of ghosts to be filled
+/// \return area of a single ghost
+double JetFinder::generateGhosts(std::vector<fastjet::PseudoJet>& ghosts)
+{
+  ghostAreaSpec = fastjet::GhostedAreaSpec(ghostEtaMax, ghostRepeatN, ghostArea, gridScatter, ktScatter, ghostktMean);
+  ghosts.clear();
+  ghostAreaSpec.add_ghosts(ghosts);
+  return ghostAreaSpec.actual_ghost_area();
+}
+
+/// Performs jet finding with explicitly given ghosts
+/// \param inputParticles vector of input particles/tracks
+/// \param jets vector of jets to be filled
+/// \param ghosts vector of ghosts
+/// \param actualGhostArea area of a single ghost
+/// \return cluster sequence needed to access constituents and areas
+std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts> JetFinder::findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets, std::vector<fastjet::PseudoJet> const& ghosts, double actualGhostArea)
+{
+  setParams();
+  jets.clear();
+  auto clusterSeq = std::make_unique<fastjet::ClusterSequenceActiveAreaExplicitGhosts>(inputParticles, jetDef, ghosts, actualGhostArea);
+  for (const auto& jet : clusterSeq->inclusive_jets()) {
+    if (!clusterSeq->is_pure_ghost(jet)) {
+      jets.push_back(jet);
+    }
+  }
+  jets = selJets(jets);
+  jets = fastjet::sorted_by_pt(jets);
+  if (isReclustering) {
+    jetR = jetR / 5.0;
+  }
+  return clusterSeq;
+}
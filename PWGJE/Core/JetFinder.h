@@ -19,6 +19,7 @@
 #define PWGJE_CORE_JETFINDER_H_
 
 #include <fastjet/AreaDefinition.hh>
+#include <fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh>
 #include <fastjet/ClusterSequenceArea.hh>
 #include <fastjet/GhostedAreaSpec.hh>
 #include <fastjet/JetDefinition.hh>
@@ -27,6 +28,7 @@
 
 #include <Rtypes.h>
 
+#include <memory>
 #include <vector>
 
 #include <math.h>
@@ -84,6 +86,9 @@ class JetFinder
   fastjet::Selector selGhosts;
   double fastjetExtraParam = -99.0;
 
+  bool shareGhostsAcrossR = false; // generate the area ghosts once per event and reuse them for all jet radii
+  int nThreadsR = 1;               // number of threads clustering different jet radii in parallel, > 1 implies shared ghosts
+
   /// Sets the jet finding parameters
   void setParams();
 
@@ -94,8 +99,26 @@ class JetFinder
   /// \return ClusterSequenceArea object needed to access constituents
   fastjet::ClusterSequenceArea findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets); // ideally find a way of passing the cluster sequence as a reeference
 
+  /// Returns true if the ghosts of the area definition can be generated once and shared between radii
+  /// (active area with a single ghost repetition)
+  bool canShareGhosts() const;
+
+  /// Generates one set of ghosts of the area definition
+  /// \param ghosts vector of ghosts to be filled
+  /// \return area of a single ghost
+  double generateGhosts(std::vector<fastjet::PseudoJet>& ghosts);
+
+  /// Performs jet finding with explicitly given ghosts, as obtained from generateGhosts
+  /// \note pure ghost jets are removed and the constituents of the jets include the ghosts, which carry no user info
+  /// \param inputParticles vector of input particles/tracks
+  /// \param jets vector of jets to be filled
+  /// \param ghosts vector of ghosts
+  /// \param actualGhostArea area of a single ghost
+  /// \return cluster sequence needed to access constituents and areas
+  std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts> findJets(std::vector<fastjet::PseudoJet>& inputParticles, std::vector<fastjet::PseudoJet>& jets, std::vector<fastjet::PseudoJet> const& ghosts, double actualGhostArea);
+
  private:
-  ClassDefNV(JetFinder, 1);
+  ClassDefNV(JetFinder, 2);
 };
 
 #endif // PWGJE_CORE_JETFINDER_H_
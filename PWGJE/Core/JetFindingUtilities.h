@@ -27,17 +27,22 @@
 #include <CommonConstants/PhysicsConstants.h>
 #include <Framework/ASoA.h>
 #include <Framework/AnalysisHelpers.h>
+#include <Framework/Logger.h>
 #include <Framework/O2DatabasePDGPlugin.h>
 
 #include <THn.h>
 #include <TRandom3.h>
 
+#include <fastjet/ClusterSequenceActiveAreaExplicitGhosts.hh>
 #include <fastjet/ClusterSequenceArea.hh>
 #include <fastjet/PseudoJet.hh>
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <memory>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 
@@ -267,9 +272,69 @@ bool analyseV0s(std::vector<fastjet::PseudoJet>& inputParticles, T const& v0s, f
   }
 }
 
+/**
+ * Fills the jets found with one jet radius into the jet tables
+ *
+ * @param jets jets found with radius R, sorted by pT
+ * @param R jet radius
+ * @param collision the collision within which jets are being found
+ * @param jetsTable output table of jets
+ * @param constituentsTable output table of jet constituents
+ * @param doCandidateJetFinding set whether only jets containing a candidate are saved
+ * @param tracks, cands, clusters constituent index buffers reused between jets
+ */
+template <typename T, typename U, typename V>
+void fillJets(std::vector<fastjet::PseudoJet> const& jets, double R, float jetAreaFractionMin, T const& collision, U& jetsTable, V& constituentsTable, std::shared_ptr<THn> const& thnSparseJet, bool fillThnSparse, bool doCandidateJetFinding, std::vector<int>& tracks, std::vector<int>& cands, std::vector<int>& clusters)
+{
+  for (const auto& jet : jets) {
+    if (jet.has_area() && jet.area() < jetAreaFractionMin * M_PI * R * R) {
+      continue;
+    }
+    if (fillThnSparse) {
+      thnSparseJet->Fill(R, jet.pt(), jet.eta(), jet.phi()); // important for normalisation in V0Jet analyses to store all jets, including those that aren't V0s
+    }
+    auto constituents = jet.constituents();
+    std::erase_if(constituents, [](const fastjet::PseudoJet& constituent) { return !constituent.has_user_info(); }); // ghosts of the clustering with explicit ghosts
+    bool isCandidateJet = false;
+    if (doCandidateJetFinding) {
+      for (const auto& constituent : constituents) {
+        auto constituentStatus = constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus();
+        if (constituentStatus == static_cast<int>(JetConstituentStatus::candidate)) { // note currently we cannot run V0 and HF in the same jet. If we ever need to we can seperate the loops
+          isCandidateJet = true;
+          break;
+        }
+      }
+      if (!isCandidateJet) {
+        continue;
+      }
+    }
+    tracks.clear();
+    cands.clear();
+    clusters.clear();
+    jetsTable(collision.globalIndex(), jet.pt(), jet.eta(), jet.phi(),
+              jet.E(), jet.rapidity(), jet.m(), jet.has_area() ? jet.area() : 0., std::round(R * 100));
+    for (const auto& constituent : sorted_by_pt(constituents)) {
+      if (constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus() == static_cast<int>(JetConstituentStatus::track)) {
+        tracks.push_back(constituent.template user_info<fastjetutilities::fastjet_user_info>().getIndex());
+      }
+      if (constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus() == static_cast<int>(JetConstituentStatus::cluster)) {
+        clusters.push_back(constituent.template user_info<fastjetutilities::fastjet_user_info>().getIndex());
+      }
+      if (constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus() == static_cast<int>(JetConstituentStatus::candidate)) {
+        cands.push_back(constituent.template user_info<fastjetutilities::fastjet_user_info>().getIndex());
+      }
+    }
+    constituentsTable(jetsTable.lastIndex(), tracks, clusters, cands);
+  }
+}
+
 /**
  * Performs jet finding and fills jet tables
  *
+ * With jetFinder.shareGhostsAcrossR or jetFinder.nThreadsR > 1 (and an area definition allowing it, see JetFinder::canShareGhosts)
+ * the ghosts are generated once per event and reused for all radii, and with jetFinder.nThreadsR > 1 the radii are clustered
+ * in parallel. The tables are always filled in the order of the radii.
+ *
  * @param jetFinder JetFinder object which carries jet finding parameters
  * @param inputParticles fastjet container
  * @param jetRadius jet finding radii
@@ -284,49 +349,66 @@ void findJets(JetFinder& jetFinder, std::vector<fastjet::PseudoJet>& inputPartic
   auto jetRValues = static_cast<std::vector<double>>(jetRadius);
   jetFinder.jetPtMin = jetPtMin;
   jetFinder.jetPtMax = jetPtMax;
-  for (auto R : jetRValues) {
-    jetFinder.jetR = R;
-    std::vector<fastjet::PseudoJet> jets;
-    fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
-    for (const auto& jet : jets) {
-      if (jet.has_area() && jet.area() < jetAreaFractionMin * M_PI * R * R) {
-        continue;
-      }
-      if (fillThnSparse) {
-        thnSparseJet->Fill(R, jet.pt(), jet.eta(), jet.phi()); // important for normalisation in V0Jet analyses to store all jets, including those that aren't V0s
-      }
-      bool isCandidateJet = false;
-      if (doCandidateJetFinding) {
-        for (const auto& constituent : jet.constituents()) {
-          auto constituentStatus = constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus();
-          if (constituentStatus == static_cast<int>(JetConstituentStatus::candidate)) { // note currently we cannot run V0 and HF in the same jet. If we ever need to we can seperate the loops
-            isCandidateJet = true;
-            break;
-          }
-        }
-        if (!isCandidateJet) {
-          continue;
-        }
-      }
-      std::vector<int> tracks;
-      std::vector<int> cands;
-      std::vector<int> clusters;
-      jetsTable(collision.globalIndex(), jet.pt(), jet.eta(), jet.phi(),
-                jet.E(), jet.rapidity(), jet.m(), jet.has_area() ? jet.area() : 0., std::round(R * 100));
-      for (const auto& constituent : sorted_by_pt(jet.constituents())) {
-        if (constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus() == static_cast<int>(JetConstituentStatus::track)) {
-          tracks.push_back(constituent.template user_info<fastjetutilities::fastjet_user_info>().getIndex());
-        }
-        if (constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus() == static_cast<int>(JetConstituentStatus::cluster)) {
-          clusters.push_back(constituent.template user_info<fastjetutilities::fastjet_user_info>().getIndex());
-        }
-        if (constituent.template user_info<fastjetutilities::fastjet_user_info>().getStatus() == static_cast<int>(JetConstituentStatus::candidate)) {
-          cands.push_back(constituent.template user_info<fastjetutilities::fastjet_user_info>().getIndex());
-        }
-      }
-      constituentsTable(jetsTable.lastIndex(), tracks, clusters, cands);
+  std::vector<int> tracks;
+  std::vector<int> cands;
+  std::vector<int> clusters;
+  tracks.reserve(inputParticles.size());
+  cands.reserve(inputParticles.size());
+  clusters.reserve(inputParticles.size());
+
+  if (!((jetFinder.shareGhostsAcrossR || jetFinder.nThreadsR > 1) && jetFinder.canShareGhosts())) {
+    for (auto R : jetRValues) {
+      jetFinder.jetR = R;
+      std::vector<fastjet::PseudoJet> jets;
+      fastjet::ClusterSequenceArea clusterSeq(jetFinder.findJets(inputParticles, jets));
+      fillJets(jets, R, jetAreaFractionMin, collision, jetsTable, constituentsTable, thnSparseJet, fillThnSparse, doCandidateJetFinding, tracks, cands, clusters);
+    }
+    return;
+  }
+
+  std::vector<fastjet::PseudoJet> ghosts;
+  double actualGhostArea = jetFinder.generateGhosts(ghosts);
+  int nR = jetRValues.size();
+  int nThreads = std::min(jetFinder.nThreadsR, nR);
+  if (nThreads <= 1) {
+    for (auto R : jetRValues) {
+      jetFinder.jetR = R;
+      std::vector<fastjet::PseudoJet> jets;
+      auto clusterSeq = jetFinder.findJets(inputParticles, jets, ghosts, actualGhostArea);
+      fillJets(jets, R, jetAreaFractionMin, collision, jetsTable, constituentsTable, thnSparseJet, fillThnSparse, doCandidateJetFinding, tracks, cands, clusters);
     }
+    return;
+  }
+
+#ifndef FASTJET_HAVE_THREAD_SAFETY
+  // the input particles (with their user info) and the selectors of the jet finder copies are shared by the threads,
+  // which is only safe if fastjet reference counts them atomically
+  LOG(fatal) << "jet finding with nThreadsR = " << jetFinder.nThreadsR << " needs a fastjet build with thread safety enabled";
+#else
+  // each radius gets its own copy of the jet finder, since the jet finding modifies its parameters
+  std::vector<JetFinder> jetFinders(nR, jetFinder);
+  std::vector<std::vector<fastjet::PseudoJet>> jetsR(nR);
+  std::vector<std::unique_ptr<fastjet::ClusterSequenceActiveAreaExplicitGhosts>> clusterSeqs(nR);
+  std::atomic<int> nextR{0};
+  auto clusterRadii = [&]() {
+    for (int iR = nextR++; iR < nR; iR = nextR++) {
+      jetFinders[iR].jetR = jetRValues[iR];
+      clusterSeqs[iR] = jetFinders[iR].findJets(inputParticles, jetsR[iR], ghosts, actualGhostArea);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int iThread = 1; iThread < nThreads; iThread++) {
+    threads.emplace_back(clusterRadii);
+  }
+  clusterRadii();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int iR = 0; iR < nR; iR++) {
+    fillJets(jetsR[iR], jetRValues[iR], jetAreaFractionMin, collision, jetsTable, constituentsTable, thnSparseJet, fillThnSparse, doCandidateJetFinding, tracks, cands, clusters);
   }
+  jetFinder.jetR = jetRValues.back();
+#endif
 }
 
 /**
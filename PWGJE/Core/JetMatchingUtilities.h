@@ -32,10 +32,12 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <numeric>
 #include <ostream>
 #include <stdexcept>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include <math.h>
@@ -411,6 +413,52 @@ auto constexpr getConstituentId(T const& track)
   }
 }
 
+template <bool jetsBaseIsMc, bool jetsTagIsMc, typename U, typename P, typename R, typename S>
+float getCandidatePtSum(U const& candidatesBase, P const& candidatesTag, R const& fullTracksBase, S const& fullTracksTag)
+{
+  float ptSum = 0.;
+  if constexpr (jetsTagIsMc) {
+    for (auto const& candidateBase : candidatesBase) {
+      if (jetcandidateutilities::isMatchedCandidate(candidateBase)) {
+        const auto candidateBaseMcId = jetcandidateutilities::matchedParticleId(candidateBase, fullTracksBase, fullTracksTag);
+        for (auto const& candidateTag : candidatesTag) {
+          const auto candidateTagId = candidateTag.mcParticleId();
+          if (candidateBaseMcId == candidateTagId) {
+            ptSum += candidateBase.pt();
+          }
+          break; // should only be one
+        }
+      }
+      break;
+    }
+  } else if constexpr (jetsBaseIsMc) {
+    for (auto const& candidateTag : candidatesTag) {
+      if (jetcandidateutilities::isMatchedCandidate(candidateTag)) {
+        const auto candidateTagMcId = jetcandidateutilities::matchedParticleId(candidateTag, fullTracksTag, fullTracksBase);
+        for (auto const& candidateBase : candidatesBase) {
+          const auto candidateBaseId = candidateBase.mcParticleId();
+          if (candidateTagMcId == candidateBaseId) {
+            ptSum += candidateTag.pt();
+          }
+          break; // should only be one
+        }
+      }
+      break;
+    }
+  } else {
+    for (auto const& candidateBase : candidatesBase) {
+      for (auto const& candidateTag : candidatesTag) {
+        if (candidateBase.globalIndex() == candidateTag.globalIndex()) {
+          ptSum += candidateBase.pt();
+        }
+        break; // should only be one
+      }
+      break;
+    }
+  }
+  return ptSum;
+}
+
 template <bool isEMCAL, bool isCandidate, bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename O, typename P, typename Q, typename R, typename S>
 float getPtSum(T const& tracksBase, U const& candidatesBase, V const& clustersBase, O const& tracksTag, P const& candidatesTag, Q const& clustersTag, R const& fullTracksBase, S const& fullTracksTag)
 {
@@ -470,45 +518,7 @@ float getPtSum(T const& tracksBase, U const& candidatesBase, V const& clustersBa
     }
   }
   if constexpr (isCandidate) {
-    if constexpr (jetsTagIsMc) {
-      for (auto const& candidateBase : candidatesBase) {
-        if (jetcandidateutilities::isMatchedCandidate(candidateBase)) {
-          const auto candidateBaseMcId = jetcandidateutilities::matchedParticleId(candidateBase, fullTracksBase, fullTracksTag);
-          for (auto const& candidateTag : candidatesTag) {
-            const auto candidateTagId = candidateTag.mcParticleId();
-            if (candidateBaseMcId == candidateTagId) {
-              ptSum += candidateBase.pt();
-            }
-            break; // should only be one
-          }
-        }
-        break;
-      }
-    } else if constexpr (jetsBaseIsMc) {
-      for (auto const& candidateTag : candidatesTag) {
-        if (jetcandidateutilities::isMatchedCandidate(candidateTag)) {
-          const auto candidateTagMcId = jetcandidateutilities::matchedParticleId(candidateTag, fullTracksTag, fullTracksBase);
-          for (auto const& candidateBase : candidatesBase) {
-            const auto candidateBaseId = candidateBase.mcParticleId();
-            if (candidateTagMcId == candidateBaseId) {
-              ptSum += candidateTag.pt();
-            }
-            break; // should only be one
-          }
-        }
-        break;
-      }
-    } else {
-      for (auto const& candidateBase : candidatesBase) {
-        for (auto const& candidateTag : candidatesTag) {
-          if (candidateBase.globalIndex() == candidateTag.globalIndex()) {
-            ptSum += candidateBase.pt();
-          }
-          break; // should only be one
-        }
-        break;
-      }
-    }
+    ptSum += getCandidatePtSum<jetsBaseIsMc, jetsTagIsMc>(candidatesBase, candidatesTag, fullTracksBase, fullTracksTag);
   }
   return ptSum;
 }
@@ -527,34 +537,170 @@ auto getConstituents(T const& jet, U const& /*constituents*/)
   }
 }
 
+/**
+ * Index from constituent ids (track, MC particle or candidate ids) to the jets of a collision containing them.
+ *
+ * Each jet is stored at most once per id, and the jets of an id are sorted by their position in the collision.
+ */
+class ConstituentJetIndex
+{
+ public:
+  using Entry = std::pair<int64_t, int>;
+
+  void clear() { entries.clear(); }
+
+  void add(int64_t id, int jet)
+  {
+    if (id != -1) {
+      entries.emplace_back(id, jet);
+    }
+  }
+
+  void build()
+  {
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+  }
+
+  /// range of the entries of the jets containing id
+  std::pair<std::vector<Entry>::const_iterator, std::vector<Entry>::const_iterator> jets(int64_t id) const
+  {
+    return std::equal_range(entries.begin(), entries.end(), Entry{id, 0}, [](const Entry& a, const Entry& b) { return a.first < b.first; });
+  }
+
+ private:
+  std::vector<Entry> entries;
+};
+
+/**
+ * Shared constituent pT of all pairs of base and tag jets of a collision with the same radius,
+ * equivalent to getPtSum without the candidate contribution.
+ *
+ * The tag jets are indexed by the ids of their constituents, so each base jet loops once over its own constituents
+ * instead of once per tag jet. The contributions are added in the same order as in getPtSum.
+ *
+ * @param ptSums shared pT of base jet iBase and tag jet iTag at iBase * nTagJets + iTag, with i the positions in the collision
+ */
+template <bool isEMCAL, bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename N, typename O, typename Q>
+void getPtSums(T const& jetsBasePerCollision, U const& jetsTagPerCollision, V const& tracksBase, N const& clustersBase, O const& tracksTag, Q const& clustersTag, std::vector<float>& ptSums)
+{
+  const int nTag = jetsTagPerCollision.size();
+  std::vector<double> rTag;
+  rTag.reserve(nTag);
+  ConstituentJetIndex tagTrackIndex;   // ids of the tag tracks, as compared to the base tracks
+  ConstituentJetIndex tagClusterIndex; // MC particle ids of the tag clusters
+  int iTag = 0;
+  for (const auto& jetTag : jetsTagPerCollision) {
+    rTag.push_back(std::round(jetTag.r()));
+    for (const auto& trackTag : getConstituents(jetTag, tracksTag)) {
+      tagTrackIndex.add(getConstituentId<jetsBaseIsMc>(trackTag), iTag);
+    }
+    if constexpr (isEMCAL && jetsBaseIsMc) {
+      for (const auto& clusterTag : getConstituents(jetTag, clustersTag)) {
+        for (const auto& clusterTagParticleId : clusterTag.mcParticlesIds()) {
+          tagClusterIndex.add(clusterTagParticleId, iTag);
+        }
+      }
+    }
+    iTag++;
+  }
+  tagTrackIndex.build();
+  tagClusterIndex.build();
+
+  ptSums.assign(static_cast<size_t>(jetsBasePerCollision.size()) * nTag, 0.f);
+  std::vector<int> clusterStamps(nTag, -1);
+  int clusterStamp = 0;
+  int iBase = 0;
+  for (const auto& jetBase : jetsBasePerCollision) {
+    float* sums = ptSums.data() + static_cast<size_t>(iBase) * nTag;
+    const double rBase = std::round(jetBase.r());
+    auto jetBaseTracks = getConstituents(jetBase, tracksBase);
+    for (const auto& trackBase : jetBaseTracks) {
+      auto [first, last] = tagTrackIndex.jets(getConstituentId<jetsTagIsMc>(trackBase));
+      for (auto entry = first; entry != last; ++entry) {
+        if (rTag[entry->second] == rBase) {
+          sums[entry->second] += trackBase.pt();
+        }
+      }
+    }
+    if constexpr (isEMCAL) {
+      if constexpr (jetsTagIsMc) {
+        // a cluster contributes once to each tag jet containing one of its particles
+        for (const auto& clusterBase : getConstituents(jetBase, clustersBase)) {
+          for (const auto& clusterBaseParticleId : clusterBase.mcParticlesIds()) {
+            auto [first, last] = tagTrackIndex.jets(clusterBaseParticleId);
+            for (auto entry = first; entry != last; ++entry) {
+              if (rTag[entry->second] == rBase && clusterStamps[entry->second] != clusterStamp) {
+                clusterStamps[entry->second] = clusterStamp;
+                sums[entry->second] += clusterBase.energy() / std::cosh(clusterBase.eta());
+              }
+            }
+          }
+          clusterStamp++;
+        }
+      }
+      if constexpr (jetsBaseIsMc) {
+        // particles already matched to a track of the tag jet are not counted again for its clusters
+        for (const auto& trackBase : jetBaseTracks) {
+          auto [first, last] = tagClusterIndex.jets(trackBase.globalIndex());
+          auto [trackFirst, trackLast] = tagTrackIndex.jets(getConstituentId<jetsTagIsMc>(trackBase));
+          for (auto entry = first; entry != last; ++entry) {
+            while (trackFirst != trackLast && trackFirst->second < entry->second) {
+              ++trackFirst;
+            }
+            if (trackFirst != trackLast && trackFirst->second == entry->second) {
+              continue;
+            }
+            if (rTag[entry->second] == rBase) {
+              sums[entry->second] += trackBase.pt();
+            }
+          }
+        }
+      }
+    }
+    iBase++;
+  }
+}
+
 template <bool jetsBaseIsMc, bool jetsTagIsMc, typename T, typename U, typename V, typename M, typename N, typename O, typename P, typename Q>
 void MatchPt(T const& jetsBasePerCollision, U const& jetsTagPerCollision, std::vector<std::vector<int>>& baseToTagMatchingPt, std::vector<std::vector<int>>& tagToBaseMatchingPt, V const& tracksBase, M const& candidatesBase, N const& clustersBase, O const& tracksTag, P const& candidatesTag, Q const& clustersTag, float minPtFraction)
 {
+  constexpr bool IsEMCAL{jetfindingutilities::isEMCALClusterTable<N>() || jetfindingutilities::isEMCALClusterTable<Q>()};
+  constexpr bool IsCandidate{(jetcandidateutilities::isCandidateTable<M>() || jetcandidateutilities::isCandidateMcTable<M>()) && (jetcandidateutilities::isCandidateTable<P>() || jetcandidateutilities::isCandidateMcTable<P>())};
+  std::vector<float> ptSumsBase;
+  std::vector<float> ptSumsTag;
+  getPtSums<IsEMCAL, jetsBaseIsMc, jetsTagIsMc>(jetsBasePerCollision, jetsTagPerCollision, tracksBase, clustersBase, tracksTag, clustersTag, ptSumsBase);
+  getPtSums<IsEMCAL, jetsTagIsMc, jetsBaseIsMc>(jetsTagPerCollision, jetsBasePerCollision, tracksTag, clustersTag, tracksBase, clustersBase, ptSumsTag);
+  const size_t nBase = jetsBasePerCollision.size();
+  const size_t nTag = jetsTagPerCollision.size();
+
   float ptSumBase;
   float ptSumTag;
+  size_t iBase = 0;
   for (const auto& jetBase : jetsBasePerCollision) {
-    auto jetBaseTracks = getConstituents(jetBase, tracksBase);
-    auto jetBaseClusters = getConstituents(jetBase, clustersBase);
-    auto jetBaseCandidates = getConstituents(jetBase, candidatesBase);
+    size_t iTag = 0;
     for (const auto& jetTag : jetsTagPerCollision) {
       if (std::round(jetBase.r()) != std::round(jetTag.r())) {
+        iTag++;
         continue;
       }
-      auto jetTagTracks = getConstituents(jetTag, tracksTag);
-      auto jetTagClusters = getConstituents(jetTag, clustersTag);
-      auto jetTagCandidates = getConstituents(jetTag, candidatesTag);
-
-      constexpr bool IsEMCAL{jetfindingutilities::isEMCALClusterTable<N>() || jetfindingutilities::isEMCALClusterTable<Q>()};
-      constexpr bool IsCandidate{(jetcandidateutilities::isCandidateTable<M>() || jetcandidateutilities::isCandidateMcTable<M>()) && (jetcandidateutilities::isCandidateTable<P>() || jetcandidateutilities::isCandidateMcTable<P>())};
-      ptSumBase = getPtSum<IsEMCAL, IsCandidate, jetsBaseIsMc, jetsTagIsMc>(jetBaseTracks, jetBaseCandidates, jetBaseClusters, jetTagTracks, jetTagCandidates, jetTagClusters, tracksBase, tracksTag);
-      ptSumTag = getPtSum<IsEMCAL, IsCandidate, jetsTagIsMc, jetsBaseIsMc>(jetTagTracks, jetTagCandidates, jetTagClusters, jetBaseTracks, jetBaseCandidates, jetBaseClusters, tracksTag, tracksBase);
+      ptSumBase = ptSumsBase[iBase * nTag + iTag];
+      ptSumTag = ptSumsTag[iTag * nBase + iBase];
+      if constexpr (IsCandidate) {
+        auto jetBaseCandidates = getConstituents(jetBase, candidatesBase);
+        auto jetTagCandidates = getConstituents(jetTag, candidatesTag);
+        ptSumBase += getCandidatePtSum<jetsBaseIsMc, jetsTagIsMc>(jetBaseCandidates, jetTagCandidates, tracksBase, tracksTag);
+        ptSumTag += getCandidatePtSum<jetsTagIsMc, jetsBaseIsMc>(jetTagCandidates, jetBaseCandidates, tracksTag, tracksBase);
+      }
       if (ptSumBase > jetBase.pt() * minPtFraction) {
         baseToTagMatchingPt[jetBase.globalIndex()].push_back(jetTag.globalIndex());
       }
       if (ptSumTag > jetTag.pt() * minPtFraction) {
         tagToBaseMatchingPt[jetTag.globalIndex()].push_back(jetBase.globalIndex());
       }
+      iTag++;
     }
+    iBase++;
   }
 }
 
@@ -90,6 +90,8 @@ struct JetFinderV0Task {
   Configurable<int> jetRecombScheme{"jetRecombScheme", 0, "jet recombination scheme. 0 = E-scheme, 1 = pT-scheme, 2 = pT2-scheme"};
   Configurable<float> jetGhostArea{"jetGhostArea", 0.005, "jet ghost area"};
   Configurable<int> ghostRepeat{"ghostRepeat", 1, "set to 0 to gain speed if you dont need area calculation"};
+  Configurable<bool> jetShareGhostsAcrossR{"jetShareGhostsAcrossR", false, "generate the ghosts once per event and reuse them for all jet radii, requires ghostRepeat = 1"};
+  Configurable<int> jetNThreadsR{"jetNThreadsR", 1, "number of threads clustering the jet radii in parallel, > 1 implies jetShareGhostsAcrossR and needs a thread-safe fastjet build"};
   Configurable<bool> DoTriggering{"DoTriggering", false, "used for the charged jet trigger to remove the eta constraint on the jet axis"};
   Configurable<float> jetAreaFractionMin{"jetAreaFractionMin", -99.0, "used to make a cut on the jet areas"};
   Configurable<int> jetPtBinWidth{"jetPtBinWidth", 5, "used to define the width of the jetPt bins for the THnSparse"};
@@ -130,6 +132,8 @@ struct JetFinderV0Task {
     jetFinder.recombScheme = static_cast<fastjet::RecombinationScheme>(static_cast<int>(jetRecombScheme));
     jetFinder.ghostArea = jetGhostArea;
     jetFinder.ghostRepeatN = ghostRepeat;
+    jetFinder.shareGhostsAcrossR = jetShareGhostsAcrossR;
+    jetFinder.nThreadsR = jetNThreadsR;
     if (DoTriggering) {
       jetFinder.isTriggering = true;
     }
@@ -13,7 +13,9 @@
 //
 /// \author Nima Zardoshti <nima.zardoshti@cern.ch>
 
+#include "PWGJE/Core/FastJetUtilities.h"
 #include "PWGJE/Core/JetBkgSubUtils.h"
+#include "PWGJE/Core/JetCandidateUtilities.h"
 #include "PWGJE/Core/JetDerivedDataUtilities.h"
 #include "PWGJE/Core/JetFindingUtilities.h"
 #include "PWGJE/DataModel/Jet.h"
@@ -32,7 +34,10 @@
 #include <fastjet/JetDefinition.hh>
 #include <fastjet/PseudoJet.hh>
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -89,6 +94,10 @@ struct RhoEstimatorTask {
     Configurable<float> bkgPhiMin{"bkgPhiMin", -99., "minimim phi for determining background density"};
     Configurable<float> bkgPhiMax{"bkgPhiMax", 99., "maximum phi for determining background density"};
     Configurable<bool> doSparse{"doSparse", false, "perfom sparse estimation"};
+    Configurable<int> rhoMode{"rhoMode", 0, "rho estimation method. 0 = median of kT jets pT/area, 1 = median of pT/area of a rapidity-azimuth grid of cells (bkgPhiMin/bkgPhiMax and doSparse not used)"};
+    Configurable<float> rhoGridSize{"rhoGridSize", 0.55, "cell size in rapidity and azimuth for rhoMode 1"};
+    Configurable<bool> fixedGhosts{"fixedGhosts", false, "generate the ghosts once and reuse them in every event instead of drawing new ones per event"};
+    Configurable<bool> candidateRhosFromSingleClustering{"candidateRhosFromSingleClustering", false, "for collisions with candidates, cluster the event once and remove the daughters of each candidate from the kT jets instead of reclustering the event per candidate"};
 
     Configurable<float> thresholdTriggerTrackPtMin{"thresholdTriggerTrackPtMin", 0.0, "Minimum trigger track pt to accept event"};
     Configurable<float> thresholdClusterEnergyMin{"thresholdClusterEnergyMin", 0.0, "Minimum cluster energy to accept event"};
@@ -106,9 +115,12 @@ struct RhoEstimatorTask {
   } config;
 
   JetBkgSubUtils bkgSub;
+  JetBkgRhoEstimator rhoEstimator;
   float bkgPhiMax_;
   float bkgPhiMin_;
   std::vector<fastjet::PseudoJet> inputParticles;
+  std::vector<std::vector<std::size_t>> candidateDaughterParticles;
+  std::vector<std::tuple<double, double>> candidateRhos;
   int trackSelection = -1;
   std::string particleSelection;
 
@@ -134,6 +146,7 @@ struct RhoEstimatorTask {
       bkgPhiMin_ = -2.0 * M_PI;
     }
     bkgSub.setPhiMinMax(bkgPhiMin_, bkgPhiMax_);
+    rhoEstimator.initialise(bkgSub, static_cast<JetBkgRhoEstimator::Mode>(static_cast<int>(config.rhoMode)), config.fixedGhosts, config.rhoGridSize);
     eventSelectionBits = jetderiveddatautilities::initialiseEventSelectionBits(static_cast<std::string>(config.eventSelections));
     triggerMaskBits = jetderiveddatautilities::initialiseTriggerMaskBits(config.triggerMasks);
 
@@ -205,6 +218,47 @@ struct RhoEstimatorTask {
   PROCESS_SWITCH_FULL(RhoEstimatorTask, processSelectionObjects<aod::JClusters>, processSelectingClusters, "process EMCal clusters", false);
   PROCESS_SWITCH_FULL(RhoEstimatorTask, processSelectionObjects<aod::JTracks>, processSelectingTracks, "process high pt tracks", false);
 
+  template <typename T, typename U>
+  void fillCandidateRhosFromSingleClustering(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, T const& candidates, U& rhoTable)
+  {
+    if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
+      for (int64_t iCandidate = 0; iCandidate < candidates.size(); iCandidate++) {
+        rhoTable(0.0, 0.0);
+      }
+      return;
+    }
+    inputParticles.clear();
+    jetfindingutilities::analyseTracks<soa::Filtered<aod::JetTracks>, soa::Filtered<aod::JetTracks>::iterator>(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning);
+
+    // positions of the daughters of each candidate among the input particles, which follow the order of the tracks
+    candidateDaughterParticles.resize(candidates.size());
+    for (auto& daughterParticles : candidateDaughterParticles) {
+      daughterParticles.clear();
+    }
+    std::size_t iParticle = 0;
+    for (auto const& track : tracks) {
+      if (iParticle == inputParticles.size()) {
+        break;
+      }
+      if (inputParticles[iParticle].user_info<fastjetutilities::fastjet_user_info>().getIndex() != track.globalIndex()) {
+        continue;
+      }
+      std::size_t iCandidate = 0;
+      for (auto const& candidate : candidates) {
+        if (jetcandidateutilities::isDaughterTrack(track, candidate, tracks)) {
+          candidateDaughterParticles[iCandidate].push_back(iParticle);
+        }
+        iCandidate++;
+      }
+      iParticle++;
+    }
+
+    rhoEstimator.estimateRhoVariants(inputParticles, candidateDaughterParticles, config.doSparse, candidateRhos);
+    for (auto const& [rho, rhoM] : candidateRhos) {
+      rhoTable(rho, rhoM);
+    }
+  }
+
   void processChargedCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks)
   {
     if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
@@ -221,7 +275,7 @@ struct RhoEstimatorTask {
     }
     inputParticles.clear();
     jetfindingutilities::analyseTracks<soa::Filtered<aod::JetTracks>, soa::Filtered<aod::JetTracks>::iterator>(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning);
-    auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+    auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
     rhoChargedTable(rho, rhoM);
   }
   PROCESS_SWITCH(RhoEstimatorTask, processChargedCollisions, "Fill rho tables for collisions using charged tracks", true);
@@ -234,13 +288,17 @@ struct RhoEstimatorTask {
     }
     inputParticles.clear();
     jetfindingutilities::analyseParticles<true, soa::Filtered<aod::JetParticles>, soa::Filtered<aod::JetParticles>::iterator>(inputParticles, particleSelection, 1, particles, pdgDatabase);
-    auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+    auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
     rhoChargedMcTable(rho, rhoM);
   }
   PROCESS_SWITCH(RhoEstimatorTask, processChargedMcCollisions, "Fill rho tables for MC collisions using charged tracks", false);
 
   void processD0Collisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesD0Data const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoD0Table);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoD0Table(0.0, 0.0);
@@ -249,7 +307,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoD0Table(rho, rhoM);
     }
   }
@@ -261,7 +319,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoD0McTable(rho, rhoM);
     }
   }
@@ -269,6 +327,10 @@ struct RhoEstimatorTask {
 
   void processDplusCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesDplusData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoDplusTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoDplusTable(0.0, 0.0);
@@ -277,7 +339,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDplusTable(rho, rhoM);
     }
   }
@@ -289,7 +351,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDplusMcTable(rho, rhoM);
     }
   }
@@ -297,6 +359,10 @@ struct RhoEstimatorTask {
 
   void processDsCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesDsData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoDsTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoDsTable(0.0, 0.0);
@@ -305,7 +371,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDsTable(rho, rhoM);
     }
   }
@@ -317,7 +383,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDsMcTable(rho, rhoM);
     }
   }
@@ -325,6 +391,10 @@ struct RhoEstimatorTask {
 
   void processDstarCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesDstarData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoDstarTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoDstarTable(0.0, 0.0);
@@ -333,7 +403,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDstarTable(rho, rhoM);
     }
   }
@@ -345,7 +415,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDstarMcTable(rho, rhoM);
     }
   }
@@ -353,6 +423,10 @@ struct RhoEstimatorTask {
 
   void processLcCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesLcData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoLcTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoLcTable(0.0, 0.0);
@@ -361,7 +435,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoLcTable(rho, rhoM);
     }
   }
@@ -373,7 +447,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoLcMcTable(rho, rhoM);
     }
   }
@@ -381,6 +455,10 @@ struct RhoEstimatorTask {
 
   void processB0Collisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesB0Data const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoB0Table);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoB0Table(0.0, 0.0);
@@ -389,7 +467,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoB0Table(rho, rhoM);
     }
   }
@@ -401,7 +479,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoB0McTable(rho, rhoM);
     }
   }
@@ -409,6 +487,10 @@ struct RhoEstimatorTask {
 
   void processBplusCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesBplusData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoBplusTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoBplusTable(0.0, 0.0);
@@ -417,7 +499,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoBplusTable(rho, rhoM);
     }
   }
@@ -429,7 +511,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoBplusMcTable(rho, rhoM);
     }
   }
@@ -437,6 +519,10 @@ struct RhoEstimatorTask {
 
   void processXicToXiPiPiCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesXicToXiPiPiData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoXicToXiPiPiTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoXicToXiPiPiTable(0.0, 0.0);
@@ -445,7 +531,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoXicToXiPiPiTable(rho, rhoM);
     }
   }
@@ -457,7 +543,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoXicToXiPiPiMcTable(rho, rhoM);
     }
   }
@@ -465,6 +551,10 @@ struct RhoEstimatorTask {
 
   void processDielectronCollisions(aod::JetCollision const& collision, soa::Filtered<aod::JetTracks> const& tracks, aod::CandidatesDielectronData const& candidates)
   {
+    if (config.candidateRhosFromSingleClustering) {
+      fillCandidateRhosFromSingleClustering(collision, tracks, candidates, rhoDielectronTable);
+      return;
+    }
     for (auto& candidate : candidates) {
       if (!jetderiveddatautilities::selectCollision(collision, eventSelectionBits) || collision.centFT0M() < config.centralityMin || collision.centFT0M() >= config.centralityMax || collision.trackOccupancyInTimeRange() > config.trackOccupancyInTimeRangeMax || std::abs(collision.posZ()) > config.vertexZCut) {
         rhoDielectronTable(0.0, 0.0);
@@ -473,7 +563,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseTracks(inputParticles, tracks, trackSelection, config.applyTrackingEfficiency, config.trackingEfficiency, config.trackingEfficiencyPtBinning, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDielectronTable(rho, rhoM);
     }
   }
@@ -485,7 +575,7 @@ struct RhoEstimatorTask {
       inputParticles.clear();
       jetfindingutilities::analyseParticles<true>(inputParticles, particleSelection, 1, particles, pdgDatabase, &candidate);
 
-      auto [rho, rhoM] = bkgSub.estimateRhoAreaMedian(inputParticles, config.doSparse);
+      auto [rho, rhoM] = rhoEstimator.estimateRho(inputParticles, config.doSparse);
       rhoDielectronMcTable(rho, rhoM);
     }
   }
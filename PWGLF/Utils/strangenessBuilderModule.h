@@ -36,9 +36,11 @@
 
 #include <array>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 //__________________________________________
@@ -721,6 +723,28 @@ class BuilderModule
     return idx;
   }
 
+  // for hash-based lookups of track combinations in findable mode
+  static uint64_t trackPairKey(int posTrackId, int negTrackId)
+  {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(posTrackId)) << 32) | static_cast<uint32_t>(negTrackId);
+  }
+  struct trackTripletHash {
+    std::size_t operator()(const std::array<int, 3>& triplet) const
+    {
+      return std::hash<uint64_t>{}(trackPairKey(triplet[0], triplet[1])) ^ (std::hash<int>{}(triplet[2]) * 0x9e3779b97f4a7c15ULL);
+    }
+  };
+
+  // groups the entries of a track array by originating particle, keeping their order
+  static std::unordered_map<int, std::vector<std::size_t>> groupByOrigin(const std::vector<trackEntry>& trackArray)
+  {
+    std::unordered_map<int, std::vector<std::size_t>> groups;
+    for (std::size_t i = 0; i < trackArray.size(); i++) {
+      groups[trackArray[i].originId].push_back(i);
+    }
+    return groups;
+  }
+
   template <typename TCollisions, typename TCCDB>
   bool initCCDB(TCCDB& ccdb, aod::BCsWithTimestamps const& bcs, TCollisions const& collisions)
   {
@@ -1012,24 +1036,39 @@ class BuilderModule
           }
         }
 
-        // Nested loop only with valuable tracks
+        // index existing (pos, neg) combinations: first occurrence in v0List (mode 1) or in v0s (mode 2)
+        std::unordered_map<uint64_t, int> existingV0s;
+        if (baseOpts.mc_findableMode.value == 1) {
+          existingV0s.reserve(v0ListReconstructedSize);
+          for (int ii = 0; ii < v0ListReconstructedSize; ii++) {
+            existingV0s.try_emplace(trackPairKey(v0List[ii].posTrackId, v0List[ii].negTrackId), ii);
+          }
+        }
+        if (baseOpts.mc_findableMode.value == 2) {
+          existingV0s.reserve(v0s.size());
+          for (const auto& v0 : v0s) {
+            existingV0s.try_emplace(trackPairKey(v0.posTrackId(), v0.negTrackId()), v0.globalIndex());
+          }
+        }
+
+        // pair only tracks with the same originating particle
+        const auto negativeTracksByOrigin = groupByOrigin(negativeTrackArray);
         for (const auto& positiveTrackIndex : positiveTrackArray) {
-          for (const auto& negativeTrackIndex : negativeTrackArray) {
-            if (positiveTrackIndex.originId != negativeTrackIndex.originId) {
-              continue; // not the same originating particle
-            }
+          const auto negativeTracks = negativeTracksByOrigin.find(positiveTrackIndex.originId);
+          if (negativeTracks == negativeTracksByOrigin.end()) {
+            continue; // no negative track with the same originating particle
+          }
+          for (const auto& iNegative : negativeTracks->second) {
+            const auto& negativeTrackIndex = negativeTrackArray[iNegative];
+            const auto existingV0 = existingV0s.find(trackPairKey(positiveTrackIndex.globalId, negativeTrackIndex.globalId));
             // findable mode 1: add non-reconstructed as v0Type 8
             if (baseOpts.mc_findableMode.value == 1) {
               bool detected = false;
-              for (int ii = 0; ii < v0ListReconstructedSize; ii++) {
-                // check if this particular combination already exists in v0List
-                if (v0List[ii].posTrackId == positiveTrackIndex.globalId &&
-                    v0List[ii].negTrackId == negativeTrackIndex.globalId) {
-                  detected = true;
-                  // override pdg code with something useful for cascade findable math
-                  v0List[ii].pdgCode = positiveTrackIndex.pdgCode;
-                  break;
-                }
+              if (existingV0 != existingV0s.end()) {
+                // this particular combination already exists in v0List
+                detected = true;
+                // override pdg code with something useful for cascade findable math
+                v0List[existingV0->second].pdgCode = positiveTrackIndex.pdgCode;
               }
               if (detected == false) {
                 // collision index: from best-version-of-this-mcCollision
@@ -1068,17 +1107,14 @@ class BuilderModule
                 currentV0Entry.isCollinearV0 = true;
               }
               currentV0Entry.found = false;
-              for (const auto& v0 : v0s) {
-                if (v0.posTrackId() == positiveTrackIndex.globalId &&
-                    v0.negTrackId() == negativeTrackIndex.globalId) {
-                  // this will override type, but not collision index
-                  // N.B.: collision index checks still desirable!
-                  currentV0Entry.globalId = v0.globalIndex();
-                  currentV0Entry.v0Type = v0.v0Type();
-                  currentV0Entry.isCollinearV0 = v0.isCollinearV0();
-                  currentV0Entry.found = true;
-                  break;
-                }
+              if (existingV0 != existingV0s.end()) {
+                // this will override type, but not collision index
+                // N.B.: collision index checks still desirable!
+                auto const& v0 = v0s.rawIteratorAt(existingV0->second);
+                currentV0Entry.globalId = v0.globalIndex();
+                currentV0Entry.v0Type = v0.v0Type();
+                currentV0Entry.isCollinearV0 = v0.isCollinearV0();
+                currentV0Entry.found = true;
               }
               if (v0BuilderOpts.mc_findableDetachedV0.value || currentV0Entry.collisionId >= 0) {
                 v0List.push_back(currentV0Entry);
@@ -1159,6 +1195,24 @@ class BuilderModule
             bachelorTrackArray.push_back(currentTrackEntry);
           }
 
+          // index existing (pos, neg, bachelor) combinations: in cascadeList (mode 1) or first occurrence in cascades (mode 2)
+          // caution: use track indices (immutable) but not V0 indices (re-indexing)
+          std::unordered_map<std::array<int, 3>, int, trackTripletHash> existingCascades;
+          if (baseOpts.mc_findableMode.value == 1) {
+            existingCascades.reserve(cascadeListReconstructedSize);
+            for (size_t ii = 0; ii < cascadeListReconstructedSize; ii++) {
+              existingCascades.try_emplace(std::array{cascadeList[ii].posTrackId, cascadeList[ii].negTrackId, cascadeList[ii].bachTrackId}, static_cast<int>(ii));
+            }
+          }
+          if (baseOpts.mc_findableMode.value == 2) {
+            existingCascades.reserve(cascades.size());
+            for (const auto& cascade : cascades) {
+              auto const& v0fromAOD = cascade.v0();
+              existingCascades.try_emplace(std::array{static_cast<int>(v0fromAOD.posTrackId()), static_cast<int>(v0fromAOD.negTrackId()), static_cast<int>(cascade.bachelorId())}, static_cast<int>(cascade.globalIndex()));
+            }
+          }
+          const auto bachelorTracksByOrigin = groupByOrigin(bachelorTrackArray);
+
           // determine which V0s are of interest to pair and do pairing
           for (size_t v0i = 0; v0i < v0List.size(); v0i++) {
             auto v0 = v0List[sorted_v0[v0i]];
@@ -1188,24 +1242,18 @@ class BuilderModule
             if (std::abs(v0OriginParticle.pdgCode()) != PDG_t::kXiMinus && std::abs(v0OriginParticle.pdgCode()) != PDG_t::kOmegaMinus) {
               continue; // this V0 does not come from any particle of interest, don't try
             }
-            for (const auto& bachelorTrackIndex : bachelorTrackArray) {
-              if (bachelorTrackIndex.originId != v0OriginParticle.globalIndex()) {
-                continue;
-              }
+            const auto bachelorTracks = bachelorTracksByOrigin.find(v0OriginParticleIndex);
+            if (bachelorTracks == bachelorTracksByOrigin.end()) {
+              continue; // no bachelor track with the same originating particle
+            }
+            for (const auto& iBachelor : bachelorTracks->second) {
+              const auto& bachelorTrackIndex = bachelorTrackArray[iBachelor];
+              const auto existingCascade = existingCascades.find(std::array{v0.posTrackId, v0.negTrackId, bachelorTrackIndex.globalId});
               // if we are here: v0 origin is 3312 or 3334, bachelor origin matches V0 origin
               // findable mode 1: add non-reconstructed as cascadeType 1
               if (baseOpts.mc_findableMode.value == 1) {
-                bool detected = false;
-                for (size_t ii = 0; ii < cascadeListReconstructedSize; ii++) {
-                  // check if this particular combination already exists in cascadeList
-                  // caution: use track indices (immutable) but not V0 indices (re-indexing)
-                  if (cascadeList[ii].posTrackId == v0.posTrackId &&
-                      cascadeList[ii].negTrackId == v0.negTrackId &&
-                      cascadeList[ii].bachTrackId == bachelorTrackIndex.globalId) {
-                    detected = true;
-                    break;
-                  }
-                }
+                // check if this particular combination already exists in cascadeList
+                bool detected = (existingCascade != existingCascades.end());
                 if (detected == false) {
                   // collision index: from best-version-of-this-mcCollision
                   // nota bene: this could be negative, caution advised
@@ -1239,17 +1287,11 @@ class BuilderModule
                 if (bestCollisionArray[bachelorTrackIndex.mcCollisionId] < 0) {
                   collisionLessCascades++;
                 }
-                for (const auto& cascade : cascades) {
-                  auto const& v0fromAOD = cascade.v0();
-                  if (v0fromAOD.posTrackId() == v0.posTrackId &&
-                      v0fromAOD.negTrackId() == v0.negTrackId &&
-                      cascade.bachelorId() == bachelorTrackIndex.globalId) {
-                    // this will override type, but not collision index
-                    // N.B.: collision index checks still desirable!
-                    currentCascadeEntry.found = true;
-                    currentCascadeEntry.globalId = cascade.globalIndex();
-                    break;
-                  }
+                if (existingCascade != existingCascades.end()) {
+                  // this will override type, but not collision index
+                  // N.B.: collision index checks still desirable!
+                  currentCascadeEntry.found = true;
+                  currentCascadeEntry.globalId = existingCascade->second;
                 }
                 if (cascadeBuilderOpts.mc_findableDetachedCascade.value || currentCascadeEntry.collisionId >= 0) {
                   cascadeList.push_back(currentCascadeEntry);
@@ -1262,15 +1304,17 @@ class BuilderModule
           // correct. We'll have to loop over all V0s and find the appropriate matches
           // ---> but only in mode 1, and only for AO2D-native V0s
           if (baseOpts.mc_findableMode.value == 1) {
+            // index v0List in sorted way, keeping the first sorted V0 for each (pos, neg) combination
+            std::unordered_map<uint64_t, size_t> sortedV0Index;
+            sortedV0Index.reserve(v0List.size());
+            for (size_t v0i = 0; v0i < v0List.size(); v0i++) {
+              const auto& v0 = v0List[sorted_v0[v0i]];
+              sortedV0Index.try_emplace(trackPairKey(v0.posTrackId, v0.negTrackId), v0i);
+            }
             for (size_t casci = 0; casci < cascadeListReconstructedSize; casci++) {
-              // loop over v0List to find corresponding v0 index, but do it in sorted way
-              for (size_t v0i = 0; v0i < v0List.size(); v0i++) {
-                auto v0 = v0List[sorted_v0[v0i]];
-                if (cascadeList[casci].posTrackId == v0.posTrackId &&
-                    cascadeList[casci].negTrackId == v0.negTrackId) {
-                  cascadeList[casci].v0Id = v0i; // fix, point to correct V0 index
-                  break;
-                }
+              const auto sortedV0 = sortedV0Index.find(trackPairKey(cascadeList[casci].posTrackId, cascadeList[casci].negTrackId));
+              if (sortedV0 != sortedV0Index.end()) {
+                cascadeList[casci].v0Id = sortedV0->second; // fix, point to correct V0 index
               }
             }
           }
@@ -0,0 +1,213 @@
+// Copyright 2019-2020 CERN and copyright holders of ALICE O2.
+// See https://alice-o2.web.cern.ch/copyright for details of the copyright holders.
+// All rights not expressly granted are reserved.
+//
+// This software is distributed under the terms of the GNU General Public
+// License v3 (GPL Version 3), copied verbatim in the file "COPYING".
+//
+// In applying this license CERN does not waive the privileges and immunities
+// granted to it by virtue of its status as an Intergovernmental Organization
+// or submit itself to any jurisdiction.
+///
+/// \file UDBcIndex.h
+/// \brief Columnar per-dataframe index of global BCs for the UD candidate producers
+///
+/// The index keeps the global BCs with a detector signal (or simply all BCs of a
+/// dataframe) in sorted flat arrays together with the row in the source table and
+/// a precomputed amplitude. Closest-BC searches and BC window queries
+/// are binary searches over the BC column instead of walks through std::map nodes
+/// or BC iterators.
+
+#ifndef PWGUD_CORE_UDBCINDEX_H_
+#define PWGUD_CORE_UDBCINDEX_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace udhelpers
+{
+
+class BcIndex
+{
+ public:
+  static constexpr int64_t NotFound = -1;
+
+  void clear()
+  {
+    mGlobalBCs.clear();
+    mRows.clear();
+    mAmplitudes.clear();
+    mSorted = true;
+    mNSource = 0;
+    mFirstSourceBC = 0;
+    mLastSourceBC = 0;
+  }
+
+  void reserve(std::size_t n)
+  {
+    mGlobalBCs.reserve(n);
+    mRows.reserve(n);
+    mAmplitudes.reserve(n);
+  }
+
+  // add an entry; build() has to be called before the index is queried
+  void add(uint64_t globalBC, int64_t row, float amplitude = 0.f)
+  {
+    if (!mGlobalBCs.empty() && globalBC < mGlobalBCs.back()) {
+      mSorted = false;
+    }
+    mGlobalBCs.push_back(globalBC);
+    mRows.push_back(row);
+    mAmplitudes.push_back(amplitude);
+  }
+
+  // sort the entries by global BC; for duplicated BCs the entry added last is kept,
+  // as with repeated assignments to a std::map<globalBC, row>
+  void build()
+  {
+    if (!mSorted) {
+      std::vector<std::size_t> order(mGlobalBCs.size());
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return mGlobalBCs[a] < mGlobalBCs[b]; });
+      permute(mGlobalBCs, order);
+      permute(mRows, order);
+      permute(mAmplitudes, order);
+      mSorted = true;
+    }
+    std::size_t nKept = 0;
+    for (std::size_t i = 0; i < mGlobalBCs.size(); ++i) {
+      if (nKept > 0 && mGlobalBCs[nKept - 1] == mGlobalBCs[i]) {
+        nKept--;
+      }
+      mGlobalBCs[nKept] = mGlobalBCs[i];
+      mRows[nKept] = mRows[i];
+      mAmplitudes[nKept] = mAmplitudes[i];
+      nKept++;
+    }
+    mGlobalBCs.resize(nKept);
+    mRows.resize(nKept);
+    mAmplitudes.resize(nKept);
+  }
+
+  // index all rows of a BCs table, row = position in the table
+  // The index is only rebuilt when the table differs from the one seen last, so that
+  // producers processing one collision at a time build it once per dataframe.
+  template <typename TBCs>
+  void fillFromBCs(TBCs const& bcs)
+  {
+    auto nBCs = static_cast<std::size_t>(bcs.size());
+    if (nBCs == 0) {
+      clear();
+      return;
+    }
+    uint64_t firstBC = bcs.iteratorAt(0).globalBC();
+    uint64_t lastBC = bcs.iteratorAt(nBCs - 1).globalBC();
+    if (nBCs == mNSource && firstBC == mFirstSourceBC && lastBC == mLastSourceBC) {
+      return;
+    }
+    clear();
+    reserve(nBCs);
+    for (const auto& bc : bcs) {
+      add(bc.globalBC(), bc.globalIndex());
+    }
+    build();
+    mNSource = nBCs;
+    mFirstSourceBC = firstBC;
+    mLastSourceBC = lastBC;
+  }
+
+  std::size_t size() const { return mGlobalBCs.size(); }
+  bool empty() const { return mGlobalBCs.empty(); }
+
+  uint64_t globalBC(std::size_t pos) const { return mGlobalBCs[pos]; }
+  int64_t row(std::size_t pos) const { return mRows[pos]; }
+  float amplitude(std::size_t pos) const { return mAmplitudes[pos]; }
+
+  // first position with global BC >= globalBC
+  std::size_t lowerBound(uint64_t globalBC) const
+  {
+    return std::lower_bound(mGlobalBCs.begin(), mGlobalBCs.end(), globalBC) - mGlobalBCs.begin();
+  }
+
+  // first position with global BC > globalBC
+  std::size_t upperBound(uint64_t globalBC) const
+  {
+    return std::upper_bound(mGlobalBCs.begin(), mGlobalBCs.end(), globalBC) - mGlobalBCs.begin();
+  }
+
+  // position of globalBC, NotFound if not indexed
+  int64_t find(uint64_t globalBC) const
+  {
+    auto pos = lowerBound(globalBC);
+    if (pos == size() || mGlobalBCs[pos] != globalBC) {
+      return NotFound;
+    }
+    return static_cast<int64_t>(pos);
+  }
+
+  // position of the entry closest to globalBC, NotFound if the index is empty
+  // On a tie the later BC is chosen.
+  int64_t closest(uint64_t globalBC) const
+  {
+    if (empty()) {
+      return NotFound;
+    }
+    auto pos1 = std::min(lowerBound(globalBC), size() - 1);
+    auto pos2 = pos1 > 0 ? pos1 - 1 : pos1;
+    auto bc1 = mGlobalBCs[pos1];
+    auto bc2 = mGlobalBCs[pos2];
+    auto dbc1 = bc1 >= globalBC ? bc1 - globalBC : globalBC - bc1;
+    auto dbc2 = bc2 >= globalBC ? bc2 - globalBC : globalBC - bc2;
+    return static_cast<int64_t>(dbc1 <= dbc2 ? pos1 : pos2);
+  }
+
+  // positions [first, last) of the entries with minBC <= global BC <= maxBC
+  std::pair<std::size_t, std::size_t> window(uint64_t minBC, uint64_t maxBC) const
+  {
+    if (maxBC < minBC) {
+      return {0, 0};
+    }
+    auto first = lowerBound(minBC);
+    auto last = std::upper_bound(mGlobalBCs.begin() + first, mGlobalBCs.end(), maxBC) - mGlobalBCs.begin();
+    return {first, static_cast<std::size_t>(last)};
+  }
+
+  // call f(pos) for all entries with minBC <= global BC <= maxBC
+  template <typename F>
+  void forEachInWindow(uint64_t minBC, uint64_t maxBC, F&& f) const
+  {
+    auto [first, last] = window(minBC, maxBC);
+    for (auto pos = first; pos < last; ++pos) {
+      f(pos);
+    }
+  }
+
+ private:
+  template <typename V>
+  static void permute(V& values, std::vector<std::size_t> const& order)
+  {
+    V sorted;
+    sorted.reserve(values.size());
+    for (auto i : order) {
+      sorted.push_back(values[i]);
+    }
+    values.swap(sorted);
+  }
+
+  std::vector<uint64_t> mGlobalBCs; // sorted global BCs
+  std::vector<int64_t> mRows;       // row in the source table
+  std::vector<float> mAmplitudes;   // amplitude stored with the entry
+  bool mSorted = true;
+
+  // signature of the BCs table used in fillFromBCs
+  std::size_t mNSource = 0;
+  uint64_t mFirstSourceBC = 0;
+  uint64_t mLastSourceBC = 0;
+};
+
+} // namespace udhelpers
+
+#endif // PWGUD_CORE_UDBCINDEX_H_
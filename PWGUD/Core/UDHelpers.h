@@ -17,6 +17,7 @@
 #define PWGUD_CORE_UDHELPERS_H_
 
 #include "PWGUD/Core/DGCutparHolder.h"
+#include "PWGUD/Core/UDBcIndex.h"
 #include "PWGUD/Core/UPCHelpers.h"
 
 #include "Common/DataModel/EventSelection.h"
@@ -203,6 +204,51 @@ T compatibleBCs(uint64_t const& meanBC, int const& deltaBC, T const& bcs)
   return compatibleBCs(bcIter, meanBC, deltaBC, bcs);
 }
 
+// In this variant of compatibleBCs the slice of BCs with globalBC in meanBC +- deltaBC
+// is obtained with a binary search in bcIndex, which needs to be filled with
+// bcIndex.fillFromBCs(bcs) for the current dataframe.
+template <typename T>
+T compatibleBCs(uint64_t const& meanBC, int const& deltaBC, T const& bcs, BcIndex const& bcIndex)
+{
+  auto [first, last] = bcIndex.window(meanBC, deltaBC);
+  if (first == last) {
+    LOGF(debug, "<compatibleBCs> No BC in [%d +- %d]", meanBC, deltaBC);
+    return T{{bcs.asArrowTable()->Slice(0, 0)}, static_cast<uint64_t>(0)};
+  }
+
+  // create bc slice
+  int64_t minBCId = bcIndex.row(first);
+  int64_t maxBCId = bcIndex.row(last - 1);
+  T bcslice{{bcs.asArrowTable()->Slice(minBCId, maxBCId - minBCId + 1)}, static_cast<uint64_t>(minBCId)};
+  bcs.copyIndexBindings(bcslice);
+  LOGF(debug, "  size of slice %d", bcslice.size());
+  return bcslice;
+}
+
+// Same as compatibleBCs(collision, ndt, bcs, nMinBCs) but using the BC index
+template <typename C, typename T>
+T compatibleBCs(C const& collision, int ndt, T const& bcs, BcIndex const& bcIndex, int nMinBCs)
+{
+  LOGF(debug, "Collision time / resolution [ns]: %f / %f", collision.collisionTime(), collision.collisionTimeRes());
+
+  // return if collisions has no associated BC
+  if (!collision.has_foundBC() || ndt < 0) {
+    return T{{bcs.asArrowTable()->Slice(0, 0)}, static_cast<uint64_t>(0)};
+  }
+
+  // due to the filling scheme the most probable BC may not be the one estimated from the collision time
+  uint64_t mostProbableBC = collision.template foundBC_as<T>().globalBC();
+  uint64_t meanBC = mostProbableBC + std::lround(collision.collisionTime() / o2::constants::lhc::LHCBunchSpacingNS);
+
+  // enforce minimum number for deltaBC
+  int deltaBC = std::ceil(collision.collisionTimeRes() / o2::constants::lhc::LHCBunchSpacingNS * ndt);
+  if (deltaBC < nMinBCs) {
+    deltaBC = nMinBCs;
+  }
+
+  return compatibleBCs(meanBC, deltaBC, bcs, bcIndex);
+}
+
 // -----------------------------------------------------------------------------
 // Same as above but for collisions with MC information
 template <typename F, typename T>
@@ -672,9 +718,9 @@ void fillBGBBFlags(upchelpers::FITInfo& info, uint64_t const& minbc, BCR const&
 }
 
 // -----------------------------------------------------------------------------
-// extract FIT information
-template <typename BC, typename BCS>
-void getFITinfo(upchelpers::FITInfo& info, BC& bc, BCS const& bcs, o2::aod::FT0s const& ft0s, o2::aod::FV0As const& fv0as, o2::aod::FDDs const& fdds)
+// extract FIT information of a given BC
+template <typename BC>
+void getFITinfoOfBC(upchelpers::FITInfo& info, BC& bc, o2::aod::FT0s const& ft0s, o2::aod::FV0As const& fv0as, o2::aod::FDDs const& fdds)
 {
   // FV0A
   if (bc.has_foundFV0()) {
@@ -703,6 +749,14 @@ void getFITinfo(upchelpers::FITInfo& info, BC& bc, BCS const& bcs, o2::aod::FT0s
     info.ampFDDC = FDDAmplitudeC(fdd);
     info.triggerMaskFDD = fdd.triggerMask();
   }
+}
+
+// -----------------------------------------------------------------------------
+// extract FIT information
+template <typename BC, typename BCS>
+void getFITinfo(upchelpers::FITInfo& info, BC& bc, BCS const& bcs, o2::aod::FT0s const& ft0s, o2::aod::FV0As const& fv0as, o2::aod::FDDs const& fdds)
+{
+  getFITinfoOfBC(info, bc, ft0s, fv0as, fdds);
 
   // fill BG and BB flags
   auto bcnum = bc.globalBC();
@@ -711,6 +765,19 @@ void getFITinfo(upchelpers::FITInfo& info, BC& bc, BCS const& bcs, o2::aod::FT0s
   fillBGBBFlags(info, bcnum - 16, bcrange);
 }
 
+// same as above, the BCs for the BG and BB flags are found with the BC index
+template <typename BC, typename BCS>
+void getFITinfo(upchelpers::FITInfo& info, BC& bc, BCS const& bcs, BcIndex const& bcIndex, o2::aod::FT0s const& ft0s, o2::aod::FV0As const& fv0as, o2::aod::FDDs const& fdds)
+{
+  getFITinfoOfBC(info, bc, ft0s, fv0as, fdds);
+
+  // fill BG and BB flags
+  auto bcnum = bc.globalBC();
+  auto bcrange = compatibleBCs(bcnum, 16, bcs, bcIndex);
+  LOGF(debug, "size of bcrange %d", bcrange.size());
+  fillBGBBFlags(info, bcnum - 16, bcrange);
+}
+
 // -----------------------------------------------------------------------------
 template <typename T>
 bool cleanZDC(T const& bc, o2::aod::Zdcs& zdcs, std::vector<float>& /*lims*/, o2::framework::SliceCache& cache)
@@ -19,6 +19,7 @@
 #include "Framework/AnalysisTask.h"
 #include "ReconstructionDataFormats/Vertex.h"
 #include "PWGUD/DataModel/UDTables.h"
+#include "PWGUD/Core/UDBcIndex.h"
 #include "PWGUD/Core/UDHelpers.h"
 #include "PWGUD/Core/UPCHelpers.h"
 #include "PWGUD/Core/DGSelector.h"
@@ -257,6 +258,7 @@ struct DGBCCandProducer {
 
   // DG selector
   DGSelector dgSelector;
+  udhelpers::BcIndex bcIndex;
 
   HistogramRegistry registry{
     "registry",
@@ -378,6 +380,8 @@ struct DGBCCandProducer {
                      TCs const& tracks, aod::FwdTracks const& fwdtracks, FTIBCs const& ftibcs,
                      aod::Zdcs const& /*zdcs*/, aod::FT0s const& ft0s, aod::FV0As const& fv0as, aod::FDDs const& fdds)
   {
+    bcIndex.fillFromBCs(bcs);
+
     // fill FITInfo
     auto bcnum = tibc.bcnum();
     upchelpers::FITInfo fitInfo{};
@@ -395,7 +399,7 @@ struct DGBCCandProducer {
 
       // get associated bc
       auto bc = tibc.bc_as<BCs>();
-      udhelpers::getFITinfo(fitInfo, bc, bcs, ft0s, fv0as, fdds);
+      udhelpers::getFITinfo(fitInfo, bc, bcs, bcIndex, ft0s, fv0as, fdds);
 
       // is there an associated collision?
       Partition<CCs> colSlize = aod::evsel::foundBCId == bc.globalIndex();
@@ -408,7 +412,7 @@ struct DGBCCandProducer {
 
         auto colTracks = tracks.sliceByCached(aod::track::collisionId, col.globalIndex(), cache);
         auto colFwdTracks = fwdtracks.sliceByCached(aod::fwdtrack::collisionId, col.globalIndex(), cache);
-        auto bcRange = udhelpers::compatibleBCs(col, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+        auto bcRange = udhelpers::compatibleBCs(col, diffCuts.NDtcoll(), bcs, bcIndex, diffCuts.minNBCs());
         isDG = dgSelector.IsSelected(diffCuts, col, bcRange, colTracks, colFwdTracks);
 
         // update UDTables, case 1.
@@ -426,7 +430,7 @@ struct DGBCCandProducer {
       } else {
         LOGF(debug, "  2. BC has NO collision");
         auto tracksArray = tibc.track_as<TCs>();
-        auto bcRange = udhelpers::compatibleBCs(bc, bc.globalBC(), diffCuts.minNBCs(), bcs);
+        auto bcRange = udhelpers::compatibleBCs(bc.globalBC(), diffCuts.minNBCs(), bcs, bcIndex);
 
         // does BC have fwdTracks?
         if (ftibcs.size() > 0) {
@@ -472,7 +476,7 @@ struct DGBCCandProducer {
 
       // the BC is not contained in the BCs table
       auto tracksArray = tibc.track_as<TCs>();
-      auto bcRange = udhelpers::compatibleBCs(bcnum, diffCuts.minNBCs(), bcs);
+      auto bcRange = udhelpers::compatibleBCs(bcnum, diffCuts.minNBCs(), bcs, bcIndex);
 
       // does BC have fwdTracks?
       if (ftibcs.size() > 0) {
@@ -538,6 +542,7 @@ struct DGBCCandProducer {
     if (bcs.size() <= 0) {
       return;
     }
+    bcIndex.fillFromBCs(bcs);
 
     // run over all BC in bcs and tibcs
     // int64_t lastCollision = 0;
@@ -603,7 +608,7 @@ struct DGBCCandProducer {
           // lastCollision = col.globalIndex();
 
           ntr1 = col.numContrib();
-          auto bcRange = udhelpers::compatibleBCs(bc, bcnum, diffCuts.minNBCs(), bcs);
+          auto bcRange = udhelpers::compatibleBCs(bcnum, diffCuts.minNBCs(), bcs, bcIndex);
           auto colTracks = tracks.sliceByCached(aod::track::collisionId, col.globalIndex(), cache);
           auto colFwdTracks = fwdtracks.sliceByCached(aod::fwdtrack::collisionId, col.globalIndex(), cache);
           isDG1 = dgSelector.IsSelected(diffCuts, col, bcRange, colTracks, colFwdTracks);
@@ -615,7 +620,7 @@ struct DGBCCandProducer {
 
             auto rtrwTOF = udhelpers::rPVtrwTOF<true>(colTracks, col.numContrib());
             auto nCharge = udhelpers::netCharge<true>(colTracks);
-            udhelpers::getFITinfo(fitInfo, bc, bcs, ft0s, fv0as, fdds);
+            udhelpers::getFITinfo(fitInfo, bc, bcs, bcIndex, ft0s, fv0as, fdds);
             int upc_flag = 0;
             ushort flags = col.flags();
             if (flags & dataformats::Vertex<o2::dataformats::TimeStamp<int>>::Flags::UPCMode)
@@ -641,7 +646,7 @@ struct DGBCCandProducer {
         if (tibc.bcnum() == bcnum) {
           SETBIT(bcFlag, 4);
 
-          auto bcRange = udhelpers::compatibleBCs(bc, bcnum, diffCuts.minNBCs(), bcs);
+          auto bcRange = udhelpers::compatibleBCs(bcnum, diffCuts.minNBCs(), bcs, bcIndex);
           auto tracksArray = tibc.track_as<TCs>();
           ntr2 = tracksArray.size();
 
@@ -669,7 +674,7 @@ struct DGBCCandProducer {
 
             auto rtrwTOF = udhelpers::rPVtrwTOF<false>(tracksArray, tracksArray.size());
             auto nCharge = udhelpers::netCharge<false>(tracksArray);
-            udhelpers::getFITinfo(fitInfo, bc, bcs, ft0s, fv0as, fdds);
+            udhelpers::getFITinfo(fitInfo, bc, bcs, bcIndex, ft0s, fv0as, fdds);
 
             // distinguish different cases
             if (bc.globalBC() == bcnum) {
@@ -13,6 +13,7 @@
 // \author Paul Buehler, paul.buehler@oeaw.ac.at
 
 #include "PWGUD/Core/DGSelector.h"
+#include "PWGUD/Core/UDBcIndex.h"
 #include "PWGUD/Core/UPCHelpers.h"
 #include "PWGUD/DataModel/UDTables.h"
 
@@ -60,6 +61,7 @@ struct DGCandProducer {
 
   // DG selector
   DGSelector dgSelector;
+  udhelpers::BcIndex bcIndex;
 
   // configurables
   Configurable<bool> saveAllTracks{"saveAllTracks", true, "save only PV contributors or all tracks associated to a collision"};
@@ -318,7 +320,8 @@ struct DGCandProducer {
     fillFIThistograms(bc, histdir);
 
     // obtain slice of compatible BCs
-    auto bcRange = udhelpers::compatibleBCs(collision, diffCuts.NDtcoll(), bcs, diffCuts.minNBCs());
+    bcIndex.fillFromBCs(bcs);
+    auto bcRange = udhelpers::compatibleBCs(collision, diffCuts.NDtcoll(), bcs, bcIndex, diffCuts.minNBCs());
     LOGF(debug, "<DGCandProducer>  Size of bcRange %d", bcRange.size());
 
     // apply DG selection
@@ -340,7 +343,7 @@ struct DGCandProducer {
 
       // fill FITInfo
       upchelpers::FITInfo fitInfo{};
-      udhelpers::getFITinfo(fitInfo, bc, bcs, ft0s, fv0as, fdds);
+      udhelpers::getFITinfo(fitInfo, bc, bcs, bcIndex, ft0s, fv0as, fdds);
 
       // update DG candidates tables
       auto rtrwTOF = udhelpers::rPVtrwTOF<true>(tracks, collision.numContrib());
@@ -19,6 +19,7 @@
 //
 
 #include "PWGUD/Core/SGSelector.h"
+#include "PWGUD/Core/UDBcIndex.h"
 #include "PWGUD/Core/UPCHelpers.h"
 #include "PWGUD/DataModel/UDTables.h"
 
@@ -94,6 +95,7 @@ struct SGCandProducer {
 
   //  SG selector
   SGSelector sgSelector;
+  udhelpers::BcIndex bcIndex;
   ctpRateFetcher mRateFetcher;
 
   // initialize RCT flag checker
@@ -344,7 +346,8 @@ struct SGCandProducer {
     auto newbc = bc;
 
     // obtain slice of compatible BCs
-    auto bcRange = udhelpers::compatibleBCs(collision, sameCuts.NDtcoll(), bcs, sameCuts.minNBCs());
+    bcIndex.fillFromBCs(bcs);
+    auto bcRange = udhelpers::compatibleBCs(collision, sameCuts.NDtcoll(), bcs, bcIndex, sameCuts.minNBCs());
     auto isSGEvent = sgSelector.IsSelected(sameCuts, collision, bcRange, bc);
     // auto isSGEvent = sgSelector.IsSelected(sameCuts, collision, bcRange, tracks);
     int issgevent = isSGEvent.value;
@@ -369,7 +372,7 @@ struct SGCandProducer {
       const uint8_t chFDDC = 0;
       const uint8_t chFV0A = 0;
       const int occ = collision.trackOccupancyInTimeRange();
-      udhelpers::getFITinfo(fitInfo, newbc, bcs, ft0s, fv0as, fdds);
+      udhelpers::getFITinfo(fitInfo, newbc, bcs, bcIndex, ft0s, fv0as, fdds);
       const int upc_flag = (collision.flags() & dataformats::Vertex<o2::dataformats::TimeStamp<int>>::Flags::UPCMode) ? 1 : 0;
       // update SG candidates tables
       outputCollisions(bc.globalBC(), bc.runNumber(),
@@ -12,6 +12,7 @@
 /// \author Diana Krupova, diana.krupova@cern.ch
 /// \since 04.06.2024
 
+#include "PWGUD/Core/UDBcIndex.h"
 #include "PWGUD/Core/UPCCutparHolder.h"
 #include "PWGUD/Core/UPCHelpers.h"
 #include "PWGUD/DataModel/UDTables.h"
@@ -237,19 +238,6 @@ struct UpcCandProducer {
     return true;
   }
 
-  auto findClosestBC(uint64_t globalBC, std::map<uint64_t, int32_t>& bcs)
-  {
-    auto it = bcs.lower_bound(globalBC);
-    auto bc1 = it->first;
-    if (it != bcs.begin())
-      --it;
-    auto bc2 = it->first;
-    auto dbc1 = bc1 >= globalBC ? bc1 - globalBC : globalBC - bc1;
-    auto dbc2 = bc2 >= globalBC ? bc2 - globalBC : globalBC - bc2;
-    auto bc = (dbc1 <= dbc2) ? bc1 : bc2;
-    return bc;
-  }
-
   auto findClosestTrackBCiter(uint64_t globalBC, std::vector<BCTracksPair>& bcs)
   {
     auto it = std::lower_bound(bcs.begin(), bcs.end(), globalBC,
@@ -817,16 +805,16 @@ struct UpcCandProducer {
     std::sort(bcsMatchedTrIdsITSTPC.begin(), bcsMatchedTrIdsITSTPC.end(),
               [](const auto& left, const auto& right) { return left.first < right.first; });
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithTOR{};
-    std::map<uint64_t, int32_t> mapGlobalBcWithTVX{};
-    std::map<uint64_t, int32_t> mapGlobalBcWithTSC{};
+    udhelpers::BcIndex bcsWithTOR{};
+    udhelpers::BcIndex bcsWithTVX{};
+    udhelpers::BcIndex bcsWithTSC{};
     for (const auto& ft0 : ft0s) {
       uint64_t globalBC = ft0.bc_as<TBCs>().globalBC();
       int32_t globalIndex = ft0.globalIndex();
       if (!(std::abs(ft0.timeA()) > 2.f && std::abs(ft0.timeC()) > 2.f))
-        mapGlobalBcWithTOR[globalBC] = globalIndex;
+        bcsWithTOR.add(globalBC, globalIndex);
       if (TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitVertex)) { // TVX
-        mapGlobalBcWithTVX[globalBC] = globalIndex;
+        bcsWithTVX.add(globalBC, globalIndex);
       }
       if (TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitCen)) { // TVX & TCE
         histRegistry.get<TH1>(HIST("hCountersTrg"))->Fill("TCE", 1);
@@ -834,19 +822,19 @@ struct UpcCandProducer {
       if (TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitVertex) &&
           (TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitCen) ||
            TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitSCen))) { // TVX & (TSC | TCE)
-        mapGlobalBcWithTSC[globalBC] = globalIndex;
+        bcsWithTSC.add(globalBC, globalIndex);
       }
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithV0A{};
+    udhelpers::BcIndex bcsWithV0A{};
     for (const auto& fv0a : fv0as) {
       if (std::abs(fv0a.time()) > 15.f)
         continue;
       uint64_t globalBC = fv0a.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithV0A[globalBC] = fv0a.globalIndex();
+      bcsWithV0A.add(globalBC, fv0a.globalIndex());
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithZdc{};
+    udhelpers::BcIndex bcsWithZdc{};
     for (const auto& zdc : zdcs) {
       if (std::abs(zdc.timeZNA()) > 2.f && std::abs(zdc.timeZNC()) > 2.f)
         continue;
@@ -855,14 +843,20 @@ struct UpcCandProducer {
       if (!(std::abs(zdc.timeZNC()) > 2.f))
         histRegistry.get<TH1>(HIST("hCountersTrg"))->Fill("ZNC", 1);
       auto globalBC = zdc.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithZdc[globalBC] = zdc.globalIndex();
+      bcsWithZdc.add(globalBC, zdc.globalIndex());
     }
 
-    auto nTORs = mapGlobalBcWithTOR.size();
-    auto nTSCs = mapGlobalBcWithTSC.size();
-    auto nTVXs = mapGlobalBcWithTVX.size();
-    auto nFV0As = mapGlobalBcWithV0A.size();
-    auto nZdcs = mapGlobalBcWithZdc.size();
+    bcsWithTOR.build();
+    bcsWithTSC.build();
+    bcsWithTVX.build();
+    bcsWithV0A.build();
+    bcsWithZdc.build();
+
+    auto nTORs = bcsWithTOR.size();
+    auto nTSCs = bcsWithTSC.size();
+    auto nTVXs = bcsWithTVX.size();
+    auto nFV0As = bcsWithV0A.size();
+    auto nZdcs = bcsWithZdc.size();
     auto nBcsWithITSTPC = bcsMatchedTrIdsITSTPC.size();
 
     // todo: calculate position of UD collision?
@@ -886,11 +880,12 @@ struct UpcCandProducer {
       fitInfo.distClosestBcTVX = 999;
       fitInfo.distClosestBcV0A = 999;
       if (nTORs > 0) {
-        uint64_t closestBcTOR = findClosestBC(globalBC, mapGlobalBcWithTOR);
+        auto closestPosTOR = bcsWithTOR.closest(globalBC);
+        uint64_t closestBcTOR = bcsWithTOR.globalBC(closestPosTOR);
         fitInfo.distClosestBcTOR = globalBC - static_cast<int64_t>(closestBcTOR);
         if (std::abs(fitInfo.distClosestBcTOR) <= fFilterFT0)
           return false;
-        auto ft0Id = mapGlobalBcWithTOR.at(closestBcTOR);
+        auto ft0Id = bcsWithTOR.row(closestPosTOR);
         auto ft0 = ft0s.iteratorAt(ft0Id);
         fitInfo.timeFT0A = ft0.timeA();
         fitInfo.timeFT0C = ft0.timeC();
@@ -902,23 +897,26 @@ struct UpcCandProducer {
           fitInfo.ampFT0C += amp;
       }
       if (nTSCs > 0) {
-        uint64_t closestBcTSC = findClosestBC(globalBC, mapGlobalBcWithTSC);
+        auto closestPosTSC = bcsWithTSC.closest(globalBC);
+        uint64_t closestBcTSC = bcsWithTSC.globalBC(closestPosTSC);
         fitInfo.distClosestBcTSC = globalBC - static_cast<int64_t>(closestBcTSC);
         if (std::abs(fitInfo.distClosestBcTSC) <= fFilterTSC)
           return false;
       }
       if (nTVXs > 0) {
-        uint64_t closestBcTVX = findClosestBC(globalBC, mapGlobalBcWithTVX);
+        auto closestPosTVX = bcsWithTVX.closest(globalBC);
+        uint64_t closestBcTVX = bcsWithTVX.globalBC(closestPosTVX);
         fitInfo.distClosestBcTVX = globalBC - static_cast<int64_t>(closestBcTVX);
         if (std::abs(fitInfo.distClosestBcTVX) <= fFilterTVX)
           return false;
       }
       if (nFV0As > 0) {
-        uint64_t closestBcV0A = findClosestBC(globalBC, mapGlobalBcWithV0A);
+        auto closestPosV0A = bcsWithV0A.closest(globalBC);
+        uint64_t closestBcV0A = bcsWithV0A.globalBC(closestPosV0A);
         fitInfo.distClosestBcV0A = globalBC - static_cast<int64_t>(closestBcV0A);
         if (std::abs(fitInfo.distClosestBcV0A) <= fFilterFV0)
           return false;
-        auto fv0aId = mapGlobalBcWithV0A.at(closestBcV0A);
+        auto fv0aId = bcsWithV0A.row(closestPosV0A);
         auto fv0a = fv0as.iteratorAt(fv0aId);
         fitInfo.timeFV0A = fv0a.time();
         const auto& v0Amps = fv0a.amplitude();
@@ -957,9 +955,9 @@ struct UpcCandProducer {
       if (!updateFitInfo(globalBC, fitInfo))
         continue;
       if (nZdcs > 0) {
-        auto itZDC = mapGlobalBcWithZdc.find(globalBC);
-        if (itZDC != mapGlobalBcWithZdc.end()) {
-          const auto& zdc = zdcs.iteratorAt(itZDC->second);
+        auto posZDC = bcsWithZdc.find(globalBC);
+        if (posZDC != udhelpers::BcIndex::NotFound) {
+          const auto& zdc = zdcs.iteratorAt(bcsWithZdc.row(posZDC));
           float timeZNA = zdc.timeZNA();
           float timeZNC = zdc.timeZNC();
           float eComZNA = zdc.energyCommonZNA();
@@ -1026,9 +1024,9 @@ struct UpcCandProducer {
       if (!updateFitInfo(globalBC, fitInfo))
         continue;
       if (nZdcs > 0) {
-        auto itZDC = mapGlobalBcWithZdc.find(globalBC);
-        if (itZDC != mapGlobalBcWithZdc.end()) {
-          const auto& zdc = zdcs.iteratorAt(itZDC->second);
+        auto posZDC = bcsWithZdc.find(globalBC);
+        if (posZDC != udhelpers::BcIndex::NotFound) {
+          const auto& zdc = zdcs.iteratorAt(bcsWithZdc.row(posZDC));
           float timeZNA = zdc.timeZNA();
           float timeZNC = zdc.timeZNC();
           float eComZNA = zdc.energyCommonZNA();
@@ -1252,35 +1250,20 @@ struct UpcCandProducer {
     bcsMatchedTrIdsTOFTagged.clear();
   }
 
-  template <typename T>
-  void fillAmplitudes(const T& t,
-                      const std::map<uint64_t, int32_t>& mapBCs,
+  void fillAmplitudes(const udhelpers::BcIndex& bcIndex,
                       std::vector<float>& amps,
                       std::vector<int8_t>& relBCs,
                       uint64_t gbc)
   {
     auto s = gbc - fBCWindowFITAmps;
     auto e = gbc + (fBCWindowFITAmps - 1);
-    auto it = mapBCs.lower_bound(s);
-    while (it->first <= e && it != mapBCs.end()) {
-      int i = it->first - s;
-      auto id = it->second;
-      const auto& row = t.iteratorAt(id);
-      float totalAmp = 0.f;
-      if constexpr (std::is_same_v<T, o2::aod::FT0s>) {
-        const auto& itAmps = row.amplitudeA();
-        totalAmp = std::accumulate(itAmps.begin(), itAmps.end(), 0.f);
-      }
-      if constexpr (std::is_same_v<T, o2::aod::FV0As>) {
-        const auto& itAmps = row.amplitude();
-        totalAmp = std::accumulate(itAmps.begin(), itAmps.end(), 0.f);
-      }
+    bcIndex.forEachInWindow(s, e, [&](std::size_t pos) {
+      float totalAmp = bcIndex.amplitude(pos);
       if (totalAmp > 0.f) {
         amps.push_back(totalAmp);
-        relBCs.push_back(gbc - (i + s));
+        relBCs.push_back(gbc - bcIndex.globalBC(pos));
       }
-      ++it;
-    }
+    });
   }
 
   template <typename TBCs>
@@ -1319,7 +1302,7 @@ struct UpcCandProducer {
     std::sort(bcsMatchedTrIdsMCH.begin(), bcsMatchedTrIdsMCH.end(),
               [](const auto& left, const auto& right) { return left.first < right.first; });
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithT0A{};
+    udhelpers::BcIndex bcsWithT0A{};
     for (const auto& ft0 : ft0s) {
       if (!TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitVertex))
         continue;
@@ -1329,20 +1312,22 @@ struct UpcCandProducer {
       if (std::abs(ft0.timeA()) > 2.f)
         continue;
       uint64_t globalBC = ft0.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithT0A[globalBC] = ft0.globalIndex();
+      const auto& t0AmpsA = ft0.amplitudeA();
+      bcsWithT0A.add(globalBC, ft0.globalIndex(), std::accumulate(t0AmpsA.begin(), t0AmpsA.end(), 0.f));
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithV0A{};
+    udhelpers::BcIndex bcsWithV0A{};
     for (const auto& fv0a : fv0as) {
       if (!TESTBIT(fv0a.triggerMask(), o2::fit::Triggers::bitA))
         continue;
       if (std::abs(fv0a.time()) > 15.f)
         continue;
       uint64_t globalBC = fv0a.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithV0A[globalBC] = fv0a.globalIndex();
+      const auto& v0Amps = fv0a.amplitude();
+      bcsWithV0A.add(globalBC, fv0a.globalIndex(), std::accumulate(v0Amps.begin(), v0Amps.end(), 0.f));
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithZdc{};
+    udhelpers::BcIndex bcsWithZdc{};
     for (const auto& zdc : zdcs) {
       if (std::abs(zdc.timeZNA()) > 2.f && std::abs(zdc.timeZNC()) > 2.f)
         continue;
@@ -1351,10 +1336,10 @@ struct UpcCandProducer {
       if (!(std::abs(zdc.timeZNC()) > 2.f))
         histRegistry.get<TH1>(HIST("hCountersTrg"))->Fill("ZNC", 1);
       auto globalBC = zdc.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithZdc[globalBC] = zdc.globalIndex();
+      bcsWithZdc.add(globalBC, zdc.globalIndex());
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithFDD{};
+    udhelpers::BcIndex bcsWithFDD{};
     uint8_t twoLayersA = 0;
     uint8_t twoLayersC = 0;
     for (const auto& fdd : fdds) {
@@ -1369,14 +1354,19 @@ struct UpcCandProducer {
       if ((twoLayersA == 0) && (twoLayersC == 0))
         continue;
       uint64_t globalBC = fdd.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithFDD[globalBC] = fdd.globalIndex();
+      bcsWithFDD.add(globalBC, fdd.globalIndex());
     }
 
-    auto nFT0s = mapGlobalBcWithT0A.size();
-    auto nFV0As = mapGlobalBcWithV0A.size();
-    auto nZdcs = mapGlobalBcWithZdc.size();
+    bcsWithT0A.build();
+    bcsWithV0A.build();
+    bcsWithZdc.build();
+    bcsWithFDD.build();
+
+    auto nFT0s = bcsWithT0A.size();
+    auto nFV0As = bcsWithV0A.size();
+    auto nZdcs = bcsWithZdc.size();
     auto nBcsWithMCH = bcsMatchedTrIdsMCH.size();
-    auto nFDDs = mapGlobalBcWithFDD.size();
+    auto nFDDs = bcsWithFDD.size();
 
     // todo: calculate position of UD collision?
     float dummyX = 0.;
@@ -1428,12 +1418,13 @@ struct UpcCandProducer {
       uint8_t chFT0A = 0;
       uint8_t chFT0C = 0;
       if (nFT0s > 0) {
-        uint64_t closestBcT0A = findClosestBC(globalBC, mapGlobalBcWithT0A);
+        auto closestPosT0A = bcsWithT0A.closest(globalBC);
+        uint64_t closestBcT0A = bcsWithT0A.globalBC(closestPosT0A);
         int64_t distClosestBcT0A = globalBC - static_cast<int64_t>(closestBcT0A);
         if (std::abs(distClosestBcT0A) <= fFilterFT0)
           continue;
         fitInfo.distClosestBcT0A = distClosestBcT0A;
-        auto ft0Id = mapGlobalBcWithT0A.at(closestBcT0A);
+        auto ft0Id = bcsWithT0A.row(closestPosT0A);
         auto ft0 = ft0s.iteratorAt(ft0Id);
         fitInfo.timeFT0A = ft0.timeA();
         fitInfo.timeFT0C = ft0.timeC();
@@ -1443,28 +1434,29 @@ struct UpcCandProducer {
         fitInfo.ampFT0C = std::accumulate(t0AmpsC.begin(), t0AmpsC.end(), 0.f);
         chFT0A = ft0.amplitudeA().size();
         chFT0C = ft0.amplitudeC().size();
-        fillAmplitudes(ft0s, mapGlobalBcWithT0A, amplitudesT0A, relBCsT0A, globalBC);
+        fillAmplitudes(bcsWithT0A, amplitudesT0A, relBCsT0A, globalBC);
       }
       uint8_t chFV0A = 0;
       if (nFV0As > 0) {
-        uint64_t closestBcV0A = findClosestBC(globalBC, mapGlobalBcWithV0A);
+        auto closestPosV0A = bcsWithV0A.closest(globalBC);
+        uint64_t closestBcV0A = bcsWithV0A.globalBC(closestPosV0A);
         int64_t distClosestBcV0A = globalBC - static_cast<int64_t>(closestBcV0A);
         if (std::abs(distClosestBcV0A) <= fFilterFV0)
           continue;
         fitInfo.distClosestBcV0A = distClosestBcV0A;
-        auto fv0aId = mapGlobalBcWithV0A.at(closestBcV0A);
+        auto fv0aId = bcsWithV0A.row(closestPosV0A);
         auto fv0a = fv0as.iteratorAt(fv0aId);
         fitInfo.timeFV0A = fv0a.time();
         const auto& v0Amps = fv0a.amplitude();
         fitInfo.ampFV0A = std::accumulate(v0Amps.begin(), v0Amps.end(), 0.f);
         chFV0A = fv0a.amplitude().size();
-        fillAmplitudes(fv0as, mapGlobalBcWithV0A, amplitudesV0A, relBCsV0A, globalBC);
+        fillAmplitudes(bcsWithV0A, amplitudesV0A, relBCsV0A, globalBC);
       }
       uint8_t chFDDA = 0;
       uint8_t chFDDC = 0;
       if (nFDDs > 0) {
-        uint64_t closestBcFDD = findClosestBC(globalBC, mapGlobalBcWithFDD);
-        auto fddId = mapGlobalBcWithFDD.at(closestBcFDD);
+        auto closestPosFDD = bcsWithFDD.closest(globalBC);
+        auto fddId = bcsWithFDD.row(closestPosFDD);
         auto fdd = fdds.iteratorAt(fddId);
         fitInfo.timeFDDA = fdd.timeA();
         fitInfo.timeFDDC = fdd.timeC();
@@ -1484,9 +1476,9 @@ struct UpcCandProducer {
         }
       }
       if (nZdcs > 0) {
-        auto itZDC = mapGlobalBcWithZdc.find(globalBC);
-        if (itZDC != mapGlobalBcWithZdc.end()) {
-          const auto& zdc = zdcs.iteratorAt(itZDC->second);
+        auto posZDC = bcsWithZdc.find(globalBC);
+        if (posZDC != udhelpers::BcIndex::NotFound) {
+          const auto& zdc = zdcs.iteratorAt(bcsWithZdc.row(posZDC));
           float timeZNA = zdc.timeZNA();
           float timeZNC = zdc.timeZNC();
           float eComZNA = zdc.energyCommonZNA();
@@ -1532,9 +1524,9 @@ struct UpcCandProducer {
     ambFwdTrBCs.clear();
     bcsMatchedTrIdsMID.clear();
     bcsMatchedTrIdsMCH.clear();
-    mapGlobalBcWithT0A.clear();
-    mapGlobalBcWithV0A.clear();
-    mapGlobalBcWithFDD.clear();
+    bcsWithT0A.clear();
+    bcsWithV0A.clear();
+    bcsWithFDD.clear();
   }
 
   template <typename TBCs>
@@ -1582,7 +1574,7 @@ struct UpcCandProducer {
     std::sort(bcsMatchedTrIdsGlobal.begin(), bcsMatchedTrIdsGlobal.end(),
               [](const auto& left, const auto& right) { return left.first < right.first; });
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithT0A{};
+    udhelpers::BcIndex bcsWithT0A{};
     for (const auto& ft0 : ft0s) {
       if (!TESTBIT(ft0.triggerMask(), o2::fit::Triggers::bitVertex))
         continue;
@@ -1602,20 +1594,22 @@ struct UpcCandProducer {
       if (std::abs(ft0.timeA()) > 2.f)
         continue;
       uint64_t globalBC = ft0.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithT0A[globalBC] = ft0.globalIndex();
+      const auto& t0AmpsA = ft0.amplitudeA();
+      bcsWithT0A.add(globalBC, ft0.globalIndex(), std::accumulate(t0AmpsA.begin(), t0AmpsA.end(), 0.f));
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithV0A{};
+    udhelpers::BcIndex bcsWithV0A{};
     for (const auto& fv0a : fv0as) {
       if (!TESTBIT(fv0a.triggerMask(), o2::fit::Triggers::bitA))
         continue;
       if (std::abs(fv0a.time()) > 15.f)
         continue;
       uint64_t globalBC = fv0a.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithV0A[globalBC] = fv0a.globalIndex();
+      const auto& v0Amps = fv0a.amplitude();
+      bcsWithV0A.add(globalBC, fv0a.globalIndex(), std::accumulate(v0Amps.begin(), v0Amps.end(), 0.f));
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithZdc{};
+    udhelpers::BcIndex bcsWithZdc{};
     for (const auto& zdc : zdcs) {
       if (std::abs(zdc.timeZNA()) > 2.f && std::abs(zdc.timeZNC()) > 2.f)
         continue;
@@ -1624,10 +1618,10 @@ struct UpcCandProducer {
       if (!(std::abs(zdc.timeZNC()) > 2.f))
         histRegistry.get<TH1>(HIST("hCountersTrg"))->Fill("ZNC", 1);
       auto globalBC = zdc.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithZdc[globalBC] = zdc.globalIndex();
+      bcsWithZdc.add(globalBC, zdc.globalIndex());
     }
 
-    std::map<uint64_t, int32_t> mapGlobalBcWithFDD{};
+    udhelpers::BcIndex bcsWithFDD{};
     uint8_t twoLayersA = 0;
     uint8_t twoLayersC = 0;
     for (const auto& fdd : fdds) {
@@ -1642,13 +1636,18 @@ struct UpcCandProducer {
       if ((twoLayersA == 0) && (twoLayersC == 0))
         continue;
       uint64_t globalBC = fdd.bc_as<TBCs>().globalBC();
-      mapGlobalBcWithFDD[globalBC] = fdd.globalIndex();
+      bcsWithFDD.add(globalBC, fdd.globalIndex());
     }
 
-    auto nFT0s = mapGlobalBcWithT0A.size();
-    auto nFV0As = mapGlobalBcWithV0A.size();
-    auto nZdcs = mapGlobalBcWithZdc.size();
-    auto nFDDs = mapGlobalBcWithFDD.size();
+    bcsWithT0A.build();
+    bcsWithV0A.build();
+    bcsWithZdc.build();
+    bcsWithFDD.build();
+
+    auto nFT0s = bcsWithT0A.size();
+    auto nFV0As = bcsWithV0A.size();
+    auto nZdcs = bcsWithZdc.size();
+    auto nFDDs = bcsWithFDD.size();
 
     // todo: calculate position of UD collision?
     float dummyX = 0.;
@@ -1735,12 +1734,13 @@ struct UpcCandProducer {
       int zVtxFT0vPv = 0;
       int vtxITSTPC = 0;
       if (nFT0s > 0) {
-        uint64_t closestBcT0A = findClosestBC(globalBC, mapGlobalBcWithT0A);
+        auto closestPosT0A = bcsWithT0A.closest(globalBC);
+        uint64_t closestBcT0A = bcsWithT0A.globalBC(closestPosT0A);
         int64_t distClosestBcT0A = globalBC - static_cast<int64_t>(closestBcT0A);
         if (std::abs(distClosestBcT0A) <= fFilterFT0)
           continue;
         fitInfo.distClosestBcT0A = distClosestBcT0A;
-        auto ft0Id = mapGlobalBcWithT0A.at(closestBcT0A);
+        auto ft0Id = bcsWithT0A.row(closestPosT0A);
         auto ft0 = ft0s.iteratorAt(ft0Id);
         fitInfo.timeFT0A = ft0.timeA();
         fitInfo.timeFT0C = ft0.timeC();
@@ -1759,28 +1759,29 @@ struct UpcCandProducer {
         sbp = ft0.bc_as<TBCs>().selection_bit(o2::aod::evsel::kNoSameBunchPileup) ? 1 : 0;
         zVtxFT0vPv = ft0.bc_as<TBCs>().selection_bit(o2::aod::evsel::kIsGoodZvtxFT0vsPV) ? 1 : 0;
         vtxITSTPC = ft0.bc_as<TBCs>().selection_bit(o2::aod::evsel::kIsVertexITSTPC) ? 1 : 0;
-        fillAmplitudes(ft0s, mapGlobalBcWithT0A, amplitudesT0A, relBCsT0A, globalBC);
+        fillAmplitudes(bcsWithT0A, amplitudesT0A, relBCsT0A, globalBC);
       }
       uint8_t chFV0A = 0;
       if (nFV0As > 0) {
-        uint64_t closestBcV0A = findClosestBC(globalBC, mapGlobalBcWithV0A);
+        auto closestPosV0A = bcsWithV0A.closest(globalBC);
+        uint64_t closestBcV0A = bcsWithV0A.globalBC(closestPosV0A);
         int64_t distClosestBcV0A = globalBC - static_cast<int64_t>(closestBcV0A);
         if (std::abs(distClosestBcV0A) <= fFilterFV0)
           continue;
         fitInfo.distClosestBcV0A = distClosestBcV0A;
-        auto fv0aId = mapGlobalBcWithV0A.at(closestBcV0A);
+        auto fv0aId = bcsWithV0A.row(closestPosV0A);
         auto fv0a = fv0as.iteratorAt(fv0aId);
         fitInfo.timeFV0A = fv0a.time();
         const auto& v0Amps = fv0a.amplitude();
         fitInfo.ampFV0A = std::accumulate(v0Amps.begin(), v0Amps.end(), 0.f);
         chFV0A = fv0a.amplitude().size();
-        fillAmplitudes(fv0as, mapGlobalBcWithV0A, amplitudesV0A, relBCsV0A, globalBC);
+        fillAmplitudes(bcsWithV0A, amplitudesV0A, relBCsV0A, globalBC);
       }
       uint8_t chFDDA = 0;
       uint8_t chFDDC = 0;
       if (nFDDs > 0) {
-        uint64_t closestBcFDD = findClosestBC(globalBC, mapGlobalBcWithFDD);
-        auto fddId = mapGlobalBcWithFDD.at(closestBcFDD);
+        auto closestPosFDD = bcsWithFDD.closest(globalBC);
+        auto fddId = bcsWithFDD.row(closestPosFDD);
         auto fdd = fdds.iteratorAt(fddId);
         fitInfo.timeFDDA = fdd.timeA();
         fitInfo.timeFDDC = fdd.timeC();
@@ -1800,9 +1801,9 @@ struct UpcCandProducer {
         }
       }
       if (nZdcs > 0) {
-        auto itZDC = mapGlobalBcWithZdc.find(globalBC);
-        if (itZDC != mapGlobalBcWithZdc.end()) {
-          const auto& zdc = zdcs.iteratorAt(itZDC->second);
+        auto posZDC = bcsWithZdc.find(globalBC);
+        if (posZDC != udhelpers::BcIndex::NotFound) {
+          const auto& zdc = zdcs.iteratorAt(bcsWithZdc.row(posZDC));
           float timeZNA = zdc.timeZNA();
           float timeZNC = zdc.timeZNC();
           float eComZNA = zdc.energyCommonZNA();
@@ -1847,9 +1848,9 @@ struct UpcCandProducer {
     bcsMatchedTrIdsMID.clear();
     bcsMatchedTrIdsMCH.clear();
     bcsMatchedTrIdsGlobal.clear();
-    mapGlobalBcWithT0A.clear();
-    mapGlobalBcWithV0A.clear();
-    mapGlobalBcWithFDD.clear();
+    bcsWithT0A.clear();
+    bcsWithV0A.clear();
+    bcsWithFDD.clear();
   }
 
   // data processors
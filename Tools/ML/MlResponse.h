@@ -23,9 +23,11 @@
 #include <Framework/Array2D.h>
 #include <Framework/Logger.h>
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <map>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -71,6 +73,59 @@ class MlResponse
     mNModels = binsLimits.size() - 1;
     mModels = std::vector<o2::ml::OnnxModel>(mNModels);
     mPaths = std::vector<std::string>(mNModels);
+    mBatches = std::vector<BatchQueue>(mNModels);
+  }
+
+  /// Enable batched inference (disabled by default)
+  /// \param batchSize is the maximum number of candidates queued per model before the queue is flushed (0 means per-candidate inference)
+  /// \note Candidates are queued with queueModelInput and their scores are written into caller-owned buffers when the queue of the corresponding model is flushed
+  void setBatchSize(std::size_t batchSize)
+  {
+    flushBatches();
+    mBatchSize = batchSize;
+    for (auto& batch : mBatches) {
+      batch.inputs.clear();
+      batch.outputs.clear();
+      batch.destinations.clear();
+      batch.inputs.reserve(batchSize * mCachedIndices.size());
+      batch.outputs.resize(batchSize * mNClasses);
+      batch.destinations.reserve(batchSize);
+    }
+  }
+
+  /// Queue the input features of a candidate for batched inference
+  /// \param input a vector containing the values of features used in the model
+  /// \param nModel is the model index
+  /// \param output is a caller-owned buffer of mNClasses scores, filled when the queue is flushed
+  /// \note The output buffer must stay valid until flushBatches is called. With batching disabled, the model is evaluated immediately
+  template <typename T1, typename T2>
+  void queueModelInput(T1& input, const T2& nModel, std::span<TypeOutputScore> output)
+  {
+    if (nModel < 0 || static_cast<std::size_t>(nModel) >= mModels.size()) {
+      LOG(fatal) << "Model index " << nModel << " is out of range! The number of initialised models is " << mModels.size() << ". Please check your configurables.";
+    }
+    if (output.size() < mNClasses) {
+      LOG(fatal) << "Output buffer of size " << output.size() << " cannot hold the scores of " << static_cast<int>(mNClasses) << " classes!";
+    }
+    if (mBatchSize == 0) {
+      auto scores = getModelOutput(input, nModel);
+      std::copy(scores.begin(), scores.end(), output.begin());
+      return;
+    }
+    auto& batch = mBatches[nModel];
+    batch.inputs.insert(batch.inputs.end(), std::begin(input), std::end(input));
+    batch.destinations.push_back(output.data());
+    if (batch.destinations.size() >= mBatchSize) {
+      flushBatch(nModel);
+    }
+  }
+
+  /// Evaluate all the queued candidates (to be called e.g. at the end of each timeframe, before using the scores)
+  void flushBatches()
+  {
+    for (std::size_t iModel{0}; iModel < mBatches.size(); ++iModel) {
+      flushBatch(iModel);
+    }
   }
 
   /// Set model paths to CCDB
@@ -118,6 +173,13 @@ class MlResponse
     mPaths = onnxFiles;
   }
 
+  /// Set the directory where the optimised graphs of the models are serialised and looked up (to be called before init)
+  /// \param dir is the directory, an empty string disables the serialisation
+  void setOptimizedModelDir(const std::string& dir)
+  {
+    mOptimizedModelDir = dir;
+  }
+
   /// Initialize class instance (initialize OnnxModels)
   /// \param enableOptimizations is a switch to enable optimizations
   /// \param threads is the number of active threads
@@ -125,6 +187,7 @@ class MlResponse
   {
     uint8_t counterModel{0};
     for (const auto& path : mPaths) {
+      mModels[counterModel].setOptimizedModelDir(mOptimizedModelDir);
       mModels[counterModel].initModel(path, enableOptimizations, threads);
       ++counterModel;
     }
@@ -168,20 +231,7 @@ class MlResponse
   {
     int nModel = findBin(candVar);
     auto output = getModelOutput(input, nModel);
-    uint8_t iClass{0};
-    for (const auto& outputValue : output) {
-      uint8_t dir = mCutDir.at(iClass);
-      if (dir != o2::cuts_ml::CutDirection::CutNot) {
-        if (dir == o2::cuts_ml::CutDirection::CutGreater && outputValue > mCuts.get(nModel, iClass)) {
-          return false;
-        }
-        if (dir == o2::cuts_ml::CutDirection::CutSmaller && outputValue < mCuts.get(nModel, iClass)) {
-          return false;
-        }
-      }
-      ++iClass;
-    }
-    return true;
+    return isSelectedMlScores(output, nModel);
   }
 
   /// ML selections
@@ -194,6 +244,16 @@ class MlResponse
   {
     int nModel = findBin(candVar);
     output = getModelOutput(input, nModel);
+    return isSelectedMlScores(output, nModel);
+  }
+
+  /// ML selections on already computed scores (e.g. filled by batched inference)
+  /// \param output is the container with the model predictions for each class
+  /// \param nModel is the model index
+  /// \return boolean telling if model predictions pass the cuts
+  template <typename T>
+  bool isSelectedMlScores(const T& output, int nModel) const
+  {
     uint8_t iClass{0};
     for (const auto& outputValue : output) {
       uint8_t dir = mCutDir.at(iClass);
@@ -210,20 +270,62 @@ class MlResponse
     return true;
   }
 
+  /// Finds the model index for a given value of the binning variable (e.g. pT)
+  /// \param value e.g. pT
+  /// \return index of the model, -1 if outside the bin limits
+  template <typename T>
+  int getModelIndex(T const& value)
+  {
+    return findBin(value);
+  }
+
  protected:
+  /// Queue of candidates waiting for batched inference with one model
+  struct BatchQueue {
+    std::vector<TypeOutputScore> inputs;        // contiguous [N, nFeatures] input block
+    std::vector<TypeOutputScore> outputs;       // [N, nClasses] output block bound to the model
+    std::vector<TypeOutputScore*> destinations; // caller-owned buffers receiving the scores of each candidate
+  };
+
   std::vector<o2::ml::OnnxModel> mModels;                 // OnnxModel objects, one for each bin
   uint8_t mNModels = 1;                                   // number of bins
   uint8_t mNClasses = 3;                                  // number of model classes
   std::vector<double> mBinsLimits = {};                   // bin limits of the variable (e.g. pT) used to select which model to use
   std::vector<std::string> mPaths = {""};                 // paths to the models, one for each bin
+  std::string mOptimizedModelDir = "";                    // directory of the serialised optimised graphs (disabled if empty)
   std::vector<int> mCutDir = {};                          // direction of the cuts on the model scores (no cut is also supported)
   o2::framework::LabeledArray<double> mCuts = {};         // array of cut values to apply on the model scores
   std::map<std::string, uint8_t> mAvailableInputFeatures; // map of available input features
   std::vector<uint8_t> mCachedIndices;                    // vector of index correspondance between configurables and available input features
 
+  std::vector<BatchQueue> mBatches;                       // queues for batched inference, one for each bin
+  std::size_t mBatchSize = 0;                             // maximum number of queued candidates per model (0 = per-candidate inference)
+
   virtual void setAvailableInputFeatures() { return; } // method to fill the map of available input features
 
  private:
+  /// Evaluate the queued candidates of one model and scatter the scores to the caller buffers
+  /// \param nModel is the model index
+  void flushBatch(std::size_t nModel)
+  {
+    auto& batch = mBatches[nModel];
+    const auto nCandidates = batch.destinations.size();
+    if (nCandidates == 0) {
+      return;
+    }
+    if (batch.outputs.size() < nCandidates * mNClasses) {
+      batch.outputs.resize(nCandidates * mNClasses);
+    }
+    if (!mModels[nModel].template evalModelBatch<TypeOutputScore, TypeOutputScore>(batch.inputs.data(), static_cast<int64_t>(nCandidates), batch.outputs.data(), mNClasses)) {
+      LOG(fatal) << "Batched inference failed for model " << nModel << "!";
+    }
+    for (std::size_t iCand{0}; iCand < nCandidates; ++iCand) {
+      std::copy_n(batch.outputs.data() + iCand * mNClasses, mNClasses, batch.destinations[iCand]);
+    }
+    batch.inputs.clear();
+    batch.destinations.clear();
+  }
+
   /// Finds matching bin in mBinsLimits
   /// \param value e.g. pT
   /// \return index of the matching bin, used to access mModels
@@ -21,6 +21,7 @@
 
 #include <Framework/Logger.h>
 
+#include <TMD5.h>
 #include <TSystem.h>
 
 #include <onnxruntime_cxx_api.h>
@@ -28,9 +29,17 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace o2
@@ -39,6 +48,165 @@ namespace o2
 namespace ml
 {
 
+std::mutex OnnxSessionCache::mMutex;
+std::unordered_map<std::string, std::weak_ptr<Ort::Session>> OnnxSessionCache::mSessions;
+std::unordered_map<std::string, OnnxSessionCache::FileHash> OnnxSessionCache::mFileHashes;
+
+std::shared_ptr<Ort::Env> OnnxSessionCache::getEnv()
+{
+  static std::shared_ptr<Ort::Env> env = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "onnx-model");
+  return env;
+}
+
+std::string OnnxSessionCache::hashModelFile(const std::string& modelPath)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return hashModelFileLocked(modelPath);
+}
+
+std::string OnnxSessionCache::hashModelFileLocked(const std::string& modelPath)
+{
+  // the content is only hashed again if the size or the modification time of the file changed
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(modelPath, ec);
+  if (ec) {
+    return "";
+  }
+  const auto mtime = std::filesystem::last_write_time(modelPath, ec);
+  if (ec) {
+    return "";
+  }
+  auto it = mFileHashes.find(modelPath);
+  if (it != mFileHashes.end() && it->second.size == size && it->second.mtime == mtime) {
+    return it->second.hash;
+  }
+
+  std::ifstream file(modelPath, std::ios::binary);
+  if (!file) {
+    return "";
+  }
+  // the digest names the serialised graphs on disk, so it has to be stable across builds and processes
+  const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  TMD5 md5;
+  md5.Update(reinterpret_cast<const UChar_t*>(content.data()), static_cast<UInt_t>(content.size()));
+  md5.Final();
+  const std::string hash = md5.AsString();
+  mFileHashes[modelPath] = FileHash{size, mtime, hash};
+  return hash;
+}
+
+std::string OnnxSessionCache::runtimeKey()
+{
+  // optimised graphs are only valid for the runtime version and the execution provider that produced them;
+  // the sessions are created with the default CPU execution provider
+  return std::string(OrtGetApiBase()->GetVersionString()) + "_CPUExecutionProvider";
+}
+
+std::shared_ptr<Ort::Session> OnnxSessionCache::getSession(const std::string& modelPath, Ort::SessionOptions sessionOptions, const std::string& optionsKey, const std::string& optimizedModelDir)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  const std::string modelHash = hashModelFileLocked(modelPath);
+  const std::string key = modelHash + "_" + optionsKey + "_" + runtimeKey();
+
+  if (!modelHash.empty()) {
+    auto it = mSessions.find(key);
+    if (it != mSessions.end()) {
+      if (auto session = it->second.lock()) {
+        LOGP(info, "Reusing ONNX session for model {} (hash {})", modelPath, modelHash);
+        return session;
+      }
+    }
+  }
+
+  auto env = getEnv();
+  std::shared_ptr<Ort::Session> session;
+  if (!optimizedModelDir.empty() && !modelHash.empty()) {
+    const std::string optimizedPath = optimizedModelDir + "/" + key + ".ort.onnx";
+    if (std::ifstream(optimizedPath).good()) {
+      // the graph was already optimised by a previous job, skip the optimisation step
+      LOGP(info, "Loading optimised ONNX graph {}", optimizedPath);
+      sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+      session = std::make_shared<Ort::Session>(*env, optimizedPath.c_str(), sessionOptions);
+    } else {
+      // write to a file private to this process and rename it, so that concurrent jobs sharing the
+      // directory never see a partially written graph
+      const std::string tmpPath = optimizedPath + ".tmp" + std::to_string(gSystem->GetPid());
+      LOGP(info, "Serialising optimised ONNX graph to {}", optimizedPath);
+      sessionOptions.SetOptimizedModelFilePath(tmpPath.c_str());
+      session = std::make_shared<Ort::Session>(*env, modelPath.c_str(), sessionOptions);
+      if (std::rename(tmpPath.c_str(), optimizedPath.c_str()) != 0) {
+        LOGP(warning, "Could not move optimised ONNX graph {} to {}", tmpPath, optimizedPath);
+        std::remove(tmpPath.c_str());
+      }
+    }
+  } else {
+    session = std::make_shared<Ort::Session>(*env, modelPath.c_str(), sessionOptions);
+  }
+
+  if (!modelHash.empty()) {
+    mSessions[key] = session;
+  }
+  return session;
+}
+
+OnnxModel::OnnxModel(OnnxModel&& other) noexcept
+{
+  *this = std::move(other);
+}
+
+OnnxModel& OnnxModel::operator=(OnnxModel&& other) noexcept
+{
+  if (this == &other) {
+    return *this;
+  }
+  mEnv = std::move(other.mEnv);
+  mSession = std::move(other.mSession);
+  sessionOptions = std::move(other.sessionOptions);
+  mMemoryInfo = std::move(other.mMemoryInfo);
+  mInputNames = std::move(other.mInputNames);
+  mInputShapes = std::move(other.mInputShapes);
+  mOutputNames = std::move(other.mOutputNames);
+  mOutputShapes = std::move(other.mOutputShapes);
+  mRunOptions = std::move(other.mRunOptions);
+  mOutputTensors = std::move(other.mOutputTensors);
+  mOutputRows = other.mOutputRows;
+  mHasStaticOutputShapes = other.mHasStaticOutputShapes;
+  modelPath = std::move(other.modelPath);
+  mOptimizedModelDir = std::move(other.mOptimizedModelDir);
+  mShareSession = other.mShareSession;
+  activeThreads = other.activeThreads;
+  validFrom = other.validFrom;
+  validUntil = other.validUntil;
+
+  // the name pointers of both models refer to strings which may have moved (short string optimisation)
+  cacheNodeNames();
+  other.mInputNamesChar.clear();
+  other.mOutputNamesChar.clear();
+  // the binding is rebuilt at the next batched evaluation
+  mIoBinding.reset();
+  mBoundInput = nullptr;
+  mBoundOutput = nullptr;
+  mBoundRows = 0;
+  other.mIoBinding.reset();
+  other.mBoundInput = nullptr;
+  other.mBoundOutput = nullptr;
+  other.mBoundRows = 0;
+  other.mOutputRows = -1;
+  return *this;
+}
+
+void OnnxModel::cacheNodeNames()
+{
+  mInputNamesChar.clear();
+  for (const auto& name : mInputNames) {
+    mInputNamesChar.push_back(name.c_str());
+  }
+  mOutputNamesChar.clear();
+  for (const auto& name : mOutputNames) {
+    mOutputNamesChar.push_back(name.c_str());
+  }
+}
+
 std::string OnnxModel::printShape(const std::vector<int64_t>& v)
 {
   std::stringstream ss("");
@@ -87,8 +255,14 @@ void OnnxModel::initModel(const std::string& localPath, const bool enableOptimiz
     sessionOptions.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
   }
 
-  mEnv = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "onnx-model");
-  mSession = std::make_shared<Ort::Session>(*mEnv, modelPath.c_str(), sessionOptions);
+  mEnv = OnnxSessionCache::getEnv();
+  if (mShareSession) {
+    const std::string optionsKey = std::to_string(enableOptimizations) + "_" + std::to_string(activeThreads);
+    // the cache adjusts the options for the serialised graph, which must not leak into the options kept for resetSession()
+    mSession = OnnxSessionCache::getSession(modelPath, sessionOptions.Clone(), optionsKey, mOptimizedModelDir);
+  } else {
+    mSession = std::make_shared<Ort::Session>(*mEnv, modelPath.c_str(), sessionOptions);
+  }
 
   Ort::AllocatorWithDefaultOptions const tmpAllocator;
   for (std::size_t i = 0; i < mSession->GetInputCount(); ++i) {
@@ -103,6 +277,21 @@ void OnnxModel::initModel(const std::string& localPath, const bool enableOptimiz
   for (std::size_t i = 0; i < mSession->GetOutputCount(); ++i) {
     mOutputShapes.emplace_back(mSession->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetShape());
   }
+  cacheNodeNames();
+  mHasStaticOutputShapes = true;
+  for (const auto& shape : mOutputShapes) {
+    for (std::size_t idim = 1; idim < shape.size(); idim++) {
+      if (shape[idim] < 0) {
+        mHasStaticOutputShapes = false;
+      }
+    }
+  }
+  mOutputTensors.clear();
+  mOutputRows = -1;
+  if (mHasStaticOutputShapes) {
+    allocateOutputTensors(1);
+  }
+
   LOG(info) << "Input Nodes:";
   for (std::size_t i = 0; i < mInputNames.size(); i++) {
     LOG(info) << "\t" << mInputNames[i] << " : " << printShape(mInputShapes[i]);
@@ -121,6 +310,21 @@ void OnnxModel::initModel(const std::string& localPath, const bool enableOptimiz
   LOG(info) << "--- Model initialized! ---";
 }
 
+void OnnxModel::allocateOutputTensors(const int64_t nRows)
+{
+  Ort::AllocatorWithDefaultOptions allocator;
+  mOutputTensors.clear();
+  for (std::size_t i = 0; i < mOutputShapes.size(); ++i) {
+    std::vector<int64_t> shape = mOutputShapes[i];
+    if (!shape.empty()) {
+      shape[0] = nRows;
+    }
+    const auto type = mSession->GetOutputTypeInfo(i).GetTensorTypeAndShapeInfo().GetElementType();
+    mOutputTensors.emplace_back(Ort::Value::CreateTensor(allocator, shape.data(), shape.size(), type));
+  }
+  mOutputRows = nRows;
+}
+
 void OnnxModel::setActiveThreads(const int threads)
 {
   activeThreads = threads;
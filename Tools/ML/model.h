@@ -28,9 +28,13 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <filesystem>
 #include <iterator>
 #include <memory>
+#include <mutex>
+#include <span>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace o2
@@ -39,17 +43,59 @@ namespace o2
 namespace ml
 {
 
+/// Process-wide cache of ONNX runtime sessions
+/// One Ort::Env is shared by all the models of the process and one Ort::Session is created for each distinct
+/// (model content, session settings) pair, so that tasks and pT bins loading the same model share it
+class OnnxSessionCache
+{
+ public:
+  /// \return the environment shared by all the ONNX models of the process
+  static std::shared_ptr<Ort::Env> getEnv();
+
+  /// Get a session for a model, creating it if no compatible session exists yet
+  /// \param modelPath path to the .onnx file
+  /// \param sessionOptions options used to create the session if needed, owned by the cache since it adjusts them for the optimised graph
+  /// \param optionsKey string identifying the session settings (optimisation level, threads)
+  /// \param optimizedModelDir if not empty, directory where the optimised graph is serialised and looked up
+  static std::shared_ptr<Ort::Session> getSession(const std::string& modelPath, Ort::SessionOptions sessionOptions, const std::string& optionsKey, const std::string& optimizedModelDir = "");
+
+  /// \return MD5 digest of the content of a model file, empty if the file cannot be read
+  /// The digest is computed once per path and only recomputed if the size or modification time of the file changes
+  static std::string hashModelFile(const std::string& modelPath);
+
+ private:
+  struct FileHash {
+    std::uintmax_t size;
+    std::filesystem::file_time_type mtime;
+    std::string hash;
+  };
+
+  static std::string hashModelFileLocked(const std::string& modelPath);
+  /// \return string identifying the ONNX runtime version and execution provider
+  static std::string runtimeKey();
+
+  static std::mutex mMutex;
+  static std::unordered_map<std::string, std::weak_ptr<Ort::Session>> mSessions;
+  static std::unordered_map<std::string, FileHash> mFileHashes;
+};
+
 class OnnxModel
 {
 
  public:
   OnnxModel() = default;
   ~OnnxModel() = default;
+  // the cached node name pointers refer to the own name strings, so a model cannot be copied and a move rebuilds them
+  OnnxModel(const OnnxModel&) = delete;
+  OnnxModel& operator=(const OnnxModel&) = delete;
+  OnnxModel(OnnxModel&& other) noexcept;
+  OnnxModel& operator=(OnnxModel&& other) noexcept;
 
   // Inferencing
   void initModel(const std::string&, const bool = false, const int = 0, const uint64_t = 0, const uint64_t = 0);
 
   // template methods -- best to define them in header
+  /// \return pointer to the last output tensor, valid until the next evaluation of the model
   template <typename T>
   T* evalModel(std::vector<Ort::Value>& input)
   {
@@ -57,33 +103,62 @@ class OnnxModel
     // assert(input[0].GetTensorTypeAndShapeInfo().GetShape() == getNumInputNodes()); --> Fails build in debug mode, TODO: assertion should be checked somehow
 
     try {
-      const Ort::RunOptions runOptions;
-      std::vector<const char*> inputNamesChar(mInputNames.size(), nullptr);
-      std::transform(std::begin(mInputNames), std::end(mInputNames), std::begin(inputNamesChar),
-                     [&](const std::string& str) { return str.c_str(); });
-
-      std::vector<const char*> outputNamesChar(mOutputNames.size(), nullptr);
-      std::transform(std::begin(mOutputNames), std::end(mOutputNames), std::begin(outputNamesChar),
-                     [&](const std::string& str) { return str.c_str(); });
-      auto outputTensors = mSession->Run(runOptions, inputNamesChar.data(), input.data(), input.size(), outputNamesChar.data(), outputNamesChar.size());
-      LOG(debug) << "Number of output tensors: " << outputTensors.size();
-      if (outputTensors.size() != mOutputNames.size()) {
-        LOG(fatal) << "Number of output tensors: " << outputTensors.size() << " does not agree with the model specified size: " << mOutputNames.size();
-      }
-      for (std::size_t i = 0; i < outputTensors.size(); i++) {
-        LOG(debug) << "Output tensor shape: " << printShape(outputTensors[i].GetTensorTypeAndShapeInfo().GetShape());
-        if ((outputTensors[i].GetTensorTypeAndShapeInfo().GetShape() != mOutputShapes[i]) && (mOutputShapes[i][0] != -1)) {
-          LOG(fatal) << "Shape of tensor " << i << " does not agree with model specification! Output: " << printShape(outputTensors[i].GetTensorTypeAndShapeInfo().GetShape()) << " model: " << printShape(mOutputShapes[i]);
+      const int64_t nRows = input[0].GetTensorTypeAndShapeInfo().GetShape()[0];
+      if (mHasStaticOutputShapes) {
+        // outputs are written into the persistent tensors, which are only reallocated when the number of rows changes
+        if (nRows != mOutputRows) {
+          allocateOutputTensors(nRows);
+        }
+        mSession->Run(mRunOptions, mInputNamesChar.data(), input.data(), input.size(), mOutputNamesChar.data(), mOutputTensors.data(), mOutputTensors.size());
+      } else {
+        // shapes of the outputs are only known after the evaluation, they are checked against the model specification
+        mOutputTensors = mSession->Run(mRunOptions, mInputNamesChar.data(), input.data(), input.size(), mOutputNamesChar.data(), mOutputNamesChar.size());
+        mOutputRows = -1;
+        LOG(debug) << "Number of output tensors: " << mOutputTensors.size();
+        if (mOutputTensors.size() != mOutputNames.size()) {
+          LOG(fatal) << "Number of output tensors: " << mOutputTensors.size() << " does not agree with the model specified size: " << mOutputNames.size();
+        }
+        for (std::size_t i = 0; i < mOutputTensors.size(); i++) {
+          LOG(debug) << "Output tensor shape: " << printShape(mOutputTensors[i].GetTensorTypeAndShapeInfo().GetShape());
+          if ((mOutputTensors[i].GetTensorTypeAndShapeInfo().GetShape() != mOutputShapes[i]) && (mOutputShapes[i][0] != -1)) {
+            LOG(fatal) << "Shape of tensor " << i << " does not agree with model specification! Output: " << printShape(mOutputTensors[i].GetTensorTypeAndShapeInfo().GetShape()) << " model: " << printShape(mOutputShapes[i]);
+          }
         }
       }
-      T* outputValues = outputTensors.back().GetTensorMutableData<T>();
+      T* outputValues = mOutputTensors.back().GetTensorMutableData<T>();
       return outputValues;
     } catch (const Ort::Exception& exception) {
       LOG(error) << "Error running model inference: " << exception.what();
+      mOutputTensors.clear();
+      mOutputRows = -1;
     }
     return nullptr;
   }
 
+  /// View on one output tensor of the last evaluation
+  /// \param iOutput index of the output tensor (by default the last one)
+  /// \return span over the output values, valid until the next evaluation of the model
+  template <typename T>
+  std::span<const T> getOutput(const std::size_t iOutput = static_cast<std::size_t>(-1))
+  {
+    if (mOutputTensors.empty()) {
+      return {};
+    }
+    auto& tensor = iOutput < mOutputTensors.size() ? mOutputTensors[iOutput] : mOutputTensors.back();
+    return {tensor.GetTensorMutableData<T>(), tensor.GetTensorTypeAndShapeInfo().GetElementCount()};
+  }
+
+  /// Evaluate the model and return a view on the last output tensor
+  /// \return span over the output values, valid until the next evaluation of the model
+  template <typename T, typename I>
+  std::span<const T> evalModelView(I& input)
+  {
+    if (evalModel<T>(input) == nullptr) {
+      return {};
+    }
+    return getOutput<T>();
+  }
+
   template <typename T>
   T* evalModel(std::vector<T>& input)
   {
@@ -91,9 +166,7 @@ class OnnxModel
     assert(size % mInputShapes[0][1] == 0);
     std::vector<int64_t> inputShape{size / mInputShapes[0][1], mInputShapes[0][1]};
     std::vector<Ort::Value> inputTensors;
-    Ort::MemoryInfo memInfo =
-      Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
-    inputTensors.emplace_back(Ort::Value::CreateTensor<T>(memInfo, input.data(), size, inputShape.data(), inputShape.size()));
+    inputTensors.emplace_back(Ort::Value::CreateTensor<T>(mMemoryInfo, input.data(), size, inputShape.data(), inputShape.size()));
     LOG(debug) << "Input shape calculated from vector: " << printShape(inputShape);
     return evalModel<T>(inputTensors);
   }
@@ -104,8 +177,6 @@ class OnnxModel
   {
     std::vector<Ort::Value> inputTensors;
 
-    Ort::MemoryInfo memInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
-
     for (std::size_t iinput = 0; iinput < input.size(); iinput++) {
       [[maybe_unused]] int totalSize = 1;
       int64_t size = input[iinput].size();
@@ -119,16 +190,70 @@ class OnnxModel
         inputShape.push_back(mInputShapes[iinput][idim]);
       }
 
-      inputTensors.emplace_back(Ort::Value::CreateTensor<T>(memInfo, input[iinput].data(), size, inputShape.data(), inputShape.size()));
+      inputTensors.emplace_back(Ort::Value::CreateTensor<T>(mMemoryInfo, input[iinput].data(), size, inputShape.data(), inputShape.size()));
     }
 
     return evalModel<T>(inputTensors);
   }
 
+  /// Batched inference through a pre-bound Ort::IoBinding
+  /// \param input pointer to a contiguous [nRows, nFeatures] input block owned by the caller
+  /// \param nRows number of rows (candidates) in the input block
+  /// \param output pointer to a caller-owned buffer of size nRows * nOutputsPerRow, filled with the last output tensor of the model
+  /// \param nOutputsPerRow number of values per row of the last output tensor (e.g. number of classes)
+  /// \return true if the inference ran successfully
+  /// \note The binding is only refreshed when the input/output buffers or the number of rows change
+  template <typename TIn, typename TOut>
+  bool evalModelBatch(TIn* input, const int64_t nRows, TOut* output, const int64_t nOutputsPerRow)
+  {
+    if (nRows <= 0) {
+      return true;
+    }
+    try {
+      if (!mIoBinding) {
+        mIoBinding = std::make_unique<Ort::IoBinding>(*mSession);
+      }
+      if (input != mBoundInput || output != mBoundOutput || nRows != mBoundRows) {
+        const int64_t nFeatures = mInputShapes[0].back();
+        std::vector<int64_t> inputShape{nRows, nFeatures};
+        std::vector<int64_t> outputShape{nRows, nOutputsPerRow};
+        mIoBinding->ClearBoundInputs();
+        mIoBinding->ClearBoundOutputs();
+        mIoBinding->BindInput(mInputNames[0].c_str(), Ort::Value::CreateTensor<TIn>(mMemoryInfo, input, nRows * nFeatures, inputShape.data(), inputShape.size()));
+        // only the last output is bound to the caller buffer, the other ones (e.g. labels) are allocated by the runtime
+        for (std::size_t iOutput = 0; iOutput + 1 < mOutputNames.size(); ++iOutput) {
+          mIoBinding->BindOutput(mOutputNames[iOutput].c_str(), mMemoryInfo);
+        }
+        mIoBinding->BindOutput(mOutputNames.back().c_str(), Ort::Value::CreateTensor<TOut>(mMemoryInfo, output, nRows * nOutputsPerRow, outputShape.data(), outputShape.size()));
+        mBoundInput = input;
+        mBoundOutput = output;
+        mBoundRows = nRows;
+      }
+      mSession->Run(Ort::RunOptions{nullptr}, *mIoBinding);
+      return true;
+    } catch (const Ort::Exception& exception) {
+      LOG(error) << "Error running batched model inference: " << exception.what();
+      mBoundInput = nullptr;
+      mBoundOutput = nullptr;
+      mBoundRows = 0;
+    }
+    return false;
+  }
+
+  // Session sharing and caching of the optimised graph, to be set before initModel
+  void setSessionSharing(const bool share) { mShareSession = share; }
+  void setOptimizedModelDir(const std::string& dir) { mOptimizedModelDir = dir; }
+
   // Reset session
   void resetSession()
   {
     mSession.reset(new Ort::Session{*mEnv, modelPath.c_str(), sessionOptions});
+    mIoBinding.reset();
+    mOutputTensors.clear();
+    mOutputRows = -1;
+    mBoundInput = nullptr;
+    mBoundOutput = nullptr;
+    mBoundRows = 0;
   }
 
   // Getters & Setters
@@ -150,14 +275,31 @@ class OnnxModel
   std::shared_ptr<Ort::Session> mSession = nullptr;
   Ort::SessionOptions sessionOptions;
 
+  // Batched inference state
+  Ort::MemoryInfo mMemoryInfo = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
+  std::unique_ptr<Ort::IoBinding> mIoBinding = nullptr;
+  const void* mBoundInput = nullptr;
+  const void* mBoundOutput = nullptr;
+  int64_t mBoundRows = 0;
+
   // Input & Output specifications of the loaded network
   std::vector<std::string> mInputNames;
   std::vector<std::vector<int64_t>> mInputShapes;
   std::vector<std::string> mOutputNames;
   std::vector<std::vector<int64_t>> mOutputShapes;
+  std::vector<const char*> mInputNamesChar;  // cached at initialisation, point into mInputNames
+  std::vector<const char*> mOutputNamesChar; // cached at initialisation, point into mOutputNames
+
+  // Persistent output tensors, reused across evaluations
+  Ort::RunOptions mRunOptions;
+  std::vector<Ort::Value> mOutputTensors;
+  int64_t mOutputRows = -1;           // number of rows the output tensors are allocated for
+  bool mHasStaticOutputShapes = false; // all output dimensions but the first one are known
 
   // Environment settings
   std::string modelPath;
+  std::string mOptimizedModelDir; // directory of the serialised optimised graphs (disabled if empty)
+  bool mShareSession = true;      // use the process-wide session cache
   int activeThreads = 0;
   uint64_t validFrom = 0;
   uint64_t validUntil = 0;
@@ -165,6 +307,8 @@ class OnnxModel
   // Internal function for printing the shape of tensors
   std::string printShape(const std::vector<int64_t>&);
   bool checkHyperloop(const bool = true);
+  void allocateOutputTensors(const int64_t);
+  void cacheNodeNames();
 };
 
 } // namespace ml